@@ -34,26 +34,129 @@ static Uint32 cache_compact(cache_struct *cache);
 static cache_item_struct *cache_find_ptr(cache_struct *cache, const void *item);
 static void cache_remove(cache_struct *cache, cache_item_struct *item);
 static void cache_remove_all(cache_struct *cache);
+static void cache_evict(cache_struct *cache, const cache_item_struct *keep);
 
-#ifdef FASTER_MAP_LOAD
-// Compare two cache items by name. NULL pointer always go beyond "real" items.
-static int cache_item_cmp(const void* i, const void *j)
+/* Marks slots of removed items, so the probing continues past them */
+static cache_item_struct cache_deleted_item;
+#define CACHE_DELETED	(&cache_deleted_item)
+
+
+// FNV-1a hash of the item name
+static Uint32 cache_hash_name(const char *name)
 {
-	const cache_item_struct *item = *((const cache_item_struct **)i);
-	const cache_item_struct *jtem = *((const cache_item_struct **)j);
-	if (!item) return jtem ? 1 : 0;
-	if (!jtem) return -1;
-	return strcmp(item->name, jtem->name);
+	Uint32 hash = 2166136261u;
+
+	if (!name)
+		return 0;
+
+	while (*name)
+	{
+		hash ^= (Uint8)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
 }
 
-// Compare string \a str with the name of item \a iptr.
-static int cache_item_cmp_str(const void* str, const void *iptr)
+static Uint32 cache_hash_item(const void *item)
 {
-	const cache_item_struct *item = *((const cache_item_struct **)iptr);
-	if (!item) return -1;
-	return strcmp(str, item->name);
+	Uint64 value = (Uint64)(size_t)item;
+	Uint32 hash = (Uint32)(value ^ (value >> 32));
+
+	hash *= 2654435761u;
+	return hash ^ (hash >> 16);
+}
+
+// Slot of the item in the index with the given hash, the slot of the item is always there
+static Uint32 cache_index_find_slot(cache_item_struct **index, Uint32 mask,
+	Uint32 hash, const cache_item_struct *item)
+{
+	Uint32 i = hash & mask;
+
+	while (index[i] != item)
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+// Inserts into a free slot only, so both indices always use the same number of slots
+static void cache_index_insert(cache_item_struct **index, Uint32 mask,
+	Uint32 hash, cache_item_struct *item)
+{
+	Uint32 i = hash & mask;
+
+	while (index[i])
+		i = (i + 1) & mask;
+
+	index[i] = item;
+}
+
+static void cache_index_rebuild(cache_struct *cache)
+{
+	cache_item_struct *item;
+	Uint32 mask = cache->index_size - 1;
+
+	memset(cache->name_index, 0, cache->index_size * sizeof(cache_item_struct*));
+	memset(cache->item_index, 0, cache->index_size * sizeof(cache_item_struct*));
+	cache->index_used = 0;
+
+	for (item = cache->lru_head; item; item = item->lru_next)
+	{
+		cache_index_insert(cache->name_index, mask, item->name_hash, item);
+		cache_index_insert(cache->item_index, mask,
+			cache_hash_item(item->cache_item), item);
+		cache->index_used++;
+	}
+}
+
+static void cache_index_add(cache_struct *cache, cache_item_struct *item)
+{
+	Uint32 mask = cache->index_size - 1;
+
+	// too many deleted markers make the probing slow
+	if ((cache->index_used + 1) * 4 > cache->index_size * 3)
+		cache_index_rebuild(cache);
+
+	cache_index_insert(cache->name_index, mask, item->name_hash, item);
+	cache_index_insert(cache->item_index, mask,
+		cache_hash_item(item->cache_item), item);
+	cache->index_used++;
+}
+
+static void cache_index_remove(cache_struct *cache, const cache_item_struct *item)
+{
+	Uint32 mask = cache->index_size - 1;
+
+	cache->name_index[cache_index_find_slot(cache->name_index, mask,
+		item->name_hash, item)] = CACHE_DELETED;
+	cache->item_index[cache_index_find_slot(cache->item_index, mask,
+		cache_hash_item(item->cache_item), item)] = CACHE_DELETED;
+}
+
+static void cache_lru_push_front(cache_struct *cache, cache_item_struct *item)
+{
+	item->lru_prev = NULL;
+	item->lru_next = cache->lru_head;
+	if (cache->lru_head)
+		cache->lru_head->lru_prev = item;
+	else
+		cache->lru_tail = item;
+	cache->lru_head = item;
+}
+
+static void cache_lru_unlink(cache_struct *cache, cache_item_struct *item)
+{
+	if (item->lru_prev)
+		item->lru_prev->lru_next = item->lru_next;
+	else
+		cache->lru_head = item->lru_next;
+	if (item->lru_next)
+		item->lru_next->lru_prev = item->lru_prev;
+	else
+		cache->lru_tail = item->lru_prev;
+	item->lru_prev = NULL;
+	item->lru_next = NULL;
 }
-#endif
 
 // top level cache system routines
 void cache_system_init(Uint32 max_items)
@@ -63,6 +166,16 @@ void cache_system_init(Uint32 max_items)
 }
 
 #ifdef	ELC
+static void cache_print(const char *str)
+{
+	put_colored_text_in_buffer(c_yellow1, CHAT_SERVER, (const unsigned char*)str, -1);
+#ifdef MAP_EDITOR2
+	log_error(str);
+#else
+	write_to_log(CHAT_SERVER, (const unsigned char*)str, strlen(str));
+#endif
+}
+
 void cache_dump_sizes(const cache_struct *cache)
 {
 	char str[256];
@@ -103,15 +216,34 @@ void cache_dump_sizes(const cache_struct *cache)
 			else
 				safe_snprintf(str, sizeof(str), "%s %6d%c - %d: %s",
 					cache_size_str, size, scale, i, item->name);
-			put_colored_text_in_buffer(c_yellow1, CHAT_SERVER, (unsigned char*)str, -1);
-#ifdef MAP_EDITOR2
-			log_error(str);
-#else
-			write_to_log(CHAT_SERVER, (unsigned char*)str, strlen(str));
-#endif
+			cache_print(str);
 		}
 	}
 }
+
+void cache_dump_stats()
+{
+	char str[256];
+	const cache_item_struct *item;
+	const cache_struct *cache;
+	Uint32 lookups;
+
+	if (!cache_system)
+		return;
+
+	for (item = cache_system->lru_head; item; item = item->lru_next)
+	{
+		cache = item->cache_item;
+		if (!cache)
+			continue;
+		lookups = cache->hits + cache->misses;
+		safe_snprintf(str, sizeof(str), "%s: %d %s, %u hits, %u misses (%.1f%%), %u evictions",
+			item->name, cache->num_items, cache_items_str, cache->hits,
+			cache->misses, lookups ? cache->hits * 100.0f / lookups : 0.0f,
+			cache->evictions);
+		cache_print(str);
+	}
+}
 #endif	/* ELC */
 
 void cache_system_maint()
@@ -193,8 +325,17 @@ cache_struct *cache_init(const char* name, Uint32 max_items,
 		return NULL;	//oops, not enough memory
 
 	cache->cached_items = calloc(max_items, sizeof(cache_item_struct *));
-	if (!cache->cached_items)
+	// keep the hash tables at most half full
+	cache->index_size = 8;
+	while (cache->index_size < max_items * 2)
+		cache->index_size *= 2;
+	cache->name_index = calloc(cache->index_size, sizeof(cache_item_struct *));
+	cache->item_index = calloc(cache->index_size, sizeof(cache_item_struct *));
+	if (!cache->cached_items || !cache->name_index || !cache->item_index)
 	{
+		free(cache->cached_items);
+		free(cache->name_index);
+		free(cache->item_index);
 		free(cache);
 		return NULL;	//oops, not enough memory
 	}
@@ -208,7 +349,8 @@ cache_struct *cache_init(const char* name, Uint32 max_items,
 	if (cache_system)
 	{
 		cache_add_item(cache_system, name, cache,
-			sizeof(cache_struct) + max_items*sizeof(cache_item_struct *));
+			sizeof(cache_struct) + max_items*sizeof(cache_item_struct *)
+			+ 2*cache->index_size*sizeof(cache_item_struct *));
 	}
 
 	//all done, send the data back
@@ -218,6 +360,7 @@ cache_struct *cache_init(const char* name, Uint32 max_items,
 void cache_delete(cache_struct *cache)
 {
 	static int cache_delete_loop_block = 0;
+	cache_item_struct *item;
 
 	if (!cache) return;
 	if (cache != cache_system)
@@ -228,18 +371,23 @@ void cache_delete(cache_struct *cache)
 		free(cache->cached_items);
 		cache->cached_items = NULL;	//failsafe
 		cache->recent_item = NULL;	//failsafe
+		free(cache->name_index);
+		free(cache->item_index);
+		cache->name_index = cache->item_index = NULL;	//failsafe
 	}
 	if (cache_system && cache != cache_system && !cache_delete_loop_block)
 	{
-		cache_delete_loop_block++;
-		cache_remove(cache_system, cache_find_ptr(cache_system, cache));
-		cache_delete_loop_block--;
-	}
-	else
-	{
-		/* Make sure it wasn't free()d by the cache_remove() call */
-		free(cache);
+		item = cache_find_ptr(cache_system, cache);
+		if (item)
+		{
+			/* cache_remove() calls us again to free() the cache */
+			cache_delete_loop_block++;
+			cache_remove(cache_system, item);
+			cache_delete_loop_block--;
+			return;
+		}
 	}
+	free(cache);
 }
 
 void cache_set_compact(cache_struct *cache, Uint32 (*compact_item)())
@@ -264,30 +412,25 @@ void cache_set_free(cache_struct *cache, void (*free_item)())
 
 static Uint32 cache_clean(cache_struct *cache)
 {
-	cache_item_struct *item;
-	Sint32 i;
+	cache_item_struct *item, *prev;
+	Uint32 size;
 	Uint32 mem_freed = 0;
 
 	if (!cache->cached_items || !cache->time_limit || !cache->free_item)
 		return 0;
 
-#ifdef FASTER_MAP_LOAD
-	for (i = cache->num_items-1; i >= 0; i--)
-#else
-	for (i = 0; i < cache->max_item; i++)
-#endif
+	// the items not used for too long are all at the end of the LRU list
+	for (item = cache->lru_tail; item
+		&& item->access_time + cache->time_limit < cur_time; item = prev)
 	{
-		item = cache->cached_items[i];
-		if (item && item->cache_item)
+		prev = item->lru_prev;
+		// decide if this entry needs to be cleaned
+		if (item->cache_item && item->access_count == 0)
 		{
-			// decide if this entry needs to be cleaned
-			if (item->access_count == 0
-				&& item->access_time + cache->time_limit < cur_time)
-			{
-				cache_remove(cache, item);
-				mem_freed += item->size;
-			}
-			//item->access_count=0;
+			size = item->size;
+			cache_remove(cache, item);
+			cache->evictions++;
+			mem_freed += size;
 		}
 	}
 
@@ -299,35 +442,30 @@ static Uint32 cache_clean(cache_struct *cache)
 
 static Uint32 cache_compact(cache_struct *cache)
 {
-	cache_item_struct *item;
-	Sint32 i;
+	cache_item_struct *item, *next;
 	Uint32 freed;
 	Uint32 mem_freed=0;
 
 	if (!cache->cached_items || !cache->time_limit || !cache->compact_item)
 		return 0;
 
-#ifdef FASTER_MAP_LOAD
-	for (i = 0; i < cache->num_items; i++)
-#else
-	for (i = 0; i < cache->max_item; i++)
-#endif
+	// cache_adj_size() moves compacted items to the front, so walk from there
+	for (item = cache->lru_head; item; item = next)
 	{
-		item = cache->cached_items[i];
-		if (item && item->cache_item)
+		next = item->lru_next;
+		if (item->cache_item)
 		{
 			//decide if this entry needs to be cleaned
 			if (item->access_count == 0
 				&& item->access_time + cache->time_limit < cur_time)
-			//if(cache->cached_items[i]->access_time+cache->time_limit < cur_time)
 			{
-				freed = (*cache->compact_item)(cache->cached_items[i]->cache_item);
+				freed = (*cache->compact_item)(item->cache_item);
 				mem_freed += freed;
-				cache_adj_size(cache, -freed, cache->cached_items[i]->cache_item);
+				cache_adj_size(cache, -freed, item->cache_item);
 			}
 			else
 			{
-				cache->cached_items[i]->access_count = 0;	// clear the counter
+				item->access_count = 0;	// clear the counter
 			}
 		}
 	}
@@ -338,6 +476,19 @@ static Uint32 cache_compact(cache_struct *cache)
 	return mem_freed;
 }
 
+// frees the least recently used items until the cache fits into its size limit
+static void cache_evict(cache_struct *cache, const cache_item_struct *keep)
+{
+	if (!cache->size_limit || !cache->free_item)
+		return;
+
+	while (cache->total_size > cache->size_limit && cache->lru_tail
+		&& cache->lru_tail != keep)
+	{
+		cache_remove(cache, cache->lru_tail);
+		cache->evictions++;
+	}
+}
 
 #ifndef	USE_INLINE
 // detailed items
@@ -347,17 +498,20 @@ void cache_use(cache_struct *cache, cache_item_struct *item_ptr)
 	{
 		item_ptr->access_time = cur_time;
 		item_ptr->access_count++;
+		// move it to the front of the LRU list, unless it's already there
+		if (cache && item_ptr->lru_prev)
+		{
+			cache_lru_unlink(cache, item_ptr);
+			cache_lru_push_front(cache, item_ptr);
+		}
 	}
 }
 #endif	//USE_INLINE
 
 cache_item_struct *cache_find(cache_struct *cache, const char *name)
 {
-#ifdef FASTER_MAP_LOAD
-	cache_item_struct **item;
-#else
-	Sint32 i;
-#endif
+	cache_item_struct *item;
+	Uint32 hash, mask, i;
 
 	if (!cache->cached_items)
 		return NULL;
@@ -366,40 +520,34 @@ cache_item_struct *cache_find(cache_struct *cache, const char *name)
 	if (cache->recent_item && cache->recent_item->name
 		&& strcmp(cache->recent_item->name, name) == 0)
 	{
+		cache->hits++;
 		cache_use(cache, cache->recent_item);
 		return cache->recent_item;
 	}
 
-
-#ifdef FASTER_MAP_LOAD
-	item = bsearch(name, cache->cached_items, cache->num_items,
-		sizeof(cache_item_struct*), cache_item_cmp_str);
-	if (!item)
-		return NULL;
-	cache_use(cache, *item);
-	cache->recent_item = *item;
-	return *item;
-#else
-	// not the most recent, then scan the list
-	for (i = 0; i < cache->max_item; i++)
+	// not the most recent, then probe the name index
+	hash = cache_hash_name(name);
+	mask = cache->index_size - 1;
+	for (i = hash & mask; (item = cache->name_index[i]); i = (i + 1) & mask)
 	{
-		if (cache->cached_items[i] && cache->cached_items[i]->name
-			&& strcmp(cache->cached_items[i]->name, name) == 0)
+		if (item != CACHE_DELETED && item->name_hash == hash
+			&& item->name && strcmp(item->name, name) == 0)
 		{
-			cache_use(cache, cache->cached_items[i]);
-			cache->recent_item = cache->cached_items[i];
-			return cache->cached_items[i];
+			cache->hits++;
+			cache_use(cache, item);
+			cache->recent_item = item;
+			return item;
 		}
 	}
 
+	cache->misses++;
 	return NULL;
-#endif
 }
 
 static cache_item_struct *cache_find_ptr(cache_struct *cache, const void *item)
 {
 	cache_item_struct *citem;
-	Sint32 i;
+	Uint32 mask, i;
 
 	if (!cache->cached_items)
 		return NULL;
@@ -412,15 +560,11 @@ static cache_item_struct *cache_find_ptr(cache_struct *cache, const void *item)
 		return cache->recent_item;
 	}
 
-	// TODO: how about a sorted list or a hash system?
-#ifdef FASTER_MAP_LOAD
-	for (i = 0; i < cache->num_items; i++)
-#else
-	for (i = 0; i < cache->max_item; i++)
-#endif
+	mask = cache->index_size - 1;
+	for (i = cache_hash_item(item) & mask; (citem = cache->item_index[i]);
+		i = (i + 1) & mask)
 	{
-		citem = cache->cached_items[i];
-		if (citem && citem->name && citem->cache_item == item)
+		if (citem != CACHE_DELETED && citem->name && citem->cache_item == item)
 		{
 			cache_use(cache, citem);
 			cache->recent_item = citem;
@@ -444,48 +588,19 @@ void *cache_find_item(cache_struct *cache, const char *name)
 cache_item_struct *cache_add_item(cache_struct *cache, const char* name,
 	void *item, Uint32 size)
 {
-#ifdef FASTER_MAP_LOAD
 	cache_item_struct *new_item;
-	int i;
+	Sint32 i;
 
 	if (!cache->cached_items)
 		return NULL;
 
+#ifdef FASTER_MAP_LOAD
+	// the lookups use the index, so the list is only kept without holes
 	if (cache->num_items >= cache->num_allocated)
 		// make sure we have room - consider dynamic expansion if not
 		return NULL;
-
-	new_item = calloc(1, sizeof(cache_item_struct));
-	if (!new_item)
-		return NULL;
-
-	new_item->cache_item = item;
-	new_item->size = size;
-	new_item->name = name;
-	new_item->access_time = cur_time;
-	new_item->access_count = 1;	//start at 0 or 1? Is this a usage
-
-	for (i = 0; i < cache->num_items; i++)
-	{
-		if (strcmp(name, cache->cached_items[i]->name) <= 0)
-		{
-			memmove(cache->cached_items + (i+1), cache->cached_items + i,
-				(cache->num_items-i) * sizeof(cache_item_struct*));
-			break;
-		}
-	}
-	cache->recent_item = cache->cached_items[i] = new_item;
-	cache->num_items++;
-	cache->total_size += size;
-
-	if (cache != cache_system)
-		cache_adj_size(cache_system, size, cache);
-
-	return new_item;
+	i = cache->num_items;
 #else
-	Sint32 i;
-
-	if(!cache->cached_items) return NULL;
 	//find an empty slot
 	for(i=cache->first_unused; i<cache->max_item; i++)
 		{
@@ -504,36 +619,57 @@ cache_item_struct *cache_add_item(cache_struct *cache, const char* name,
 			i= cache->max_item;
 			cache->max_item++;
 		}
+#endif
+
 	//allocate the memory
-	cache->cached_items[i]=calloc(1,sizeof(cache_item_struct));
-	if(!cache->cached_items[i]) return NULL;
+	new_item = calloc(1, sizeof(cache_item_struct));
+	if (!new_item)
+		return NULL;
+#ifndef FASTER_MAP_LOAD
 	//adjusted the lowest unsued size
-	cache->first_unused= i+1;
+	cache->first_unused = i+1;
+#endif
 	//memorize the information
-	cache->cached_items[i]->cache_item=item;
-	cache->cached_items[i]->size=size;
-	cache->cached_items[i]->name=name;
-	cache->cached_items[i]->access_time=cur_time;
-	cache->cached_items[i]->access_count=1;	//start at 0 or 1? Is this a usage
+	new_item->cache_item = item;
+	new_item->size = size;
+	new_item->name = name;
+	new_item->name_hash = cache_hash_name(name);
+	new_item->access_time = cur_time;
+	new_item->access_count = 1;	//start at 0 or 1? Is this a usage
+	cache->cached_items[i] = new_item;
 	cache->num_items++;
-	cache->total_size+=size;
-	if(cache != cache_system) cache_adj_size(cache_system, size, cache);
+	cache->total_size += size;
+	cache_lru_push_front(cache, new_item);
+	cache_index_add(cache, new_item);
+	if (cache != cache_system)
+		cache_adj_size(cache_system, size, cache);
+	cache_evict(cache, new_item);
 	//return the pointer to the detailed item
-	cache->recent_item = cache->cached_items[i];
-	return(cache->recent_item);
-#endif
+	cache->recent_item = new_item;
+	return new_item;
 }
 
 void cache_set_name(cache_struct *cache, const char* name, void *item)
 {
 	cache_item_struct *item_ptr = cache_find_ptr(cache, item);
+	Uint32 mask;
+
 	if (item_ptr)
 	{
+		mask = cache->index_size - 1;
+		cache->name_index[cache_index_find_slot(cache->name_index, mask,
+			item_ptr->name_hash, item_ptr)] = CACHE_DELETED;
 		item_ptr->name = name;
-#ifdef FASTER_MAP_LOAD
-		qsort(cache->cached_items, cache->num_items, sizeof(item_ptr),
-			cache_item_cmp);
-#endif
+		item_ptr->name_hash = cache_hash_name(name);
+		// the item index keeps its slot, count the new one for both
+		if ((cache->index_used + 1) * 4 > cache->index_size * 3)
+			cache_index_rebuild(cache);
+		else
+		{
+			cache_index_insert(cache->name_index, mask,
+				item_ptr->name_hash, item_ptr);
+			cache->index_used++;
+		}
 	}
 }
 
@@ -553,6 +689,7 @@ void cache_adj_size(cache_struct *cache, Uint32 size, void *item)
 		cache_use(cache, item_ptr);
 		//item_ptr->access_time=cur_time;
 		//item_ptr->access_count++;
+		cache_evict(cache, item_ptr);
 	}
 }
 
@@ -562,6 +699,8 @@ static void cache_remove(cache_struct *cache, cache_item_struct *item)
 		return;		//nothing to do
 	if (cache != cache_system)
 		cache_adj_size(cache_system, -item->size, cache);
+	cache_lru_unlink(cache, item);
+	cache_index_remove(cache, item);
 	if (item->cache_item && cache->free_item)
 		(*cache->free_item)(item->cache_item);
 	cache->total_size -= item->size;
@@ -572,12 +711,12 @@ static void cache_remove(cache_struct *cache, cache_item_struct *item)
 	item->name = NULL;		//failsafe
 	item->size = 0;			//failsafe
 #ifdef FASTER_MAP_LOAD
-	if (cache->num_items > 0)
 	{
 		cache_item_struct **ci = cache->cached_items + cache->num_items;
 		if (*ci == item)
 		{
 			free(*ci);
+			*ci = NULL;
 		}
 		else
 		{
@@ -588,6 +727,7 @@ static void cache_remove(cache_struct *cache, cache_item_struct *item)
 					free(*ci);
 					memmove(ci, ci+1,
 						(cache->num_items-(ci-cache->cached_items))*sizeof(cache_item_struct*));
+					cache->cached_items[cache->num_items] = NULL;
 					break;
 				}
 			}
@@ -660,6 +800,8 @@ static void cache_remove_all(cache_struct *cache)
 	cache->num_items = cache->max_item = 0;
 #endif
 	cache->recent_item = NULL;	//forget where we are just incase
+	// drop the deleted markers too
+	cache_index_rebuild(cache);
 }
 
 /* currently UNUSED
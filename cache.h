@@ -16,13 +16,16 @@ extern "C" {
 /*!
  * a single item storable in the cache
  */
-typedef struct
+typedef struct cache_item_struct
 {
 	void	*cache_item;	/*!< pointer to the item we are caching */
 	Uint32	size;			/*!< size of item */
 	Uint32	access_time;	/*!< last time used */
 	Uint32	access_count;	/*!< number of usages since last checkpoint */
 	const char *name;	/*!< original source or name, NOTE: this is NOT free()'d and allows dups! */
+	Uint32	name_hash;		/*!< hash of the name, used by the name index */
+	struct cache_item_struct	*lru_prev;	/*!< more recently used item, NULL for the most recent one */
+	struct cache_item_struct	*lru_next;	/*!< less recently used item, NULL for the least recent one */
 } cache_item_struct;
 
 /*!
@@ -44,6 +47,15 @@ typedef struct
 	Uint32	size_limit;		/*!< limit on size before forcing a scan */
 	void	(*free_item)();	/*!< routine to call to free an item */
 	Uint32	(*compact_item)();	/*!< routine to call to reduce memory usage without freeing */
+	cache_item_struct	**name_index;	/*!< open addressing hash table of the items by name */
+	cache_item_struct	**item_index;	/*!< open addressing hash table of the items by cached pointer */
+	Uint32	index_size;		/*!< number of slots in each hash table, a power of two */
+	Uint32	index_used;		/*!< number of slots used by items or deleted markers */
+	cache_item_struct	*lru_head;	/*!< the most recently used item */
+	cache_item_struct	*lru_tail;	/*!< the least recently used item, evicted first */
+	Uint32	hits;			/*!< number of lookups by name that found an item */
+	Uint32	misses;			/*!< number of lookups by name that found nothing */
+	Uint32	evictions;		/*!< number of items removed by the time or size limit */
 } cache_struct;
 
 #ifndef	NEW_TEXTURES
@@ -107,6 +119,17 @@ void cache_system_maint(void);
  * \callgraph
  */
 void cache_dump_sizes(const cache_struct *cache);
+
+/*!
+ * \ingroup cache
+ * \brief dumps the usage statistics of all caches.
+ *
+ *      Dumps the number of hits, misses and evictions of every cache in
+ *      \see cache_system to the console.
+ *
+ * \callgraph
+ */
+void cache_dump_stats(void);
 #endif	/* ELC */
 
 /*!
@@ -150,7 +173,8 @@ void cache_set_time_limit(cache_struct *cache, Uint32 time_limit);
  * \ingroup cache
  * \brief   sets a \a size_limit for items in \a cache.
  *
- *      Sets a \a size_limit in bytes for items in the given \a cache.
+ *      Sets a \a size_limit in bytes for items in the given \a cache. When
+ *      the cache grows beyond it, the least recently used items are freed.
  *
  * \param cache         the cache for which the size limit should be set.
  * \param size_limit    the max. size for items in \a cache (in bytes).
@@ -214,12 +238,13 @@ void cache_adj_size(cache_struct *cache, Uint32 size, void *item);
 
 /*!
  * \ingroup cache
- * \brief   determines whether \a item is an element of \a cache.
+ * \brief   marks \a item as used.
  *
- *      Determines whether \a item is an element of \a cache.
+ *      Updates the access time and counter of \a item and moves it to
+ *      the front of the LRU list of \a cache.
  *
- * \param cache     the cache to search
- * \param item      the item to search for
+ * \param cache     the cache that contains \a item
+ * \param item      the item that was used
  */
 #ifndef	USE_INLINE
 void cache_use(cache_struct *cache, cache_item_struct *item);
@@ -232,6 +257,19 @@ static __inline__ void	cache_use(cache_struct *cache, cache_item_struct *item_pt
 	{
 		item_ptr->access_time = cur_time;
 		item_ptr->access_count++;
+		// move it to the front of the LRU list, unless it's already there
+		if (cache && item_ptr->lru_prev)
+		{
+			item_ptr->lru_prev->lru_next = item_ptr->lru_next;
+			if (item_ptr->lru_next)
+				item_ptr->lru_next->lru_prev = item_ptr->lru_prev;
+			else
+				cache->lru_tail = item_ptr->lru_prev;
+			item_ptr->lru_prev = NULL;
+			item_ptr->lru_next = cache->lru_head;
+			cache->lru_head->lru_prev = item_ptr;
+			cache->lru_head = item_ptr;
+		}
 	}
 }
 #endif	//USE_INLINE
@@ -4,8 +4,13 @@ include(CheckCXXSourceCompiles)
 if (CMAKE_COMPILER_IS_GNUCC OR CMAKE_COMPILER_IS_GNUCXX)
 	set(SSE_FLAGS "-msse")
 	set(SSE2_FLAGS "-msse2")
+	set(AVX2_FLAGS "-mavx2 -mf16c")
 endif (CMAKE_COMPILER_IS_GNUCC OR CMAKE_COMPILER_IS_GNUCXX)
 
+if (MSVC)
+	set(AVX2_FLAGS "/arch:AVX2")
+endif (MSVC)
+
 set(CMAKE_REQUIRED_FLAGS ${SSE2_FLAGS})
 check_cxx_source_compiles("
 	#include <emmintrin.h>
@@ -36,8 +41,30 @@ check_cxx_source_compiles("
 	}"
 	HAS_SSE_EXTENSIONS)
 
+set(CMAKE_REQUIRED_FLAGS ${AVX2_FLAGS})
+check_cxx_source_compiles("
+	#include <immintrin.h>
+
+	int main()
+	{
+		__m256i a;
+		__m128i b;
+		float vals[8] = {0};
+		a = _mm256_cvttps_epi32(_mm256_loadu_ps(vals));
+		a = _mm256_permute4x64_epi64(a, 0);
+		b = _mm_cvtps_ph(_mm256_castps256_ps128(
+			_mm256_castsi256_ps(a)), 0);
+		_mm_storeu_si128((__m128i*)vals, b);
+		return 0;
+	}"
+	HAS_AVX2_EXTENSIONS)
+
 set(CMAKE_REQUIRED_FLAGS)
 
+if (HAS_AVX2_EXTENSIONS)
+	message(STATUS "Using AVX2 extensions with runtime detection")
+endif(HAS_AVX2_EXTENSIONS)
+
 if (HAS_SSE2_EXTENSIONS)
 	message(STATUS "Using SSE2 extensions")
 elseif (HAS_SSE_EXTENSIONS)
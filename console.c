@@ -11,6 +11,7 @@
 #include "cal.h"
 #include "chat.h"
 #include "consolewin.h"
+#include "eye_candy_wrapper.h"
 #include "elconfig.h"
 #include "filter.h"
 #include "gamewin.h"
@@ -29,6 +30,7 @@
 #include "multiplayer.h"
 #include "notepad.h"
 #include "pm_log.h"
+#include "pathfinder.h"
 #include "platform.h"
 #include "questlog.h"
 #include "sound.h"
@@ -932,6 +934,8 @@ int command_quit(char *text, int len)
 int command_mem(char *text, int len)
 {
 	cache_dump_sizes(cache_system);
+	cache_dump_stats();
+	engine_log_cache_statistics();
 #ifdef	DEBUG
 	cache_dump_sizes(cache_e3d);
 #endif	//DEBUG
@@ -1724,6 +1728,11 @@ add_command("horse", &horse_cmd);
 	add_command(cmd_ignore, &command_ignore);
 	add_command(cmd_filters, &list_filters);
 	add_command(cmd_filter, &command_filter);
+#ifdef DEBUG
+	add_command("filter_benchmark", &benchmark_filters);
+	add_command("pf_benchmark", &pf_benchmark);
+	add_command("ec_benchmark", &ec_benchmark);
+#endif
 	add_command(cmd_unignore, &command_unignore);
 	add_command(cmd_unfilter, &command_unfilter);
 	add_command(cmd_glinfo, &command_glinfo);
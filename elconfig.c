@@ -242,6 +242,12 @@ int engine_use_multisample_shadows = engine_true;
 int engine_use_scene_fbo = engine_true;
 int engine_light_system = 0;
 int engine_use_multithreaded_culling = engine_true;
+int engine_culling_split_depth = 2;
+int engine_max_occluders = 32;
+int engine_texture_cache_size = 512;
+int engine_mesh_cache_size = 128;
+int engine_use_texture_streaming = engine_true;
+int engine_texture_upload_budget = 4096;
 char el2_data_dir[256] = { EL2_DATA_DIR }; /*!< the default directory where we look for el2 data files (aka installation dir) */
 
 void change_engine_shadow_quality(int* var, int value)
@@ -439,6 +445,42 @@ void change_engine_use_multithreaded_culling(int* var)
 	engine_set_use_multithreaded_culling(*var);
 }
 
+void change_engine_culling_split_depth(int* var, int value)
+{
+	*var = value;
+	engine_set_culling_split_depth(*var);
+}
+
+void change_engine_max_occluders(int* var, int value)
+{
+	*var = value;
+	engine_set_max_occluders(*var);
+}
+
+void change_engine_texture_cache_size(int* var, int value)
+{
+	*var = value;
+	engine_set_texture_cache_size(*var);
+}
+
+void change_engine_mesh_cache_size(int* var, int value)
+{
+	*var = value;
+	engine_set_mesh_cache_size(*var);
+}
+
+void change_engine_use_texture_streaming(int* var)
+{
+	*var = !*var;
+	engine_set_use_texture_streaming(*var);
+}
+
+void change_engine_texture_upload_budget(int* var, int value)
+{
+	*var = value;
+	engine_set_texture_upload_budget(*var);
+}
+
 void change_engine_opengl_version(int* var, int value)
 {
 	*var = value;
@@ -2041,6 +2083,12 @@ static void init_ELC_vars(void)
 	add_var(OPT_BOOL, "use_multisample_shadows", "ums", &engine_use_multisample_shadows, change_engine_use_multisample_shadows, engine_true, "Use multisample shadows", "Use multisample shadows for better quality.", TROUBLESHOOT);
 	add_var(OPT_BOOL, "use_scene_fbo", "usf", &engine_use_scene_fbo, change_engine_use_scene_fbo, engine_true, "Use scene fbo", "Use scene framebuffer object and blit it with framebuffer.", TROUBLESHOOT);
 	add_var(OPT_BOOL, "use_multithreaded_culling", "umc", &engine_use_multithreaded_culling, change_engine_use_multithreaded_culling, engine_true, "Use multihreaded culling", "Use multiple threads for culling to increase performance.", TROUBLESHOOT);
+	add_var(OPT_INT, "culling_split_depth", "csd", &engine_culling_split_depth, change_engine_culling_split_depth, 2, "Culling split depth", "Depth of the object tree where multithreaded culling is split into tasks, zero disables the splitting.", TROUBLESHOOT, 0, 4);
+	add_var(OPT_INT, "max_occluders", "mocc", &engine_max_occluders, change_engine_max_occluders, 32, "Max occluders", "Number of the nearest objects rasterized as occluders for occlusion culling, zero disables occlusion culling.", TROUBLESHOOT, 0, 256);
+	add_var(OPT_INT, "texture_cache_size", "tcs", &engine_texture_cache_size, change_engine_texture_cache_size, 512, "Texture cache size", "Size in MiB of the texture cache. After a map change, unused textures are freed until the cache fits.", TROUBLESHOOT, 16, 4096);
+	add_var(OPT_INT, "mesh_cache_size", "mcs", &engine_mesh_cache_size, change_engine_mesh_cache_size, 128, "Mesh cache size", "Size in MiB of the mesh cache. After a map change, unused meshes are freed until the cache fits.", TROUBLESHOOT, 16, 4096);
+	add_var(OPT_BOOL, "use_texture_streaming", "uts", &engine_use_texture_streaming, change_engine_use_texture_streaming, engine_true, "Use texture streaming", "Load the textures of objects and actors in the background. Until a texture is loaded, the error texture is shown.", TROUBLESHOOT);
+	add_var(OPT_INT, "texture_upload_budget", "tub", &engine_texture_upload_budget, change_engine_texture_upload_budget, 4096, "Texture upload budget", "Size in KiB of the streamed textures that are uploaded per frame. At least one texture is uploaded per frame.", TROUBLESHOOT, 64, 65535);
 
 	add_var(OPT_MULTI_NO_SAVE, "effect_debug", "effect_debug", &engine_effect_debug, change_engine_effect_debug, 0, "effect", "effect used for rendering", TROUBLESHOOT, "default", "debug_uv", "debug_depth", "debug_alpha", "debug_albedo", "debug_normal", "debug_tbn_matrix_0", "debug_tbn_matrix_1", "debug_tbn_matrix_2", "debug_shadow", "debug_specular", "debug_gloss", "debug_emissive", "debug_diffuse_light", "debug_specular_light", "debug_packed_light_index", 0);
 
@@ -55,6 +55,9 @@
 #include "engine/script/imagescript.hpp"
 #include "engine/abstractlogger.hpp"
 #include "engine/abstractmaploader.hpp"
+#include "engine/thread/abstractthreadtask.hpp"
+#include "engine/thread/jobsystem.hpp"
+#include "engine/thread/taskgroup.hpp"
 #ifdef	USE_GPU_COUNTER
 #include "engine/gpucounters.hpp"
 #include <GL/glx.h>
@@ -364,6 +367,36 @@ namespace
 		LOG_TO_CONSOLE(c_red1, format_string.str().c_str());
 	}
 
+	class RunJobTask: public AbstractThreadTask
+	{
+		private:
+			void (*m_job)(void* data, const Uint32 index);
+			void* m_data;
+			const Uint32 m_index;
+
+		public:
+			RunJobTask(void (*job)(void* data, const Uint32 index),
+				void* data, const Uint32 index);
+			virtual ~RunJobTask() noexcept;
+			virtual void operator()();
+
+	};
+
+	RunJobTask::RunJobTask(void (*job)(void* data, const Uint32 index),
+		void* data, const Uint32 index): m_job(job), m_data(data),
+		m_index(index)
+	{
+	}
+
+	RunJobTask::~RunJobTask() noexcept
+	{
+	}
+
+	void RunJobTask::operator()()
+	{
+		m_job(m_data, m_index);
+	}
+
 }
 
 extern "C" void log_ARB_debug_output(GLenum source, GLenum type, GLuint id,
@@ -489,8 +522,38 @@ extern "C" void init_global_vars()
 {
 	TRY_BLOCK
 
+	std::string mesh_data_cache_dir, shader_source_cache_dir;
+	std::string program_binary_cache_dir;
+
 	global_vars.reset(new GlobalVars());
 
+	mesh_data_cache_dir = get_path_config_base();
+	mesh_data_cache_dir += "mesh_cache/";
+
+	if (mkdir_tree(mesh_data_cache_dir.c_str(), 0))
+	{
+		global_vars->set_mesh_data_cache_dir(el::String(
+			el::string_to_utf8(mesh_data_cache_dir)));
+	}
+
+	shader_source_cache_dir = get_path_config_base();
+	shader_source_cache_dir += "shader_cache/";
+
+	if (mkdir_tree(shader_source_cache_dir.c_str(), 0))
+	{
+		global_vars->set_shader_source_cache_dir(el::String(
+			el::string_to_utf8(shader_source_cache_dir)));
+	}
+
+	program_binary_cache_dir = get_path_config_base();
+	program_binary_cache_dir += "program_cache/";
+
+	if (mkdir_tree(program_binary_cache_dir.c_str(), 0))
+	{
+		global_vars->set_program_binary_cache_dir(el::String(
+			el::string_to_utf8(program_binary_cache_dir)));
+	}
+
 	CATCH_BLOCK
 }
 
@@ -1695,6 +1758,97 @@ extern "C" void engine_set_use_multithreaded_culling(const int value)
 	global_vars->set_use_multithreaded_culling(value != 0);
 }
 
+extern "C" void engine_set_culling_split_depth(const int value)
+{
+	global_vars->set_culling_split_depth(value);
+}
+
+extern "C" void engine_set_max_occluders(const int value)
+{
+	global_vars->set_max_occluders(value);
+}
+
+extern "C" void engine_set_texture_cache_size(const int value)
+{
+	global_vars->set_texture_cache_size(value);
+}
+
+extern "C" void engine_set_mesh_cache_size(const int value)
+{
+	global_vars->set_mesh_cache_size(value);
+}
+
+extern "C" void engine_set_use_texture_streaming(const int value)
+{
+	global_vars->set_use_texture_streaming(value != 0);
+}
+
+extern "C" void engine_set_texture_upload_budget(const int value)
+{
+	global_vars->set_texture_upload_budget(value);
+}
+
+extern "C" void engine_log_cache_statistics()
+{
+	if (scene.get() == 0)
+	{
+		return;
+	}
+
+	BOOST_FOREACH(const el::String &line,
+		scene->get_scene_resources().get_cache_statistics())
+	{
+		LOG_TO_CONSOLE(c_yellow1, line.get().c_str());
+	}
+}
+
+extern "C" void engine_run_jobs(void (*job)(void* data, const Uint32 index),
+	void* data, const Uint32 count)
+{
+	std::auto_ptr<AbstractThreadTask> task;
+	TaskGroup task_group;
+	JobSystem* job_system;
+	Uint32 i;
+
+	job_system = nullptr;
+
+	if (scene.get() != 0)
+	{
+		job_system =
+			scene->get_scene_resources().get_job_system().get();
+	}
+
+	if ((job_system == nullptr) || (count < 2))
+	{
+		for (i = 0; i < count; ++i)
+		{
+			job(data, i);
+		}
+
+		return;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		task.reset(new RunJobTask(job, data, i));
+
+		job_system->add(task, task_group);
+	}
+
+	job_system->wait(task_group);
+}
+
+extern "C" Uint32 engine_get_pending_texture_count()
+{
+	if (scene.get() == 0)
+	{
+		return 0;
+	}
+
+	return scene->get_scene_resources().get_texture_cache(
+		)->get_pending_texture_count();
+}
+
 extern "C" int engine_get_opengl_3_0()
 {
 	return global_vars->get_opengl_3_0();
@@ -98,6 +98,17 @@ void engine_set_use_multisample_shadows(const int value);
 void engine_set_use_scene_fbo(const int value);
 void engine_set_light_system(const int value);
 void engine_set_use_multithreaded_culling(const int value);
+void engine_set_culling_split_depth(const int value);
+void engine_set_max_occluders(const int value);
+void engine_set_texture_cache_size(const int value);
+void engine_set_mesh_cache_size(const int value);
+void engine_set_use_texture_streaming(const int value);
+void engine_set_texture_upload_budget(const int value);
+void engine_log_cache_statistics();
+Uint32 engine_get_pending_texture_count();
+/* Calls job(data, i) for all i < count on the engine job system and waits */
+void engine_run_jobs(void (*job)(void* data, const Uint32 index),
+	void* data, const Uint32 count);
 
 float engine_get_z_near();
 float engine_get_z_far();
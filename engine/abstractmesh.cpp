@@ -16,6 +16,7 @@
 #include "vertexstream.hpp"
 #include "vertexbuffers.hpp"
 #include "vertexbuffersbuilder.hpp"
+#include "cpurasterizer.hpp"
 
 namespace eternal_lands
 {
@@ -70,6 +71,8 @@ namespace eternal_lands
 		m_instance_count = instance_count;
 		m_sub_meshs = source->get_sub_meshs();
 		m_min_max_boxes = source->get_min_max_boxes();
+		CpuRasterizer::build_occluder(*source, m_occluder_vertices,
+			m_occluder_indices);
 		m_primitive = source->get_primitive();
 		m_use_restart_index = source->get_use_restart_index();
 		m_static_indices = static_indices;
@@ -246,6 +249,8 @@ namespace eternal_lands
 		mesh.m_static_vertices = m_static_vertices;
 		mesh.m_sub_meshs = m_sub_meshs;
 		mesh.m_min_max_boxes = m_min_max_boxes;
+		mesh.m_occluder_vertices = m_occluder_vertices;
+		mesh.m_occluder_indices = m_occluder_indices;
 	}
 
 	void AbstractMesh::get_bounding_box(
@@ -36,6 +36,14 @@ namespace eternal_lands
 			 * These min max boxes are used for lod selection.
 			 */
 			AlignedSint16Vec8Array m_min_max_boxes;
+
+			/**
+			 * Positions and triangle indices used to rasterize
+			 * the mesh as occluder, empty if the mesh has too
+			 * many triangles.
+			 */
+			AlignedVec4Array m_occluder_vertices;
+			Uint32Vector m_occluder_indices;
 			SubMeshVector m_sub_meshs;
 			VertexFormatConstSharedPtr m_vertex_format;
 			const String m_name;
@@ -255,6 +263,35 @@ namespace eternal_lands
 				return m_min_max_boxes;
 			}
 
+			/**
+			 * Returns the occluder vertices.
+			 * @result The occluder vertices.
+			 */
+			inline const AlignedVec4Array &get_occluder_vertices()
+				const noexcept
+			{
+				return m_occluder_vertices;
+			}
+
+			/**
+			 * Returns the occluder triangle indices.
+			 * @result The occluder triangle indices.
+			 */
+			inline const Uint32Vector &get_occluder_indices() const
+				noexcept
+			{
+				return m_occluder_indices;
+			}
+
+			/**
+			 * Returns true if the mesh can be used as occluder.
+			 * @result True if the mesh has an occluder.
+			 */
+			inline bool get_occluder() const noexcept
+			{
+				return !m_occluder_indices.empty();
+			}
+
 			/**
 			 * Returns the number of vertexes.
 			 * @result The vertex count.
@@ -15,6 +15,7 @@
 #include "materialcache.hpp"
 #include "texture.hpp"
 #include "image.hpp"
+#include "imageupdate.hpp"
 
 namespace eternal_lands
 {
@@ -210,7 +211,7 @@ namespace eternal_lands
 		const ImageConstSharedPtr &displacement_map,
 		const ImageConstSharedPtr &normal_map,
 		const ImageConstSharedPtr &dudv_map,
-		const glm::vec3 &translation)
+		const glm::vec3 &translation, const glm::uvec4 &rect)
 	{
 		String texture_format_str, rgb10_a2_str;
 
@@ -230,11 +231,41 @@ namespace eternal_lands
 
 		m_translation = translation;
 
-		do_update_geometry_maps(displacement_map, normal_map, dudv_map);
+		do_update_geometry_maps(displacement_map, normal_map, dudv_map,
+			rect);
+	}
+
+	void AbstractTerrain::update_texture(const TextureSharedPtr &texture,
+		const ImageConstSharedPtr &image, const glm::uvec4 &rect)
+	{
+		glm::uvec3 offset, size;
+
+		if ((rect.x >= rect.z) || (rect.y >= rect.w))
+		{
+			return;
+		}
+
+		if ((rect.x == 0) && (rect.y == 0) &&
+			(rect.z >= image->get_width()) &&
+			(rect.w >= image->get_height()))
+		{
+			texture->update_image(image);
+
+			return;
+		}
+
+		offset = glm::uvec3(rect.x, rect.y, 0);
+		size.x = std::min(rect.z, image->get_width()) - rect.x;
+		size.y = std::min(rect.w, image->get_height()) - rect.y;
+		size.z = std::max(image->get_depth(), 1u);
+
+		texture->sub_texture(ImageUpdate(image, offset, size,
+			cmft_positive_x, 0));
 	}
 
 	void AbstractTerrain::update_blend_map(
-		const ImageConstSharedPtr &blend_image, const BitSet64 &layers)
+		const ImageConstSharedPtr &blend_image, const BitSet64 &layers,
+		const glm::uvec4 &rect)
 	{
 		glm::uvec3 offset, size;
 		Uint32 i, count;
@@ -244,9 +275,9 @@ namespace eternal_lands
 			BOOST_FOREACH(const MaterialSharedPtr &material,
 				m_clipmap_materials)
 			{
-				material->get_texture(
+				update_texture(material->get_texture(
 					ShaderSourceTerrain::get_blend_sampler(
-						0))->update_image(blend_image);
+						0)), blend_image, rect);
 			}
 
 			return;
@@ -43,7 +43,8 @@ namespace eternal_lands
 			virtual void do_update_geometry_maps(
 				const ImageConstSharedPtr &displacement_map,
 				const ImageConstSharedPtr &normal_tangent_map,
-				const ImageConstSharedPtr &dudv_map) = 0;
+				const ImageConstSharedPtr &dudv_map,
+				const glm::uvec4 &rect) = 0;
 			void set_albedo_maps(const StringVector &albedo_maps,
 				const BitSet64 &blend_size_textures,
 				const TextureCacheSharedPtr &texture_cache);
@@ -83,6 +84,21 @@ namespace eternal_lands
 				const TextureSharedPtr &texture,
 				const SamplerParameterType sampler);
 
+			/**
+			 * Updates the texels of the rect of the texture
+			 * with the texels of the image. The whole image is
+			 * used if the rect covers it, only the texels of the
+			 * rect are copied and uploaded else.
+			 * @param texture The texture to update.
+			 * @param image The image to use.
+			 * @param rect The min x, min y, max x and max y of
+			 * the texels to update, max is exclusive.
+			 */
+			static void update_texture(
+				const TextureSharedPtr &texture,
+				const ImageConstSharedPtr &image,
+				const glm::uvec4 &rect);
+
 			inline const GlobalVarsConstSharedPtr &get_global_vars()
 				const noexcept
 			{
@@ -126,14 +142,27 @@ namespace eternal_lands
 				const glm::vec3 &translation);
 			void set_blend_map(const ImageConstSharedPtr &blend_map,
 				const TextureCacheSharedPtr &texture_cache);
+
+			/**
+			 * Updates the geometry maps after they were changed.
+			 * @param rect The min x, min y, max x and max y of
+			 * the changed texels, max is exclusive.
+			 */
 			void update_geometry_maps(
 				const ImageConstSharedPtr &displacement_map,
 				const ImageConstSharedPtr &normal_tangent_map,
 				const ImageConstSharedPtr &dudv_map,
-				const glm::vec3 &translation);
+				const glm::vec3 &translation,
+				const glm::uvec4 &rect);
+
+			/**
+			 * Updates the blend map after it was changed.
+			 * @param rect The min x, min y, max x and max y of
+			 * the changed texels, max is exclusive.
+			 */
 			void update_blend_map(
 				const ImageConstSharedPtr &blend_map,
-				const BitSet64 &layers);
+				const BitSet64 &layers, const glm::uvec4 &rect);
 			void set_texture_maps(const StringVector &albedo_maps,
 				const StringVector &height_maps,
 				const StringVector &specular_maps,
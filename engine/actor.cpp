@@ -67,13 +67,16 @@ namespace eternal_lands
 
 	void Actor::init_enhanced_actor(
 		const FileSystemConstSharedPtr &file_system,
-		const GlobalVarsConstSharedPtr &global_vars)
+		const GlobalVarsConstSharedPtr &global_vars,
+		const JobSystemWeakPtr &job_system,
+		const ActorTextureCacheWeakPtr &actor_texture_cache)
 	{
 		assert(m_index_source.get() != nullptr);
 
 		m_actor_texture_builder =
 			boost::make_shared<ActorTextureBuilder>(file_system,
-				global_vars, get_name());
+				global_vars, job_system, actor_texture_cache,
+				get_name());
 
 		get_materials()[0]->set_texture(
 			m_actor_texture_builder->get_texture(), spt_effect_0);
@@ -87,6 +90,10 @@ namespace eternal_lands
 		m_actor_texture_builder->build_actor_images();
 		m_actor_texture_builder->build_actor_texture();
 
+		// the texture changes if it is shared with other actors
+		get_materials()[0]->set_texture(
+			m_actor_texture_builder->get_texture(), spt_effect_0);
+
 		get_materials()[0]->set_effect(
 			m_actor_texture_builder->get_effect());
 	}
@@ -65,7 +65,10 @@ namespace eternal_lands
 			void remove_mesh(const Uint32 id);
 			void init_enhanced_actor(
 				const FileSystemConstSharedPtr &file_system,
-				const GlobalVarsConstSharedPtr &global_vars);
+				const GlobalVarsConstSharedPtr &global_vars,
+				const JobSystemWeakPtr &job_system,
+				const ActorTextureCacheWeakPtr
+					&actor_texture_cache);
 			void set_parts(
 				const ActorPartTextureTypeStringMap &parts);
 
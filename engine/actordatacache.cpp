@@ -49,11 +49,15 @@ namespace eternal_lands
 		const MaterialDescriptionCacheWeakPtr
 			&material_description_cache,
 		const GlobalVarsConstSharedPtr &global_vars,
-		const FileSystemConstSharedPtr &file_system):
+		const FileSystemConstSharedPtr &file_system,
+		const JobSystemWeakPtr &job_system,
+		const ActorTextureCacheWeakPtr &actor_texture_cache):
 		m_mesh_builder(mesh_builder), m_material_cache(material_cache),
 		m_material_builder(material_builder),
 		m_material_description_cache(material_description_cache),
-		m_global_vars(global_vars), m_file_system(file_system)
+		m_global_vars(global_vars), m_file_system(file_system),
+		m_job_system(job_system),
+		m_actor_texture_cache(actor_texture_cache)
 	{
 		assert(!m_mesh_builder.expired());
 		assert(!m_material_cache.expired());
@@ -172,7 +176,8 @@ namespace eternal_lands
 				found->second.m_core_model));
 
 			result->init_enhanced_actor(get_file_system(),
-				get_global_vars());
+				get_global_vars(), get_job_system(),
+				get_actor_texture_cache());
 		}
 		else
 		{
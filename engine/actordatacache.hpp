@@ -44,6 +44,8 @@ namespace eternal_lands
 				m_material_description_cache;
 			const GlobalVarsConstSharedPtr m_global_vars;
 			const FileSystemConstSharedPtr m_file_system;
+			const JobSystemWeakPtr m_job_system;
+			const ActorTextureCacheWeakPtr m_actor_texture_cache;
 
 			inline MeshBuilderConstSharedPtr get_mesh_builder()
 				const noexcept
@@ -105,6 +107,18 @@ namespace eternal_lands
 				return m_file_system;
 			}
 
+			inline const JobSystemWeakPtr &get_job_system() const
+				noexcept
+			{
+				return m_job_system;
+			}
+
+			inline const ActorTextureCacheWeakPtr
+				&get_actor_texture_cache() const noexcept
+			{
+				return m_actor_texture_cache;
+			}
+
 		public:
 			/**
 			 * Default constructor.
@@ -116,7 +130,10 @@ namespace eternal_lands
 				const MaterialDescriptionCacheWeakPtr
 					&material_description_cache,
 				const GlobalVarsConstSharedPtr &global_vars,
-				const FileSystemConstSharedPtr &file_system);
+				const FileSystemConstSharedPtr &file_system,
+				const JobSystemWeakPtr &job_system,
+				const ActorTextureCacheWeakPtr
+					&actor_texture_cache);
 
 			/**
 			 * Default destructor.
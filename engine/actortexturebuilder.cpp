@@ -6,14 +6,20 @@
  ****************************************************************************/
 
 #include "actortexturebuilder.hpp"
+#include "actortexturecache.hpp"
 #include "image.hpp"
 #include "reader.hpp"
 #include "exceptions.hpp"
 #include "texture.hpp"
 #include "logging.hpp"
 #include "codec/codecmanager.hpp"
+#include "codec/dxt.hpp"
 #include "filesystem.hpp"
 #include "globalvars.hpp"
+#include "thread/jobsystem.hpp"
+#ifdef	USE_SSE2
+#include <emmintrin.h>
+#endif	/* USE_SSE2 */
 
 namespace eternal_lands
 {
@@ -294,6 +300,132 @@ namespace eternal_lands
 			return result;
 		}
 
+		/**
+		 * Reads a row of an uncompressed image as rgba8 pixels. Rows
+		 * of eight bit channels are copied, all other formats are
+		 * converted pixel by pixel. Missing channels are zero, a
+		 * missing alpha is one, as in Image::get_pixel().
+		 */
+		void get_rgba8_row(const ImageSharedPtr &image, const Uint32 y,
+			const Uint16 mipmap, const Uint32 width, Uint8* row)
+		{
+			const Uint8* source;
+			glm::vec4 value;
+			Uint32 x, i, count, stride;
+
+			count = image->get_channel_count();
+			stride = image->get_pixel_size() / 8;
+
+			if ((image->get_type() == GL_UNSIGNED_BYTE) &&
+				(stride == count))
+			{
+				source = static_cast<const Uint8*>(
+					image->get_pixel_data(0, y, 0, 0,
+						mipmap));
+
+				if (count == 4)
+				{
+					memcpy(row, source, width * 4);
+
+					return;
+				}
+
+				for (x = 0; x < width; ++x)
+				{
+					for (i = 0; i < 4; ++i)
+					{
+						row[x * 4 + i] = i < count ?
+							source[x * count + i] :
+							(i == 3 ? 255 : 0);
+					}
+				}
+
+				return;
+			}
+
+			for (x = 0; x < width; ++x)
+			{
+				value = glm::clamp(image->get_pixel(x, y, 0, 0,
+					mipmap), 0.0f, 1.0f) * 255.0f + 0.5f;
+
+				for (i = 0; i < 4; ++i)
+				{
+					row[x * 4 + i] = value[i];
+				}
+			}
+		}
+
+		/**
+		 * Blends two rows of rgba8 pixels, using the first channel
+		 * of the mask row as weight of the first row:
+		 * t0 * mask + t1 * (1 - mask), rounded to nearest.
+		 */
+		void blend_row(const Uint8* t0, const Uint8* t1,
+			const Uint8* mask, Uint8* dest, const Uint32 width)
+		{
+			Uint32 x, i, value;
+
+			x = 0;
+
+#ifdef	USE_SSE2
+			__m128i a, b, m, zero, lo, hi, half, max;
+
+			zero = _mm_setzero_si128();
+			half = _mm_set1_epi16(128);
+			max = _mm_set1_epi16(255);
+
+			for (; (x + 4) <= width; x += 4)
+			{
+				a = _mm_loadu_si128(reinterpret_cast<
+					const __m128i*>(t0 + x * 4));
+				b = _mm_loadu_si128(reinterpret_cast<
+					const __m128i*>(t1 + x * 4));
+				m = _mm_loadu_si128(reinterpret_cast<
+					const __m128i*>(mask + x * 4));
+
+				// the weight in all four bytes of the pixel
+				m = _mm_and_si128(m, _mm_set1_epi32(0xFF));
+				m = _mm_or_si128(m, _mm_slli_epi32(m, 8));
+				m = _mm_or_si128(m, _mm_slli_epi32(m, 16));
+
+				// a * m + b * (255 - m) fits into 16 bit, the
+				// division by 255 is done with shifts
+				lo = _mm_unpacklo_epi8(m, zero);
+				lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(
+					_mm_unpacklo_epi8(a, zero), lo),
+					_mm_mullo_epi16(_mm_unpacklo_epi8(b,
+						zero), _mm_sub_epi16(max, lo))),
+					half);
+				lo = _mm_srli_epi16(_mm_add_epi16(lo,
+					_mm_srli_epi16(lo, 8)), 8);
+
+				hi = _mm_unpackhi_epi8(m, zero);
+				hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(
+					_mm_unpackhi_epi8(a, zero), hi),
+					_mm_mullo_epi16(_mm_unpackhi_epi8(b,
+						zero), _mm_sub_epi16(max, hi))),
+					half);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi,
+					_mm_srli_epi16(hi, 8)), 8);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(
+					dest + x * 4), _mm_packus_epi16(lo, hi));
+			}
+#endif	/* USE_SSE2 */
+
+			for (; x < width; ++x)
+			{
+				for (i = 0; i < 4; ++i)
+				{
+					value = t0[x * 4 + i] * mask[x * 4] +
+						t1[x * 4 + i] *
+						(255 - mask[x * 4]) + 128;
+					dest[x * 4 + i] = (value +
+						(value >> 8)) >> 8;
+				}
+			}
+		}
+
 		void set_image_lines(const ImageSharedPtr &src_image,
 			const glm::uvec2 &size, const Uint16 scale,
 			const glm::uvec2 &offset, const Uint16 mipmap,
@@ -380,11 +512,10 @@ namespace eternal_lands
 			const glm::uvec2 &size, const Uint16 scale,
 			const glm::uvec2 &offset, const ImageSharedPtr &image,
 			const ImageCompressionTypeSet &compressions,
-			const bool sRGB)
+			const bool sRGB, JobSystem* job_system)
 		{
-			glm::vec4 temp;
 			ImageSharedPtr tmp;
-			Uint32 x, y, width, height;
+			Uint32 y, width, height;
 			Uint16 mipmap;
 
 			tmp = get_image(reader, size, scale, compressions,
@@ -437,9 +568,16 @@ namespace eternal_lands
 			if (TextureFormatUtil::get_compressed(
 				tmp->get_texture_format()))
 			{
-				tmp = get_image(reader, size, scale,
-					ImageCompressionTypeSet(), false, true,
-					mipmap);
+				if (job_system != nullptr)
+				{
+					tmp = tmp->decompress(false, false,
+						false, *job_system);
+				}
+				else
+				{
+					tmp = tmp->decompress(false, false,
+						false);
+				}
 			}
 
 			if ((tmp->get_texture_format() == tft_rgba8) ||
@@ -468,21 +606,20 @@ namespace eternal_lands
 				}
 			}
 
+			assert(image->get_pixel_size() == 32);
+			assert(!image->get_compressed());
+
 			width = size[0] * scale;
 			height = size[1] * scale;
 
 			for (y = 0; y < height; y++)
 			{
-				for (x = 0; x < width; x++)
-				{
-					temp = tmp->get_pixel(x, y, 0, 0,
-						mipmap);
-
-					image->set_pixel(
-						x + offset[0] * scale,
-						y + offset[1] * scale, 0, 0, 0,
-						temp);
-				}
+				get_rgba8_row(tmp, y, mipmap, width,
+					static_cast<Uint8*>(
+						image->get_pixel_data(
+							offset[0] * scale,
+							y + offset[1] * scale,
+							0, 0, 0)));
 			}
 		}
 
@@ -492,19 +629,19 @@ namespace eternal_lands
 			const glm::uvec2 &size, const Uint16 scale,
 			const glm::uvec2 &offset, const ImageSharedPtr &image,
 			const ImageCompressionTypeSet &compressions,
-			const bool sRGB)
+			const bool sRGB, JobSystem* job_system)
 		{
-			glm::vec4 t0, t1, value, temp;
 			ImageSharedPtr texture_image, base_image, mask_image;
-			float blend;
-			Uint32 x, y, width, height;
+			std::vector<Uint8> t0, t1, mask;
+			Uint32 y, width, height;
 			Uint16 texture_mipmap, base_mipmap, mask_mipmap;
 
 			if ((base_reader.get() == nullptr) ||
 				(mask_reader.get() == nullptr))
 			{
 				return set_image(texture_reader, size, scale,
-					offset, image, compressions, sRGB);
+					offset, image, compressions, sRGB,
+					job_system);
 			}
 
 			texture_image = get_image(texture_reader, size, scale,
@@ -522,26 +659,28 @@ namespace eternal_lands
 			width = size[0] * scale;
 			height = size[1] * scale;
 
+			assert(image->get_pixel_size() == 32);
+			assert(!image->get_compressed());
+
+			t0.resize(width * 4);
+			t1.resize(width * 4);
+			mask.resize(width * 4);
+
 			for (y = 0; y < height; y++)
 			{
-				for (x = 0; x < width; x++)
-				{
-					t0 = texture_image->get_pixel(x, y, 0,
-						0, texture_mipmap);
-					t1 = base_image->get_pixel(x, y, 0, 0,
-						base_mipmap);
-					value = mask_image->get_pixel(x, y, 0,
-						0, mask_mipmap);
-
-					blend = value.r;
-
-					temp = t0 * blend;
-					temp += t1 * (1.0f - blend);
-					image->set_pixel(
-						x + offset[0] * scale,
-						y + offset[1] * scale, 0, 0, 0,
-						temp);
-				}
+				get_rgba8_row(texture_image, y, texture_mipmap,
+					width, &t0[0]);
+				get_rgba8_row(base_image, y, base_mipmap, width,
+					&t1[0]);
+				get_rgba8_row(mask_image, y, mask_mipmap, width,
+					&mask[0]);
+
+				blend_row(&t0[0], &t1[0], &mask[0],
+					static_cast<Uint8*>(
+						image->get_pixel_data(
+							offset[0] * scale,
+							y + offset[1] * scale,
+							0, 0, 0)), width);
 			}
 		}
 
@@ -553,12 +692,35 @@ namespace eternal_lands
 		std::map<ActorPartTextureType, ReaderSharedPtr> parts;
 		glm::uvec3 size;
 		ImageCompressionTypeSet compressions;
+		ActorTextureCacheSharedPtr actor_texture_cache;
+		JobSystemSharedPtr job_system;
 		TextureFormatType texture_format;
 		bool compressed, sRGB;
 
 		LOG_DEBUG(lt_actor_texture, UTF8("Building actor '%1%' images "
 			"%2%"), get_name() % UTF8("started"));
 
+		actor_texture_cache = m_actor_texture_cache.lock();
+
+		if (actor_texture_cache.get() != nullptr)
+		{
+			// an actor with the same parts built it already
+			if (actor_texture_cache->find(get_key(), m_texture,
+				m_alphas))
+			{
+				m_image.reset();
+
+				LOG_DEBUG(lt_actor_texture, UTF8("Building "
+					"actor '%1%' images %2%"), get_name()
+					% UTF8("cached"));
+
+				return;
+			}
+
+			// the old texture can be used by other actors
+			create_texture();
+		}
+
 		end = m_parts.end();
 
 		for (it = m_parts.begin(); it != end; ++it)
@@ -711,13 +873,15 @@ namespace eternal_lands
 		m_image = boost::make_shared<Image>(m_name, false,
 			texture_format, size, 0, false);
 
+		job_system = m_job_system.lock();
+
 		if (parts[aptt_pants_tex].get() != nullptr)
 		{
 			set_image(parts[aptt_pants_tex], parts[aptt_legs_base],
 				parts[aptt_pants_mask],
 				actor_part_sizes[apt_pants], m_scale,
 				actor_part_offsets[apt_pants], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_boots_tex].get() != nullptr)
@@ -726,7 +890,7 @@ namespace eternal_lands
 				parts[aptt_boots_mask],
 				actor_part_sizes[apt_boots], m_scale,
 				actor_part_offsets[apt_boots], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_torso_tex].get() != nullptr)
@@ -735,7 +899,7 @@ namespace eternal_lands
 				parts[aptt_torso_mask],
 				actor_part_sizes[apt_torso], m_scale,
 				actor_part_offsets[apt_torso], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_arms_tex].get() != nullptr)
@@ -744,7 +908,7 @@ namespace eternal_lands
 				parts[aptt_arms_mask],
 				actor_part_sizes[apt_arms], m_scale,
 				actor_part_offsets[apt_arms], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_hands_tex].get() != nullptr)
@@ -754,7 +918,7 @@ namespace eternal_lands
 				parts[aptt_hands_mask],
 				actor_part_sizes[apt_hands], m_scale,
 				actor_part_offsets[apt_hands], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_head_tex].get() != nullptr)
@@ -763,7 +927,7 @@ namespace eternal_lands
 				parts[aptt_head_mask],
 				actor_part_sizes[apt_head], m_scale,
 				actor_part_offsets[apt_head], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_hair_tex].get() != nullptr)
@@ -771,7 +935,7 @@ namespace eternal_lands
 			set_image(parts[aptt_hair_tex],
 				actor_part_sizes[apt_hair], m_scale,
 				actor_part_offsets[apt_hair], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_weapon_tex].get() != nullptr)
@@ -779,7 +943,7 @@ namespace eternal_lands
 			set_image(parts[aptt_weapon_tex],
 				actor_part_sizes[apt_weapon], m_scale,
 				actor_part_offsets[apt_weapon], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_shield_tex].get() != nullptr)
@@ -787,7 +951,7 @@ namespace eternal_lands
 			set_image(parts[aptt_shield_tex],
 				actor_part_sizes[apt_shield], m_scale,
 				actor_part_offsets[apt_shield], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_helmet_tex].get() != nullptr)
@@ -795,7 +959,7 @@ namespace eternal_lands
 			set_image(parts[aptt_helmet_tex],
 				actor_part_sizes[apt_helmet], m_scale,
 				actor_part_offsets[apt_helmet], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_neck_tex].get() != nullptr)
@@ -803,7 +967,7 @@ namespace eternal_lands
 			set_image(parts[aptt_neck_tex],
 				actor_part_sizes[apt_neck], m_scale,
 				actor_part_offsets[apt_neck], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
 		}
 
 		if (parts[aptt_cape_tex].get() != nullptr)
@@ -811,24 +975,81 @@ namespace eternal_lands
 			set_image(parts[aptt_cape_tex],
 				actor_part_sizes[apt_cape], m_scale,
 				actor_part_offsets[apt_cape], m_image,
-				compressions, sRGB);
+				compressions, sRGB, job_system.get());
+		}
+
+		// built uncompressed, because not all parts are compressed
+		if (m_compression && !compressed)
+		{
+			compress_image(sRGB);
 		}
 
 		LOG_DEBUG(lt_actor_texture, UTF8("Building actor '%1%' images "
 			"%2%"), get_name() % UTF8("done"));
 	}
 
+	void ActorTextureBuilder::compress_image(const bool sRGB)
+	{
+		JobSystemSharedPtr job_system;
+		TextureFormatType texture_format;
+
+		if (get_uses_alpha())
+		{
+			texture_format = sRGB ? tft_srgb_a_dxt5 : tft_rgba_dxt5;
+		}
+		else
+		{
+			texture_format = sRGB ? tft_srgb_dxt1 : tft_rgb_dxt1;
+		}
+
+		job_system = m_job_system.lock();
+
+		if (job_system.get() != nullptr)
+		{
+			m_image = Dxt::compress(m_image, texture_format, true,
+				*job_system);
+		}
+		else
+		{
+			m_image = Dxt::compress(m_image, texture_format, true);
+		}
+	}
+
 	void ActorTextureBuilder::build_actor_texture()
 	{
+		ActorTextureCacheSharedPtr actor_texture_cache;
+
+		// texture from the cache or already built
+		if (m_image.get() == nullptr)
+		{
+			return;
+		}
+
 		LOG_DEBUG(lt_actor_texture, UTF8("Building actor '%1%' texture"
 			" %2%"), get_name() % UTF8("started"));
 
 		CHECK_GL_ERROR();
 
+		if (m_texture->get_format() != m_image->get_texture_format())
+		{
+			m_texture->change_format(m_image->get_texture_format());
+		}
+
 		m_texture->set_image(m_image);
 
 		CHECK_GL_ERROR_NAME(get_name());
 
+		// the texture has its own copy now
+		m_image.reset();
+
+		actor_texture_cache = m_actor_texture_cache.lock();
+
+		if (actor_texture_cache.get() != nullptr)
+		{
+			actor_texture_cache->add(get_key(), m_texture,
+				m_alphas);
+		}
+
 		LOG_DEBUG(lt_actor_texture, UTF8("Building actor '%1%' texture"
 			" %2%"), get_name() % UTF8("done"));
 	}
@@ -842,11 +1063,12 @@ namespace eternal_lands
 	ActorTextureBuilder::ActorTextureBuilder(
 		const FileSystemConstSharedPtr &file_system,
 		const GlobalVarsConstSharedPtr &global_vars,
+		const JobSystemWeakPtr &job_system,
+		const ActorTextureCacheWeakPtr &actor_texture_cache,
 		const String &name): m_name(name), m_file_system(file_system),
-		m_global_vars(global_vars)
+		m_global_vars(global_vars), m_job_system(job_system),
+		m_actor_texture_cache(actor_texture_cache)
 	{
-		TextureFormatType texture_format;
-
 		assert(m_file_system.get() != nullptr);
 		assert(m_global_vars.get() != nullptr);
 
@@ -855,6 +1077,13 @@ namespace eternal_lands
 		m_compression = m_global_vars->get_use_s3tc_for_actors();
 		m_alphas.reset();
 
+		create_texture();
+	}
+
+	void ActorTextureBuilder::create_texture()
+	{
+		TextureFormatType texture_format;
+
 		if (m_compression)
 		{
 			texture_format = tft_srgb_a_dxt5;
@@ -868,6 +1097,27 @@ namespace eternal_lands
 			m_size, 0, 0xFFFF, 0, texture_format, ttt_texture_2d);
 	}
 
+	String ActorTextureBuilder::get_key() const
+	{
+		ActorPartTextureTypeStringMap::const_iterator it, end;
+		StringStream str;
+
+		str << m_size << UTF8(" ") << m_compression;
+
+		end = m_parts.end();
+
+		for (it = m_parts.begin(); it != end; ++it)
+		{
+			if (it->second != String())
+			{
+				str << UTF8(" ") << it->first << UTF8(":")
+					<< it->second;
+			}
+		}
+
+		return String(str.str());
+	}
+
 	ActorTextureBuilder::~ActorTextureBuilder() noexcept
 	{
 	}
@@ -73,6 +73,8 @@ namespace eternal_lands
 			TextureSharedPtr m_texture;
 			const FileSystemConstSharedPtr m_file_system;
 			const GlobalVarsConstSharedPtr m_global_vars;
+			const JobSystemWeakPtr m_job_system;
+			const ActorTextureCacheWeakPtr m_actor_texture_cache;
 			Uint32 m_size;
 			Uint16 m_scale;
 			BitSet16 m_alphas;
@@ -90,10 +92,17 @@ namespace eternal_lands
 				return m_global_vars;
 			}
 
+			void compress_image(const bool sRGB);
+			void create_texture();
+			String get_key() const;
+
 		public:
 			ActorTextureBuilder(
 				const FileSystemConstSharedPtr &file_system,
 				const GlobalVarsConstSharedPtr &global_vars,
+				const JobSystemWeakPtr &job_system,
+				const ActorTextureCacheWeakPtr
+					&actor_texture_cache,
 				const String &name);
 			~ActorTextureBuilder() noexcept;
 			void set_parts(
@@ -0,0 +1,91 @@
+/****************************************************************************
+ *            actortexturecache.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "actortexturecache.hpp"
+#include "texture.hpp"
+
+namespace eternal_lands
+{
+
+	ActorTextureCache::ActorTextureCache(): m_hits(0), m_misses(0)
+	{
+	}
+
+	ActorTextureCache::~ActorTextureCache() noexcept
+	{
+	}
+
+	bool ActorTextureCache::find(const String &key,
+		TextureSharedPtr &texture, BitSet16 &alphas)
+	{
+		ActorTextureCacheMap::iterator found;
+
+		found = m_actor_texture_cache.find(key);
+
+		if (found != m_actor_texture_cache.end())
+		{
+			texture = found->second.m_texture.lock();
+
+			if (texture.get() != nullptr)
+			{
+				alphas = found->second.m_alphas;
+				m_hits++;
+
+				return true;
+			}
+
+			m_actor_texture_cache.erase(found);
+		}
+
+		m_misses++;
+
+		return false;
+	}
+
+	void ActorTextureCache::add(const String &key,
+		const TextureSharedPtr &texture, const BitSet16 alphas)
+	{
+		ActorTextureCacheItem item;
+
+		item.m_texture = texture;
+		item.m_alphas = alphas;
+
+		m_actor_texture_cache[key] = item;
+	}
+
+	Uint32 ActorTextureCache::trim()
+	{
+		ActorTextureCacheMap::iterator it;
+		Uint32 count;
+
+		count = 0;
+		it = m_actor_texture_cache.begin();
+
+		while (it != m_actor_texture_cache.end())
+		{
+			if (it->second.m_texture.expired())
+			{
+				it = m_actor_texture_cache.erase(it);
+				count++;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		return count;
+	}
+
+	String ActorTextureCache::get_statistics() const
+	{
+		return String(boost::str(boost::format(UTF8("%1% textures, "
+			"%2% hits, %3% misses")) % get_count() % get_hits() %
+			get_misses()));
+	}
+
+}
@@ -0,0 +1,124 @@
+/****************************************************************************
+ *            actortexturecache.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_e84d9722_fe01_48af_862e_66f577d4376f
+#define	UUID_e84d9722_fe01_48af_862e_66f577d4376f
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include <boost/unordered_map.hpp>
+
+/**
+ * @file
+ * @brief The @c class ActorTextureCache.
+ * This file contains the @c class ActorTextureCache.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief @c class for sharing built actor textures.
+	 *
+	 * Actors with the same parts use the same texture. The cache only
+	 * holds weak pointers, so a texture is freed when the last actor
+	 * using it is gone.
+	 */
+	class ActorTextureCache: public boost::noncopyable
+	{
+		private:
+			class ActorTextureCacheItem
+			{
+				public:
+					TextureWeakPtr m_texture;
+					BitSet16 m_alphas;
+
+			};
+
+			typedef boost::unordered_map<String,
+				ActorTextureCacheItem> ActorTextureCacheMap;
+
+			ActorTextureCacheMap m_actor_texture_cache;
+			Uint32 m_hits;
+			Uint32 m_misses;
+
+		public:
+			/**
+			 * Default constructor.
+			 */
+			ActorTextureCache();
+
+			/**
+			 * Default destructor.
+			 */
+			~ActorTextureCache() noexcept;
+
+			/**
+			 * @brief Looks up a texture.
+			 *
+			 * Looks up the texture built from the parts with the
+			 * given key, if it is still used by an actor.
+			 * @param key The key of the parts.
+			 * @param texture Returns the texture if found.
+			 * @param alphas Returns the parts that use alpha.
+			 * @return True if the texture was found.
+			 */
+			bool find(const String &key, TextureSharedPtr &texture,
+				BitSet16 &alphas);
+
+			/**
+			 * @brief Adds a texture.
+			 *
+			 * Adds the texture built from the parts with the given
+			 * key, replacing the old one.
+			 * @param key The key of the parts.
+			 * @param texture The texture.
+			 * @param alphas The parts that use alpha.
+			 */
+			void add(const String &key,
+				const TextureSharedPtr &texture,
+				const BitSet16 alphas);
+
+			/**
+			 * @brief Removes textures no longer used.
+			 *
+			 * Removes the entries of textures that no actor uses.
+			 * @return The number of removed entries.
+			 */
+			Uint32 trim();
+
+			inline Uint32 get_count() const noexcept
+			{
+				return m_actor_texture_cache.size();
+			}
+
+			inline Uint32 get_hits() const noexcept
+			{
+				return m_hits;
+			}
+
+			inline Uint32 get_misses() const noexcept
+			{
+				return m_misses;
+			}
+
+			/**
+			 * @brief Statistics of the cache.
+			 *
+			 * Returns the number of textures and the hit and miss
+			 * counters as one line of text.
+			 * @return The statistics.
+			 */
+			String get_statistics() const;
+
+	};
+
+}
+
+#endif	/* UUID_e84d9722_fe01_48af_862e_66f577d4376f */
@@ -0,0 +1,88 @@
+/****************************************************************************
+ *            cachefilewriter.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "cachefilewriter.hpp"
+#include "writer.hpp"
+#include "utf.hpp"
+#include <cstdio>
+#include <fstream>
+
+namespace eternal_lands
+{
+
+	CacheFileWriter::CacheFileWriter(const String &file_name):
+		m_file_name(file_name)
+	{
+		StringStream str;
+
+		str << utf8_to_string(file_name) << "." << SDL_ThreadID();
+		str << ".tmp";
+
+		m_tmp_name = str.str();
+
+		m_stream = boost::make_shared<std::ofstream>(
+			m_tmp_name.c_str(), std::ios::binary |
+			std::ios::out | std::ios::trunc);
+
+		if (m_stream->is_open())
+		{
+			m_writer = boost::make_shared<Writer>(m_stream,
+				file_name);
+		}
+	}
+
+	CacheFileWriter::~CacheFileWriter() noexcept
+	{
+		if (get_open())
+		{
+			m_writer.reset();
+			m_stream->close();
+
+			std::remove(m_tmp_name.c_str());
+		}
+	}
+
+	bool CacheFileWriter::commit()
+	{
+		std::string name;
+
+		if (!get_open())
+		{
+			return false;
+		}
+
+		m_writer.reset();
+		m_stream->close();
+
+		if (m_stream->fail())
+		{
+			std::remove(m_tmp_name.c_str());
+
+			return false;
+		}
+
+		name = utf8_to_string(get_file_name());
+
+		if (std::rename(m_tmp_name.c_str(), name.c_str()) == 0)
+		{
+			return true;
+		}
+
+		// not every platform replaces an existing file
+		std::remove(name.c_str());
+
+		if (std::rename(m_tmp_name.c_str(), name.c_str()) == 0)
+		{
+			return true;
+		}
+
+		std::remove(m_tmp_name.c_str());
+
+		return false;
+	}
+
+}
@@ -0,0 +1,92 @@
+/****************************************************************************
+ *            cachefilewriter.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_dfee9dad_6fcc_49b1_ae7e_e3abe10a5901
+#define	UUID_dfee9dad_6fcc_49b1_ae7e_e3abe10a5901
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+
+/**
+ * @file
+ * @brief The @c class CacheFileWriter.
+ * This file contains the @c class CacheFileWriter.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief @c class for writing disk cache files.
+	 *
+	 * Writes into a temporary file that commit() renames to the cache
+	 * file, so an incomplete cache file is never read. The same cache
+	 * file can be written by several threads at once, so the name of
+	 * the temporary file contains the thread id. The temporary file is
+	 * removed again if commit() is not called or fails.
+	 */
+	class CacheFileWriter: public boost::noncopyable
+	{
+		private:
+			boost::shared_ptr<std::ofstream> m_stream;
+			WriterSharedPtr m_writer;
+			const String m_file_name;
+			std::string m_tmp_name;
+
+		public:
+			/**
+			 * Default constructor, creates the temporary file.
+			 * @param file_name The name of the cache file.
+			 */
+			CacheFileWriter(const String &file_name);
+
+			/**
+			 * Default destructor, removes the temporary file if
+			 * it was not renamed.
+			 */
+			~CacheFileWriter() noexcept;
+
+			/**
+			 * Closes the temporary file and renames it to the
+			 * cache file.
+			 * @return True if the whole file was written and
+			 * renamed, else false.
+			 */
+			bool commit();
+
+			/**
+			 * @return True if the temporary file was created,
+			 * else false.
+			 */
+			inline bool get_open() const noexcept
+			{
+				return m_writer.get() != nullptr;
+			}
+
+			/**
+			 * @return The writer of the temporary file, only
+			 * valid if get_open() returns true.
+			 */
+			inline Writer &get_writer() noexcept
+			{
+				assert(get_open());
+
+				return *m_writer;
+			}
+
+			inline const String &get_file_name() const noexcept
+			{
+				return m_file_name;
+			}
+
+	};
+
+}
+
+#endif	/* UUID_dfee9dad_6fcc_49b1_ae7e_e3abe10a5901 */
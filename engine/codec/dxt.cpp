@@ -11,6 +11,12 @@
 #include "reader.hpp"
 #include "image.hpp"
 #include "dds.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
+#ifdef	USE_SSE2
+#include <emmintrin.h>
+#endif	/* USE_SSE2 */
 
 namespace eternal_lands
 {
@@ -18,449 +24,1232 @@ namespace eternal_lands
 	namespace
 	{
 
-		struct DXTColorBlock
+		/**
+		 * Packs the channels into an Uint32 that has the bytes in
+		 * the memory order r, g, b, a, so it can be stored as one
+		 * rgba8 pixel.
+		 */
+		inline Uint32 get_rgba8(const Uint32 r, const Uint32 g,
+			const Uint32 b, const Uint32 a)
 		{
-			Uint16Array2 m_colors;
-			Uint8Array4 m_indices;
-		};
+			Uint8Array4 bytes;
+			Uint32 result;
+
+			bytes[0] = r;
+			bytes[1] = g;
+			bytes[2] = b;
+			bytes[3] = a;
 
-		struct DXTExplicitAlphaBlock
+			memcpy(&result, bytes.data(), sizeof(result));
+
+			return result;
+		}
+
+		inline Uint32 get_u16(const Uint8* data)
 		{
-			Uint8Array8 m_alphas;
-		};
+			return data[0] | (data[1] << 8);
+		}
 
-		struct DXTInterpolatedAlphaBlock
+		inline Uint32 get_u32(const Uint8* data)
 		{
-			Uint8Array2 m_alphas;
-			Uint8Array6 m_indices;
-		};
+			return get_u16(data) | (get_u16(data + 2) << 16);
+		}
+
+		inline Uint64 get_u48(const Uint8* data)
+		{
+			return get_u32(data) | (static_cast<Uint64>(get_u16(
+				data + 4)) << 32);
+		}
+
+		/**
+		 * Builds the four colors of a dxt color block. The end
+		 * points are expanded to eight bits by bit replication and
+		 * the interpolated colors are rounded to the nearest value.
+		 */
+		void get_dxt_colors(const Uint8* block, const bool dxt1,
+			Uint32Array4 &colors)
+		{
+			Uint32 c0, c1, r0, g0, b0, r1, g1, b1;
+
+			c0 = get_u16(block);
+			c1 = get_u16(block + 2);
+
+			r0 = (c0 >> 11) & 0x1F;
+			g0 = (c0 >> 5) & 0x3F;
+			b0 = c0 & 0x1F;
+			r1 = (c1 >> 11) & 0x1F;
+			g1 = (c1 >> 5) & 0x3F;
+			b1 = c1 & 0x1F;
+
+			r0 = (r0 << 3) | (r0 >> 2);
+			g0 = (g0 << 2) | (g0 >> 4);
+			b0 = (b0 << 3) | (b0 >> 2);
+			r1 = (r1 << 3) | (r1 >> 2);
+			g1 = (g1 << 2) | (g1 >> 4);
+			b1 = (b1 << 3) | (b1 >> 2);
 
-		void unpack_dxt_color(const DXTColorBlock &block, const bool dxt1,
-			Vec4Array16 &values)
-		{
-			Vec4Array4 colors;
-			Uint32 i, j, index;
-
-			colors[0][0] = boost::numeric_cast<float>(
-				(block.m_colors[0] & 0xF800) >> 11);
-			colors[0][1] = boost::numeric_cast<float>(
-				(block.m_colors[0] & 0x07E0) >> 5);
-			colors[0][2] = boost::numeric_cast<float>(
-				block.m_colors[0] & 0x001F);
-			colors[0][3] = 1.0f;
-			colors[0] *= glm::vec4(1.0f / 31.0f, 1.0f / 63.0f, 1.0f / 31.0f, 1.0f);
-
-			colors[1][0] = boost::numeric_cast<float>(
-				(block.m_colors[1] & 0xF800) >> 11);
-			colors[1][1] = boost::numeric_cast<float>(
-				(block.m_colors[1] & 0x07E0) >> 5);
-			colors[1][2] = boost::numeric_cast<float>(
-				block.m_colors[1] & 0x001F);
-			colors[1][3] = 1.0f;
-			colors[1] *= glm::vec4(1.0f / 31.0f, 1.0f / 63.0f, 1.0f / 31.0f, 1.0f);
-
-			if (dxt1 && (block.m_colors[0] <= block.m_colors[1]))
-			{
-				// 1-bit alpha
-				// one intermediate colour, half way between the other two
-				colors[2] = (colors[0] + colors[1]) / 2.0f;
-				// transparent colour
-				colors[3] = glm::vec4(0.0f);
+			colors[0] = get_rgba8(r0, g0, b0, 255);
+			colors[1] = get_rgba8(r1, g1, b1, 255);
+
+			if (dxt1 && (c0 <= c1))
+			{
+				// 1-bit alpha, one color half way between the
+				// other two and transparent black
+				colors[2] = get_rgba8((r0 + r1 + 1) / 2,
+					(g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2,
+					255);
+				colors[3] = get_rgba8(0, 0, 0, 0);
+
+				return;
+			}
+
+			colors[2] = get_rgba8((2 * r0 + r1 + 1) / 3,
+				(2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3,
+				255);
+			colors[3] = get_rgba8((r0 + 2 * r1 + 1) / 3,
+				(g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3,
+				255);
+		}
+
+		/**
+		 * Builds the eight values of an interpolated alpha (dxt5,
+		 * rgtc) block, rounded to the nearest value. Signed values
+		 * are stored as two's complement bytes.
+		 */
+		void get_alphas(const Uint8* block, const bool sign,
+			Uint8Array8 &alphas)
+		{
+			Sint32 a0, a1, value, min, max;
+			Uint32 i;
+
+			if (sign)
+			{
+				// -128 is treated as -127
+				a0 = std::max(static_cast<Sint8>(block[0]),
+					static_cast<Sint8>(-127));
+				a1 = std::max(static_cast<Sint8>(block[1]),
+					static_cast<Sint8>(-127));
+				min = -127;
+				max = 127;
 			}
 			else
 			{
-				// first interpolated colour, 1/3 of the way along
-				colors[2] = (2.0f * colors[0] + colors[1]) / 3.0f;
-				// second interpolated colour, 2/3 of the way along
-				colors[3] = (colors[0] + 2.0f * colors[1]) / 3.0f;
+				a0 = block[0];
+				a1 = block[1];
+				min = 0;
+				max = 255;
 			}
 
-			// Process 4x4 block of texels
-			for (i = 0; i < 4; ++i)
+			alphas[0] = a0;
+			alphas[1] = a1;
+
+			if (a0 > a1)
 			{
-				for (j = 0; j < 4; ++j)
+				for (i = 0; i < 6; ++i)
 				{
-					// LSB come first
-					index = (block.m_indices[i] >> (j * 2)) & 0x3;
-
-					values[(i * 4) + j] = colors[index];
+					value = (6 - i) * a0 + (i + 1) * a1;
+					value += value < 0 ? -3 : 3;
+					alphas[i + 2] = value / 7;
 				}
+
+				return;
 			}
+
+			// 4 interpolated alphas, plus min and max
+			for (i = 0; i < 4; ++i)
+			{
+				value = (4 - i) * a0 + (i + 1) * a1;
+				value += value < 0 ? -2 : 2;
+				alphas[i + 2] = value / 5;
+			}
+
+			alphas[6] = min;
+			alphas[7] = max;
 		}
 
-		void unpack_dxt_alpha(const DXTExplicitAlphaBlock &block,
-			const Uint16 channel, Vec4Array16 &values)
+		/**
+		 * Writes the up to 4x4 rgba8 pixels of a color block.
+		 * @param block The 8 bytes of the color block.
+		 * @param dxt1 True for dxt1 blocks that can use 1-bit alpha.
+		 * @param dest The first pixel of the block.
+		 * @param pitch The size of a row of the image in bytes.
+		 * @param sx The number of pixels in a row, less than four
+		 * at the edge of the image.
+		 * @param sy The number of rows, less than four at the edge
+		 * of the image.
+		 */
+		void write_dxt_color_block(const Uint8* block, const bool dxt1,
+			Uint8* dest, const Uint32 pitch, const Uint32 sx,
+			const Uint32 sy)
 		{
-			float value;
-			Uint32 i, j, index;
+			Uint32Array4 colors;
+			Uint32 bx, by, indices;
 
-			index = 0;
+			get_dxt_colors(block, dxt1, colors);
 
-			for (i = 0; i < 8; ++i)
+			indices = get_u32(block + 4);
+
+#ifdef	USE_SSE2
+			if (sx == 4)
+			{
+				__m128i c0, c1, c2, c3, masks, ones, twos;
+				__m128i row, value;
+
+				c0 = _mm_set1_epi32(colors[0]);
+				c1 = _mm_set1_epi32(colors[1]);
+				c2 = _mm_set1_epi32(colors[2]);
+				c3 = _mm_set1_epi32(colors[3]);
+
+				// The two index bits of each pixel in a row
+				masks = _mm_set_epi32(0xC0, 0x30, 0x0C, 0x03);
+				ones = _mm_set_epi32(0x40, 0x10, 0x04, 0x01);
+				twos = _mm_set_epi32(0x80, 0x20, 0x08, 0x02);
+
+				for (by = 0; by < sy; ++by)
+				{
+					row = _mm_and_si128(_mm_set1_epi32(
+						indices >> (by * 8)), masks);
+
+					value = _mm_and_si128(c0,
+						_mm_cmpeq_epi32(row,
+							_mm_setzero_si128()));
+					value = _mm_or_si128(value,
+						_mm_and_si128(c1,
+							_mm_cmpeq_epi32(row,
+								ones)));
+					value = _mm_or_si128(value,
+						_mm_and_si128(c2,
+							_mm_cmpeq_epi32(row,
+								twos)));
+					value = _mm_or_si128(value,
+						_mm_and_si128(c3,
+							_mm_cmpeq_epi32(row,
+								masks)));
+
+					_mm_storeu_si128(reinterpret_cast<
+						__m128i*>(dest + by * pitch),
+						value);
+				}
+
+				return;
+			}
+#endif	/* USE_SSE2 */
+
+			for (by = 0; by < sy; ++by)
 			{
-				for (j = 0; j < 2; ++j)
+				for (bx = 0; bx < sx; ++bx)
 				{
-					value = boost::numeric_cast<float>(
-						(block.m_alphas[i] >> (j * 4)) & 0xF);
-					values[index][channel] = value / 15.0f;
-					index++;
+					// LSB come first
+					memcpy(dest + by * pitch + bx * 4,
+						&colors[(indices >>
+							(by * 8 + bx * 2)) &
+							0x3], 4);
 				}
 			}
 		}
 
-		void unpack_dxt_alpha(const DXTInterpolatedAlphaBlock &block,
-			const Uint16 channel, Vec4Array16 &values)
+		/**
+		 * Writes the alpha values of a dxt3 block, every fourth
+		 * byte starting at dest.
+		 */
+		void write_dxt_explicit_alpha_block(const Uint8* block,
+			Uint8* dest, const Uint32 pitch, const Uint32 sx,
+			const Uint32 sy)
 		{
-			FloatArray8 alphas;
-			Uint32 i, index, idx0, idx1;
-
-			alphas[0] = block.m_alphas[0];
-			alphas[1] = block.m_alphas[1];
+			Uint32 bx, by, row;
 
-			if (block.m_alphas[0] > block.m_alphas[1])
+			for (by = 0; by < sy; ++by)
 			{
-				for (i = 0; i < 6; ++i)
+				row = get_u16(block + by * 2);
+
+				for (bx = 0; bx < sx; ++bx)
 				{
-					alphas[i + 2] = (((6 - i) *
-						block.m_alphas[0]) +
-						((i + 1) * block.m_alphas[1]))
-						/ 7.0f;
+					dest[by * pitch + bx * 4] =
+						((row >> (bx * 4)) & 0xF) * 17;
 				}
 			}
-			else
+		}
+
+		/**
+		 * Writes the values of an interpolated alpha block to one
+		 * channel of the image.
+		 * @param block The 8 bytes of the alpha block.
+		 * @param sign True for signed rgtc blocks.
+		 * @param dest The channel of the first pixel of the block.
+		 * @param pitch The size of a row of the image in bytes.
+		 * @param stride The size of a pixel in bytes.
+		 * @param sx The number of pixels in a row.
+		 * @param sy The number of rows.
+		 */
+		void write_alpha_block(const Uint8* block, const bool sign,
+			Uint8* dest, const Uint32 pitch, const Uint32 stride,
+			const Uint32 sx, const Uint32 sy)
+		{
+			Uint8Array8 alphas;
+			Uint64 indices;
+			Uint32 bx, by;
+
+			get_alphas(block, sign, alphas);
+
+			indices = get_u48(block + 2);
+
+			for (by = 0; by < sy; ++by)
 			{
-				// 4 interpolated alphas, plus zero and one
-				// full range including extremes at [0] and [5]
-				// we want to fill in [1] through [4] at weights ranging
-				// from 1/5 to 4/5
-				for (i = 0; i < 4; ++i)
+				for (bx = 0; bx < sx; ++bx)
 				{
-					alphas[i + 2] = (((4 - i) *
-						block.m_alphas[0]) +
-						((i + 1) * block.m_alphas[1]))
-						/ 5.0f;
+					dest[by * pitch + bx * stride] =
+						alphas[(indices >> ((by * 4 +
+							bx) * 3)) & 0x7];
 				}
+			}
+		}
 
-				alphas[6] = 0.0f;
-				alphas[7] = 255.0f;
+		Uint32 get_block_size(const TextureFormatType format)
+		{
+			switch (format)
+			{
+				case tft_rgb_dxt1:
+				case tft_rgba_dxt1:
+				case tft_srgb_dxt1:
+				case tft_srgb_a_dxt1:
+				case tft_r_rgtc1:
+				case tft_signed_r_rgtc1:
+					return 8;
+				default:
+					return 16;
 			}
+		}
 
-			for (i = 0; i < 16; ++i)
+		/**
+		 * Decodes a block directly from the compressed data into
+		 * the image memory.
+		 * @param block The compressed block.
+		 * @param dest The first pixel of the block, at the channel
+		 * of the layer when merging layers.
+		 * @param pitch The size of a row of the image in bytes.
+		 * @param stride The size of a pixel in bytes.
+		 */
+		void uncompress_block(const Uint8* block,
+			const TextureFormatType format, Uint8* dest,
+			const Uint32 pitch, const Uint32 stride,
+			const Uint32 sx, const Uint32 sy)
+		{
+			switch (format)
+			{
+				case tft_rgb_dxt1:
+				case tft_rgba_dxt1:
+				case tft_srgb_dxt1:
+				case tft_srgb_a_dxt1:
+					write_dxt_color_block(block, true,
+						dest, pitch, sx, sy);
+					return;
+				case tft_rgba_dxt3:
+				case tft_srgb_a_dxt3:
+					write_dxt_color_block(block + 8, false,
+						dest, pitch, sx, sy);
+					write_dxt_explicit_alpha_block(block,
+						dest + 3, pitch, sx, sy);
+					return;
+				case tft_rgba_dxt5:
+				case tft_srgb_a_dxt5:
+					write_dxt_color_block(block + 8, false,
+						dest, pitch, sx, sy);
+					write_alpha_block(block, false,
+						dest + 3, pitch, 4, sx, sy);
+					return;
+				case tft_r_rgtc1:
+					write_alpha_block(block, false, dest,
+						pitch, stride, sx, sy);
+					return;
+				case tft_signed_r_rgtc1:
+					write_alpha_block(block, true, dest,
+						pitch, stride, sx, sy);
+					return;
+				case tft_rg_rgtc2:
+					write_alpha_block(block, false, dest,
+						pitch, stride, sx, sy);
+					write_alpha_block(block + 8, false,
+						dest + 1, pitch, stride, sx,
+						sy);
+					return;
+				case tft_signed_rg_rgtc2:
+					write_alpha_block(block, true, dest,
+						pitch, stride, sx, sy);
+					write_alpha_block(block + 8, true,
+						dest + 1, pitch, stride, sx,
+						sy);
+					return;
+				default:
+					EL_THROW_EXCEPTION(
+						InvalidParameterException()
+						<< errinfo_message(UTF8("Not a "
+							"block compressed "
+							"format"))
+						<< errinfo_string_value(
+							TextureFormatUtil::get_str(
+								format)));
+			}
+		}
+
+		/**
+		 * Number of 4x4 block rows uncompressed by one task.
+		 */
+		const Uint32 uncompress_block_rows = 32;
+
+		/**
+		 * Uncompresses the block rows [begin, end) of one face of
+		 * one mipmap level, counted over all slices. When merging
+		 * layers, two rg or four r layers are written into the
+		 * channels of one rgba slice.
+		 * @param source The first block of the face.
+		 */
+		void uncompress_rows(const Uint8* source, Image &image,
+			const TextureFormatType format, const Uint32 width,
+			const Uint32 height, const Uint16 face,
+			const Uint16 mipmap, const bool merge_layers,
+			const Uint32 begin, const Uint32 end)
+		{
+			Uint8* dest;
+			Uint32 i, x, y, z, rows, layers, channels, block_size;
+			Uint32 pitch, stride, sx, sy;
+
+			layers = 1;
+			channels = 0;
+
+			if (((format == tft_signed_rg_rgtc2) ||
+				(format == tft_rg_rgtc2)) && merge_layers)
 			{
-				idx0 = (i * 3) / 8;
-				idx1 = (i * 3) % 8;
-				index = (block.m_indices[idx0] >> idx1) & 0x07;
+				layers = 2;
+				channels = 2;
+			}
+
+			if (((format == tft_signed_r_rgtc1) ||
+				(format == tft_r_rgtc1)) && merge_layers)
+			{
+				layers = 4;
+				channels = 1;
+			}
+
+			block_size = get_block_size(format);
+			stride = image.get_pixel_size() / 8;
+			pitch = image.get_width(mipmap) * stride;
+			rows = (height + 3) / 4;
+
+			source += static_cast<Uint64>(begin) *
+				((width + 3) / 4) * block_size;
+
+			// slices are done individually, 4x4 blocks in x/y
+			for (i = begin; i < end; ++i)
+			{
+				z = i / rows;
+				y = (i % rows) * 4;
+
+				dest = static_cast<Uint8*>(
+					image.get_pixel_data(0, y, z / layers,
+						face, mipmap)) +
+					(z % layers) * channels;
 
-				if ((idx1 > 5) && (idx0 < 4))
+				sy = std::min(height - y,
+					static_cast<Uint32>(4));
+
+				for (x = 0; x < width; x += 4)
 				{
-					index |= (block.m_indices[idx0 + 1] << (8 - idx1)) & 0x07;
+					sx = std::min(width - x,
+						static_cast<Uint32>(4));
+
+					uncompress_block(source, format,
+						dest + x * stride, pitch,
+						stride, sx, sy);
+
+					source += block_size;
 				}
+			}
+		}
+
+		class UncompressTask: public AbstractThreadTask
+		{
+			private:
+				const Uint8* m_source;
+				Image &m_image;
+				const TextureFormatType m_format;
+				const Uint32 m_width;
+				const Uint32 m_height;
+				const Uint32 m_begin;
+				const Uint32 m_end;
+				const Uint16 m_face;
+				const Uint16 m_mipmap;
+				const bool m_merge_layers;
+
+			public:
+				UncompressTask(const Uint8* source,
+					Image &image,
+					const TextureFormatType format,
+					const Uint32 width,
+					const Uint32 height,
+					const Uint16 face, const Uint16 mipmap,
+					const bool merge_layers,
+					const Uint32 begin, const Uint32 end);
+				virtual ~UncompressTask() noexcept;
+				virtual void operator()();
 
-				values[i][channel] = alphas[index] / 255.0f;
+		};
+
+		UncompressTask::UncompressTask(const Uint8* source,
+			Image &image, const TextureFormatType format,
+			const Uint32 width, const Uint32 height,
+			const Uint16 face, const Uint16 mipmap,
+			const bool merge_layers, const Uint32 begin,
+			const Uint32 end): m_source(source), m_image(image),
+			m_format(format), m_width(width), m_height(height),
+			m_begin(begin), m_end(end), m_face(face),
+			m_mipmap(mipmap), m_merge_layers(merge_layers)
+		{
+		}
+
+		UncompressTask::~UncompressTask() noexcept
+		{
+		}
+
+		void UncompressTask::operator()()
+		{
+			uncompress_rows(m_source, m_image, m_format, m_width,
+				m_height, m_face, m_mipmap, m_merge_layers,
+				m_begin, m_end);
+		}
+
+		/**
+		 * Uncompresses one face of one mipmap level, in tasks of
+		 * the job system if there is one, else at once.
+		 * @param source The first block of the face.
+		 */
+		void uncompress_face(const Uint8* source, Image &image,
+			const TextureFormatType format, const Uint32 width,
+			const Uint32 height, const Uint32 depth,
+			const Uint16 face, const Uint16 mipmap,
+			const bool merge_layers, JobSystem* job_system,
+			TaskGroup &task_group)
+		{
+			std::auto_ptr<AbstractThreadTask> task;
+			Uint32 i, rows;
+
+			rows = ((height + 3) / 4) * depth;
+
+			if (job_system == nullptr)
+			{
+				uncompress_rows(source, image, format, width,
+					height, face, mipmap, merge_layers, 0,
+					rows);
+
+				return;
+			}
+
+			for (i = 0; i < rows; i += uncompress_block_rows)
+			{
+				task.reset(new UncompressTask(source, image,
+					format, width, height, face, mipmap,
+					merge_layers, i, std::min(i +
+						uncompress_block_rows, rows)));
+
+				job_system->add(task, task_group);
 			}
 		}
 
-		void unpack_dxt1(const DXTColorBlock &block, Vec4Array16 &values)
+		/**
+		 * The size of the compressed data of one face of one mipmap
+		 * level.
+		 */
+		Uint64 get_face_size(const TextureFormatType format,
+			const Uint32 width, const Uint32 height,
+			const Uint32 depth)
 		{
-			unpack_dxt_color(block, true, values);
+			return static_cast<Uint64>((width + 3) / 4) *
+				((height + 3) / 4) * depth *
+				get_block_size(format);
 		}
 
-		void unpack_dxt3(const DXTExplicitAlphaBlock &alpha_block,
-			const DXTColorBlock &color_block, Vec4Array16 &values)
+		ARRAY_NAME(float, 16, Float);
+		ARRAY_NAME(Uint8Array16, 4, Uint8Array16);
+
+		/**
+		 * Number of 4x4 block rows compressed by one task.
+		 */
+		const Uint32 compress_block_rows = 16;
+
+		inline void set_u16(Uint8* data, const Uint32 value)
 		{
-			unpack_dxt_color(color_block, false, values);
-			unpack_dxt_alpha(alpha_block, 3, values);
+			data[0] = value & 0xFF;
+			data[1] = (value >> 8) & 0xFF;
 		}
 
-		void unpack_dxt5(const DXTInterpolatedAlphaBlock &alpha_block,
-			const DXTColorBlock &color_block, Vec4Array16 &values)
+		inline void set_u32(Uint8* data, const Uint32 value)
 		{
-			unpack_dxt_color(color_block, false, values);
-			unpack_dxt_alpha(alpha_block, 3, values);
+			set_u16(data, value & 0xFFFF);
+			set_u16(data + 2, value >> 16);
 		}
 
-		void unpack_ati1(const DXTInterpolatedAlphaBlock &block,
-			Vec4Array16 &values)
+		inline Uint32 get_565(const float r, const float g,
+			const float b)
 		{
-			unpack_dxt_alpha(block, 0, values);
+			return (static_cast<Uint32>(r * 31.0f / 255.0f + 0.5f)
+				<< 11) |
+				(static_cast<Uint32>(g * 63.0f / 255.0f + 0.5f)
+				<< 5) |
+				static_cast<Uint32>(b * 31.0f / 255.0f + 0.5f);
 		}
 
-		void unpack_ati2(const DXTInterpolatedAlphaBlock &first_block,
-			const DXTInterpolatedAlphaBlock &second_block,
-			Vec4Array16 &values)
+		/**
+		 * Reads the up to 4x4 rgba8 pixels of a block, one array per
+		 * channel. The missing pixels at the edge of the image are
+		 * copies of the last row or column, so they don't change the
+		 * end points.
+		 */
+		void read_block(const Uint8* source, const Uint32 pitch,
+			const Uint32 sx, const Uint32 sy,
+			Uint8Array16Array4 &pixels)
 		{
-			unpack_dxt_alpha(first_block, 0, values);
-			unpack_dxt_alpha(second_block, 1, values);
+			const Uint8* pixel;
+			Uint32 x, y, i;
+
+			for (y = 0; y < 4; ++y)
+			{
+				for (x = 0; x < 4; ++x)
+				{
+					pixel = source + std::min(y, sy - 1) *
+						pitch + std::min(x, sx - 1) * 4;
+
+					for (i = 0; i < 4; ++i)
+					{
+						pixels[i][y * 4 + x] = pixel[i];
+					}
+				}
+			}
 		}
 
-		bool alpha_check_dxt1(const DXTColorBlock &block)
+		/**
+		 * Selects the nearest of the colors for each pixel. With
+		 * 1-bit alpha only the first three colors are used for the
+		 * opaque pixels and the transparent ones get the fourth.
+		 */
+		Uint32 get_color_indices(const FloatArray16 &r,
+			const FloatArray16 &g, const FloatArray16 &b,
+			const BitSet16 transparent, const Uint32Array4 &colors,
+			const Uint32 count)
 		{
-			Uint32 i, j, index;
+			Uint8Array4 color;
+			Uint32Array4 group_indices;
+			Uint32 i, j, k, indices;
+			FloatArray4 pr, pg, pb;
 
-			if (block.m_colors[0] <= block.m_colors[1])
+			for (i = 0; i < 4; ++i)
 			{
-				// Process 4x4 block of texels
-				for (i = 0; i < 4; ++i)
+				memcpy(color.data(), &colors[i], sizeof(colors[i]));
+
+				pr[i] = color[0];
+				pg[i] = color[1];
+				pb[i] = color[2];
+			}
+
+			indices = 0;
+
+			for (i = 0; i < 4; ++i)
+			{
+#ifdef	USE_SSE2
+				__m128 cr, cg, cb, dr, dg, db, best, dist;
+				__m128 less, index;
+
+				cr = _mm_loadu_ps(r.data() + i * 4);
+				cg = _mm_loadu_ps(g.data() + i * 4);
+				cb = _mm_loadu_ps(b.data() + i * 4);
+
+				best = _mm_set1_ps(
+					std::numeric_limits<float>::max());
+				index = _mm_setzero_ps();
+
+				// squared distances to all colors, four pixels
+				// at once, the first of equally near colors is
+				// kept
+				for (k = 0; k < count; ++k)
+				{
+					dr = _mm_sub_ps(cr, _mm_set1_ps(pr[k]));
+					dg = _mm_sub_ps(cg, _mm_set1_ps(pg[k]));
+					db = _mm_sub_ps(cb, _mm_set1_ps(pb[k]));
+
+					dist = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(dr, dr),
+						_mm_mul_ps(dg, dg)),
+						_mm_mul_ps(db, db));
+
+					less = _mm_cmplt_ps(dist, best);
+					best = _mm_min_ps(dist, best);
+					index = _mm_or_ps(_mm_and_ps(less,
+						_mm_set1_ps(k)),
+						_mm_andnot_ps(less, index));
+				}
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(
+					group_indices.data()),
+					_mm_cvtps_epi32(index));
+#else	/* USE_SSE2 */
+				float dr, dg, db, best, dist;
+
+				for (j = 0; j < 4; ++j)
 				{
-					for (j = 0; j < 4; ++j)
+					best = 0.0f;
+					group_indices[j] = 0;
+
+					for (k = 0; k < count; ++k)
 					{
-						// LSB come first
-						index = block.m_indices[i] >>
-							(j * 2) & 0x3;
+						dr = r[i * 4 + j] - pr[k];
+						dg = g[i * 4 + j] - pg[k];
+						db = b[i * 4 + j] - pb[k];
+
+						dist = dr * dr + dg * dg +
+							db * db;
 
-						if (index == 3)
+						if ((k == 0) || (dist < best))
 						{
-							return true;
+							best = dist;
+							group_indices[j] = k;
 						}
 					}
 				}
+#endif	/* USE_SSE2 */
+
+				for (j = 0; j < 4; ++j)
+				{
+					if (transparent[i * 4 + j])
+					{
+						group_indices[j] = 3;
+					}
+
+					indices |= group_indices[j] <<
+						((i * 4 + j) * 2);
+				}
 			}
 
-			return false;
+			return indices;
 		}
 
-		void read_colors_block(const ReaderSharedPtr &reader,
-			DXTColorBlock &colors)
+		/**
+		 * Compresses a dxt color block with a range fit: the end
+		 * points are the two pixels at the ends of the principal
+		 * axis of the colors, found by power iteration on their
+		 * covariance matrix.
+		 * @param pixels The pixels of the block.
+		 * @param dxt1 True for dxt1 blocks, that use three colors and
+		 * transparent black if the first end point is not greater
+		 * than the second one.
+		 * @param alpha True if pixels with alpha below 128 should be
+		 * transparent, only used for dxt1.
+		 * @param block The 8 bytes of the color block.
+		 */
+		void compress_color_block(const Uint8Array16Array4 &pixels,
+			const bool dxt1, const bool alpha, Uint8* block)
 		{
-			BOOST_FOREACH(Uint16 &value, colors.m_colors)
+			FloatArray16 r, g, b;
+			BitSet16 transparent;
+			glm::vec3 mean, axis, value;
+			glm::mat3 covariance;
+			Uint32 i, count, c0, c1, min_index, max_index;
+			Uint32Array4 colors;
+			float scale, dot, min_dot, max_dot;
+
+			mean = glm::vec3(0.0f);
+			count = 0;
+
+			for (i = 0; i < 16; ++i)
 			{
-				value = reader->read_u8();
-				value += reader->read_u8() * 256;
+				r[i] = pixels[0][i];
+				g[i] = pixels[1][i];
+				b[i] = pixels[2][i];
+
+				transparent[i] = dxt1 && alpha &&
+					(pixels[3][i] < 128);
+
+				if (!transparent[i])
+				{
+					mean += glm::vec3(r[i], g[i], b[i]);
+					count++;
+				}
 			}
 
-			BOOST_FOREACH(Uint8 &value, colors.m_indices)
+			if (count == 0)
 			{
-				value = reader->read_u8();
+				set_u16(block, 0);
+				set_u16(block + 2, 0);
+				set_u32(block + 4, 0xFFFFFFFF);
+
+				return;
 			}
-		}
 
-		void read_alphas_block(const ReaderSharedPtr &reader,
-			DXTInterpolatedAlphaBlock &alphas)
-		{
-			BOOST_FOREACH(Uint8 &value, alphas.m_alphas)
+			mean /= static_cast<float>(count);
+			covariance = glm::mat3(0.0f);
+
+			for (i = 0; i < 16; ++i)
 			{
-				value = reader->read_u8();
+				if (transparent[i])
+				{
+					continue;
+				}
+
+				value = glm::vec3(r[i], g[i], b[i]) - mean;
+
+				covariance += glm::outerProduct(value, value);
 			}
 
-			BOOST_FOREACH(Uint8 &value, alphas.m_indices)
+			// start with the column of the channel with the largest
+			// variance, the diagonal of the bounding box would be
+			// orthogonal to the axis of anti-correlated channels
+			axis = covariance[0];
+
+			if ((covariance[1][1] > covariance[0][0]) &&
+				(covariance[1][1] >= covariance[2][2]))
 			{
-				value = reader->read_u8();
+				axis = covariance[1];
 			}
-		}
 
-		void read_alphas_block(const ReaderSharedPtr &reader,
-			DXTExplicitAlphaBlock &alphas)
-		{
-			BOOST_FOREACH(Uint8 &value, alphas.m_alphas)
+			if ((covariance[2][2] > covariance[0][0]) &&
+				(covariance[2][2] > covariance[1][1]))
 			{
-				value = reader->read_u8();
+				axis = covariance[2];
 			}
-		}
 
-		void read_and_uncompress_dxt1_block(
-			const ReaderSharedPtr &reader, Vec4Array16 &values)
-		{
-			DXTColorBlock colors;
+			for (i = 0; i < 8; ++i)
+			{
+				value = covariance * axis;
+				scale = glm::max(glm::abs(value.x), glm::max(
+					glm::abs(value.y), glm::abs(value.z)));
+
+				if (scale <= 0.0f)
+				{
+					break;
+				}
 
-			read_colors_block(reader, colors);
+				axis = value / scale;
+			}
 
-			unpack_dxt1(colors, values);
-		}
+			min_index = 0;
+			max_index = 0;
+			min_dot = std::numeric_limits<float>::max();
+			max_dot = -std::numeric_limits<float>::max();
 
-		void read_and_uncompress_dxt3_block(
-			const ReaderSharedPtr &reader, Vec4Array16 &values)
-		{
-			DXTExplicitAlphaBlock alphas;
-			DXTColorBlock colors;
+			for (i = 0; i < 16; ++i)
+			{
+				if (transparent[i])
+				{
+					continue;
+				}
+
+				dot = glm::dot(glm::vec3(r[i], g[i], b[i]),
+					axis);
+
+				if (dot < min_dot)
+				{
+					min_dot = dot;
+					min_index = i;
+				}
 
-			read_alphas_block(reader, alphas);
-			read_colors_block(reader, colors);
+				if (dot > max_dot)
+				{
+					max_dot = dot;
+					max_index = i;
+				}
+			}
+
+			c0 = get_565(r[max_index], g[max_index], b[max_index]);
+			c1 = get_565(r[min_index], g[min_index], b[min_index]);
 
-			unpack_dxt3(alphas, colors, values);
+			if (count < 16)
+			{
+				// three colors and transparent black, the
+				// first end point must not be greater
+				if (c0 > c1)
+				{
+					std::swap(c0, c1);
+				}
+			}
+			else
+			{
+				if (c0 < c1)
+				{
+					std::swap(c0, c1);
+				}
+			}
+
+			set_u16(block, c0);
+			set_u16(block + 2, c1);
+
+			get_dxt_colors(block, dxt1, colors);
+
+			// a single color if the end points are the same
+			if (c0 == c1)
+			{
+				count = 1;
+			}
+			else
+			{
+				count = count < 16 ? 3 : 4;
+			}
+
+			set_u32(block + 4, get_color_indices(r, g, b,
+				transparent, colors, count));
 		}
 
-		void read_and_uncompress_dxt5_block(
-			const ReaderSharedPtr &reader, Vec4Array16 &values)
+		/**
+		 * Compresses an interpolated alpha block (dxt5) with the
+		 * minimum and maximum as end points, using the eight value
+		 * mode.
+		 */
+		void compress_alpha_block(const Uint8Array16 &alphas,
+			Uint8* block)
 		{
-			DXTInterpolatedAlphaBlock alphas;
-			DXTColorBlock colors;
+			Uint8Array16 indices;
+			Uint8Array8 values;
+			Uint64 bits;
+			Uint32 i, min, max;
+
+			min = *std::min_element(alphas.begin(), alphas.end());
+			max = *std::max_element(alphas.begin(), alphas.end());
+
+			block[0] = max;
+			block[1] = min;
+
+			if (min == max)
+			{
+				memset(block + 2, 0, 6);
+
+				return;
+			}
+
+			get_alphas(block, false, values);
+
+#ifdef	USE_SSE2
+			__m128i value, best, index, dist, less, alpha;
+
+			alpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+				alphas.data()));
+			best = _mm_set1_epi8(-1);
+			index = _mm_setzero_si128();
+
+			// absolute differences of all 16 pixels at once, the
+			// first of equally near values is kept
+			for (i = 0; i < 8; ++i)
+			{
+				value = _mm_set1_epi8(values[i]);
+				dist = _mm_or_si128(_mm_subs_epu8(alpha, value),
+					_mm_subs_epu8(value, alpha));
+				less = _mm_xor_si128(_mm_cmpeq_epi8(
+					_mm_max_epu8(dist, best), dist),
+					_mm_set1_epi8(-1));
+				best = _mm_min_epu8(dist, best);
+				index = _mm_or_si128(_mm_and_si128(less,
+					_mm_set1_epi8(i)),
+					_mm_andnot_si128(less, index));
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(
+				indices.data()), index);
+#else	/* USE_SSE2 */
+			Uint32 j, best, dist;
+
+			for (i = 0; i < 16; ++i)
+			{
+				best = 256;
+				indices[i] = 0;
+
+				for (j = 0; j < 8; ++j)
+				{
+					dist = std::abs(static_cast<Sint32>(
+						alphas[i]) - values[j]);
 
-			read_alphas_block(reader, alphas);
-			read_colors_block(reader, colors);
+					if (dist < best)
+					{
+						best = dist;
+						indices[i] = j;
+					}
+				}
+			}
+#endif	/* USE_SSE2 */
 
-			unpack_dxt5(alphas, colors, values);
+			bits = 0;
+
+			for (i = 0; i < 16; ++i)
+			{
+				bits |= static_cast<Uint64>(indices[i]) <<
+					(i * 3);
+			}
+
+			for (i = 0; i < 6; ++i)
+			{
+				block[i + 2] = (bits >> (i * 8)) & 0xFF;
+			}
 		}
 
-		void read_and_uncompress_ati1_block(
-			const ReaderSharedPtr &reader, Vec4Array16 &values)
+		void compress_block(const Uint8* source,
+			const TextureFormatType format, Uint8* block,
+			const Uint32 pitch, const Uint32 sx, const Uint32 sy)
 		{
-			DXTInterpolatedAlphaBlock alphas;
+			Uint8Array16Array4 pixels;
 
-			read_alphas_block(reader, alphas);
+			read_block(source, pitch, sx, sy, pixels);
 
-			unpack_ati1(alphas, values);
+			switch (format)
+			{
+				case tft_rgb_dxt1:
+				case tft_srgb_dxt1:
+					compress_color_block(pixels, true,
+						false, block);
+					return;
+				case tft_rgba_dxt1:
+				case tft_srgb_a_dxt1:
+					compress_color_block(pixels, true,
+						true, block);
+					return;
+				default:
+					compress_alpha_block(pixels[3], block);
+					compress_color_block(pixels, false,
+						false, block + 8);
+					return;
+			}
 		}
 
-		void read_and_uncompress_ati2_block(
-			const ReaderSharedPtr &reader, Vec4Array16 &values)
+		/**
+		 * Compresses the block rows [begin, end) of one mipmap level.
+		 */
+		void compress_rows(const Image &source, Image &dest,
+			const Uint16 mipmap, const Uint32 begin,
+			const Uint32 end)
 		{
-			DXTInterpolatedAlphaBlock first_block;
-			DXTInterpolatedAlphaBlock second_block;
+			const Uint8* pixels;
+			Uint8* block;
+			Uint32 x, y, width, height, pitch, block_size;
+
+			width = source.get_width(mipmap);
+			height = source.get_height(mipmap);
+			pitch = width * 4;
+			block_size = get_block_size(dest.get_texture_format());
 
-			read_alphas_block(reader, first_block);
-			read_alphas_block(reader, second_block);
+			for (y = begin; y < end; ++y)
+			{
+				pixels = static_cast<const Uint8*>(
+					source.get_pixel_data(0, y * 4, 0, 0,
+						mipmap));
+				block = static_cast<Uint8*>(
+					dest.get_block_data(0, y, 0, 0,
+						mipmap));
+
+				for (x = 0; x < width; x += 4)
+				{
+					compress_block(pixels + x * 4,
+						dest.get_texture_format(),
+						block, pitch,
+						std::min(width - x, 4u),
+						std::min(height - y * 4, 4u));
 
-			unpack_ati2(first_block, second_block, values);
+					block += block_size;
+				}
+			}
 		}
 
-		void merge_r_layers(const glm::vec4 &current_value,
-			const Uint16 layer, glm::vec4 &value)
+		class CompressTask: public AbstractThreadTask
 		{
-			float color;
+			private:
+				const Image &m_source;
+				Image &m_dest;
+				const Uint32 m_begin;
+				const Uint32 m_end;
+				const Uint16 m_mipmap;
+
+			public:
+				CompressTask(const Image &source, Image &dest,
+					const Uint16 mipmap, const Uint32 begin,
+					const Uint32 end);
+				virtual ~CompressTask() noexcept;
+				virtual void operator()();
 
-			color = value.r;
+		};
 
-			value = current_value;
+		CompressTask::CompressTask(const Image &source, Image &dest,
+			const Uint16 mipmap, const Uint32 begin,
+			const Uint32 end): m_source(source), m_dest(dest),
+			m_begin(begin), m_end(end), m_mipmap(mipmap)
+		{
+		}
 
-			value[layer] = color;
+		CompressTask::~CompressTask() noexcept
+		{
 		}
 
-		void merge_rg_layers(const glm::vec4 &current_value,
-			const Uint16 layer, glm::vec4 &value)
+		void CompressTask::operator()()
 		{
-			if (layer > 0)
+			compress_rows(m_source, m_dest, m_mipmap, m_begin,
+				m_end);
+		}
+
+		/**
+		 * Builds a mipmap level of a rgba8 image as the average of
+		 * 2x2 pixels of the level above.
+		 */
+		void build_mipmap(Image &image, const Uint16 mipmap)
+		{
+			const Uint8* source;
+			Uint8* dest;
+			Uint32 x, y, i, width, height, x0, x1, y0, y1;
+			Uint32 pitch;
+
+			width = image.get_width(mipmap - 1);
+			height = image.get_height(mipmap - 1);
+			pitch = width * 4;
+
+			source = static_cast<const Uint8*>(image.get_data(0,
+				mipmap - 1));
+
+			for (y = 0; y < image.get_height(mipmap); ++y)
 			{
-				value.r = current_value.r;
-				value.g = current_value.g;
+				y0 = std::min(y * 2, height - 1) * pitch;
+				y1 = std::min(y * 2 + 1, height - 1) * pitch;
+
+				dest = static_cast<Uint8*>(
+					image.get_pixel_data(0, y, 0, 0,
+						mipmap));
 
-				value.b = value.r;
-				value.a = value.g;
+				for (x = 0; x < image.get_width(mipmap); ++x)
+				{
+					x0 = std::min(x * 2, width - 1) * 4;
+					x1 = std::min(x * 2 + 1, width - 1) * 4;
+
+					for (i = 0; i < 4; ++i)
+					{
+						dest[x * 4 + i] = (source[y0 + x0 + i]
+							+ source[y0 + x1 + i] +
+							source[y1 + x0 + i] +
+							source[y1 + x1 + i] + 2)
+							/ 4;
+					}
+				}
 			}
 		}
 
-		void uncompress_block(const ReaderSharedPtr &reader,
-			const ImageSharedPtr &image,
-			const TextureFormatType format,
-			const Uint32 x, const Uint32 y, const Uint32 z,
-			const Uint16 face, const Uint16 mipmap,
-			const Uint32 width, const Uint32 height,
-			const Uint16 layer, const bool merge_layers)
+		ImageSharedPtr compress_image(const ImageConstSharedPtr &image,
+			const TextureFormatType texture_format,
+			const bool mipmaps, JobSystem* job_system)
 		{
-			Vec4Array16 values;
-			glm::vec4 value, current_value;
-			Uint32 bx, by, sx, sy;
+			ImageConstSharedPtr source;
+			ImageSharedPtr mipmapped, result;
+			std::auto_ptr<AbstractThreadTask> task;
+			TaskGroup task_group;
+			Uint32 i, j, rows, mipmap_count;
+
+			if (((image->get_texture_format() != tft_rgba8) &&
+				(image->get_texture_format() != tft_srgb8_a8))
+				|| image->get_cube_map() ||
+				(image->get_depth() > 1))
+			{
+				EL_THROW_EXCEPTION(InvalidParameterException()
+					<< errinfo_message(UTF8("Only 2d rgba8 "
+						"images can be compressed"))
+					<< errinfo_string_value(
+						TextureFormatUtil::get_str(
+							image->get_texture_format()))
+					<< boost::errinfo_file_name(
+						image->get_name()));
+			}
 
-			switch (format)
+			switch (texture_format)
 			{
 				case tft_rgb_dxt1:
 				case tft_rgba_dxt1:
 				case tft_srgb_dxt1:
 				case tft_srgb_a_dxt1:
-					read_and_uncompress_dxt1_block(reader,
-						values);
-					break;
-				case tft_rgba_dxt3:
-				case tft_srgb_a_dxt3:
-					read_and_uncompress_dxt3_block(reader,
-						values);
-					break;
 				case tft_rgba_dxt5:
 				case tft_srgb_a_dxt5:
-					read_and_uncompress_dxt5_block(reader,
-						values);
-					break;
-				case tft_r_rgtc1:
-				case tft_signed_r_rgtc1:
-					read_and_uncompress_ati1_block(reader,
-						values);
-					break;
-				case tft_rg_rgtc2:
-				case tft_signed_rg_rgtc2:
-					read_and_uncompress_ati2_block(reader,
-						values);
 					break;
 				default:
 					EL_THROW_EXCEPTION(
 						InvalidParameterException()
+						<< errinfo_message(UTF8("Only "
+							"dxt1 and dxt5 "
+							"supported"))
+						<< errinfo_string_value(
+							TextureFormatUtil::get_str(
+								texture_format))
 						<< boost::errinfo_file_name(
-							reader->get_name()));
+							image->get_name()));
 			}
 
-			sx = std::min(width - x, static_cast<Uint32>(4));
-			sy = std::min(height - y, static_cast<Uint32>(4));
+			mipmap_count = image->get_mipmap_count();
 
-			// write 4x4 block to uncompressed version
-			for (by = 0; by < sy; by++)
+			if (mipmaps)
 			{
-				for (bx = 0; bx < sx; bx++)
+				mipmap_count = 0;
+
+				while ((std::max(image->get_width(),
+					image->get_height()) >> mipmap_count)
+					> 1)
 				{
-					value = values[by * 4 + bx];
+					mipmap_count++;
+				}
+			}
 
-					current_value = image->get_pixel(x + bx,
-						y + by, z, face, mipmap);
+			source = image;
 
-					if (((format == tft_signed_r_rgtc1) ||
-						(format == tft_r_rgtc1)) &&
-						merge_layers)
-					{
-						merge_r_layers(current_value,
-							layer, value);
-					}
+			if (mipmap_count > image->get_mipmap_count())
+			{
+				mipmapped = boost::make_shared<Image>(
+					image->get_name(), false,
+					image->get_texture_format(),
+					image->get_size(), mipmap_count, false);
 
-					if (((format == tft_signed_rg_rgtc2) ||
-						(format == tft_rg_rgtc2)) &&
-						merge_layers)
+				for (i = 0; i <= mipmap_count; ++i)
+				{
+					if (i > image->get_mipmap_count())
 					{
-						merge_rg_layers(current_value,
-							layer, value);
+						build_mipmap(*mipmapped, i);
+
+						continue;
 					}
 
-					image->set_pixel(x + bx, y + by, z,
-						face, mipmap, value);
+					memcpy(mipmapped->get_pixel_data(0, 0,
+						0, 0, i), image->get_data(0, i),
+						image->get_mipmap_size(i));
 				}
-			}
-		}
 
-		void read_uncompress_face(const ReaderSharedPtr &reader,
-			const ImageSharedPtr &image,
-			const TextureFormatType format, const Uint32 width,
-			const Uint32 height, const Uint32 depth,
-			const Uint16 face, const Uint16 mipmap,
-			const bool merge_layers)
-		{
-			Uint32 x, y, z, layers;
+				source = mipmapped;
+			}
 
-			layers = 1;
+			result = boost::make_shared<Image>(image->get_name(),
+				false, texture_format, image->get_size(),
+				mipmap_count, false);
 
-			if (((format == tft_signed_rg_rgtc2) ||
-				(format == tft_rg_rgtc2)) && merge_layers)
+			for (i = 0; i <= mipmap_count; ++i)
 			{
-				layers = 2;
-			}
+				rows = (source->get_height(i) + 3) / 4;
 
-			if (((format == tft_signed_r_rgtc1) ||
-				(format == tft_r_rgtc1)) && merge_layers)
-			{
-				layers = 4;
-			}
+				if (job_system == nullptr)
+				{
+					compress_rows(*source, *result, i, 0,
+						rows);
 
-			// slices are done individually
-			for (z = 0; z < depth; z++)
-			{
-				// 4x4 blocks in x/y
-				for (y = 0; y < height; y += 4)
+					continue;
+				}
+
+				for (j = 0; j < rows; j += compress_block_rows)
 				{
-					for (x = 0; x < width; x += 4)
-					{
-						uncompress_block(reader, image,
-							format, x, y,
-							z / layers, face,
-							mipmap, width, height,
-							z % layers,
-							merge_layers);
-					}
+					task.reset(new CompressTask(*source,
+						*result, i, j, std::min(j +
+							compress_block_rows,
+							rows)));
+
+					job_system->add(task, task_group);
 				}
 			}
+
+			if (job_system != nullptr)
+			{
+				job_system->wait(task_group);
+			}
+
+			return result;
 		}
 
 		TextureFormatType get_uncompressed_texture_format(
@@ -543,77 +1332,155 @@ namespace eternal_lands
 			}
 		}
 
-	}
-
-	ImageSharedPtr Dxt::uncompress(const ReaderSharedPtr &reader,
-		const String &name, const glm::uvec3 &size,
-		const TextureFormatType texture_format, const Uint16 mipmaps,
-		const bool cube_map, const bool array, const bool rg_formats,
-		const bool sRGB, const bool merge_layers)
-	{
-		ImageSharedPtr image;
-		Uint32 width, height, depth, face_count, mipmap_count;
-		Uint32 i, j;
-		TextureFormatType uncompressed_format;
-		bool can_merge_layers;
-
-		LOG_DEBUG(lt_dds_image, UTF8("Uncompressing DDS file '%1%'."),
-			reader->get_name());
-
-		if ((size.x % 4) != 0)
+		ImageSharedPtr uncompress_image(const ReaderSharedPtr &reader,
+			const String &name, const glm::uvec3 &size,
+			const TextureFormatType texture_format,
+			const Uint16 mipmaps, const bool cube_map,
+			const bool array, const bool rg_formats,
+			const bool sRGB, const bool merge_layers,
+			JobSystem* job_system)
 		{
-			EL_THROW_EXCEPTION(InvalidParameterException()
-				<< boost::errinfo_file_name(
-					reader->get_name()));
-		}
+			ImageSharedPtr image;
+			const Uint8* source;
+			Uint64 data_size;
+			Uint32 width, height, depth, face_count, mipmap_count;
+			TaskGroup task_group;
+			Uint32 i, j;
+			TextureFormatType uncompressed_format;
+			bool can_merge_layers;
+
+			LOG_DEBUG(lt_dds_image, UTF8("Uncompressing DDS file "
+				"'%1%'."), reader->get_name());
+
+			if ((size.x % 4) != 0)
+			{
+				EL_THROW_EXCEPTION(InvalidParameterException()
+					<< boost::errinfo_file_name(
+						reader->get_name()));
+			}
 
-		if ((size.y % 4) != 0)
-		{
-			EL_THROW_EXCEPTION(InvalidParameterException()
-				<< boost::errinfo_file_name(
-					reader->get_name()));
-		}
+			if ((size.y % 4) != 0)
+			{
+				EL_THROW_EXCEPTION(InvalidParameterException()
+					<< boost::errinfo_file_name(
+						reader->get_name()));
+			}
 
-		uncompressed_format = get_uncompressed_texture_format(
-			reader->get_name(), texture_format, size.z,
-			rg_formats, sRGB, merge_layers, can_merge_layers);
+			uncompressed_format = get_uncompressed_texture_format(
+				reader->get_name(), texture_format, size.z,
+				rg_formats, sRGB, merge_layers,
+				can_merge_layers);
 
-		image = boost::make_shared<Image>(name, cube_map,
-			uncompressed_format, size, mipmaps, array);
+			image = boost::make_shared<Image>(name, cube_map,
+				uncompressed_format, size, mipmaps, array);
 
-		face_count = image->get_face_count();
-		mipmap_count = image->get_mipmap_count();
+			face_count = image->get_face_count();
+			mipmap_count = image->get_mipmap_count();
 
-		for (i = 0; i < face_count; ++i)
-		{
-			width = std::max(1u, image->get_width());
-			height = std::max(1u, image->get_height());
-			depth = std::max(1u, image->get_depth());
+			// check the size first, the blocks are read without
+			// checks
+			data_size = 0;
 
-			for (j = 0; j <= mipmap_count; ++j)
+			for (i = 0; i < face_count; ++i)
 			{
-				read_uncompress_face(reader, image,
-					texture_format, width, height, depth,
-					i, j, can_merge_layers);
+				width = std::max(1u, image->get_width());
+				height = std::max(1u, image->get_height());
+				depth = std::max(1u, image->get_depth());
 
-				if (width > 1)
+				for (j = 0; j <= mipmap_count; ++j)
 				{
-					width /= 2;
-				}
+					data_size += get_face_size(
+						texture_format, width, height,
+						depth);
 
-				if (height > 1)
-				{
-					height /= 2;
+					width = std::max(1u, width / 2);
+					height = std::max(1u, height / 2);
+					depth = std::max(1u, depth / 2);
 				}
+			}
+
+			if (!reader->check_size(data_size))
+			{
+				EL_THROW_EXCEPTION(ReadErrorException()
+					<< errinfo_message(UTF8("Compressed "
+						"data too small"))
+					<< errinfo_size(data_size)
+					<< boost::errinfo_file_name(
+						reader->get_name()));
+			}
 
-				if (depth > 1)
+			source = static_cast<const Uint8*>(
+				reader->get_buffer()->get_ptr()) +
+				reader->get_position();
+
+			for (i = 0; i < face_count; ++i)
+			{
+				width = std::max(1u, image->get_width());
+				height = std::max(1u, image->get_height());
+				depth = std::max(1u, image->get_depth());
+
+				for (j = 0; j <= mipmap_count; ++j)
 				{
-					depth /= 2;
+					uncompress_face(source, *image,
+						texture_format, width, height,
+						depth, i, j, can_merge_layers,
+						job_system, task_group);
+
+					source += get_face_size(texture_format,
+						width, height, depth);
+
+					width = std::max(1u, width / 2);
+					height = std::max(1u, height / 2);
+					depth = std::max(1u, depth / 2);
 				}
 			}
+
+			if (job_system != nullptr)
+			{
+				job_system->wait(task_group);
+			}
+
+			reader->skip(data_size);
+
+			return image;
 		}
 
-		return image;
+	}
+
+	ImageSharedPtr Dxt::uncompress(const ReaderSharedPtr &reader,
+		const String &name, const glm::uvec3 &size,
+		const TextureFormatType texture_format, const Uint16 mipmaps,
+		const bool cube_map, const bool array, const bool rg_formats,
+		const bool sRGB, const bool merge_layers)
+	{
+		return uncompress_image(reader, name, size, texture_format,
+			mipmaps, cube_map, array, rg_formats, sRGB,
+			merge_layers, nullptr);
+	}
+
+	ImageSharedPtr Dxt::uncompress(const ReaderSharedPtr &reader,
+		const String &name, const glm::uvec3 &size,
+		const TextureFormatType texture_format, const Uint16 mipmaps,
+		const bool cube_map, const bool array, const bool rg_formats,
+		const bool sRGB, const bool merge_layers, JobSystem &job_system)
+	{
+		return uncompress_image(reader, name, size, texture_format,
+			mipmaps, cube_map, array, rg_formats, sRGB,
+			merge_layers, &job_system);
+	}
+
+	ImageSharedPtr Dxt::compress(const ImageConstSharedPtr &image,
+		const TextureFormatType texture_format, const bool mipmaps)
+	{
+		return compress_image(image, texture_format, mipmaps, nullptr);
+	}
+
+	ImageSharedPtr Dxt::compress(const ImageConstSharedPtr &image,
+		const TextureFormatType texture_format, const bool mipmaps,
+		JobSystem &job_system)
+	{
+		return compress_image(image, texture_format, mipmaps,
+			&job_system);
 	}
 
 }
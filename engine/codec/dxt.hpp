@@ -50,6 +50,52 @@ namespace eternal_lands
 				const bool array, const bool rg_formats,
 				const bool sRGB, const bool merge_layers);
 
+			/**
+			 * Uncompresses the blocks like the other uncompress,
+			 * using the job system for rows of blocks.
+			 * @param job_system The job system to use.
+			 */
+			static ImageSharedPtr uncompress(
+				const ReaderSharedPtr &reader,
+				const String &name, const glm::uvec3 &size,
+				const TextureFormatType texture_format,
+				const Uint16 mipmaps, const bool cube_map,
+				const bool array, const bool rg_formats,
+				const bool sRGB, const bool merge_layers,
+				JobSystem &job_system);
+
+			/**
+			 * Compresses a 2d rgba8 image into dxt1 or dxt5 blocks.
+			 * The end points of each block are chosen by a range
+			 * fit along the principal axis of its colors.
+			 * @param image The rgba8 or srgb8_a8 image to compress.
+			 * @param texture_format The dxt1 or dxt5 format of the
+			 * returned image.
+			 * @param mipmaps True if the missing mipmaps down to
+			 * 1x1 should be built with a box filter, else only the
+			 * mipmaps of the image are used.
+			 */
+			static ImageSharedPtr compress(
+				const ImageConstSharedPtr &image,
+				const TextureFormatType texture_format,
+				const bool mipmaps);
+
+			/**
+			 * Compresses a 2d rgba8 image into dxt1 or dxt5 blocks,
+			 * using the job system for rows of blocks.
+			 * @param image The rgba8 or srgb8_a8 image to compress.
+			 * @param texture_format The dxt1 or dxt5 format of the
+			 * returned image.
+			 * @param mipmaps True if the missing mipmaps down to
+			 * 1x1 should be built with a box filter, else only the
+			 * mipmaps of the image are used.
+			 * @param job_system The job system to use.
+			 */
+			static ImageSharedPtr compress(
+				const ImageConstSharedPtr &image,
+				const TextureFormatType texture_format,
+				const bool mipmaps, JobSystem &job_system);
+
 	};
 
 }
@@ -7,15 +7,87 @@
 
 #include "cpurasterizer.hpp"
 #include "submesh.hpp"
+#include "meshdatatool.hpp"
+#include "vertexelement.hpp"
 #include "simd/simd.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
 
 namespace eternal_lands
 {
 
+	namespace
+	{
+
+		class RasterizeTileTask: public AbstractThreadTask
+		{
+			private:
+				CpuRasterizer &m_cpu_rasterizer;
+				const Uint32 m_index;
+
+			public:
+				RasterizeTileTask(CpuRasterizer &cpu_rasterizer,
+					const Uint32 index);
+				virtual ~RasterizeTileTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		RasterizeTileTask::RasterizeTileTask(
+			CpuRasterizer &cpu_rasterizer, const Uint32 index):
+			m_cpu_rasterizer(cpu_rasterizer), m_index(index)
+		{
+		}
+
+		RasterizeTileTask::~RasterizeTileTask() noexcept
+		{
+		}
+
+		void RasterizeTileTask::operator()()
+		{
+			m_cpu_rasterizer.rasterize_tile(m_index);
+		}
+
+		inline float get_edge(const glm::vec4 &v0, const glm::vec4 &v1,
+			const glm::vec2 &point) noexcept
+		{
+			return (v1.x - v0.x) * (point.y - v0.y) -
+				(v1.y - v0.y) * (point.x - v0.x);
+		}
+
+	}
+
 	CpuRasterizer::CpuRasterizer(const Uint32 width, const Uint32 height,
 		const float threshold, const bool use_simd): m_width(width),
-		m_height(height), m_threshold(threshold), m_use_simd(use_simd)
+		m_height(height), m_threshold(threshold), m_use_simd(use_simd),
+		m_occlusion(false)
 	{
+		Uint32 i, depth_width, depth_height;
+
+		m_depth_width = std::max((width + get_depth_buffer_scale() - 1)
+			/ get_depth_buffer_scale(), 1u);
+		m_depth_height = std::max((height + get_depth_buffer_scale() -
+			1) / get_depth_buffer_scale(), 1u);
+		m_depth_size = glm::vec2(m_depth_width, m_depth_height);
+
+		m_tiles_x = (m_depth_width + get_tile_size() - 1) /
+			get_tile_size();
+		m_tiles_y = (m_depth_height + get_tile_size() - 1) /
+			get_tile_size();
+
+		depth_width = m_tiles_x * get_tile_size();
+		depth_height = m_tiles_y * get_tile_size();
+
+		m_depth_levels.resize(get_depth_level_count());
+
+		for (i = 0; i < get_depth_level_count(); ++i)
+		{
+			m_depth_levels[i].resize((depth_width >> i) *
+				(depth_height >> i), 1.0f);
+		}
+
+		m_tile_bins.resize(m_tiles_x * m_tiles_y);
 	}
 
 	CpuRasterizer::~CpuRasterizer() noexcept
@@ -203,17 +275,40 @@ namespace eternal_lands
 
 		if (get_use_simd())
 		{
-			return SIMD::check_coverage_simple(
+			result = SIMD::check_coverage_simple(
 				glm::value_ptr(glm::transpose(matrix)),
 				min_max_boxes.get_ptr_at(0), count,
 				get_width(), get_height(), get_threshold());
 		}
+		else
+		{
+			for (i = 0; i < count; ++i)
+			{
+				value = min_max_boxes[i];
+
+				result[i] = check_visibility(matrix, 
+					glm::ivec4(value[0], value[1],
+						value[2], value[3]),
+					glm::ivec4(value[4], value[5],
+						value[6], value[7]));
+			}
+		}
+
+		if (!get_occlusion(projection_view_matrix))
+		{
+			return result;
+		}
 
 		for (i = 0; i < count; ++i)
 		{
+			if (!result[i])
+			{
+				continue;
+			}
+
 			value = min_max_boxes[i];
 
-			result[i] = check_visibility(matrix, 
+			result[i] = !check_occlusion(matrix,
 				glm::ivec4(value[0], value[1], value[2],
 					value[3]),
 				glm::ivec4(value[4], value[5], value[6],
@@ -233,6 +328,7 @@ namespace eternal_lands
 		Sint16Array8 value;
 		BitSet64 result;
 		Uint32 i, j, index, size, count;
+		bool occlusion;
 
 		matrix = glm::mat4x4(world_matrix);
 
@@ -249,6 +345,7 @@ namespace eternal_lands
 		matrix = projection_view_matrix * matrix;
 
 		size = std::min(sub_meshs.size(), result.size());
+		occlusion = get_occlusion(projection_view_matrix);
 
 		if (get_use_simd())
 		{
@@ -261,13 +358,38 @@ namespace eternal_lands
 
 				result[i] = true;
 
-				if (count > 0)
+				if (count == 0)
+				{
+					continue;
+				}
+
+				result[i] = SIMD::check_coverage(
+					glm::value_ptr(matrix),
+					min_max_boxes.get_ptr_at(index),
+					count, get_width(), get_height(),
+					get_threshold());
+
+				if (!result[i] || !occlusion)
+				{
+					continue;
+				}
+
+				result[i] = false;
+
+				for (j = 0; j < count; ++j)
 				{
-					result[i] = SIMD::check_coverage(
-						glm::value_ptr(matrix),
-						min_max_boxes.get_ptr_at(index),
-						count, get_width(),
-						get_height(), get_threshold());
+					value = min_max_boxes[index + j];
+
+					if (!check_occlusion(matrix,
+						glm::ivec4(value[0], value[1],
+							value[2], value[3]),
+						glm::ivec4(value[4], value[5],
+							value[6], value[7])))
+					{
+						result[i] = true;
+
+						break;
+					}
 				}
 			}
 
@@ -287,7 +409,16 @@ namespace eternal_lands
 			{
 				value = min_max_boxes[index + j];
 
-				if (check_visibility(matrix,
+				if (!check_visibility(matrix,
+					glm::ivec4(value[0], value[1],
+						value[2], value[3]),
+					glm::ivec4(value[4], value[5],
+						value[6], value[7])))
+				{
+					continue;
+				}
+
+				if (!occlusion || !check_occlusion(matrix,
 					glm::ivec4(value[0], value[1],
 						value[2], value[3]),
 					glm::ivec4(value[4], value[5],
@@ -303,4 +434,465 @@ namespace eternal_lands
 		return result;
 	}
 
+	bool CpuRasterizer::check_occlusion(const glm::mat4x4 &matrix,
+		const glm::ivec4 &min, const glm::ivec4 &max) const
+	{
+		glm::vec4 value;
+		glm::vec3 vmin, vmax, tmp;
+		glm::uvec4 rect;
+		float depth;
+		Uint32 i, x, y, level, width;
+
+		for (i = 0; i < 8; ++i)
+		{
+			value.x = (i & 1) ? max.x : min.x;
+			value.y = (i & 2) ? max.y : min.y;
+			value.z = (i & 4) ? max.z : min.z;
+			value.w = 1.0f;
+
+			value = matrix * value;
+
+			/**
+			 * Boxes crossing the near plane are never occluded.
+			 */
+			if ((value.w < epsilon) || (value.z < -value.w))
+			{
+				return false;
+			}
+
+			tmp = glm::vec3(value) / value.w;
+
+			if (i == 0)
+			{
+				vmin = tmp;
+				vmax = tmp;
+			}
+			else
+			{
+				vmin = glm::min(vmin, tmp);
+				vmax = glm::max(vmax, tmp);
+			}
+		}
+
+		depth = vmin.z * 0.5f + 0.5f;
+
+		vmin = glm::clamp(vmin * 0.5f + 0.5f, 0.0f, 1.0f);
+		vmax = glm::clamp(vmax * 0.5f + 0.5f, 0.0f, 1.0f);
+
+		rect.x = std::floor(vmin.x * m_depth_size.x);
+		rect.y = std::floor(vmin.y * m_depth_size.y);
+		rect.z = std::ceil(vmax.x * m_depth_size.x);
+		rect.w = std::ceil(vmax.y * m_depth_size.y);
+
+		if ((rect.x >= rect.z) || (rect.y >= rect.w))
+		{
+			return false;
+		}
+
+		/**
+		 * Use the first level where the box covers at most four
+		 * texels in each direction.
+		 */
+		level = 0;
+
+		while (((level + 1) < get_depth_level_count()) &&
+			((((rect.z - rect.x) >> level) > 4) ||
+			(((rect.w - rect.y) >> level) > 4)))
+		{
+			level++;
+		}
+
+		width = (m_tiles_x * get_tile_size()) >> level;
+
+		for (y = rect.y >> level; y <= ((rect.w - 1) >> level); ++y)
+		{
+			for (x = rect.x >> level; x <= ((rect.z - 1) >> level);
+				++x)
+			{
+				if (depth <= m_depth_levels[level][y * width +
+					x])
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void CpuRasterizer::build_occluder(const MeshDataTool &mesh_data_tool,
+		AlignedVec4Array &vertices, Uint32Vector &indices)
+	{
+		Uint32 i, count;
+
+		vertices.resize(0);
+		indices.clear();
+
+		switch (mesh_data_tool.get_primitive())
+		{
+			case pt_triangles:
+			case pt_triangle_strip:
+			case pt_triangle_fan:
+				break;
+			default:
+				return;
+		}
+
+		/**
+		 * Animated meshs don't stay at their bind pose.
+		 */
+		if (mesh_data_tool.get_has_semantic(vst_bone_weight) ||
+			mesh_data_tool.get_has_semantic(vst_morph_position))
+		{
+			return;
+		}
+
+		count = mesh_data_tool.get_vertex_count();
+
+		if ((count == 0) || (count > (get_max_occluder_triangles() *
+			3)))
+		{
+			return;
+		}
+
+		for (i = 0; i < mesh_data_tool.get_sub_meshs().size(); ++i)
+		{
+			mesh_data_tool.get_triangle_indices(i, indices, true);
+
+			if (indices.size() > (get_max_occluder_triangles() * 3))
+			{
+				indices.clear();
+
+				return;
+			}
+		}
+
+		if (indices.empty())
+		{
+			return;
+		}
+
+		vertices.resize(count);
+
+		for (i = 0; i < count; ++i)
+		{
+			vertices[i] = glm::vec4(glm::vec3(
+				mesh_data_tool.get_vertex_data(vst_position,
+					i)), 1.0f);
+		}
+	}
+
+	void CpuRasterizer::clear_occluders(
+		const glm::mat4x4 &projection_view_matrix)
+	{
+		m_occlusion_matrix = projection_view_matrix;
+		m_occluder_vertices.resize(0);
+		m_occluder_triangles.clear();
+		m_occlusion = false;
+
+		BOOST_FOREACH(Uint32Vector &bin, m_tile_bins)
+		{
+			bin.clear();
+		}
+	}
+
+	void CpuRasterizer::add_occluder(const glm::mat4x3 &world_matrix,
+		const AlignedVec4Array &vertices, const Uint32Vector &indices)
+	{
+		glm::mat4x4 matrix;
+		glm::vec4 value;
+		Uint32 i, offset, count, triangle;
+
+		if ((vertices.size() == 0) || (indices.size() < 3))
+		{
+			return;
+		}
+
+		matrix = m_occlusion_matrix * glm::mat4x4(world_matrix);
+
+		offset = m_occluder_vertices.size();
+		count = vertices.size();
+
+		if (m_occluder_vertices.capacity() < (offset + count))
+		{
+			m_occluder_vertices.reserve(std::max(offset + count,
+				static_cast<Uint32>(
+					m_occluder_vertices.capacity() * 2)));
+		}
+
+		m_occluder_vertices.resize(offset + count);
+
+		if (get_use_simd())
+		{
+			SIMD::transform(vertices.get_ptr(), count, matrix,
+				m_occluder_vertices.get_ptr_at(offset));
+		}
+		else
+		{
+			for (i = 0; i < count; ++i)
+			{
+				m_occluder_vertices[offset + i] = matrix *
+					glm::vec4(glm::vec3(vertices[i]),
+						1.0f);
+			}
+		}
+
+		for (i = 0; i < count; ++i)
+		{
+			value = m_occluder_vertices[offset + i];
+
+			/**
+			 * Vertices behind the near plane get a w of zero,
+			 * their triangles are not binned.
+			 */
+			if ((value.w < epsilon) || (value.z < -value.w))
+			{
+				value.w = 0.0f;
+			}
+			else
+			{
+				value.x = (value.x / value.w * 0.5f + 0.5f) *
+					m_depth_size.x;
+				value.y = (value.y / value.w * 0.5f + 0.5f) *
+					m_depth_size.y;
+				value.z = glm::clamp(value.z / value.w * 0.5f +
+					0.5f, 0.0f, 1.0f);
+			}
+
+			m_occluder_vertices[offset + i] = value;
+		}
+
+		triangle = m_occluder_triangles.size() / 3;
+		count = indices.size() / 3;
+
+		for (i = 0; i < (count * 3); ++i)
+		{
+			assert(indices[i] < vertices.size());
+
+			m_occluder_triangles.push_back(indices[i] + offset);
+		}
+
+		for (i = 0; i < count; ++i)
+		{
+			bin_triangle(triangle + i);
+		}
+	}
+
+	void CpuRasterizer::bin_triangle(const Uint32 index)
+	{
+		glm::vec4 v0, v1, v2;
+		glm::vec2 vmin, vmax;
+		Uint32 x, y, x0, y0, x1, y1;
+
+		v0 = m_occluder_vertices[m_occluder_triangles[index * 3 + 0]];
+		v1 = m_occluder_vertices[m_occluder_triangles[index * 3 + 1]];
+		v2 = m_occluder_vertices[m_occluder_triangles[index * 3 + 2]];
+
+		if ((v0.w == 0.0f) || (v1.w == 0.0f) || (v2.w == 0.0f))
+		{
+			return;
+		}
+
+		vmin = glm::min(glm::min(glm::vec2(v0), glm::vec2(v1)),
+			glm::vec2(v2));
+		vmax = glm::max(glm::max(glm::vec2(v0), glm::vec2(v1)),
+			glm::vec2(v2));
+
+		if ((vmax.x <= 0.0f) || (vmax.y <= 0.0f) ||
+			(vmin.x >= m_depth_size.x) ||
+			(vmin.y >= m_depth_size.y))
+		{
+			return;
+		}
+
+		vmin = glm::max(vmin, 0.0f);
+		vmax = glm::min(vmax, m_depth_size - 1.0f);
+
+		x0 = static_cast<Uint32>(vmin.x) / get_tile_size();
+		y0 = static_cast<Uint32>(vmin.y) / get_tile_size();
+		x1 = static_cast<Uint32>(vmax.x) / get_tile_size();
+		y1 = static_cast<Uint32>(vmax.y) / get_tile_size();
+
+		for (y = y0; y <= y1; ++y)
+		{
+			for (x = x0; x <= x1; ++x)
+			{
+				m_tile_bins[y * m_tiles_x + x].push_back(index);
+			}
+		}
+
+		m_occlusion = true;
+	}
+
+	void CpuRasterizer::rasterize_occluders(JobSystem* job_system)
+	{
+		std::auto_ptr<AbstractThreadTask> task;
+		TaskGroup task_group;
+		Uint32 i, count;
+
+		if (!m_occlusion)
+		{
+			return;
+		}
+
+		count = m_tile_bins.size();
+
+		if (job_system == nullptr)
+		{
+			for (i = 0; i < count; ++i)
+			{
+				rasterize_tile(i);
+			}
+
+			return;
+		}
+
+		for (i = 0; i < count; ++i)
+		{
+			task.reset(new RasterizeTileTask(*this, i));
+
+			job_system->add(task, task_group);
+		}
+
+		job_system->wait(task_group);
+	}
+
+	void CpuRasterizer::rasterize_tile(const Uint32 index)
+	{
+		glm::uvec4 rect;
+		float* dest;
+		const float* source;
+		Uint32 x, y, level, size, width, source_width;
+
+		rect.x = (index % m_tiles_x) * get_tile_size();
+		rect.y = (index / m_tiles_x) * get_tile_size();
+		rect.z = rect.x + get_tile_size();
+		rect.w = rect.y + get_tile_size();
+
+		width = m_tiles_x * get_tile_size();
+
+		for (y = rect.y; y < rect.w; ++y)
+		{
+			std::fill(m_depth_levels[0].begin() + y * width +
+				rect.x, m_depth_levels[0].begin() + y * width +
+				rect.z, 1.0f);
+		}
+
+		BOOST_FOREACH(const Uint32 triangle, m_tile_bins[index])
+		{
+			rasterize_triangle(triangle, rect);
+		}
+
+		for (level = 1; level < get_depth_level_count(); ++level)
+		{
+			size = get_tile_size() >> level;
+			source_width = width >> (level - 1);
+
+			for (y = 0; y < size; ++y)
+			{
+				source = &m_depth_levels[level - 1][
+					((rect.y >> (level - 1)) + y * 2) *
+					source_width + (rect.x >> (level - 1))];
+				dest = &m_depth_levels[level][
+					((rect.y >> level) + y) *
+					(width >> level) + (rect.x >> level)];
+
+				for (x = 0; x < size; ++x)
+				{
+					dest[x] = std::max(std::max(
+						source[x * 2],
+						source[x * 2 + 1]), std::max(
+						source[x * 2 + source_width],
+						source[x * 2 + source_width
+							+ 1]));
+				}
+			}
+		}
+	}
+
+	void CpuRasterizer::rasterize_triangle(const Uint32 index,
+		const glm::uvec4 &rect)
+	{
+		glm::vec4 v0, v1, v2;
+		glm::vec3 edge_a, edge_b, edge_c, row, edges, depths;
+		glm::vec2 vmin, vmax;
+		float* depth_buffer;
+		float area, depth;
+		Uint32 x, y, x0, y0, x1, y1, width;
+
+		v0 = m_occluder_vertices[m_occluder_triangles[index * 3 + 0]];
+		v1 = m_occluder_vertices[m_occluder_triangles[index * 3 + 1]];
+		v2 = m_occluder_vertices[m_occluder_triangles[index * 3 + 2]];
+
+		area = get_edge(v0, v1, glm::vec2(v2));
+
+		if (std::abs(area) < epsilon)
+		{
+			return;
+		}
+
+		/**
+		 * Both windings are rasterized, the depth test keeps the
+		 * nearest one.
+		 */
+		if (area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		vmin = glm::min(glm::min(glm::vec2(v0), glm::vec2(v1)),
+			glm::vec2(v2));
+		vmax = glm::max(glm::max(glm::vec2(v0), glm::vec2(v1)),
+			glm::vec2(v2));
+
+		vmin = glm::clamp(glm::floor(vmin), glm::vec2(rect.x, rect.y),
+			glm::vec2(rect.z, rect.w));
+		vmax = glm::clamp(glm::ceil(vmax), glm::vec2(rect.x, rect.y),
+			glm::vec2(rect.z, rect.w));
+
+		x0 = vmin.x;
+		y0 = vmin.y;
+		x1 = vmax.x;
+		y1 = vmax.y;
+
+		width = m_tiles_x * get_tile_size();
+		depth_buffer = &m_depth_levels[0][0];
+
+		/**
+		 * Edge functions a * x + b * y + c, positive inside the
+		 * triangle. They are evaluated for every pixel instead of
+		 * stepped, so an edge shared with a neighbouring triangle
+		 * gives exactly the negated values and no pixels between
+		 * the two are left out.
+		 */
+		edge_a = glm::vec3(v1.y - v2.y, v2.y - v0.y, v0.y - v1.y);
+		edge_b = glm::vec3(v2.x - v1.x, v0.x - v2.x, v1.x - v0.x);
+		edge_c = glm::vec3(v1.x * v2.y - v1.y * v2.x,
+			v2.x * v0.y - v2.y * v0.x, v0.x * v1.y - v0.y * v1.x);
+
+		depths = glm::vec3(v0.z, v1.z, v2.z) / area;
+
+		for (y = y0; y < y1; ++y)
+		{
+			row = edge_b * (y + 0.5f) + edge_c;
+
+			for (x = x0; x < x1; ++x)
+			{
+				edges = edge_a * (x + 0.5f) + row;
+
+				if ((edges.x < 0.0f) || (edges.y < 0.0f) ||
+					(edges.z < 0.0f))
+				{
+					continue;
+				}
+
+				depth = glm::dot(edges, depths);
+
+				depth_buffer[y * width + x] = std::min(
+					depth_buffer[y * width + x], depth);
+			}
+		}
+	}
+
 }
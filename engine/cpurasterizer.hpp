@@ -26,24 +26,75 @@ namespace eternal_lands
 	/**
 	 * @brief CPU rasterizer
 	 *
-	 * CPU rasterizer for occlusion and visibilty tests.
+	 * CPU rasterizer for occlusion and visibilty tests. Occluder meshs
+	 * are transformed into screen space and their triangles binned
+	 * into tiles. The tiles are rasterized in parallel into a depth
+	 * buffer with a reduced resolution. Every tile also builds the
+	 * levels of a depth hierarchy, where each texel stores the
+	 * farthest depth of the four texels of the level below. Min/max
+	 * boxes are occluded if their nearest depth is behind all texels
+	 * of the hierarchy they cover.
 	 */
 	class CpuRasterizer: public boost::noncopyable
 	{
 		private:
 			/**
-			 * Depth buffer for occlusion and visibility tests.
+			 * Depth hierarchy for occlusion tests, level zero is
+			 * the depth buffer.
 			 */
-			AlignedVec4Array m_depth_buffer;
+			std::vector<FloatVector> m_depth_levels;
+
+			/**
+			 * Screen space vertices of all occluders, x and y
+			 * in pixels, z the depth and w the clip space w.
+			 */
+			AlignedVec4Array m_occluder_vertices;
+
+			/**
+			 * Three indices into the occluder vertices for each
+			 * occluder triangle.
+			 */
+			Uint32Vector m_occluder_triangles;
+
+			/**
+			 * Indices of the occluder triangles overlapping each
+			 * tile.
+			 */
+			std::vector<Uint32Vector> m_tile_bins;
+			glm::mat4x4 m_occlusion_matrix;
+			glm::vec2 m_depth_size;
 			const Uint32 m_width;
 			const Uint32 m_height;
 			const float m_threshold;
+			Uint32 m_depth_width;
+			Uint32 m_depth_height;
+			Uint32 m_tiles_x;
+			Uint32 m_tiles_y;
 			const bool m_use_simd;
+			bool m_occlusion;
+
+			void bin_triangle(const Uint32 index);
+			void rasterize_triangle(const Uint32 index,
+				const glm::uvec4 &rect);
 
 		protected:
 			bool check_visibility(const glm::mat4x4 &matrix,
 				const glm::ivec4 &min, const glm::ivec4 &max)
 				const;
+			bool check_occlusion(const glm::mat4x4 &matrix,
+				const glm::ivec4 &min, const glm::ivec4 &max)
+				const;
+
+			/**
+			 * Returns true if occlusion tests are done for boxes
+			 * projected with the given matrix.
+			 */
+			inline bool get_occlusion(
+				const glm::mat4x4 &projection_view_matrix) const
+			{
+				return m_occlusion && (projection_view_matrix ==
+					m_occlusion_matrix);
+			}
 
 		public:
 			/**
@@ -65,6 +116,63 @@ namespace eternal_lands
 				const BoundingBox &bounding_box,
 				AlignedSint16Vec8Array &min_max_boxes);
 
+			/**
+			 * Builds the occluder of the mesh, the positions and
+			 * triangle indices of all sub meshs. Meshs with more
+			 * than get_max_occluder_triangles() triangles don't
+			 * get an occluder and the arrays are left empty.
+			 * @param mesh_data_tool The mesh data to use.
+			 * @param vertices The occluder vertices.
+			 * @param indices The occluder triangle indices.
+			 */
+			static void build_occluder(
+				const MeshDataTool &mesh_data_tool,
+				AlignedVec4Array &vertices,
+				Uint32Vector &indices);
+
+			/**
+			 * Removes all occluders and starts occluder
+			 * rasterization with the given matrix. Occlusion
+			 * tests are only done for boxes checked with the
+			 * same projection view matrix.
+			 * @param projection_view_matrix The matrix the
+			 * occluders are rasterized with.
+			 */
+			void clear_occluders(
+				const glm::mat4x4 &projection_view_matrix);
+
+			/**
+			 * Transforms the occluder into screen space and bins
+			 * its triangles into the tiles. Triangles crossing
+			 * the near plane are dropped.
+			 * @param world_matrix The world matrix of the
+			 * occluder.
+			 * @param vertices The occluder vertices.
+			 * @param indices The occluder triangle indices.
+			 */
+			void add_occluder(const glm::mat4x3 &world_matrix,
+				const AlignedVec4Array &vertices,
+				const Uint32Vector &indices);
+
+			/**
+			 * Rasterizes the binned occluder triangles into the
+			 * depth buffer and builds the depth hierarchy, using
+			 * one task for each tile.
+			 * @param job_system The job system that runs the
+			 * tasks, if nullptr the tiles are rasterized by the
+			 * calling thread.
+			 */
+			void rasterize_occluders(JobSystem* job_system);
+
+			/**
+			 * Rasterizes the binned occluder triangles of the
+			 * tile and builds its part of the depth hierarchy.
+			 * Different tiles can be rasterized at the same
+			 * time.
+			 * @param index The index of the tile.
+			 */
+			void rasterize_tile(const Uint32 index);
+
 			BitSet64 check_visibility(
 				const glm::mat4x4 &projection_view_matrix,
 				const glm::mat4x3 &world_matrix,
@@ -114,6 +222,68 @@ namespace eternal_lands
 				return 16.0f;
 			}
 
+			/**
+			 * Returns the number of occluder triangles binned
+			 * since the last clear_occluders().
+			 */
+			inline Uint32 get_occluder_triangle_count() const
+				noexcept
+			{
+				return m_occluder_triangles.size() / 3;
+			}
+
+			/**
+			 * Returns the number of tiles in x direction.
+			 */
+			inline Uint32 get_tiles_x() const noexcept
+			{
+				return m_tiles_x;
+			}
+
+			/**
+			 * Returns the number of tiles in y direction.
+			 */
+			inline Uint32 get_tiles_y() const noexcept
+			{
+				return m_tiles_y;
+			}
+
+			/**
+			 * Size of the tiles in depth buffer pixels.
+			 */
+			static inline Uint32 get_tile_size() noexcept
+			{
+				return 32;
+			}
+
+			/**
+			 * Number of levels of the depth hierarchy, the last
+			 * level has one texel per tile.
+			 */
+			static inline Uint32 get_depth_level_count() noexcept
+			{
+				return 6;
+			}
+
+			/**
+			 * The depth buffer has the size of the view divided
+			 * by this value.
+			 */
+			static inline Uint32 get_depth_buffer_scale() noexcept
+			{
+				return 4;
+			}
+
+			/**
+			 * Meshs with more triangles are not used as
+			 * occluders.
+			 */
+			static inline Uint32 get_max_occluder_triangles()
+				noexcept
+			{
+				return 1024;
+			}
+
 			/**
 			 * Using SIMD (SSE/SSE2) instruction for rastering.
 			 * @result Using SIMD (SSE/SSE2) instruction.
@@ -12,6 +12,9 @@
 #include "shader/samplerparameterutil.hpp"
 #include "logging.hpp"
 #include "shader/glslprogramcache.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
 
 namespace eternal_lands
 {
@@ -83,6 +86,84 @@ namespace eternal_lands
 			"\tgl_FragColor = gl_FragCoord.zzzz;\n"
 			"}\n"));
 
+		/**
+		 * Builds the shader source of one program of an effect. The
+		 * shader source builder is only read, so the tasks of all
+		 * effects can run at the same time.
+		 */
+		class BuildSourceTask: public AbstractThreadTask
+		{
+			private:
+				const ShaderSourceBuilderConstSharedPtr
+					m_shader_source_builder;
+				const EffectDescription &m_description;
+				ShaderTypeStringMap &m_program_description;
+				const ShaderBuildType m_shader_build;
+				const ShaderOutputType m_shader_output;
+				const Uint16 m_lights_count;
+
+			public:
+				BuildSourceTask(
+					const ShaderSourceBuilderConstSharedPtr
+						&shader_source_builder,
+					const EffectDescription &description,
+					const ShaderBuildType shader_build,
+					const ShaderOutputType shader_output,
+					const Uint16 lights_count,
+					ShaderTypeStringMap
+						&program_description);
+				virtual ~BuildSourceTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		BuildSourceTask::BuildSourceTask(
+			const ShaderSourceBuilderConstSharedPtr
+				&shader_source_builder,
+			const EffectDescription &description,
+			const ShaderBuildType shader_build,
+			const ShaderOutputType shader_output,
+			const Uint16 lights_count,
+			ShaderTypeStringMap &program_description):
+			m_shader_source_builder(shader_source_builder),
+			m_description(description),
+			m_program_description(program_description),
+			m_shader_build(shader_build),
+			m_shader_output(shader_output),
+			m_lights_count(lights_count)
+		{
+		}
+
+		BuildSourceTask::~BuildSourceTask() noexcept
+		{
+		}
+
+		void BuildSourceTask::operator()()
+		{
+			LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
+				m_shader_build % m_description.get_name());
+
+			try
+			{
+				m_shader_source_builder->build(m_description,
+					m_shader_build, m_shader_output,
+					m_lights_count, m_program_description);
+
+				return;
+			}
+			catch (boost::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+			catch (std::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+
+			/* An empty description marks the failed build */
+			m_program_description.clear();
+		}
+
 	}
 
 	Effect::Effect(const GlslProgramCacheWeakPtr &glsl_program_cache):
@@ -96,7 +177,7 @@ namespace eternal_lands
 
 	Effect::Effect(const GlslProgramCacheWeakPtr &glsl_program_cache,
 		const ShaderSourceBuilderConstWeakPtr &shader_source_builder,
-		const EffectDescription &description):
+		const EffectDescription &description, const bool load_now):
 		m_glsl_program_cache(glsl_program_cache),
 		m_shader_source_builder(shader_source_builder),
 		m_description(description), m_debug_shader(sbt_debug_uv)
@@ -104,125 +185,143 @@ namespace eternal_lands
 		assert(!m_glsl_program_cache.expired());
 		assert(!m_shader_source_builder.expired());
 
-		load();
+		if (load_now)
+		{
+			load();
+		}
 	}
 
 	Effect::~Effect() noexcept
 	{
 	}
 
-	void Effect::do_load()
+	void Effect::add_build_task(JobSystem* job_system,
+		TaskGroup &task_group, const EffectProgramType effect_program,
+		const ShaderBuildType shader_build,
+		const ShaderOutputType shader_output,
+		const Uint16 lights_count)
 	{
-		ShaderTypeStringMap program_description;
-		Uint16 fragment_lights_count, vertex_lights_count;
-		Uint16 lights_count;
-
-		m_programs[ept_default].reset();
-		m_programs[ept_shadow].reset();
-		m_programs[ept_depth].reset();
-		m_programs[ept_height_map].reset();
-
-		fragment_lights_count = get_shader_source_builder(
-			)->get_fragment_lights_count();
-		vertex_lights_count = get_shader_source_builder(
-			)->get_vertex_lights_count();
+		std::auto_ptr<AbstractThreadTask> task;
 
-		/* default shader */
-		lights_count = 0;
+		task.reset(new BuildSourceTask(get_shader_source_builder(),
+			get_description(), shader_build, shader_output,
+			lights_count, m_program_descriptions[effect_program]));
 
-		if (get_description().get_description() != edt_default)
+		if (job_system == nullptr)
 		{
-			LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-				sbt_screen_quad % m_description.get_name());
-
-			get_shader_source_builder()->build(m_description,
-				sbt_screen_quad,
-				get_description().get_output(), lights_count,
-				program_description);
-
-			m_programs[ept_default] = get_glsl_program_cache(
-				)->get_program(program_description);
+			(*task)();
 
-			m_programs[ept_depth] = get_glsl_program_cache(
-				)->get_program(program_description);
+			return;
+		}
 
-			m_programs[ept_shadow] = get_glsl_program_cache(
-				)->get_program(program_description);
+		job_system->add(task, task_group);
+	}
 
-			m_programs[ept_height_map] = get_glsl_program_cache(
-				)->get_program(program_description);
+	void Effect::build_sources(JobSystem* job_system,
+		TaskGroup &task_group)
+	{
+		Uint16 lights_count;
 
-			m_programs[ept_debug] = get_glsl_program_cache(
-				)->get_program(program_description);
+		BOOST_FOREACH(ShaderTypeStringMap &program_description,
+			m_program_descriptions)
+		{
+			program_description.clear();
+		}
 
+		if (m_shader_source_builder.expired())
+		{
 			return;
 		}
 
-		LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-			sbt_default % m_description.get_name());
+		if (get_description().get_description() != edt_default)
+		{
+			add_build_task(job_system, task_group, ept_default,
+				sbt_screen_quad, get_description().get_output(),
+				0);
 
-		lights_count = vertex_lights_count + fragment_lights_count;
+			return;
+		}
 
-		get_shader_source_builder()->build(m_description, sbt_default,
-			get_description().get_output(), lights_count,
-			program_description);
+		lights_count = get_shader_source_builder(
+			)->get_vertex_lights_count();
+		lights_count += get_shader_source_builder(
+			)->get_fragment_lights_count();
 
-		m_programs[ept_default] = get_glsl_program_cache()->get_program(
-			program_description);
+		/* default shader */
+		add_build_task(job_system, task_group, ept_default,
+			sbt_default, get_description().get_output(),
+			lights_count);
 
 		/* Depth shader */
-		LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-			sbt_depth % m_description.get_name());
-
-		get_shader_source_builder()->build(m_description, sbt_depth,
-			sot_float, 0, program_description);
-
-		m_programs[ept_depth] = get_glsl_program_cache()->get_program(
-			program_description);
+		add_build_task(job_system, task_group, ept_depth, sbt_depth,
+			sot_float, 0);
 
 		/* Height map shader */
-		LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-			sbt_depth % m_description.get_name());
-
-		get_shader_source_builder()->build(m_description,
-			sbt_height_map, sot_float, 0, program_description);
-
-		m_programs[ept_height_map] = get_glsl_program_cache(
-			)->get_program(program_description);
+		add_build_task(job_system, task_group, ept_height_map,
+			sbt_height_map, sot_float, 0);
 
 		/* Glow shader */
-		LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-			sbt_depth % m_description.get_name());
+		add_build_task(job_system, task_group, ept_glow, sbt_default,
+			get_description().get_output(), 0);
 
-		get_shader_source_builder()->build(m_description,
-			sbt_default, get_description().get_output(), 0,
-			program_description);
+		/* Shadow shader */
+		add_build_task(job_system, task_group, ept_shadow, sbt_shadow,
+			sot_float, 0);
 
-		m_programs[ept_glow] = get_glsl_program_cache(
-			)->get_program(program_description);
+		/* debug shader */
+		add_build_task(job_system, task_group, ept_debug,
+			get_debug_shader(), sot_float, lights_count);
+	}
 
-		/* Shadow shader */
-		LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-			sbt_shadow % m_description.get_name());
+	void Effect::do_load()
+	{
+		Uint32 i, count;
+
+		m_programs[ept_default].reset();
+		m_programs[ept_shadow].reset();
+		m_programs[ept_depth].reset();
+		m_programs[ept_height_map].reset();
 
-		get_shader_source_builder()->build(m_description, sbt_shadow,
-			sot_float, 0, program_description);
+		if (get_description().get_description() != edt_default)
+		{
+			count = 1;
+		}
+		else
+		{
+			count = m_program_descriptions.size();
+		}
 
-		m_programs[ept_shadow] = get_glsl_program_cache()->get_program(
-			program_description);
+		for (i = 0; i < count; ++i)
+		{
+			if (m_program_descriptions[i].empty())
+			{
+				EL_THROW_EXCEPTION(InternalErrorException()
+					<< errinfo_message(UTF8("Building "
+						"shader source failed"))
+					<< errinfo_name(
+						get_description().get_name()));
+			}
+		}
 
-		/* debug shader */
-		LOG_DEBUG(lt_shader_source, UTF8("%1% effect '%2%'"),
-			get_debug_shader() % m_description.get_name());
+		if (get_description().get_description() != edt_default)
+		{
+			m_programs[ept_default] = get_glsl_program_cache(
+				)->get_program(m_program_descriptions[
+					ept_default]);
 
-		lights_count = vertex_lights_count + fragment_lights_count;
+			m_programs[ept_depth] = m_programs[ept_default];
+			m_programs[ept_shadow] = m_programs[ept_default];
+			m_programs[ept_height_map] = m_programs[ept_default];
+			m_programs[ept_debug] = m_programs[ept_default];
 
-		get_shader_source_builder()->build(m_description,
-			get_debug_shader(), sot_float, lights_count,
-			program_description);
+			return;
+		}
 
-		m_programs[ept_debug] = get_glsl_program_cache()->get_program(
-			program_description);
+		for (i = 0; i < count; ++i)
+		{
+			m_programs[i] = get_glsl_program_cache()->get_program(
+				m_program_descriptions[i]);
+		}
 	}
 
 	void Effect::error_load()
@@ -260,6 +359,14 @@ namespace eternal_lands
 	}
 
 	void Effect::load()
+	{
+		TaskGroup task_group;
+
+		build_sources(nullptr, task_group);
+		load_programs();
+	}
+
+	void Effect::load_programs()
 	{
 		try
 		{
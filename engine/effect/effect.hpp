@@ -33,10 +33,18 @@ namespace eternal_lands
 				m_shader_source_builder;
 			const EffectDescription m_description;
 			boost::array<GlslProgramSharedPtr, 6> m_programs;
+			boost::array<ShaderTypeStringMap, 6>
+				m_program_descriptions;
 			ShaderBuildType m_debug_shader;
 
 			void error_load();
 			void do_load();
+			void add_build_task(JobSystem* job_system,
+				TaskGroup &task_group,
+				const EffectProgramType effect_program,
+				const ShaderBuildType shader_build,
+				const ShaderOutputType shader_output,
+				const Uint16 lights_count);
 
 			inline GlslProgramCacheSharedPtr
 				get_glsl_program_cache() const noexcept
@@ -65,13 +73,38 @@ namespace eternal_lands
 		public:
 			Effect(const GlslProgramCacheWeakPtr
 				&glsl_program_cache);
+			/**
+			 * @param load_now If false, the effect is not usable
+			 * before build_sources and load_programs are called.
+			 */
 			Effect(const GlslProgramCacheWeakPtr
 					&glsl_program_cache,
 				const ShaderSourceBuilderConstWeakPtr
 					&shader_source_builder,
-				const EffectDescription &description);
+				const EffectDescription &description,
+				const bool load_now);
 			~Effect() noexcept;
 			void load();
+
+			/**
+			 * Builds the shader sources of all programs. The
+			 * sources are generated by tasks of the job system,
+			 * or at once when there is no job system. Don't use
+			 * the effect until the task group is done.
+			 * @param job_system The job system to use, can be
+			 * nullptr.
+			 * @param task_group The task group to add the tasks
+			 * to.
+			 */
+			void build_sources(JobSystem* job_system,
+				TaskGroup &task_group);
+
+			/**
+			 * Creates the programs from the shader sources built
+			 * by build_sources. Must be called from the thread
+			 * with the OpenGL context, after the tasks are done.
+			 */
+			void load_programs();
 			bool get_simple_shadow() const;
 
 			inline void set_debug_shader(
@@ -13,16 +13,19 @@
 #include "xmlwriter.hpp"
 #include "logging.hpp"
 #include "filesystem.hpp"
-#include "logging.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
 
 namespace eternal_lands
 {
 
 	EffectCache::EffectCache(const GlslProgramCacheWeakPtr
 			&glsl_program_cache,
-		const ShaderSourceBuilderConstWeakPtr &shader_source_builder):
+		const ShaderSourceBuilderConstWeakPtr &shader_source_builder,
+		const JobSystemWeakPtr &job_system):
 		m_glsl_program_cache(glsl_program_cache),
-		m_shader_source_builder(shader_source_builder)
+		m_shader_source_builder(shader_source_builder),
+		m_job_system(job_system)
 	{
 		assert(!m_glsl_program_cache.expired());
 		assert(!m_shader_source_builder.expired());
@@ -64,16 +67,47 @@ namespace eternal_lands
 		return m_simple_effect;
 	}
 
+	void EffectCache::build_sources(const EffectSharedPtrVector &effects)
+	{
+		JobSystemSharedPtr job_system;
+		TaskGroup task_group;
+
+		job_system = get_job_system().lock();
+
+		BOOST_FOREACH(const EffectSharedPtr &effect, effects)
+		{
+			effect->build_sources(job_system.get(), task_group);
+		}
+
+		if (job_system.get() != nullptr)
+		{
+			job_system->wait(task_group);
+		}
+	}
+
+	void EffectCache::load_effects(const EffectSharedPtrVector &effects)
+	{
+		build_sources(effects);
+
+		BOOST_FOREACH(const EffectSharedPtr &effect, effects)
+		{
+			effect->load_programs();
+		}
+	}
+
 	void EffectCache::reload()
 	{
 		EffectCacheMap::iterator it, end;
+		EffectSharedPtrVector effects;
 
 		end = m_effect_cache.end();
 
 		for (it = m_effect_cache.begin(); it != end; ++it)
 		{
-			it->second->load();
+			effects.push_back(it->second);
 		}
+
+		load_effects(effects);
 	}
 
 	void EffectCache::set_debug_shader(const ShaderBuildType debug)
@@ -90,10 +124,11 @@ namespace eternal_lands
 
 	void EffectCache::load_effect(
 		const FileSystemConstSharedPtr &file_system,
-		const String &file_name)
+		const String &file_name, EffectSharedPtrVector &effects)
 	{
 		EffectDescription effect_description;
 		XmlReaderSharedPtr xml_reader;
+		EffectSharedPtr effect;
 		String name;
 
 		try
@@ -117,8 +152,13 @@ namespace eternal_lands
 
 			name = effect_description.get_name();
 
-			m_effect_cache[name] = build_effect(
-				effect_description);
+			effect = boost::make_shared<Effect>(
+				get_glsl_program_cache(),
+				get_shader_source_builder(),
+				effect_description, false);
+
+			m_effect_cache[name] = effect;
+			effects.push_back(effect);
 
 			LOG_DEBUG(lt_effect, UTF8("Effect '%1%' loaded from "
 				"file '%2%'"), name % file_name);
@@ -132,7 +172,7 @@ namespace eternal_lands
 	}
 
 	void EffectCache::load_xml(const FileSystemConstSharedPtr &file_system,
-		const String &dir)
+		const String &dir, EffectSharedPtrVector &effects)
 	{
 		StringSet files;
 
@@ -140,10 +180,30 @@ namespace eternal_lands
 
 		BOOST_FOREACH(const String &file, files)
 		{
-			load_effect(file_system, file);
+			load_effect(file_system, file, effects);
 		}
 	}
 
+	void EffectCache::load_xml(const FileSystemConstSharedPtr &file_system,
+		const String &dir)
+	{
+		EffectSharedPtrVector effects;
+
+		load_xml(file_system, dir, effects);
+
+		load_effects(effects);
+	}
+
+	void EffectCache::build_sources(
+		const FileSystemConstSharedPtr &file_system, const String &dir)
+	{
+		EffectSharedPtrVector effects;
+
+		load_xml(file_system, dir, effects);
+
+		build_sources(effects);
+	}
+
 	StringVector EffectCache::get_effect_names() const
 	{
 		EffectCacheMap::const_iterator it, end;
@@ -175,7 +235,7 @@ namespace eternal_lands
 		const EffectDescription &effect_description) const
 	{
 		return boost::make_shared<Effect>(get_glsl_program_cache(),
-			get_shader_source_builder(), effect_description);
+			get_shader_source_builder(), effect_description, true);
 	}
 
 }
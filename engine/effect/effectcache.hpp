@@ -38,6 +38,7 @@ namespace eternal_lands
 			const GlslProgramCacheWeakPtr m_glsl_program_cache;
 			const ShaderSourceBuilderConstWeakPtr
 				m_shader_source_builder;
+			const JobSystemWeakPtr m_job_system;
 			EffectSharedPtr m_simple_effect;
 
 			inline const GlslProgramCacheWeakPtr
@@ -52,9 +53,30 @@ namespace eternal_lands
 				return m_shader_source_builder;
 			}
 
+			inline const JobSystemWeakPtr &get_job_system() const
+				noexcept
+			{
+				return m_job_system;
+			}
+
 			void load_effect(
 				const FileSystemConstSharedPtr &file_system,
-				const String &file_name);
+				const String &file_name,
+				EffectSharedPtrVector &effects);
+
+			void load_xml(
+				const FileSystemConstSharedPtr &file_system,
+				const String &dir,
+				EffectSharedPtrVector &effects);
+			void build_sources(
+				const EffectSharedPtrVector &effects);
+
+			/**
+			 * Loads the effects. The shader sources of all
+			 * effects are built in parallel by the job system,
+			 * the programs are then created on this thread.
+			 */
+			void load_effects(const EffectSharedPtrVector &effects);
 
 		public:
 			/**
@@ -63,7 +85,8 @@ namespace eternal_lands
 			EffectCache(const GlslProgramCacheWeakPtr
 					&glsl_program_cache,
 				const ShaderSourceBuilderConstWeakPtr
-					&shader_source_builder);
+					&shader_source_builder,
+				const JobSystemWeakPtr &job_system);
 
 			/**
 			 * Default destructor.
@@ -76,6 +99,16 @@ namespace eternal_lands
 			void load_xml(
 				const FileSystemConstSharedPtr &file_system,
 				const String &dir);
+
+			/**
+			 * Loads the effects of the dir and builds their shader
+			 * sources, but not the programs, so no OpenGL context
+			 * is needed. Used to fill the shader source disk
+			 * cache. The programs are created by the next reload.
+			 */
+			void build_sources(
+				const FileSystemConstSharedPtr &file_system,
+				const String &dir);
 			StringVector get_effect_names() const;
 			void add_effect(
 				const EffectDescription &effect_description);
@@ -760,6 +760,28 @@ namespace eternal_lands
 			<< boost::errinfo_file_name(file_name));
 	}
 
+	Uint8Array20 FileSystem::get_content_sha1(
+		const ReaderSharedPtr &reader)
+	{
+		return get_file_sha1(reader->get_buffer());
+	}
+
+	String FileSystem::get_sha1_string(const Uint8Array20 &sha1)
+	{
+		return String(get_sha1_str(sha1));
+	}
+
+	StringSet FileSystem::get_dir_files(const String &dir,
+		const String &pattern)
+	{
+		StringSet result;
+
+		scan_directory(String(utf8_to_string(dir)), String(), pattern,
+			result);
+
+		return result;
+	}
+
 	String FileSystem::get_file_string(const String &file_name) const
 	{
 		ReaderSharedPtr reader;
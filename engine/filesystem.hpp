@@ -69,6 +69,33 @@ namespace eternal_lands
 			static String get_file_name_without_extension(
 				const String &file_name);
 
+			/**
+			 * Calculates the sha1 of the content of a file, as
+			 * used to check files against their expected sha1.
+			 * @param reader The reader of the file.
+			 * @return The sha1 of the file content.
+			 */
+			static Uint8Array20 get_content_sha1(
+				const ReaderSharedPtr &reader);
+
+			/**
+			 * Converts a sha1 to a string of 40 hex digits.
+			 * @param sha1 The sha1 to convert.
+			 * @return The hex string.
+			 */
+			static String get_sha1_string(const Uint8Array20 &sha1);
+
+			/**
+			 * Returns the names of the files in a dir of the
+			 * disk, that is not one of the archives, like the
+			 * disk cache dirs.
+			 * @param dir The dir on the disk.
+			 * @param pattern The pattern the names must match.
+			 * @return The names of the files, relative to dir.
+			 */
+			static StringSet get_dir_files(const String &dir,
+				const String &pattern);
+
 	};
 
 }
@@ -73,6 +73,11 @@ namespace eternal_lands
 				return m_planes[index];
 			}
 
+			inline Uint32 get_plane_count() const noexcept
+			{
+				return m_planes.size();
+			}
+
 			inline IntersectionType intersect(
 				const BoundingBox &box) const
 			{
@@ -21,6 +21,11 @@ namespace eternal_lands
 		m_clipmap_terrain_size = 1024;
 		m_clipmap_terrain_world_size = 8;
 		m_clipmap_terrain_slices = 4;
+		m_culling_split_depth = 2;
+		m_max_occluders = 32;
+		m_texture_cache_size = 512;
+		m_mesh_cache_size = 128;
+		m_texture_upload_budget = 4096;
 		m_shadow_quality = sqt_no;
 		m_terrain_quality = qt_medium;
 		m_opengl_version = ovt_2_1;
@@ -41,6 +46,7 @@ namespace eternal_lands
 		m_effect_debug = false;
 		m_use_scene_fbo = true;
 		m_use_multithreaded_culling = true;
+		m_use_texture_streaming = true;
 	}
 
 	GlobalVars::~GlobalVars() noexcept
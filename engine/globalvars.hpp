@@ -71,12 +71,20 @@ namespace eternal_lands
 	{
 		private:
 			String m_quality;
+			String m_mesh_data_cache_dir;
+			String m_shader_source_cache_dir;
+			String m_program_binary_cache_dir;
 			float m_shadow_distance;
 			float m_view_distance;
 			Uint16 m_shadow_map_size;
 			Uint16 m_clipmap_terrain_size;
 			Uint16 m_clipmap_terrain_world_size;
 			Uint16 m_clipmap_terrain_slices;
+			Uint16 m_culling_split_depth;
+			Uint16 m_max_occluders;
+			Uint16 m_texture_cache_size;
+			Uint16 m_mesh_cache_size;
+			Uint16 m_texture_upload_budget;
 			ShadowQualityType m_shadow_quality;
 			QualityType m_terrain_quality;
 			OpenglVerionType m_opengl_version;
@@ -93,6 +101,7 @@ namespace eternal_lands
 			bool m_effect_debug;
 			bool m_use_scene_fbo;
 			bool m_use_multithreaded_culling;
+			bool m_use_texture_streaming;
 
 		public:
 			GlobalVars();
@@ -103,6 +112,26 @@ namespace eternal_lands
 				m_quality = quality;
 			}
 
+			inline void set_mesh_data_cache_dir(
+				const String &mesh_data_cache_dir) noexcept
+			{
+				m_mesh_data_cache_dir = mesh_data_cache_dir;
+			}
+
+			inline void set_shader_source_cache_dir(
+				const String &shader_source_cache_dir) noexcept
+			{
+				m_shader_source_cache_dir =
+					shader_source_cache_dir;
+			}
+
+			inline void set_program_binary_cache_dir(
+				const String &program_binary_cache_dir) noexcept
+			{
+				m_program_binary_cache_dir =
+					program_binary_cache_dir;
+			}
+
 			inline void set_shadow_distance(
 				const float shadow_distance) noexcept
 			{
@@ -142,6 +171,36 @@ namespace eternal_lands
 					clipmap_terrain_slices;
 			}
 
+			inline void set_culling_split_depth(
+				const Uint16 culling_split_depth) noexcept
+			{
+				m_culling_split_depth = culling_split_depth;
+			}
+
+			inline void set_max_occluders(
+				const Uint16 max_occluders) noexcept
+			{
+				m_max_occluders = max_occluders;
+			}
+
+			inline void set_texture_cache_size(
+				const Uint16 texture_cache_size) noexcept
+			{
+				m_texture_cache_size = texture_cache_size;
+			}
+
+			inline void set_mesh_cache_size(
+				const Uint16 mesh_cache_size) noexcept
+			{
+				m_mesh_cache_size = mesh_cache_size;
+			}
+
+			inline void set_texture_upload_budget(
+				const Uint16 texture_upload_budget) noexcept
+			{
+				m_texture_upload_budget = texture_upload_budget;
+			}
+
 			inline void set_shadow_quality(
 				const ShadowQualityType shadow_quality) noexcept
 			{
@@ -238,11 +297,50 @@ namespace eternal_lands
 					use_multithreaded_culling;
 			}
 
+			inline void set_use_texture_streaming(
+				const bool use_texture_streaming) noexcept
+			{
+				m_use_texture_streaming = use_texture_streaming;
+			}
+
 			inline const String &get_quality() const noexcept
 			{
 				return m_quality;
 			}
 
+			/**
+			 * Directory where the processed mesh data is saved
+			 * and mapped from on the next load, ending with a
+			 * slash. Empty disables the mesh data disk cache.
+			 */
+			inline const String &get_mesh_data_cache_dir() const
+				noexcept
+			{
+				return m_mesh_data_cache_dir;
+			}
+
+			/**
+			 * Returns the dir of the shader source disk cache,
+			 * ending with a slash. Empty disables the shader
+			 * source disk cache.
+			 */
+			inline const String &get_shader_source_cache_dir()
+				const noexcept
+			{
+				return m_shader_source_cache_dir;
+			}
+
+			/**
+			 * Returns the dir of the linked program binary disk
+			 * cache, ending with a slash. Empty disables the
+			 * program binary disk cache.
+			 */
+			inline const String &get_program_binary_cache_dir()
+				const noexcept
+			{
+				return m_program_binary_cache_dir;
+			}
+
 			inline float get_shadow_distance() const noexcept
 			{
 				return m_shadow_distance;
@@ -294,6 +392,54 @@ namespace eternal_lands
 				return m_clipmap_terrain_slices;
 			}
 
+			/**
+			 * Depth of the object tree where the culling is split
+			 * into tasks when using multithreaded culling. Zero
+			 * disables the splitting.
+			 */
+			inline Uint16 get_culling_split_depth() const noexcept
+			{
+				return m_culling_split_depth;
+			}
+
+			/**
+			 * Number of the nearest visible objects of the last
+			 * frame that are rasterized as occluders by the cpu
+			 * rasterizer. Zero disables occlusion culling.
+			 */
+			inline Uint16 get_max_occluders() const noexcept
+			{
+				return m_max_occluders;
+			}
+
+			/**
+			 * Size in MiB the texture cache is trimmed to after
+			 * a map change. Textures still in use are kept.
+			 */
+			inline Uint16 get_texture_cache_size() const noexcept
+			{
+				return m_texture_cache_size;
+			}
+
+			/**
+			 * Size in MiB the mesh data cache is trimmed to after
+			 * a map change. Meshes still in use are kept.
+			 */
+			inline Uint16 get_mesh_cache_size() const noexcept
+			{
+				return m_mesh_cache_size;
+			}
+
+			/**
+			 * Size in KiB of the streamed textures that are
+			 * uploaded per frame. At least one texture is
+			 * uploaded per frame.
+			 */
+			inline Uint16 get_texture_upload_budget() const noexcept
+			{
+				return m_texture_upload_budget;
+			}
+
 			inline ShadowQualityType get_shadow_quality() const
 				noexcept
 			{
@@ -430,6 +576,16 @@ namespace eternal_lands
 				return m_use_multithreaded_culling;
 			}
 
+			/**
+			 * Load the textures of objects and actors in the
+			 * background, showing the error texture until they
+			 * are uploaded.
+			 */
+			inline bool get_use_texture_streaming() const noexcept
+			{
+				return m_use_texture_streaming;
+			}
+
 	};
 
 }
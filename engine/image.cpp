@@ -6,6 +6,7 @@
  ****************************************************************************/
 
 #include "image.hpp"
+#include "imageview.hpp"
 #include "packtool.hpp"
 #include "logging.hpp"
 #include "reader.hpp"
@@ -48,6 +49,55 @@ namespace eternal_lands
 			}
 		}
 
+		template <GLenum type>
+		glm::vec4 get_channels(const void* const value,
+			const Uint32 count)
+		{
+			typedef typename ImageChannel<type>::value_type
+				value_type;
+
+			const value_type* const ptr =
+				static_cast<const value_type*>(value);
+
+			switch (count)
+			{
+				case 1:
+					return ImagePixel<type, 1>::get(ptr);
+				case 2:
+					return ImagePixel<type, 2>::get(ptr);
+				case 3:
+					return ImagePixel<type, 3>::get(ptr);
+				default:
+					return ImagePixel<type, 4>::get(ptr);
+			}
+		}
+
+		template <GLenum type>
+		void set_channels(const glm::vec4 &data, void* const value,
+			const Uint32 count)
+		{
+			typedef typename ImageChannel<type>::value_type
+				value_type;
+
+			value_type* const ptr = static_cast<value_type*>(value);
+
+			switch (count)
+			{
+				case 1:
+					ImagePixel<type, 1>::set(data, ptr);
+					return;
+				case 2:
+					ImagePixel<type, 2>::set(data, ptr);
+					return;
+				case 3:
+					ImagePixel<type, 3>::set(data, ptr);
+					return;
+				default:
+					ImagePixel<type, 4>::set(data, ptr);
+					return;
+			}
+		}
+
 		Uint16 clamp_mipmap_count(const glm::uvec3 &size,
 			const Uint16 mipmap_count, const bool array)
 		{
@@ -440,22 +490,12 @@ namespace eternal_lands
 		switch (get_type())
 		{
 			case GL_UNSIGNED_BYTE:
-				for (i = 0; i < count; ++i)
-				{
-					result[i] = static_cast<const Uint8*>(
-						value)[i];
-					result[i] /= std::numeric_limits<
-						Uint8>::max();
-				}
+				result = get_channels<GL_UNSIGNED_BYTE>(value,
+					count);
 				break;
 			case GL_UNSIGNED_SHORT:
-				for (i = 0; i < count; ++i)
-				{
-					result[i] = static_cast<const Uint16*>(
-						value)[i];
-					result[i] /= std::numeric_limits<
-						Uint16>::max();
-				}
+				result = get_channels<GL_UNSIGNED_SHORT>(value,
+					count);
 				break;
 			case GL_UNSIGNED_INT:
 				for (i = 0; i < count; ++i)
@@ -467,19 +507,11 @@ namespace eternal_lands
 				}
 				break;
 			case GL_FLOAT:
-				for (i = 0; i < count; ++i)
-				{
-					result[i] = static_cast<const float*>(
-						value)[i];
-				}
+				result = get_channels<GL_FLOAT>(value, count);
 				break;
 			case GL_HALF_FLOAT:
-				for (i = 0; i < count; ++i)
-				{
-					result[i] = glm::detail::toFloat32(
-						static_cast<const Uint16*>(
-							value)[i]);
-				}
+				result = get_channels<GL_HALF_FLOAT>(value,
+					count);
 				break;
 			case GL_UNSIGNED_BYTE_3_3_2:
 				result = glm::vec4(PackTool::unpack_uint_3_3_2(
@@ -532,8 +564,8 @@ namespace eternal_lands
 					*static_cast<const Uint32*>(value));
 				break;
 			case GL_UNSIGNED_INT_10_10_10_2:
-				result = PackTool::unpack_uint_10_10_10_2(true,
-					*static_cast<const Uint32*>(value));
+				result = ImagePixelRGB10A2::get(
+					static_cast<const Uint32*>(value));
 				break;
 			case GL_UNSIGNED_INT_2_10_10_10_REV:
 				result = PackTool::unpack_uint_2_10_10_10_rev(
@@ -977,22 +1009,12 @@ namespace eternal_lands
 		switch (get_type())
 		{
 			case GL_UNSIGNED_BYTE:
-				for (i = 0; i < count; ++i)
-				{
-					static_cast<Uint8*>(value)[i] =
-						tmp[i] *
-						std::numeric_limits<
-							Uint8>::max();
-				}
+				set_channels<GL_UNSIGNED_BYTE>(tmp, value,
+					count);
 				return;
 			case GL_UNSIGNED_SHORT:
-				for (i = 0; i < count; ++i)
-				{
-					static_cast<Uint16*>(value)[i] =
-						tmp[i] *
-						std::numeric_limits<
-							Uint16>::max();
-				}
+				set_channels<GL_UNSIGNED_SHORT>(tmp, value,
+					count);
 				return;
 			case GL_UNSIGNED_INT:
 				for (i = 0; i < count; ++i)
@@ -1004,18 +1026,10 @@ namespace eternal_lands
 				}
 				return;
 			case GL_FLOAT:
-				for (i = 0; i < count; ++i)
-				{
-					static_cast<float*>(value)[i] = tmp[i];
-				}
+				set_channels<GL_FLOAT>(tmp, value, count);
 				return;
 			case GL_HALF_FLOAT:
-				for (i = 0; i < count; ++i)
-				{
-					static_cast<glm::detail::hdata*>(
-						value)[i] =
-						glm::detail::toFloat16(tmp[i]);
-				}
+				set_channels<GL_HALF_FLOAT>(tmp, value, count);
 				return;
 			case GL_UNSIGNED_BYTE_3_3_2:
 				*static_cast<Uint8*>(value) =
@@ -1073,9 +1087,8 @@ namespace eternal_lands
 				}
 				return;
 			case GL_UNSIGNED_INT_10_10_10_2:
-				*static_cast<Uint32*>(value) =
-					PackTool::pack_uint_10_10_10_2(true,
-						tmp);
+				ImagePixelRGB10A2::set(tmp,
+					static_cast<Uint32*>(value));
 				return;
 			case GL_UNSIGNED_INT_2_10_10_10_REV:
 				*static_cast<Uint32*>(value) =
@@ -1610,6 +1623,31 @@ namespace eternal_lands
 		return shared_from_this();
 	}
 
+	ImageSharedPtr Image::decompress(const bool copy,
+		const bool rg_formats, const bool merge_layers,
+		JobSystem &job_system)
+	{
+		ReaderSharedPtr reader;
+
+		if (get_compressed())
+		{
+			reader = boost::make_shared<Reader>(get_buffer(),
+				get_name());
+
+			return Dxt::uncompress(reader, get_name(), get_size(),
+				get_texture_format(), get_mipmap_count(),
+				get_cube_map(), get_array(), rg_formats,
+				get_sRGB(), merge_layers, job_system);
+		}
+
+		if (copy)
+		{
+			return boost::make_shared<Image>(*this);
+		}
+
+		return shared_from_this();
+	}
+
 	ImageConstSharedPtr Image::decompress(const bool copy,
 		const bool rg_formats, const bool merge_layers) const
 	{
@@ -127,6 +127,24 @@ namespace eternal_lands
 			ImageSharedPtr decompress(const bool copy,
 				const bool rg_formats, const bool merge_layers);
 
+			/**
+			 * @brief Returns decompressed image.
+			 * Returns a decompressed copy of the image if the
+			 * image is compressed, using the job system for rows
+			 * of blocks, else the image itself is returned.
+			 * @param copy Returns a copy of the image if the image
+			 * is uncompressed.
+			 * @param rg_formats Use RG and R as format for
+			 * uncompressed image.
+			 * @param merge_layers Merge multiple layers (two or
+			 * four) of a red or red-green into in a rgba format.
+			 * @param job_system The job system to use.
+			 * @return the uncompressed image.
+			 */
+			ImageSharedPtr decompress(const bool copy,
+				const bool rg_formats, const bool merge_layers,
+				JobSystem &job_system);
+
 			/**
 			 * @brief Returns decompressed image.
 			 * Returns a decompressed copy of the image if the
@@ -7,6 +7,8 @@
 
 #include "imageupdate.hpp"
 #include "readwritememory.hpp"
+#include "image.hpp"
+#include "exceptions.hpp"
 
 namespace eternal_lands
 {
@@ -23,6 +25,51 @@ namespace eternal_lands
 	{
 	}
 
+	ImageUpdate::ImageUpdate(const ImageConstSharedPtr &image,
+		const glm::uvec3 &offset, const glm::uvec3 &size,
+		const CubeMapFaceType face, const Uint16 mipmap):
+		m_name(image->get_name()), m_offset(offset), m_size(size),
+		m_face(face), m_format(image->get_format()),
+		m_type(image->get_type()), m_mipmap(mipmap),
+		m_compressed(false)
+	{
+		ReadWriteMemorySharedPtr buffer;
+		Uint8* dest;
+		Uint32 y, z, row_size;
+
+		if (image->get_compressed())
+		{
+			EL_THROW_EXCEPTION(InvalidParameterException()
+				<< errinfo_message(UTF8("Can't update a region "
+					"of a compressed image"))
+				<< boost::errinfo_file_name(image->get_name()));
+		}
+
+		assert((offset.x + size.x) <= image->get_width(mipmap));
+		assert((offset.y + size.y) <= image->get_height(mipmap));
+
+		row_size = (size.x * image->get_pixel_size()) / 8;
+
+		buffer = boost::make_shared<ReadWriteMemory>(row_size * size.y *
+			size.z);
+
+		dest = static_cast<Uint8*>(buffer->get_ptr());
+
+		for (z = 0; z < size.z; ++z)
+		{
+			for (y = 0; y < size.y; ++y)
+			{
+				memcpy(dest, image->get_pixel_data(offset.x,
+					offset.y + y, offset.z + z, face,
+					mipmap), row_size);
+
+				dest += row_size;
+			}
+		}
+
+		m_buffer = buffer;
+	}
+
 	ImageUpdate::~ImageUpdate() noexcept
 	{
 	}
@@ -50,6 +50,22 @@ namespace eternal_lands
 				const CubeMapFaceType face,
 				const GLenum format, const GLenum type,
 				const Uint16 mipmap, const bool compressed);
+
+			/**
+			 * Creates an update for a region of an uncompressed
+			 * image. The pixels of the region are copied, so the
+			 * image can change after this.
+			 * @param image The image to use.
+			 * @param offset The offset of the region.
+			 * @param size The size of the region.
+			 * @param face The face of the image to use.
+			 * @param mipmap The mipmap of the image to use.
+			 */
+			ImageUpdate(const ImageConstSharedPtr &image,
+				const glm::uvec3 &offset,
+				const glm::uvec3 &size,
+				const CubeMapFaceType face,
+				const Uint16 mipmap);
 			~ImageUpdate() noexcept;
 
 			inline void set_name(const String &name) noexcept
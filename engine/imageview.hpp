@@ -0,0 +1,422 @@
+/****************************************************************************
+ *            imageview.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_1a9ff16c_9106_428e_9bfd_9186195de776
+#define	UUID_1a9ff16c_9106_428e_9bfd_9186195de776
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include "image.hpp"
+#include "exceptions.hpp"
+
+/**
+ * @file
+ * @brief The @c class ImageView.
+ * This file contains the @c class ImageView, the @c class
+ * ConstImageView and the pixel traits they use.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief Conversion of one channel value.
+	 *
+	 * Converts one channel value of the given source type to and from
+	 * float, the same way Image::get_pixel() and Image::set_pixel()
+	 * do it.
+	 */
+	template <GLenum type>
+	class ImageChannel;
+
+	template <>
+	class ImageChannel<GL_UNSIGNED_BYTE>
+	{
+		public:
+			typedef Uint8 value_type;
+
+			static inline float get(const Uint8 value) noexcept
+			{
+				return value / static_cast<float>(
+					std::numeric_limits<Uint8>::max());
+			}
+
+			static inline Uint8 set(const float value) noexcept
+			{
+				return value * std::numeric_limits<
+					Uint8>::max();
+			}
+
+	};
+
+	template <>
+	class ImageChannel<GL_UNSIGNED_SHORT>
+	{
+		public:
+			typedef Uint16 value_type;
+
+			static inline float get(const Uint16 value) noexcept
+			{
+				return value / static_cast<float>(
+					std::numeric_limits<Uint16>::max());
+			}
+
+			static inline Uint16 set(const float value) noexcept
+			{
+				return value * std::numeric_limits<
+					Uint16>::max();
+			}
+
+	};
+
+	template <>
+	class ImageChannel<GL_HALF_FLOAT>
+	{
+		public:
+			typedef Uint16 value_type;
+
+			static inline float get(const Uint16 value) noexcept
+			{
+				return glm::detail::toFloat32(value);
+			}
+
+			static inline Uint16 set(const float value) noexcept
+			{
+				return glm::detail::toFloat16(value);
+			}
+
+	};
+
+	template <>
+	class ImageChannel<GL_FLOAT>
+	{
+		public:
+			typedef float value_type;
+
+			static inline float get(const float value) noexcept
+			{
+				return value;
+			}
+
+			static inline float set(const float value) noexcept
+			{
+				return value;
+			}
+
+	};
+
+	/**
+	 * @brief Pixel traits for images with one value per channel.
+	 *
+	 * Pixel traits for images that store the channels as separate
+	 * values of the given source type. Missing channels read as zero,
+	 * a missing alpha as one.
+	 */
+	template <GLenum type, Uint16 count>
+	class ImagePixel
+	{
+		public:
+			typedef typename ImageChannel<type>::value_type
+				value_type;
+
+			/**
+			 * Number of values of one pixel.
+			 */
+			static const Uint16 value_count = count;
+
+			static inline bool get_supported(const Image &image)
+			{
+				return (image.get_type() == type) &&
+					(image.get_channel_count() == count);
+			}
+
+			static inline glm::vec4 get(const value_type* value)
+				noexcept
+			{
+				glm::vec4 result;
+				Uint32 i;
+
+				result = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+				for (i = 0; i < count; ++i)
+				{
+					result[i] = ImageChannel<type>::get(
+						value[i]);
+				}
+
+				return result;
+			}
+
+			static inline void set(const glm::vec4 &data,
+				value_type* value) noexcept
+			{
+				Uint32 i;
+
+				for (i = 0; i < count; ++i)
+				{
+					value[i] = ImageChannel<type>::set(
+						data[i]);
+				}
+			}
+
+	};
+
+	/**
+	 * @brief Pixel traits for rgb10_a2 images.
+	 *
+	 * Pixel traits for images that store the pixel as one 32 bit
+	 * value with 10 bits for red, green and blue and 2 bits for
+	 * alpha, red in the most significant bits.
+	 */
+	class ImagePixelRGB10A2
+	{
+		public:
+			typedef Uint32 value_type;
+
+			/**
+			 * Number of values of one pixel.
+			 */
+			static const Uint16 value_count = 1;
+
+			static inline bool get_supported(const Image &image)
+			{
+				return image.get_type() ==
+					GL_UNSIGNED_INT_10_10_10_2;
+			}
+
+			static inline glm::vec4 get(const Uint32* value)
+				noexcept
+			{
+				glm::vec4 result;
+
+				result.r = (*value >> 22) & 0x3FF;
+				result.g = (*value >> 12) & 0x3FF;
+				result.b = (*value >> 2) & 0x3FF;
+				result.a = *value & 0x3;
+
+				return result / glm::vec4(1023.0f, 1023.0f,
+					1023.0f, 3.0f);
+			}
+
+			static inline void set(const glm::vec4 &data,
+				Uint32* value) noexcept
+			{
+				glm::uvec4 tmp;
+
+				tmp = glm::uvec4(glm::clamp(data, 0.0f, 1.0f) *
+					glm::vec4(1023.0f, 1023.0f, 1023.0f,
+						3.0f) + 0.5f);
+
+				*value = (tmp.r << 22) | (tmp.g << 12) |
+					(tmp.b << 2) | tmp.a;
+			}
+
+	};
+
+	typedef ImagePixel<GL_UNSIGNED_BYTE, 1> ImagePixelR8;
+	typedef ImagePixel<GL_UNSIGNED_BYTE, 2> ImagePixelRG8;
+	typedef ImagePixel<GL_UNSIGNED_BYTE, 3> ImagePixelRGB8;
+	typedef ImagePixel<GL_UNSIGNED_BYTE, 4> ImagePixelRGBA8;
+	typedef ImagePixel<GL_UNSIGNED_SHORT, 1> ImagePixelR16;
+	typedef ImagePixel<GL_UNSIGNED_SHORT, 2> ImagePixelRG16;
+	typedef ImagePixel<GL_UNSIGNED_SHORT, 3> ImagePixelRGB16;
+	typedef ImagePixel<GL_UNSIGNED_SHORT, 4> ImagePixelRGBA16;
+	typedef ImagePixel<GL_HALF_FLOAT, 1> ImagePixelR16F;
+	typedef ImagePixel<GL_HALF_FLOAT, 2> ImagePixelRG16F;
+	typedef ImagePixel<GL_HALF_FLOAT, 3> ImagePixelRGB16F;
+	typedef ImagePixel<GL_HALF_FLOAT, 4> ImagePixelRGBA16F;
+	typedef ImagePixel<GL_FLOAT, 1> ImagePixelR32F;
+	typedef ImagePixel<GL_FLOAT, 2> ImagePixelRG32F;
+	typedef ImagePixel<GL_FLOAT, 3> ImagePixelRGB32F;
+	typedef ImagePixel<GL_FLOAT, 4> ImagePixelRGBA32F;
+
+	/**
+	 * @brief Read only typed view of one face and mipmap of an image.
+	 *
+	 * The format of the image is checked once when the view is
+	 * created, all accesses after that go straight to the memory of
+	 * the image with the conversion of the pixel traits. The rows are
+	 * plain arrays of get_row_size() values, so loops over them can be
+	 * vectorized by the compiler. The view holds no state of its own
+	 * that changes and the image must outlive it.
+	 */
+	template <typename T>
+	class ConstImageView
+	{
+		public:
+			typedef typename T::value_type value_type;
+
+		private:
+			const value_type* m_data;
+			Uint32 m_width;
+			Uint32 m_height;
+			Uint32 m_depth;
+
+		public:
+			/**
+			 * Default constructor.
+			 * @throw InvalidParameterException if the format of
+			 * the image doesn't match the pixel traits.
+			 */
+			ConstImageView(const Image &image, const Uint16 face,
+				const Uint16 mipmap)
+			{
+				glm::uvec3 size;
+
+				if (!get_supported(image))
+				{
+					EL_THROW_EXCEPTION(
+						InvalidParameterException()
+						<< errinfo_message(UTF8("Image "
+							"format doesn't match "
+							"the view"))
+						<< errinfo_string_value(
+							TextureFormatUtil::get_str(
+							image.get_texture_format()))
+						<< errinfo_name(
+							image.get_name()));
+				}
+
+				size = image.get_size(mipmap);
+
+				m_data = static_cast<const value_type*>(
+					image.get_data(0, 0, 0, face, mipmap));
+				m_width = size.x;
+				m_height = size.y;
+				m_depth = size.z;
+			}
+
+			/**
+			 * Returns true if the image can be viewed with the
+			 * pixel traits. Images with swizzled channels are not
+			 * supported.
+			 */
+			static inline bool get_supported(const Image &image)
+			{
+				switch (image.get_format())
+				{
+					case GL_BGR:
+					case GL_BGR_INTEGER:
+					case GL_BGRA:
+					case GL_BGRA_INTEGER:
+						return false;
+					default:
+						break;
+				}
+
+				return !image.get_compressed() &&
+					T::get_supported(image) &&
+					((image.get_pixel_size() / 8) ==
+					(sizeof(value_type) * T::value_count));
+			}
+
+			inline Uint32 get_width() const noexcept
+			{
+				return m_width;
+			}
+
+			inline Uint32 get_height() const noexcept
+			{
+				return m_height;
+			}
+
+			inline Uint32 get_depth() const noexcept
+			{
+				return m_depth;
+			}
+
+			/**
+			 * Returns the number of values of one row.
+			 */
+			inline Uint32 get_row_size() const noexcept
+			{
+				return m_width * T::value_count;
+			}
+
+			/**
+			 * Returns the pointer to the first value of the
+			 * given row. The row ends get_row_size() values
+			 * after it.
+			 */
+			inline const value_type* get_row(const Uint32 y,
+				const Uint32 z) const noexcept
+			{
+				assert(y < m_height);
+				assert(z < m_depth);
+
+				return m_data + (z * m_height + y) *
+					get_row_size();
+			}
+
+			inline const value_type* get_row_end(const Uint32 y,
+				const Uint32 z) const noexcept
+			{
+				return get_row(y, z) + get_row_size();
+			}
+
+			inline glm::vec4 get_pixel(const Uint32 x,
+				const Uint32 y, const Uint32 z) const noexcept
+			{
+				assert(x < m_width);
+
+				return T::get(get_row(y, z) +
+					x * T::value_count);
+			}
+
+	};
+
+	/**
+	 * @brief Typed view of one face and mipmap of an image.
+	 *
+	 * Like ConstImageView, but also gives write access to the pixels.
+	 */
+	template <typename T>
+	class ImageView: public ConstImageView<T>
+	{
+		public:
+			typedef typename T::value_type value_type;
+
+			/**
+			 * Default constructor.
+			 * @throw InvalidParameterException if the format of
+			 * the image doesn't match the pixel traits.
+			 */
+			ImageView(Image &image, const Uint16 face,
+				const Uint16 mipmap):
+				ConstImageView<T>(image, face, mipmap)
+			{
+			}
+
+			inline value_type* get_row(const Uint32 y,
+				const Uint32 z) noexcept
+			{
+				return const_cast<value_type*>(
+					ConstImageView<T>::get_row(y, z));
+			}
+
+			inline value_type* get_row_end(const Uint32 y,
+				const Uint32 z) noexcept
+			{
+				return get_row(y, z) + this->get_row_size();
+			}
+
+			inline void set_pixel(const Uint32 x, const Uint32 y,
+				const Uint32 z, const glm::vec4 &data) noexcept
+			{
+				assert(x < this->get_width());
+
+				T::set(data, get_row(y, z) +
+					x * T::value_count);
+			}
+
+	};
+
+}
+
+#endif	/* UUID_1a9ff16c_9106_428e_9bfd_9186195de776 */
@@ -76,9 +76,12 @@ namespace eternal_lands
 			get_texture_cache());
 
 		m_map->set_name(name);
+		m_map->begin_static_objects();
 
 		read(name);
 
+		m_map->end_static_objects();
+
 		return m_map;
 	}
 
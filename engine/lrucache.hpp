@@ -0,0 +1,279 @@
+/****************************************************************************
+ *            lrucache.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_0c5f3a0e_9a3e_4a4c_b7a4_2f0f6d7e31c4
+#define	UUID_0c5f3a0e_9a3e_4a4c_b7a4_2f0f6d7e31c4
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+/**
+ * @file
+ * @brief The @c class LruCache.
+ * This file contains the @c class LruCache.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief @c class for caches with a memory budget.
+	 *
+	 * Stores the values in a hash table by name and keeps them in
+	 * least recently used order. When trim() is called and the
+	 * memory usage is above the budget, the least recently used
+	 * values that are not used outside of the cache are removed.
+	 * Values still in use are never removed, so the budget is a
+	 * soft limit. The static functions get_unused() and
+	 * get_memory_usage() of the traits tell if a value is only used
+	 * by the cache and how much memory it uses.
+	 */
+	template <typename T, typename Traits>
+	class LruCache: public boost::noncopyable
+	{
+		private:
+			class Entry
+			{
+				public:
+					String m_name;
+					T m_value;
+					mutable Uint64 m_memory_usage;
+
+					Entry(const String &name, const T &value,
+						const Uint64 memory_usage):
+						m_name(name), m_value(value),
+						m_memory_usage(memory_usage)
+					{
+					}
+
+			};
+
+			typedef boost::multi_index::multi_index_container<
+				Entry, boost::multi_index::indexed_by<
+					boost::multi_index::sequenced<>,
+					boost::multi_index::hashed_unique<
+						boost::multi_index::member<Entry,
+							String, &Entry::m_name> > > >
+				EntryContainer;
+			typedef typename EntryContainer::template nth_index<
+				1>::type EntryNameIndex;
+
+			EntryContainer m_entries;
+			Uint64 m_memory_usage;
+			Uint64 m_budget;
+			Uint32 m_hits;
+			Uint32 m_misses;
+			Uint32 m_evictions;
+
+		public:
+			/**
+			 * Default constructor.
+			 */
+			LruCache(): m_memory_usage(0), m_budget(0),
+				m_hits(0), m_misses(0), m_evictions(0)
+			{
+			}
+
+			/**
+			 * Default destructor.
+			 */
+			~LruCache() noexcept
+			{
+			}
+
+			/**
+			 * @brief Looks up a value.
+			 *
+			 * Looks up the value and marks it as the most
+			 * recently used one.
+			 * @param name The name of the value.
+			 * @param value Returns the value if found.
+			 * @return True if the value was found.
+			 */
+			bool find(const String &name, T &value)
+			{
+				typename EntryNameIndex::iterator found;
+
+				found = m_entries.template get<1>().find(name);
+
+				if (found == m_entries.template get<1>().end())
+				{
+					m_misses++;
+
+					return false;
+				}
+
+				m_hits++;
+
+				m_entries.relocate(m_entries.begin(),
+					m_entries.template project<0>(found));
+
+				value = found->m_value;
+
+				return true;
+			}
+
+			/**
+			 * @brief Adds a value.
+			 *
+			 * Adds the value as the most recently used one,
+			 * replacing the value with the same name. Nothing is
+			 * removed, so the new value stays valid until the
+			 * next call of trim().
+			 * @param name The name of the value.
+			 * @param value The value to add.
+			 */
+			void add(const String &name, const T &value)
+			{
+				typename EntryNameIndex::iterator found;
+				Uint64 memory_usage;
+
+				memory_usage = Traits::get_memory_usage(value);
+
+				found = m_entries.template get<1>().find(name);
+
+				if (found != m_entries.template get<1>().end())
+				{
+					m_memory_usage -= found->m_memory_usage;
+					m_entries.template get<1>().erase(found);
+				}
+
+				m_entries.push_front(Entry(name, value,
+					memory_usage));
+
+				m_memory_usage += memory_usage;
+			}
+
+			/**
+			 * @brief Removes unused values above the budget.
+			 *
+			 * Updates the memory usage of all values, because it
+			 * can change after they are added, then removes the
+			 * least recently used values that are unused until the
+			 * memory usage fits into the budget.
+			 * @return The number of removed values.
+			 */
+			Uint32 trim()
+			{
+				typename EntryContainer::iterator it, end;
+				Uint32 count;
+
+				m_memory_usage = 0;
+				end = m_entries.end();
+
+				for (it = m_entries.begin(); it != end; ++it)
+				{
+					it->m_memory_usage =
+						Traits::get_memory_usage(
+							it->m_value);
+					m_memory_usage += it->m_memory_usage;
+				}
+
+				count = 0;
+				it = m_entries.end();
+
+				while ((m_memory_usage > m_budget) &&
+					(it != m_entries.begin()))
+				{
+					--it;
+
+					if (!Traits::get_unused(it->m_value))
+					{
+						continue;
+					}
+
+					m_memory_usage -= it->m_memory_usage;
+					it = m_entries.erase(it);
+					count++;
+				}
+
+				m_evictions += count;
+
+				return count;
+			}
+
+			/**
+			 * @brief Removes all values.
+			 *
+			 * Removes all values, even the ones still in use.
+			 */
+			inline void clear()
+			{
+				m_entries.clear();
+				m_memory_usage = 0;
+			}
+
+			inline void set_budget(const Uint64 budget) noexcept
+			{
+				m_budget = budget;
+			}
+
+			inline Uint64 get_budget() const noexcept
+			{
+				return m_budget;
+			}
+
+			/**
+			 * @brief Memory usage.
+			 *
+			 * Returns the memory usage of all values, as of the
+			 * last call of trim() or add().
+			 * @return The memory usage.
+			 */
+			inline Uint64 get_memory_usage() const noexcept
+			{
+				return m_memory_usage;
+			}
+
+			inline Uint32 get_count() const noexcept
+			{
+				return m_entries.size();
+			}
+
+			inline Uint32 get_hits() const noexcept
+			{
+				return m_hits;
+			}
+
+			inline Uint32 get_misses() const noexcept
+			{
+				return m_misses;
+			}
+
+			inline Uint32 get_evictions() const noexcept
+			{
+				return m_evictions;
+			}
+
+			/**
+			 * @brief Statistics of the cache.
+			 *
+			 * Returns the number of values, the memory usage,
+			 * the budget and the hit, miss and eviction counters
+			 * as one line of text.
+			 * @return The statistics.
+			 */
+			String get_statistics() const
+			{
+				return String(boost::str(boost::format(
+					UTF8("%1% values, %2% of %3% KiB, "
+					"%4% hits, %5% misses, %6% evictions"))
+					% get_count() % (get_memory_usage() /
+					1024) % (get_budget() / 1024) %
+					get_hits() % get_misses() %
+					get_evictions()));
+			}
+
+	};
+
+}
+
+#endif	/* UUID_0c5f3a0e_9a3e_4a4c_b7a4_2f0f6d7e31c4 */
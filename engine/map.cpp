@@ -10,6 +10,7 @@
 #include "object.hpp"
 #include "exceptions.hpp"
 #include "rstartree.hpp"
+#include "staticrstartree.hpp"
 #include "meshcache.hpp"
 #include "instancedata.hpp"
 #include "objectdescription.hpp"
@@ -49,10 +50,12 @@ namespace eternal_lands
 		m_mesh_builder(mesh_builder), m_mesh_cache(mesh_cache),
 		m_material_cache(material_cache),
 		m_terrain_builder(terrain_builder),
-		m_texture_cache(texture_cache), m_id(0), m_dungeon(false)
+		m_texture_cache(texture_cache), m_id(0), m_dungeon(false),
+		m_loading_static_objects(false)
 	{
 		m_light_tree.reset(new RStarTree());
 		m_object_tree.reset(new RStarTree());
+		m_static_object_tree.reset(new StaticRStarTree());
 
 		set_ground_hemisphere(glm::vec4(0.2f, 0.2f, 0.2f, 0.0f));
 
@@ -63,6 +66,50 @@ namespace eternal_lands
 	{
 	}
 
+	void Map::add_object_to_tree(const ObjectSharedPtr &object)
+	{
+		if (m_loading_static_objects)
+		{
+			m_static_objects.push_back(object);
+
+			return;
+		}
+
+		m_object_tree->add(object);
+	}
+
+	void Map::begin_static_objects()
+	{
+		m_loading_static_objects = true;
+	}
+
+	void Map::end_static_objects()
+	{
+		BoundedObjectSharedPtrVector objects;
+
+		m_loading_static_objects = false;
+
+		/**
+		 * The tree is build again from all its old objects that
+		 * are not removed and the new ones.
+		 */
+		BOOST_FOREACH(const BoundedObjectSharedPtr &object,
+			m_static_object_tree->get_objects())
+		{
+			if (object.get() != nullptr)
+			{
+				objects.push_back(object);
+			}
+		}
+
+		objects.insert(objects.end(), m_static_objects.begin(),
+			m_static_objects.end());
+
+		m_static_objects.clear();
+
+		m_static_object_tree->build(objects);
+	}
+
 	void Map::add_object(const ObjectDescription &object_description)
 	{
 		std::pair<Uint32ObjectSharedPtrMap::iterator, bool> temp;
@@ -104,7 +151,7 @@ namespace eternal_lands
 
 		assert(temp.second);
 
-		m_object_tree->add(object);
+		add_object_to_tree(object);
 	}
 
 	void Map::add_object(const InstanceData &instance_data)
@@ -132,7 +179,7 @@ namespace eternal_lands
 
 		assert(temp.second);
 
-		m_object_tree->add(object);
+		add_object_to_tree(object);
 	}
 
 	void Map::add_object(const ObjectData &object_data,
@@ -152,7 +199,7 @@ namespace eternal_lands
 
 		assert(temp.second);
 
-		m_object_tree->add(object);
+		add_object_to_tree(object);
 	}
 
 	void Map::add_object(const ObjectData &object_data,
@@ -170,7 +217,7 @@ namespace eternal_lands
 
 		assert(temp.second);
 
-		m_object_tree->add(object);
+		add_object_to_tree(object);
 	}
 
 	void Map::remove_object(const Uint32 id)
@@ -181,7 +228,10 @@ namespace eternal_lands
 
 		if (found != m_objects.end())
 		{
-			m_object_tree->remove(found->second);
+			if (!m_static_object_tree->remove(found->second))
+			{
+				m_object_tree->remove(found->second);
+			}
 
 			m_objects.erase(found);
 		}
@@ -238,6 +288,8 @@ namespace eternal_lands
 	{
 		m_light_tree->clear();
 		m_object_tree->clear();
+		m_static_object_tree->clear();
+		m_static_objects.clear();
 		m_terrain->clear();
 		m_objects.clear();
 		m_lights.clear();
@@ -260,9 +312,19 @@ namespace eternal_lands
 		const
 	{
 		m_terrain->intersect(frustum, visitor);
+		m_static_object_tree->intersect(frustum, visitor);
 		m_object_tree->intersect(frustum, visitor);
 	}
 
+	void Map::intersect(const Frustum &frustum, const Uint16 depth,
+		ObjectVisitor &visitor, RStarTreeSubTreeVector &sub_trees) const
+	{
+		m_terrain->intersect(frustum, visitor);
+		m_static_object_tree->intersect(frustum, depth, visitor,
+			sub_trees);
+		m_object_tree->intersect(frustum, depth, visitor, sub_trees);
+	}
+
 	void Map::intersect(const Frustum &frustum, LightVisitor &visitor)
 		const
 	{
@@ -283,6 +345,7 @@ namespace eternal_lands
 		BoundingBox bounding_box;
 
 		bounding_box = m_object_tree->get_bounding_box();
+		bounding_box.merge(m_static_object_tree->get_bounding_box());
 		bounding_box.merge(m_terrain->get_bounding_box());
 
 		return bounding_box;
@@ -344,16 +407,16 @@ namespace eternal_lands
 		const ImageConstSharedPtr &displacement_map,
 		const ImageConstSharedPtr &normal_tangent_map,
 		const ImageConstSharedPtr &dudv_map,
-		const glm::vec3 &translation)
+		const glm::vec3 &translation, const glm::uvec4 &rect)
 	{
 		m_terrain->update_geometry_maps(displacement_map,
-			normal_tangent_map, dudv_map, translation);
+			normal_tangent_map, dudv_map, translation, rect);
 	}
 
 	void Map::update_terrain_blend_map(const ImageConstSharedPtr &blend_map,
-		const BitSet64 &layers)
+		const BitSet64 &layers, const glm::uvec4 &rect)
 	{
-		m_terrain->update_blend_map(blend_map, layers);
+		m_terrain->update_blend_map(blend_map, layers, rect);
 	}
 
 	void Map::set_terrain_material(const StringVector &albedo_maps,
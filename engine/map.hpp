@@ -40,6 +40,8 @@ namespace eternal_lands
 			const TextureCacheWeakPtr m_texture_cache;
 			boost::scoped_ptr<RStarTree> m_object_tree;
 			boost::scoped_ptr<RStarTree> m_light_tree;
+			boost::scoped_ptr<StaticRStarTree> m_static_object_tree;
+			BoundedObjectSharedPtrVector m_static_objects;
 			ShaderSourceTerrainSharedPtr m_terrain_effect;
 			AbstractTerrainSharedPtr m_terrain;
 			Uint32ObjectSharedPtrMap m_objects;
@@ -51,6 +53,9 @@ namespace eternal_lands
 			String m_name;
 			Uint32 m_id;
 			bool m_dungeon;
+			bool m_loading_static_objects;
+
+			void add_object_to_tree(const ObjectSharedPtr &object);
 
 			inline GlobalVarsConstSharedPtr get_global_vars() const
 				noexcept
@@ -143,6 +148,20 @@ namespace eternal_lands
 				const MaterialSharedPtrVector &materials);
 			void add_object(const InstanceData &instance_data);
 			void remove_object(const Uint32 id);
+
+			/**
+			 * Objects added after this call are collected and only
+			 * added to the static object tree when
+			 * end_static_objects() is called. Use for objects
+			 * that never move, e.g. while loading the map.
+			 */
+			void begin_static_objects();
+
+			/**
+			 * Bulk loads all objects added since
+			 * begin_static_objects() into the static object tree.
+			 */
+			void end_static_objects();
 			bool get_object_position(const Uint32 id,
 				glm::vec3 &position);
 			void add_light(const LightData &light_data);
@@ -156,6 +175,9 @@ namespace eternal_lands
 				TerrainVisitor &terrain) const;
 			void intersect(const Frustum &frustum,
 				ObjectVisitor &visitor) const;
+			void intersect(const Frustum &frustum,
+				const Uint16 depth, ObjectVisitor &visitor,
+				RStarTreeSubTreeVector &sub_trees) const;
 			void intersect(const Frustum &frustum,
 				LightVisitor &visitor) const;
 			void init_terrain_rendering_data(
@@ -182,10 +204,11 @@ namespace eternal_lands
 				const ImageConstSharedPtr &displacement_map,
 				const ImageConstSharedPtr &normal_tangent_map,
 				const ImageConstSharedPtr &dudv_map,
-				const glm::vec3 &translation);
+				const glm::vec3 &translation,
+				const glm::uvec4 &rect);
 			void update_terrain_blend_map(
 				const ImageConstSharedPtr &blend_map,
-				const BitSet64 &layers);
+				const BitSet64 &layers, const glm::uvec4 &rect);
 			void set_terrain_material(
 				const StringVector &albedo_maps,
 				const StringVector &specular_maps,
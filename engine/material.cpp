@@ -125,8 +125,8 @@ namespace eternal_lands
 			return;
 		}
 
-		m_textures[sampler] = get_texture_cache()->get_texture(name,
-			sRGB, rectangle);
+		m_textures[sampler] = get_texture_cache()->get_streamed_texture(
+			name, sRGB, rectangle);
 	}
 
 	const String &Material::get_texture_name(
@@ -8,10 +8,22 @@
 #include "materialcache.hpp"
 #include "materialdescriptioncache.hpp"
 #include "materialbuilder.hpp"
+#include "material.hpp"
 
 namespace eternal_lands
 {
 
+	namespace
+	{
+
+		/**
+		 * The textures of the materials are in the texture cache,
+		 * so the budget is only for the material objects.
+		 */
+		const Uint64 material_cache_budget = 1024 * 1024;
+
+	}
+
 	MaterialCache::MaterialCache(
 		const MaterialBuilderWeakPtr &material_builder,
 		const MaterialDescriptionCacheWeakPtr
@@ -21,31 +33,52 @@ namespace eternal_lands
 	{
 		assert(!m_material_builder.expired());
 		assert(!m_material_description_cache.expired());
+
+		m_material_cache.set_budget(material_cache_budget);
 	}
 
 	MaterialCache::~MaterialCache() noexcept
 	{
 	}
 
-	const MaterialSharedPtr &MaterialCache::get_material(const String &name)
+	bool MaterialCache::MaterialCacheTraits::get_unused(
+		const MaterialSharedPtr &material) noexcept
 	{
-		StringMaterialSharedPtrMap::iterator found;
-		MaterialSharedPtr material;
+		return material.unique();
+	}
 
-		found = m_material_cache.find(name);
+	Uint64 MaterialCache::MaterialCacheTraits::get_memory_usage(
+		const MaterialSharedPtr &material) noexcept
+	{
+		return sizeof(Material);
+	}
 
-		if (found != m_material_cache.end())
+	MaterialSharedPtr MaterialCache::get_material(const String &name)
+	{
+		MaterialSharedPtr material;
+
+		if (m_material_cache.find(name, material))
 		{
-			return found->second;
+			return material;
 		}
 
 		material = get_material_builder()->get_material(
 			get_material_description_cache(
 				)->get_material_description(name));
 
-		m_material_cache[name] = material;
+		m_material_cache.add(name, material);
+
+		return material;
+	}
 
-		return m_material_cache[name];
+	void MaterialCache::trim()
+	{
+		m_material_cache.trim();
+	}
+
+	String MaterialCache::get_statistics() const
+	{
+		return m_material_cache.get_statistics();
 	}
 
 }
@@ -13,6 +13,7 @@
 #endif	/* __cplusplus */
 
 #include "prerequisites.hpp"
+#include "lrucache.hpp"
 
 /**
  * @file
@@ -25,10 +26,22 @@ namespace eternal_lands
 	class MaterialCache: public boost::noncopyable
 	{
 		private:
-			typedef std::map<String, MaterialSharedPtr>
-				StringMaterialSharedPtrMap;
+			class MaterialCacheTraits
+			{
+				public:
+					static bool get_unused(
+						const MaterialSharedPtr &material)
+						noexcept;
+					static Uint64 get_memory_usage(
+						const MaterialSharedPtr &material)
+						noexcept;
+
+			};
+
+			typedef LruCache<MaterialSharedPtr, MaterialCacheTraits>
+				MaterialLruCache;
 
-			StringMaterialSharedPtrMap m_material_cache;
+			MaterialLruCache m_material_cache;
 			const MaterialBuilderWeakPtr m_material_builder;
 			const MaterialDescriptionCacheWeakPtr
 				m_material_description_cache;
@@ -64,8 +77,15 @@ namespace eternal_lands
 					&material_description_cache);
 			~MaterialCache() noexcept;
 			StringVector get_material_names() const;
-			const MaterialSharedPtr &get_material(
-				const String &name);
+			MaterialSharedPtr get_material(const String &name);
+
+			/**
+			 * Removes the least recently used materials that are
+			 * not used any more, until the cache fits into its
+			 * budget.
+			 */
+			void trim();
+			String get_statistics() const;
 
 	};
 
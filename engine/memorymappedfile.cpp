@@ -0,0 +1,158 @@
+/****************************************************************************
+ *            memorymappedfile.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "memorymappedfile.hpp"
+#include "exceptions.hpp"
+#include "utf.hpp"
+#ifdef	WINDOWS
+#include <windows.h>
+#else	/* WINDOWS */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif	/* WINDOWS */
+
+namespace eternal_lands
+{
+
+#ifdef	WINDOWS
+	MemoryMappedFile::MemoryMappedFile(const String &name): m_ptr(0),
+		m_size(0)
+	{
+		HANDLE file, mapping;
+		LARGE_INTEGER size;
+
+		file = CreateFileA(utf8_to_string(name).c_str(), GENERIC_READ,
+			FILE_SHARE_READ, 0, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, 0);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			EL_THROW_EXCEPTION(FileNotFoundException()
+				<< boost::errinfo_file_name(name));
+		}
+
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Can't get file size"))
+				<< boost::errinfo_file_name(name));
+		}
+
+		m_size = size.QuadPart;
+
+		if (m_size == 0)
+		{
+			CloseHandle(file);
+
+			return;
+		}
+
+		mapping = CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+
+		CloseHandle(file);
+
+		if (mapping == 0)
+		{
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Can't map file"))
+				<< boost::errinfo_file_name(name));
+		}
+
+		/* The view keeps the mapping alive */
+		m_ptr = static_cast<const Uint8*>(MapViewOfFile(mapping,
+			FILE_MAP_READ, 0, 0, 0));
+
+		CloseHandle(mapping);
+
+		if (m_ptr == 0)
+		{
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Can't map file"))
+				<< boost::errinfo_file_name(name));
+		}
+	}
+
+	MemoryMappedFile::~MemoryMappedFile() noexcept
+	{
+		if (m_ptr != nullptr)
+		{
+			UnmapViewOfFile(m_ptr);
+		}
+	}
+#else	/* WINDOWS */
+	MemoryMappedFile::MemoryMappedFile(const String &name): m_ptr(0),
+		m_size(0)
+	{
+		struct stat file_stat;
+		void* ptr;
+		int file;
+
+		file = open(utf8_to_string(name).c_str(), O_RDONLY);
+
+		if (file == -1)
+		{
+			EL_THROW_EXCEPTION(FileNotFoundException()
+				<< boost::errinfo_file_name(name));
+		}
+
+		if (fstat(file, &file_stat) != 0)
+		{
+			close(file);
+
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Can't get file size"))
+				<< boost::errinfo_file_name(name));
+		}
+
+		m_size = file_stat.st_size;
+
+		if (m_size == 0)
+		{
+			close(file);
+
+			return;
+		}
+
+		ptr = mmap(0, m_size, PROT_READ, MAP_SHARED, file, 0);
+
+		/* The mapping stays valid after closing the file */
+		close(file);
+
+		if (ptr == MAP_FAILED)
+		{
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Can't map file"))
+				<< boost::errinfo_file_name(name));
+		}
+
+		m_ptr = static_cast<const Uint8*>(ptr);
+	}
+
+	MemoryMappedFile::~MemoryMappedFile() noexcept
+	{
+		if (m_ptr != nullptr)
+		{
+			munmap(const_cast<Uint8*>(m_ptr), m_size);
+		}
+	}
+#endif	/* WINDOWS */
+
+	const void* MemoryMappedFile::get_ptr() const noexcept
+	{
+		return m_ptr;
+	}
+
+	Uint64 MemoryMappedFile::get_size() const noexcept
+	{
+		return m_size;
+	}
+
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+ *            memorymappedfile.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_ee9c3cdb_766e_4bbc_8cd9_177003712003
+#define	UUID_ee9c3cdb_766e_4bbc_8cd9_177003712003
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include "abstractreadmemory.hpp"
+
+/**
+ * @file
+ * @brief The @c class MemoryMappedFile.
+ * This file contains the @c class MemoryMappedFile.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief @c class for read only memory mapped files.
+	 *
+	 * Maps the whole file read only into memory. The pages are read by
+	 * the operating system when they are used, so the file can be
+	 * read from many threads at the same time without any locking.
+	 */
+	class MemoryMappedFile: public AbstractReadMemory
+	{
+		private:
+			/**
+			 * @brief Pointer to the memory.
+			 *
+			 * Pointer to the mapped memory, page aligned.
+			 */
+			const Uint8* m_ptr;
+
+			/**
+			 * @brief The size of the memory.
+			 *
+			 * The size of the mapped file in bytes.
+			 */
+			Uint64 m_size;
+
+		public:
+			/**
+			 * Default constructor.
+			 * @param name The name of the file to map.
+			 */
+			MemoryMappedFile(const String &name);
+
+			/**
+			 * Default destructor.
+			 */
+			virtual ~MemoryMappedFile() noexcept;
+
+			/**
+			 * @brief Gets the pointer of the memory.
+			 *
+			 * Gets the pointer of the memory.
+			 * @return Returns the pointer of the memory.
+			 */
+			virtual const void* get_ptr() const noexcept;
+
+			/**
+			 * @brief Gets the size of the memory.
+			 *
+			 * Gets the size of the memory.
+			 * @return Returns the size of the memory.
+			 */
+			virtual Uint64 get_size() const noexcept;
+
+	};
+
+}
+
+#endif	/* UUID_ee9c3cdb_766e_4bbc_8cd9_177003712003 */
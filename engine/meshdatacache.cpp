@@ -17,6 +17,10 @@
 #include "submesh.hpp"
 #include "globalvars.hpp"
 #include "exceptions.hpp"
+#include "memorymappedfile.hpp"
+#include "writer.hpp"
+#include "utf.hpp"
+#include "cachefilewriter.hpp"
 
 namespace eternal_lands
 {
@@ -511,19 +515,154 @@ namespace eternal_lands
 			return false;
 		}
 
-	}
+		/**
+		 * Magic number, version and byte order mark of the mesh data
+		 * disk cache files. The vertex and index buffers are saved in
+		 * the byte order of the machine, so files of other machines
+		 * are ignored. Increase the version when the format of the
+		 * files or the processing of the meshs changes.
+		 */
+		const Uint32 mesh_data_cache_magic = 0x434D4C45;
+		const Uint32 mesh_data_cache_version = 1;
+		const Uint32 mesh_data_cache_byte_order = 0x01020304;
+
+		/**
+		 * The name depends on the content of the source file and on
+		 * the OpenGL features the mesh data is processed for, so a
+		 * changed source file uses a new cache file.
+		 */
+		String get_cache_file_name(const String &dir,
+			const ReaderSharedPtr &reader, const bool opengl_3_1,
+			const bool opengl_3_2)
+		{
+			StringStream str;
 
-	class MeshDataCache::MeshDataCacheItem
-	{
-		public:
-			MeshDataToolSharedPtr m_mesh_data_tool;
-			StringVector m_materials;
-	};
+			str << dir << FileSystem::get_sha1_string(
+				FileSystem::get_content_sha1(reader));
+			str << UTF8("_") << opengl_3_1 << opengl_3_2;
+			str << UTF8(".elmc");
+
+			return String(str.str());
+		}
+
+		bool load_cached_mesh(const String &file_name,
+			const String &name, const bool use_simd,
+			MeshDataToolSharedPtr &mesh_data_tool,
+			StringVector &materials)
+		{
+			MemoryMappedFileSharedPtr memory;
+			Uint32 i, count, byte_order;
+
+			try
+			{
+				memory = boost::make_shared<MemoryMappedFile>(
+					file_name);
+
+				Reader reader(memory, file_name);
+
+				if (!reader.check_size(4 * sizeof(Uint32)))
+				{
+					return false;
+				}
+
+				if ((reader.read_u32_le() !=
+						mesh_data_cache_magic) ||
+					(reader.read_u32_le() !=
+						mesh_data_cache_version))
+				{
+					return false;
+				}
+
+				reader.read(&byte_order, sizeof(byte_order));
+
+				if (byte_order != mesh_data_cache_byte_order)
+				{
+					return false;
+				}
+
+				count = reader.read_u32_le();
+
+				if (!reader.check_size(count))
+				{
+					return false;
+				}
+
+				materials.clear();
+
+				for (i = 0; i < count; ++i)
+				{
+					materials.push_back(
+						reader.read_dynamic_utf8_string(
+							));
+				}
+
+				mesh_data_tool.reset(new MeshDataTool(name,
+					reader, use_simd));
+
+				return true;
+			}
+			catch (const FileNotFoundException &)
+			{
+				return false;
+			}
+			catch (boost::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+			catch (std::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+
+			materials.clear();
+
+			return false;
+		}
+
+		void save_cached_mesh(const String &file_name,
+			const MeshDataToolSharedPtr &mesh_data_tool,
+			const StringVector &materials)
+		{
+			CacheFileWriter file(file_name);
+
+			if (!file.get_open())
+			{
+				LOG_WARNING(lt_mesh, UTF8("Can't create mesh "
+					"data cache file '%1%'"), file_name);
+
+				return;
+			}
+
+			Writer &writer = file.get_writer();
+
+			writer.write_u32_le(mesh_data_cache_magic);
+			writer.write_u32_le(mesh_data_cache_version);
+			writer.write(&mesh_data_cache_byte_order,
+				sizeof(mesh_data_cache_byte_order));
+			writer.write_u32_le(materials.size());
+
+			BOOST_FOREACH(const String &material, materials)
+			{
+				writer.write_dynamic_utf8_string(material);
+			}
+
+			mesh_data_tool->save(writer);
+
+			if (!file.commit())
+			{
+				LOG_WARNING(lt_mesh, UTF8("Can't write mesh "
+					"data cache file '%1%'"), file_name);
+			}
+		}
+
+	}
 
 	MeshDataCache::MeshDataCache(
 		const GlobalVarsConstSharedPtr &global_vars,
-		const FileSystemConstSharedPtr &file_system):
-		m_global_vars(global_vars), m_file_system(file_system)
+		const FileSystemConstSharedPtr &file_system,
+		const JobSystemWeakPtr &job_system):
+		m_global_vars(global_vars), m_file_system(file_system),
+		m_job_system(job_system)
 	{
 		assert(m_global_vars.get() != nullptr);
 		assert(m_file_system.get() != nullptr);
@@ -533,11 +672,48 @@ namespace eternal_lands
 	{
 	}
 
+	bool MeshDataCache::MeshDataCacheTraits::get_unused(
+		const MeshDataCacheItem &item) noexcept
+	{
+		return item.m_mesh_data_tool.unique();
+	}
+
+	Uint64 MeshDataCache::MeshDataCacheTraits::get_memory_usage(
+		const MeshDataCacheItem &item) noexcept
+	{
+		return item.m_mesh_data_tool->get_memory_usage();
+	}
+
+	void MeshDataCache::process_mesh(const ReaderSharedPtr &reader,
+		MeshDataToolSharedPtr &mesh_data_tool,
+		StringVector &materials)
+	{
+		do_load_mesh(reader, get_global_vars()->get_use_simd(),
+			mesh_data_tool, materials);
+
+		mesh_data_tool->optimize();
+
+		if (!get_global_vars()->get_opengl_3_1())
+		{
+			mesh_data_tool->disable_restart_index();
+		}
+
+		if (!get_global_vars()->get_opengl_3_2())
+		{
+			mesh_data_tool->disable_use_base_vertex();
+		}
+
+		mesh_data_tool->build_min_max_boxes();
+		mesh_data_tool->build_tangent(false, true,
+			get_job_system().lock().get());
+	}
+
 	void MeshDataCache::load_mesh(const String &name,
 		MeshDataToolSharedPtr &mesh_data_tool,
 		StringVector &materials)
 	{
 		ReaderSharedPtr reader;
+		String file_name;
 
 		try
 		{
@@ -546,6 +722,10 @@ namespace eternal_lands
 				get_global_vars()->get_use_simd(),
 				mesh_data_tool))
 			{
+				mesh_data_tool->build_min_max_boxes();
+				mesh_data_tool->build_tangent(false, true,
+					get_job_system().lock().get());
+
 				materials.resize(1);
 
 				return;
@@ -553,21 +733,32 @@ namespace eternal_lands
 
 			reader = get_file_system()->get_file(name);
 
-			do_load_mesh(reader, get_global_vars()->get_use_simd(),
-				mesh_data_tool, materials);
-
-			mesh_data_tool->optimize();
-
-			if (!get_global_vars()->get_opengl_3_1())
+			if (get_global_vars()->get_mesh_data_cache_dir(
+				).get().empty())
 			{
-				mesh_data_tool->disable_restart_index();
+				process_mesh(reader, mesh_data_tool,
+					materials);
+
+				return;
 			}
 
-			if (!get_global_vars()->get_opengl_3_2())
+			file_name = get_cache_file_name(
+				get_global_vars()->get_mesh_data_cache_dir(),
+				reader, get_global_vars()->get_opengl_3_1(),
+				get_global_vars()->get_opengl_3_2());
+
+			if (load_cached_mesh(file_name, name,
+				get_global_vars()->get_use_simd(),
+				mesh_data_tool, materials))
 			{
-				mesh_data_tool->disable_use_base_vertex();
+				return;
 			}
 
+			process_mesh(reader, mesh_data_tool, materials);
+
+			save_cached_mesh(file_name, mesh_data_tool,
+				materials);
+
 			return;
 		}
 		catch (boost::exception &exception)
@@ -582,6 +773,10 @@ namespace eternal_lands
 		load_error_sphere(String(UTF8("sphere")),
 			get_global_vars()->get_use_simd(), mesh_data_tool);
 
+		mesh_data_tool->build_min_max_boxes();
+		mesh_data_tool->build_tangent(false, true,
+			get_job_system().lock().get());
+
 		materials.resize(1);
 	}
 
@@ -590,27 +785,16 @@ namespace eternal_lands
 		StringVector &materials)
 	{
 		MeshDataCache::MeshDataCacheItem tmp;
-		MeshDataCacheMap::iterator found;
-
-		found = m_mesh_data_cache.find(name);
 
-		if (found == m_mesh_data_cache.end())
+		if (!m_mesh_data_cache.find(name, tmp))
 		{
 			load_mesh(name, tmp.m_mesh_data_tool, tmp.m_materials);
 
-			tmp.m_mesh_data_tool->build_min_max_boxes();	
-			tmp.m_mesh_data_tool->build_tangent(false, true);
-
-			m_mesh_data_cache[name] = tmp;
-
-			mesh_data_tool = tmp.m_mesh_data_tool;
-			materials = tmp.m_materials;
-		}
-		else
-		{
-			mesh_data_tool = found->second.m_mesh_data_tool;
-			materials = found->second.m_materials;
+			m_mesh_data_cache.add(name, tmp);
 		}
+
+		mesh_data_tool = tmp.m_mesh_data_tool;
+		materials = tmp.m_materials;
 	}
 
 	void MeshDataCache::get_mesh_data(const String &name,
@@ -621,24 +805,30 @@ namespace eternal_lands
 		get_mesh_data(name, mesh_data_tool, materials);
 	}
 
-	const StringVector &MeshDataCache::get_mesh_materials(
-		const String &name)
+	StringVector MeshDataCache::get_mesh_materials(const String &name)
 	{
 		MeshDataCache::MeshDataCacheItem tmp;
-		MeshDataCacheMap::iterator found;
-
-		found = m_mesh_data_cache.find(name);
 
-		if (found == m_mesh_data_cache.end())
+		if (!m_mesh_data_cache.find(name, tmp))
 		{
 			load_mesh(name, tmp.m_mesh_data_tool, tmp.m_materials);
 
-			m_mesh_data_cache[name] = tmp;
-
-			found = m_mesh_data_cache.find(name);
+			m_mesh_data_cache.add(name, tmp);
 		}
 
-		return found->second.m_materials;
+		return tmp.m_materials;
+	}
+
+	void MeshDataCache::trim()
+	{
+		m_mesh_data_cache.set_budget(static_cast<Uint64>(
+			get_global_vars()->get_mesh_cache_size()) * 1024 * 1024);
+		m_mesh_data_cache.trim();
+	}
+
+	String MeshDataCache::get_statistics() const
+	{
+		return m_mesh_data_cache.get_statistics();
 	}
 
 }
@@ -13,6 +13,7 @@
 #endif	/* __cplusplus */
 
 #include "prerequisites.hpp"
+#include "lrucache.hpp"
 
 /**
  * @file
@@ -30,14 +31,33 @@ namespace eternal_lands
 	class MeshDataCache: public boost::noncopyable
 	{
 		private:
-			class MeshDataCacheItem;
+			class MeshDataCacheItem
+			{
+				public:
+					MeshDataToolSharedPtr m_mesh_data_tool;
+					StringVector m_materials;
+
+			};
+
+			class MeshDataCacheTraits
+			{
+				public:
+					static bool get_unused(
+						const MeshDataCacheItem &item)
+						noexcept;
+					static Uint64 get_memory_usage(
+						const MeshDataCacheItem &item)
+						noexcept;
 
-			typedef std::map<String, MeshDataCacheItem>
-				MeshDataCacheMap;
+			};
+
+			typedef LruCache<MeshDataCacheItem, MeshDataCacheTraits>
+				MeshDataLruCache;
 
 			const GlobalVarsConstSharedPtr m_global_vars;
 			const FileSystemConstSharedPtr m_file_system;
-			MeshDataCacheMap m_mesh_data_cache;
+			const JobSystemWeakPtr m_job_system;
+			MeshDataLruCache m_mesh_data_cache;
 
 			inline const FileSystemConstSharedPtr &get_file_system()
 				const noexcept
@@ -51,6 +71,22 @@ namespace eternal_lands
 				return m_global_vars;
 			}
 
+			inline const JobSystemWeakPtr &get_job_system() const
+				noexcept
+			{
+				return m_job_system;
+			}
+
+			void process_mesh(const ReaderSharedPtr &reader,
+				MeshDataToolSharedPtr &mesh_data_tool,
+				StringVector &materials);
+
+			/**
+			 * Loads the mesh, from the mesh data disk cache if
+			 * the processed mesh data of the file content is
+			 * there, otherwise from the file. Newly processed
+			 * mesh data is saved in the disk cache.
+			 */
 			void load_mesh(const String &name,
 				MeshDataToolSharedPtr &mesh_data_tool,
 				StringVector &materials);
@@ -61,7 +97,8 @@ namespace eternal_lands
 			 */
 			MeshDataCache(
 				const GlobalVarsConstSharedPtr &global_vars,
-				const FileSystemConstSharedPtr &file_system);
+				const FileSystemConstSharedPtr &file_system,
+				const JobSystemWeakPtr &job_system);
 
 			/**
 			 * Default destructor.
@@ -72,8 +109,15 @@ namespace eternal_lands
 				StringVector &materials);
 			void get_mesh_data(const String &name,
 				MeshDataToolSharedPtr &mesh_data_tool);
-			const StringVector &get_mesh_materials(
-				const String &name);
+			StringVector get_mesh_materials(const String &name);
+
+			/**
+			 * Removes the least recently used mesh data that is
+			 * not used any more, until the cache fits into the
+			 * mesh cache size of the global vars.
+			 */
+			void trim();
+			String get_statistics() const;
 
 	};
 
@@ -17,6 +17,11 @@
 #include "vertexstreams.hpp"
 #include "simd/simd.hpp"
 #include "cpurasterizer.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
 
 namespace eternal_lands
 {
@@ -272,6 +277,492 @@ namespace eternal_lands
 			bitangent = glm::vec3(t0.x * p1 - t1.x * p0) * r;
 		}
 
+		/**
+		 * Number of triangles or vertices processed by one task.
+		 */
+		const Uint32 build_block_size = 16384;
+
+		void build_face_normals(const AlignedVec4Array &positions,
+			const Uint32Vector &indices, const bool use_simd,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &normals)
+		{
+			Vec3Array3 vertices;
+			Uint32 i, j, count;
+
+			i = begin;
+			count = (end - begin) & ~0x03;
+
+			if (use_simd && (count > 0))
+			{
+				SIMD::build_face_normals(positions.get_ptr(),
+					&indices[begin * 3], count,
+					normals.get_ptr_at(begin));
+
+				i += count;
+			}
+
+			for (; i < end; ++i)
+			{
+				for (j = 0; j < 3; ++j)
+				{
+					vertices[j] = glm::vec3(
+						positions[indices[i * 3 + j]]);
+				}
+
+				normals[i] = glm::vec4(get_normal(vertices),
+					0.0f);
+			}
+		}
+
+		void build_face_tangents(const AlignedVec4Array &positions,
+			const AlignedVec4Array &texture_coords,
+			const Uint32Vector &indices, const bool use_simd,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &tangents,
+			AlignedVec4Array &bitangents)
+		{
+			Vec3Array3 vertices;
+			Vec2Array3 uvs;
+			glm::vec3 tangent, bitangent;
+			Uint32 i, j, index, count;
+
+			i = begin;
+			count = (end - begin) & ~0x03;
+
+			if (use_simd && (count > 0))
+			{
+				SIMD::build_face_tangents(positions.get_ptr(),
+					texture_coords.get_ptr(),
+					&indices[begin * 3], count,
+					tangents.get_ptr_at(begin),
+					bitangents.get_ptr_at(begin));
+
+				i += count;
+			}
+
+			for (; i < end; ++i)
+			{
+				for (j = 0; j < 3; ++j)
+				{
+					index = indices[i * 3 + j];
+
+					vertices[j] = glm::vec3(
+						positions[index]);
+					uvs[j] = glm::vec2(
+						texture_coords[index]);
+				}
+
+				get_tangent(vertices, uvs, tangent, bitangent);
+
+				tangents[i] = glm::vec4(tangent, 0.0f);
+				bitangents[i] = glm::vec4(bitangent, 0.0f);
+			}
+		}
+
+		/**
+		 * Builds the list of triangles using each vertex, sorted by
+		 * triangle. The triangles of vertex i are stored from
+		 * offsets[i] to offsets[i + 1], so each vertex can sum
+		 * the values of its triangles without any locking.
+		 */
+		void build_vertex_triangles(const Uint32Vector &indices,
+			const Uint32 vertex_count, Uint32Vector &offsets,
+			Uint32Vector &triangles)
+		{
+			Uint32Vector next;
+			Uint32 i, index, count;
+
+			count = indices.size();
+
+			offsets.assign(vertex_count + 1, 0);
+			triangles.resize(count);
+
+			for (i = 0; i < count; ++i)
+			{
+				assert(indices[i] < vertex_count);
+
+				offsets[indices[i] + 1]++;
+			}
+
+			for (i = 0; i < vertex_count; ++i)
+			{
+				offsets[i + 1] += offsets[i];
+			}
+
+			next.assign(offsets.begin(), offsets.end() - 1);
+
+			for (i = 0; i < count; ++i)
+			{
+				index = indices[i];
+
+				triangles[next[index]] = i / 3;
+				next[index]++;
+			}
+		}
+
+		void build_vertex_normals(const Uint32Vector &offsets,
+			const Uint32Vector &triangles,
+			const AlignedVec4Array &face_normals,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &normals)
+		{
+			glm::vec3 normal;
+			Uint32 i, j;
+			float len;
+
+			for (i = begin; i < end; ++i)
+			{
+				normal = glm::vec3(0.0f);
+
+				for (j = offsets[i]; j < offsets[i + 1]; ++j)
+				{
+					normal += glm::vec3(
+						face_normals[triangles[j]]);
+				}
+
+				len = glm::dot(normal, normal);
+
+				if (len < epsilon)
+				{
+					normal = glm::vec3(0.0f, 0.0f, 1.0f);
+				}
+				else
+				{
+					normal /= std::sqrt(len);
+				}
+
+				normals[i] = glm::vec4(normal, 1.0f);
+			}
+		}
+
+		void build_vertex_tangents(const Uint32Vector &offsets,
+			const Uint32Vector &triangles,
+			const AlignedVec4Array &face_tangents,
+			const AlignedVec4Array &face_bitangents,
+			const AlignedVec4Array &normals,
+			const bool gram_schmidth_orthogonalize,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &tangents)
+		{
+			glm::vec3 normal, tangent, bitangent;
+			Uint32 i, j, index;
+
+			for (i = begin; i < end; ++i)
+			{
+				tangent = glm::vec3(0.0f);
+				bitangent = glm::vec3(0.0f);
+
+				for (j = offsets[i]; j < offsets[i + 1]; ++j)
+				{
+					index = triangles[j];
+
+					tangent += glm::vec3(
+						face_tangents[index]);
+					bitangent += glm::vec3(
+						face_bitangents[index]);
+				}
+
+				if (glm::dot(tangent, tangent) < 0.0001f)
+				{
+					tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+				}
+
+				if (!gram_schmidth_orthogonalize)
+				{
+					tangents[i] = glm::vec4(
+						glm::normalize(tangent), 1.0f);
+
+					continue;
+				}
+
+				normal = glm::vec3(normals[i]);
+
+				tangents[i] = MeshDataTool::
+					get_gram_schmidth_orthogonalize_tangent(
+						normal, tangent, bitangent);
+			}
+		}
+
+		class FaceNormalsTask: public AbstractThreadTask
+		{
+			private:
+				const AlignedVec4Array &m_positions;
+				const Uint32Vector &m_indices;
+				AlignedVec4Array &m_normals;
+				const Uint32 m_begin;
+				const Uint32 m_end;
+				const bool m_use_simd;
+
+			public:
+				FaceNormalsTask(
+					const AlignedVec4Array &positions,
+					const Uint32Vector &indices,
+					const bool use_simd, const Uint32 begin,
+					const Uint32 end,
+					AlignedVec4Array &normals);
+				virtual ~FaceNormalsTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		FaceNormalsTask::FaceNormalsTask(
+			const AlignedVec4Array &positions,
+			const Uint32Vector &indices, const bool use_simd,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &normals): m_positions(positions),
+			m_indices(indices), m_normals(normals), m_begin(begin),
+			m_end(end), m_use_simd(use_simd)
+		{
+		}
+
+		FaceNormalsTask::~FaceNormalsTask() noexcept
+		{
+		}
+
+		void FaceNormalsTask::operator()()
+		{
+			build_face_normals(m_positions, m_indices, m_use_simd,
+				m_begin, m_end, m_normals);
+		}
+
+		class FaceTangentsTask: public AbstractThreadTask
+		{
+			private:
+				const AlignedVec4Array &m_positions;
+				const AlignedVec4Array &m_texture_coords;
+				const Uint32Vector &m_indices;
+				AlignedVec4Array &m_tangents;
+				AlignedVec4Array &m_bitangents;
+				const Uint32 m_begin;
+				const Uint32 m_end;
+				const bool m_use_simd;
+
+			public:
+				FaceTangentsTask(
+					const AlignedVec4Array &positions,
+					const AlignedVec4Array &texture_coords,
+					const Uint32Vector &indices,
+					const bool use_simd, const Uint32 begin,
+					const Uint32 end,
+					AlignedVec4Array &tangents,
+					AlignedVec4Array &bitangents);
+				virtual ~FaceTangentsTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		FaceTangentsTask::FaceTangentsTask(
+			const AlignedVec4Array &positions,
+			const AlignedVec4Array &texture_coords,
+			const Uint32Vector &indices, const bool use_simd,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &tangents,
+			AlignedVec4Array &bitangents): m_positions(positions),
+			m_texture_coords(texture_coords), m_indices(indices),
+			m_tangents(tangents), m_bitangents(bitangents),
+			m_begin(begin), m_end(end), m_use_simd(use_simd)
+		{
+		}
+
+		FaceTangentsTask::~FaceTangentsTask() noexcept
+		{
+		}
+
+		void FaceTangentsTask::operator()()
+		{
+			build_face_tangents(m_positions, m_texture_coords,
+				m_indices, m_use_simd, m_begin, m_end,
+				m_tangents, m_bitangents);
+		}
+
+		class VertexTrianglesTask: public AbstractThreadTask
+		{
+			private:
+				const Uint32Vector &m_indices;
+				Uint32Vector &m_offsets;
+				Uint32Vector &m_triangles;
+				const Uint32 m_vertex_count;
+
+			public:
+				VertexTrianglesTask(const Uint32Vector &indices,
+					const Uint32 vertex_count,
+					Uint32Vector &offsets,
+					Uint32Vector &triangles);
+				virtual ~VertexTrianglesTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		VertexTrianglesTask::VertexTrianglesTask(
+			const Uint32Vector &indices, const Uint32 vertex_count,
+			Uint32Vector &offsets, Uint32Vector &triangles):
+			m_indices(indices), m_offsets(offsets),
+			m_triangles(triangles), m_vertex_count(vertex_count)
+		{
+		}
+
+		VertexTrianglesTask::~VertexTrianglesTask() noexcept
+		{
+		}
+
+		void VertexTrianglesTask::operator()()
+		{
+			build_vertex_triangles(m_indices, m_vertex_count,
+				m_offsets, m_triangles);
+		}
+
+		class VertexNormalsTask: public AbstractThreadTask
+		{
+			private:
+				const Uint32Vector &m_offsets;
+				const Uint32Vector &m_triangles;
+				const AlignedVec4Array &m_face_normals;
+				AlignedVec4Array &m_normals;
+				const Uint32 m_begin;
+				const Uint32 m_end;
+
+			public:
+				VertexNormalsTask(const Uint32Vector &offsets,
+					const Uint32Vector &triangles,
+					const AlignedVec4Array &face_normals,
+					const Uint32 begin, const Uint32 end,
+					AlignedVec4Array &normals);
+				virtual ~VertexNormalsTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		VertexNormalsTask::VertexNormalsTask(
+			const Uint32Vector &offsets,
+			const Uint32Vector &triangles,
+			const AlignedVec4Array &face_normals,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &normals): m_offsets(offsets),
+			m_triangles(triangles), m_face_normals(face_normals),
+			m_normals(normals), m_begin(begin), m_end(end)
+		{
+		}
+
+		VertexNormalsTask::~VertexNormalsTask() noexcept
+		{
+		}
+
+		void VertexNormalsTask::operator()()
+		{
+			build_vertex_normals(m_offsets, m_triangles,
+				m_face_normals, m_begin, m_end, m_normals);
+		}
+
+		class VertexTangentsTask: public AbstractThreadTask
+		{
+			private:
+				const Uint32Vector &m_offsets;
+				const Uint32Vector &m_triangles;
+				const AlignedVec4Array &m_face_tangents;
+				const AlignedVec4Array &m_face_bitangents;
+				const AlignedVec4Array &m_normals;
+				AlignedVec4Array &m_tangents;
+				const Uint32 m_begin;
+				const Uint32 m_end;
+				const bool m_gram_schmidth_orthogonalize;
+
+			public:
+				VertexTangentsTask(const Uint32Vector &offsets,
+					const Uint32Vector &triangles,
+					const AlignedVec4Array &face_tangents,
+					const AlignedVec4Array &face_bitangents,
+					const AlignedVec4Array &normals,
+					const bool gram_schmidth_orthogonalize,
+					const Uint32 begin, const Uint32 end,
+					AlignedVec4Array &tangents);
+				virtual ~VertexTangentsTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		VertexTangentsTask::VertexTangentsTask(
+			const Uint32Vector &offsets,
+			const Uint32Vector &triangles,
+			const AlignedVec4Array &face_tangents,
+			const AlignedVec4Array &face_bitangents,
+			const AlignedVec4Array &normals,
+			const bool gram_schmidth_orthogonalize,
+			const Uint32 begin, const Uint32 end,
+			AlignedVec4Array &tangents): m_offsets(offsets),
+			m_triangles(triangles), m_face_tangents(face_tangents),
+			m_face_bitangents(face_bitangents), m_normals(normals),
+			m_tangents(tangents), m_begin(begin), m_end(end),
+			m_gram_schmidth_orthogonalize(
+				gram_schmidth_orthogonalize)
+		{
+		}
+
+		VertexTangentsTask::~VertexTangentsTask() noexcept
+		{
+		}
+
+		void VertexTangentsTask::operator()()
+		{
+			build_vertex_tangents(m_offsets, m_triangles,
+				m_face_tangents, m_face_bitangents, m_normals,
+				m_gram_schmidth_orthogonalize, m_begin, m_end,
+				m_tangents);
+		}
+
+		/**
+		 * Adds the task to the job system or executes it at once,
+		 * if no job system is used.
+		 */
+		void run_task(std::auto_ptr<AbstractThreadTask> &task,
+			JobSystem* job_system, TaskGroup &task_group)
+		{
+			if (job_system == nullptr)
+			{
+				(*task)();
+				task.reset();
+
+				return;
+			}
+
+			job_system->add(task, task_group);
+		}
+
+		void wait_tasks(JobSystem* job_system,
+			const TaskGroup &task_group)
+		{
+			if (job_system != nullptr)
+			{
+				job_system->wait(task_group);
+			}
+		}
+
+		void check_primitive(const PrimitiveType primitive)
+		{
+			if ((primitive != pt_triangles) &&
+				(primitive != pt_triangle_fan) &&
+				(primitive != pt_triangle_strip))
+			{
+				EL_THROW_EXCEPTION(InvalidParameterException()
+					<< errinfo_message(UTF8("Only triangle "
+						"primitives supported"))
+					<< errinfo_string_value(
+						PrimitiveUtil::get_str(
+						primitive)));
+			}
+		}
+
+		/**
+		 * Counts, primitive and restart index flag.
+		 */
+		const Uint32 header_size = 6 * sizeof(Uint32) + sizeof(Uint8);
+
+		/**
+		 * Bounding box, draw data, min max boxes and packed flag.
+		 */
+		const Uint32 sub_mesh_size = 6 * sizeof(float) +
+			7 * sizeof(Uint32) + sizeof(Uint8);
+
 	}
 
 	MeshDataTool::MeshDataTool(const String &name,
@@ -284,17 +775,7 @@ namespace eternal_lands
 	{
 		assert(!get_name().get().empty());
 
-		if ((primitive != pt_triangles) &&
-			(primitive != pt_triangle_fan) &&
-			(primitive != pt_triangle_strip))
-		{
-			EL_THROW_EXCEPTION(InvalidParameterException()
-				<< errinfo_message(UTF8("Only triangle "
-					"primitives supported"))
-				<< errinfo_string_value(
-					PrimitiveUtil::get_str(
-					primitive)));
-		}
+		check_primitive(primitive);
 
 		m_vertex_count = vertex_count;
 		m_primitive = primitive;
@@ -310,10 +791,194 @@ namespace eternal_lands
 		resize_indices(index_count);
 	}
 
+	MeshDataTool::MeshDataTool(const String &name, Reader &reader,
+		const bool use_simd): m_name(name), m_use_simd(use_simd)
+	{
+		BoundingBox bounding_box;
+		glm::vec3 center, half_size;
+		Uint64 size;
+		Uint32 i, index_count, sub_mesh_count, semantic_count;
+		Uint32 min_max_boxes_count, offset, count, min_vertex;
+		Uint32 max_vertex, min_max_boxes_index, boxes_count, semantic;
+		Sint32 base_vertex;
+		bool packed;
+
+		assert(!get_name().get().empty());
+
+		if (!reader.check_size(header_size))
+		{
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Mesh data too small"))
+				<< boost::errinfo_file_name(reader.get_name()));
+		}
+
+		m_vertex_count = reader.read_u32_le();
+		index_count = reader.read_u32_le();
+		sub_mesh_count = reader.read_u32_le();
+		semantic_count = reader.read_u32_le();
+		min_max_boxes_count = reader.read_u32_le();
+		m_primitive = static_cast<PrimitiveType>(reader.read_u32_le());
+		m_use_restart_index = reader.read_u8() != 0;
+
+		check_primitive(m_primitive);
+
+		size = static_cast<Uint64>(sub_mesh_count) * sub_mesh_size;
+		size += static_cast<Uint64>(semantic_count) *
+			(sizeof(Uint32) + static_cast<Uint64>(m_vertex_count) *
+			sizeof(glm::vec4));
+		size += static_cast<Uint64>(index_count) * sizeof(Uint32);
+		size += static_cast<Uint64>(min_max_boxes_count) *
+			sizeof(Sint16Array8);
+
+		if ((semantic_count > VertexElement::get_vertex_semantic_count())
+			|| !reader.check_size(size))
+		{
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(UTF8("Mesh data too small"))
+				<< boost::errinfo_file_name(reader.get_name()));
+		}
+
+		m_sub_meshs.reserve(sub_mesh_count);
+
+		for (i = 0; i < sub_mesh_count; ++i)
+		{
+			center.x = reader.read_float_le();
+			center.y = reader.read_float_le();
+			center.z = reader.read_float_le();
+			half_size.x = reader.read_float_le();
+			half_size.y = reader.read_float_le();
+			half_size.z = reader.read_float_le();
+			offset = reader.read_u32_le();
+			count = reader.read_u32_le();
+			min_vertex = reader.read_u32_le();
+			max_vertex = reader.read_u32_le();
+			base_vertex = reader.read_s32_le();
+			min_max_boxes_index = reader.read_u32_le();
+			boxes_count = reader.read_u32_le();
+			packed = reader.read_u8() != 0;
+
+			bounding_box.set_center(center);
+			bounding_box.set_half_size(half_size);
+
+			m_sub_meshs.push_back(SubMesh(bounding_box, offset,
+				count, min_vertex, max_vertex, base_vertex,
+				packed));
+			m_sub_meshs.back().set_min_max_boxes_index(
+				min_max_boxes_index);
+			m_sub_meshs.back().set_min_max_boxes_count(
+				boxes_count);
+		}
+
+		for (i = 0; i < semantic_count; ++i)
+		{
+			semantic = reader.read_u32_le();
+
+			if (semantic >= VertexElement::get_vertex_semantic_count())
+			{
+				EL_THROW_EXCEPTION(ReadErrorException()
+					<< errinfo_message(UTF8("Invalid vertex "
+						"semantic"))
+					<< errinfo_value(semantic)
+					<< boost::errinfo_file_name(
+						reader.get_name()));
+			}
+
+			AlignedVec4Array &vertices = m_vertices[
+				static_cast<VertexSemanticType>(semantic)];
+
+			vertices.resize(m_vertex_count);
+
+			if (m_vertex_count > 0)
+			{
+				reader.read(vertices.get_ptr(),
+					m_vertex_count * sizeof(glm::vec4));
+			}
+		}
+
+		m_indices.resize(index_count);
+
+		if (index_count > 0)
+		{
+			reader.read(&m_indices[0], index_count *
+				sizeof(Uint32));
+		}
+
+		m_min_max_boxes.resize(min_max_boxes_count);
+
+		if (min_max_boxes_count > 0)
+		{
+			reader.read(m_min_max_boxes.get_ptr(),
+				min_max_boxes_count * sizeof(Sint16Array8));
+		}
+	}
+
 	MeshDataTool::~MeshDataTool() noexcept
 	{
 	}
 
+	void MeshDataTool::save(Writer &writer) const
+	{
+		VertexSemanticTypeAlignedVec4ArrayMap::const_iterator it, end;
+
+		writer.write_u32_le(get_vertex_count());
+		writer.write_u32_le(get_index_count());
+		writer.write_u32_le(get_sub_meshs().size());
+		writer.write_u32_le(get_semantic_count());
+		writer.write_u32_le(get_min_max_boxes().size());
+		writer.write_u32_le(get_primitive());
+		writer.write_u8(get_use_restart_index() ? 1 : 0);
+
+		BOOST_FOREACH(const SubMesh &sub_mesh, get_sub_meshs())
+		{
+			writer.write_float_le(
+				sub_mesh.get_bounding_box().get_center().x);
+			writer.write_float_le(
+				sub_mesh.get_bounding_box().get_center().y);
+			writer.write_float_le(
+				sub_mesh.get_bounding_box().get_center().z);
+			writer.write_float_le(
+				sub_mesh.get_bounding_box().get_half_size().x);
+			writer.write_float_le(
+				sub_mesh.get_bounding_box().get_half_size().y);
+			writer.write_float_le(
+				sub_mesh.get_bounding_box().get_half_size().z);
+			writer.write_u32_le(sub_mesh.get_offset());
+			writer.write_u32_le(sub_mesh.get_count());
+			writer.write_u32_le(sub_mesh.get_min_vertex());
+			writer.write_u32_le(sub_mesh.get_max_vertex());
+			writer.write_s32_le(sub_mesh.get_base_vertex());
+			writer.write_u32_le(sub_mesh.get_min_max_boxes_index());
+			writer.write_u32_le(sub_mesh.get_min_max_boxes_count());
+			writer.write_u8(sub_mesh.get_packed() ? 1 : 0);
+		}
+
+		end = m_vertices.end();
+
+		for (it = m_vertices.begin(); it != end; ++it)
+		{
+			writer.write_u32_le(it->first);
+
+			if (get_vertex_count() > 0)
+			{
+				writer.write(it->second.get_ptr(),
+					get_vertex_count() * sizeof(glm::vec4));
+			}
+		}
+
+		if (get_index_count() > 0)
+		{
+			writer.write(&m_indices[0], get_index_count() *
+				sizeof(Uint32));
+		}
+
+		if (get_min_max_boxes().size() > 0)
+		{
+			writer.write(get_min_max_boxes().get_ptr(),
+				get_min_max_boxes().size() *
+				sizeof(Sint16Array8));
+		}
+	}
+
 	void MeshDataTool::resize_vertices(const Uint32 vertex_count)
 	{
 		VertexSemanticTypeAlignedVec4ArrayMap::iterator it, end;
@@ -469,7 +1134,7 @@ namespace eternal_lands
 		update_sub_meshs_packed();
 	}
 
-	void MeshDataTool::build_normal(const bool morph_target)
+	void MeshDataTool::build_normal_simple(const bool morph_target)
 	{
 		Triangles triangles(get_indices(), get_sub_meshs(),
 			get_primitive(), get_restart_index(),
@@ -542,7 +1207,7 @@ namespace eternal_lands
 		}
 	}
 
-	void MeshDataTool::build_tangent(const bool morph_target,
+	void MeshDataTool::build_tangent_simple(const bool morph_target,
 		const bool gram_schmidth_orthogonalize)
 	{
 		Triangles triangles(get_indices(), get_sub_meshs(),
@@ -636,6 +1301,203 @@ namespace eternal_lands
 		}
 	}
 
+	const AlignedVec4Array &MeshDataTool::get_vertices(
+		const VertexSemanticType semantic,
+		AlignedVec4Array &default_vertices) const
+	{
+		VertexSemanticTypeAlignedVec4ArrayMap::const_iterator found;
+		Uint32 i, count;
+
+		found = m_vertices.find(semantic);
+
+		if (found != m_vertices.end())
+		{
+			assert(get_vertex_count() == found->second.size());
+
+			return found->second;
+		}
+
+		count = get_vertex_count();
+
+		default_vertices.resize(count);
+
+		for (i = 0; i < count; ++i)
+		{
+			default_vertices[i] = glm::vec4(0.0f, 0.0f, 0.0f,
+				1.0f);
+		}
+
+		return default_vertices;
+	}
+
+	void MeshDataTool::get_all_triangle_indices(Uint32Vector &indices)
+		const
+	{
+		Uint32 i, count;
+
+		indices.clear();
+		indices.reserve(get_index_count());
+
+		count = get_sub_meshs().size();
+
+		for (i = 0; i < count; ++i)
+		{
+			get_triangle_indices(i, indices, true);
+		}
+	}
+
+	void MeshDataTool::build_normal(const bool morph_target,
+		JobSystem* job_system)
+	{
+		VertexSemanticTypeAlignedVec4ArrayMap::iterator found;
+		std::auto_ptr<AbstractThreadTask> task;
+		TaskGroup task_group;
+		AlignedVec4Array default_positions, face_normals;
+		Uint32Vector indices, offsets, triangles;
+		const AlignedVec4Array* positions;
+		Uint32 i, count;
+		VertexSemanticType position, normal;
+
+		if (morph_target)
+		{
+			position = vst_morph_position;
+			normal = vst_morph_normal;
+		}
+		else
+		{
+			position = vst_position;
+			normal = vst_normal;
+		}
+
+		found = m_vertices.find(normal);
+
+		if (found == m_vertices.end())
+		{
+			return;
+		}
+
+		positions = &get_vertices(position, default_positions);
+
+		get_all_triangle_indices(indices);
+
+		count = indices.size() / 3;
+
+		face_normals.resize(count);
+
+		task.reset(new VertexTrianglesTask(indices, get_vertex_count(),
+			offsets, triangles));
+
+		run_task(task, job_system, task_group);
+
+		for (i = 0; i < count; i += build_block_size)
+		{
+			task.reset(new FaceNormalsTask(*positions, indices,
+				get_use_simd(), i, std::min(i +
+					build_block_size, count),
+				face_normals));
+
+			run_task(task, job_system, task_group);
+		}
+
+		wait_tasks(job_system, task_group);
+
+		count = get_vertex_count();
+
+		for (i = 0; i < count; i += build_block_size)
+		{
+			task.reset(new VertexNormalsTask(offsets, triangles,
+				face_normals, i, std::min(i + build_block_size,
+					count), found->second));
+
+			run_task(task, job_system, task_group);
+		}
+
+		wait_tasks(job_system, task_group);
+	}
+
+	void MeshDataTool::build_tangent(const bool morph_target,
+		const bool gram_schmidth_orthogonalize, JobSystem* job_system)
+	{
+		VertexSemanticTypeAlignedVec4ArrayMap::iterator found;
+		std::auto_ptr<AbstractThreadTask> task;
+		TaskGroup task_group;
+		AlignedVec4Array default_positions, default_texture_coords;
+		AlignedVec4Array default_normals, face_tangents;
+		AlignedVec4Array face_bitangents;
+		Uint32Vector indices, offsets, triangles;
+		const AlignedVec4Array* positions;
+		const AlignedVec4Array* texture_coords;
+		const AlignedVec4Array* normals;
+		Uint32 i, count;
+		VertexSemanticType position, normal, tangent, texture_coord;
+
+		if (morph_target)
+		{
+			position = vst_morph_position;
+			normal = vst_morph_normal;
+			tangent = vst_morph_tangent;
+			texture_coord = vst_morph_texture_coordinate;
+		}
+		else
+		{
+			position = vst_position;
+			normal = vst_normal;
+			tangent = vst_tangent;
+			texture_coord = vst_texture_coordinate;
+		}
+
+		found = m_vertices.find(tangent);
+
+		if (found == m_vertices.end())
+		{
+			return;
+		}
+
+		positions = &get_vertices(position, default_positions);
+		texture_coords = &get_vertices(texture_coord,
+			default_texture_coords);
+		normals = &get_vertices(normal, default_normals);
+
+		get_all_triangle_indices(indices);
+
+		count = indices.size() / 3;
+
+		face_tangents.resize(count);
+		face_bitangents.resize(count);
+
+		task.reset(new VertexTrianglesTask(indices, get_vertex_count(),
+			offsets, triangles));
+
+		run_task(task, job_system, task_group);
+
+		for (i = 0; i < count; i += build_block_size)
+		{
+			task.reset(new FaceTangentsTask(*positions,
+				*texture_coords, indices, get_use_simd(), i,
+				std::min(i + build_block_size, count),
+				face_tangents, face_bitangents));
+
+			run_task(task, job_system, task_group);
+		}
+
+		wait_tasks(job_system, task_group);
+
+		count = get_vertex_count();
+
+		for (i = 0; i < count; i += build_block_size)
+		{
+			task.reset(new VertexTangentsTask(offsets, triangles,
+				face_tangents, face_bitangents, *normals,
+				gram_schmidth_orthogonalize, i, std::min(i +
+					build_block_size, count),
+				found->second));
+
+			run_task(task, job_system, task_group);
+		}
+
+		wait_tasks(job_system, task_group);
+	}
+
 	void MeshDataTool::build_scale_morph(const float scale)
 	{
 		Triangles triangles(get_indices(), get_sub_meshs(),
@@ -47,6 +47,11 @@ namespace eternal_lands
 			const bool m_use_simd;
 
 			void vertex_optimize();
+			const AlignedVec4Array &get_vertices(
+				const VertexSemanticType semantic,
+				AlignedVec4Array &default_vertices) const;
+			void get_all_triangle_indices(Uint32Vector &indices)
+				const;
 
 			inline Uint32 get_semantic_count() const
 			{
@@ -71,6 +76,18 @@ namespace eternal_lands
 				const bool use_restart_index,
 				const bool use_simd);
 
+			/**
+			 * @brief Load constructor.
+			 * Creates the mesh data from a binary blob written
+			 * with save(), using plain copies for the vertex,
+			 * index and min max box buffers.
+			 * @param name The name of the mesh.
+			 * @param reader The reader to read the data from.
+			 * @param use_simd If simd is used for the mesh.
+			 */
+			MeshDataTool(const String &name, Reader &reader,
+				const bool use_simd);
+
 			/**
 			 * Default destructor.
 			 */
@@ -82,9 +99,55 @@ namespace eternal_lands
 					const glm::vec3 &bitangent);
 			void update_sub_meshs_packed();
 			void update_sub_meshs_bounding_box();
+
+			/**
+			 * Builds the tangents of the vertices. The triangles
+			 * are split into blocks, whose tangents are
+			 * calculated in parallel and with SIMD if used. Each
+			 * vertex then sums the tangents of its triangles in
+			 * triangle order, so the result does not depend on
+			 * the number of threads.
+			 * @param morph_target If true, the morph target
+			 * tangents are build.
+			 * @param gram_schmidth_orthogonalize If true, the
+			 * tangents are orthogonalized to the normals and the
+			 * handedness is stored in w.
+			 * @param job_system The job system to use, can be
+			 * zero to build the tangents in the calling thread.
+			 */
 			void build_tangent(const bool morph_target,
+				const bool gram_schmidth_orthogonalize,
+				JobSystem* job_system = nullptr);
+
+			/**
+			 * Builds the normals of the vertices. The triangles
+			 * are split into blocks, whose normals are
+			 * calculated in parallel and with SIMD if used. Each
+			 * vertex then sums the normals of its triangles in
+			 * triangle order, so the result does not depend on
+			 * the number of threads.
+			 * @param morph_target If true, the morph target
+			 * normals are build.
+			 * @param job_system The job system to use, can be
+			 * zero to build the normals in the calling thread.
+			 */
+			void build_normal(const bool morph_target,
+				JobSystem* job_system = nullptr);
+
+			/**
+			 * Builds the tangents of the vertices one triangle
+			 * after another. Used to check and benchmark
+			 * build_tangent().
+			 */
+			void build_tangent_simple(const bool morph_target,
 				const bool gram_schmidth_orthogonalize);
-			void build_normal(const bool morph_target);
+
+			/**
+			 * Builds the normals of the vertices one triangle
+			 * after another. Used to check and benchmark
+			 * build_normal().
+			 */
+			void build_normal_simple(const bool morph_target);
 			void build_scale_morph(const float scale = 1.0f);
 			void optimize();
 			void get_bounding_box(
@@ -94,6 +157,16 @@ namespace eternal_lands
 				const VertexSemanticType semantic,
 				const Uint32 index, OutStream &str);
 			void write_to_stream(OutStream &str);
+
+			/**
+			 * @brief Saves the mesh data.
+			 * Writes the vertices, indices, sub meshs and min max
+			 * boxes as a binary blob that the load constructor
+			 * can read again. The buffers are written in the byte
+			 * order of the machine.
+			 * @param writer The writer to write the data to.
+			 */
+			void save(Writer &writer) const;
 			void set_vertex_data(
 				const VertexSemanticType vertex_semantic,
 				const Uint32 index, const glm::vec4 &data);
@@ -278,6 +351,18 @@ namespace eternal_lands
 				return m_indices.size();
 			}
 
+			/**
+			 * Returns the memory used by the vertices and indices.
+			 * @result The memory usage in bytes.
+			 */
+			inline Uint64 get_memory_usage() const noexcept
+			{
+				return static_cast<Uint64>(get_semantic_count()) *
+					get_vertex_count() * sizeof(glm::vec4) +
+					static_cast<Uint64>(get_index_count()) *
+					sizeof(Uint32);
+			}
+
 			/**
 			 * Return the primitive type.
 			 * @result The primitive type.
@@ -315,6 +400,18 @@ namespace eternal_lands
 				return m_sub_meshs;
 			}
 
+			/**
+			 * Returns true if the mesh data has vertices of the
+			 * semantic.
+			 * @param semantic The vertex semantic to check.
+			 * @result True if the semantic is used.
+			 */
+			inline bool get_has_semantic(
+				const VertexSemanticType semantic) const
+			{
+				return m_vertices.count(semantic) > 0;
+			}
+
 			/**
 			 * Using SIMD (SSE/SSE2) instruction for
 			 * transformations, conversions etc.
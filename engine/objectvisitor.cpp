@@ -11,6 +11,10 @@
 #include "cpurasterizer.hpp"
 #include "abstractmesh.hpp"
 #include "submesh.hpp"
+#include "rstartreesubtree.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
 
 namespace eternal_lands
 {
@@ -78,6 +82,80 @@ namespace eternal_lands
 			return distance0 < distance1;
 		}
 
+		class IntersectSortTask: public AbstractThreadTask
+		{
+			private:
+				const Frustum &m_frustum;
+				const RStarTreeSubTree &m_sub_tree;
+				const glm::vec3 m_position;
+				ObjectVisitor &m_visitor;
+
+			public:
+				IntersectSortTask(const Frustum &frustum,
+					const RStarTreeSubTree &sub_tree,
+					const glm::vec3 &position,
+					ObjectVisitor &visitor);
+				virtual ~IntersectSortTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		IntersectSortTask::IntersectSortTask(const Frustum &frustum,
+			const RStarTreeSubTree &sub_tree,
+			const glm::vec3 &position, ObjectVisitor &visitor):
+			m_frustum(frustum), m_sub_tree(sub_tree),
+			m_position(position), m_visitor(visitor)
+		{
+		}
+
+		IntersectSortTask::~IntersectSortTask() noexcept
+		{
+		}
+
+		void IntersectSortTask::operator()()
+		{
+			m_sub_tree.intersect(m_frustum, m_visitor);
+			m_visitor.sort(m_position);
+		}
+
+		class MergeTask: public AbstractThreadTask
+		{
+			private:
+				const RenderObjectDataVector::iterator m_begin;
+				const RenderObjectDataVector::iterator m_middle;
+				const RenderObjectDataVector::iterator m_end;
+
+			public:
+				MergeTask(
+					const RenderObjectDataVector::iterator
+						&begin,
+					const RenderObjectDataVector::iterator
+						&middle,
+					const RenderObjectDataVector::iterator
+						&end);
+				virtual ~MergeTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		MergeTask::MergeTask(
+			const RenderObjectDataVector::iterator &begin,
+			const RenderObjectDataVector::iterator &middle,
+			const RenderObjectDataVector::iterator &end):
+			m_begin(begin), m_middle(middle), m_end(end)
+		{
+		}
+
+		MergeTask::~MergeTask() noexcept
+		{
+		}
+
+		void MergeTask::operator()()
+		{
+			std::inplace_merge(m_begin, m_middle, m_end,
+				ObjectSort());
+		}
+
 	}
 
 	ObjectVisitor::ObjectVisitor()
@@ -103,6 +181,95 @@ namespace eternal_lands
 			ObjectSort());
 	}
 
+	void ObjectVisitor::intersect_and_sort(const Frustum &frustum,
+		const RStarTreeSubTreeVector &sub_trees,
+		const glm::vec3 &position, JobSystem &job_system)
+	{
+		std::auto_ptr<AbstractThreadTask> task;
+		Uint32Vector offsets;
+		Uint32 i, count, size, step;
+
+		count = sub_trees.size();
+
+		while (m_chunks.size() < count)
+		{
+			m_chunks.push_back(new ObjectVisitor());
+		}
+
+		{
+			TaskGroup task_group;
+
+			for (i = 0; i < count; ++i)
+			{
+				m_chunks[i].set_projection_view_matrix(
+					get_projection_view_matrix());
+				m_chunks[i].set_cpu_rasterizer(
+					get_cpu_rasterizer());
+
+				task.reset(new IntersectSortTask(frustum,
+					sub_trees[i], position, m_chunks[i]));
+
+				job_system.add(task, task_group);
+			}
+
+			sort(position);
+
+			job_system.wait(task_group);
+		}
+
+		size = m_objects.size();
+
+		for (i = 0; i < count; ++i)
+		{
+			size += m_chunks[i].get_objects().size();
+		}
+
+		m_objects.reserve(size);
+
+		offsets.push_back(0);
+		offsets.push_back(m_objects.size());
+
+		for (i = 0; i < count; ++i)
+		{
+			if (m_chunks[i].get_objects().empty())
+			{
+				continue;
+			}
+
+			m_objects.insert(m_objects.end(),
+				m_chunks[i].get_objects().begin(),
+				m_chunks[i].get_objects().end());
+
+			m_chunks[i].clear();
+
+			offsets.push_back(m_objects.size());
+		}
+
+		/**
+		 * All ranges are sorted, merge neighbouring ranges pairwise
+		 * until only one is left.
+		 */
+		count = offsets.size() - 1;
+
+		for (step = 1; step < count; step *= 2)
+		{
+			TaskGroup task_group;
+
+			for (i = 0; (i + step) < count; i += 2 * step)
+			{
+				task.reset(new MergeTask(
+					m_objects.begin() + offsets[i],
+					m_objects.begin() + offsets[i + step],
+					m_objects.begin() + offsets[std::min(
+						i + 2 * step, count)]));
+
+				job_system.add(task, task_group);
+			}
+
+			job_system.wait(task_group);
+		}
+	}
+
 	void ObjectVisitor::add(const ObjectSharedPtr &object)
 	{
 		BitSet64 visibility_mask;
@@ -35,6 +35,13 @@ namespace eternal_lands
 			glm::mat4x4 m_projection_view_matrix;
 			CpuRasterizerSharedPtr m_cpu_rasterizer;
 
+			/**
+			 * One chunk for each sub tree intersected in
+			 * parallel, kept between the frames to reuse the
+			 * memory.
+			 */
+			boost::ptr_vector<ObjectVisitor> m_chunks;
+
 			void clear();
 			BitSet64 get_visibility_mask(
 				const ObjectConstSharedPtr &object) const;
@@ -45,6 +52,23 @@ namespace eternal_lands
 			virtual void operator()(
 				const BoundedObjectSharedPtr &bounded_object);
 			void sort(const glm::vec3 &position);
+
+			/**
+			 * Intersects the sub trees with one task for each,
+			 * writing into its own chunk. The chunks and the
+			 * objects already in the visitor are sorted in
+			 * parallel and then merged into the objects.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param sub_trees The sub trees to intersect.
+			 * @param position The position used for sorting.
+			 * @param job_system The job system that runs the
+			 * tasks.
+			 */
+			void intersect_and_sort(const Frustum &frustum,
+				const RStarTreeSubTreeVector &sub_trees,
+				const glm::vec3 &position,
+				JobSystem &job_system);
 			void add(const ObjectSharedPtr &object);
 			void add(const ObjectSharedPtr &object,
 				const BitSet64 blend_mask,
@@ -133,6 +133,7 @@ namespace eternal_lands
 	ARRAY(Uint32, 2);
 	ARRAY(Uint32, 3);
 	ARRAY(Uint32, 4);
+	ARRAY(Uint32, 8);
 	ARRAY(Uint32, 32);
 	ARRAY(Uint16, 2);
 	ARRAY(Uint16, 3);
@@ -222,6 +223,7 @@ namespace eternal_lands
 	class Actor;
 	class ActorDataCache;
 	class ActorTextureBuilder;
+	class ActorTextureCache;
 	class AngelScript;
 	class Atlas;
 	class BoundedObject;
@@ -258,6 +260,7 @@ namespace eternal_lands
 	class InstanceData;
 	class InstancesBuilder;
 	class InstancingData;
+	class JobSystem;
 	class Light;
 	class LightData;
 	class LightVisitor;
@@ -272,6 +275,7 @@ namespace eternal_lands
 	class MaterialScript;
 	class MaterialScriptCache;
 	class MaterialScriptManager;
+	class MemoryMappedFile;
 	class MeshBuilder;
 	class MeshCache;
 	class MeshDataCache;
@@ -291,6 +295,8 @@ namespace eternal_lands
 	class RenderObjectData;
 	class RStarTree;
 	class RStarTreeNode;
+	class RStarTreeSubTree;
+	class StaticRStarTree;
 	class Scene;
 	class SceneResources;
 	class SceneView;
@@ -305,6 +311,7 @@ namespace eternal_lands
 	class StateManager;
 	class SubMesh;
 	class SubObject;
+	class TaskGroup;
 	class TerrainBuilder;
 	class TerrainData;
 	class TerrainMaterialData;
@@ -394,6 +401,7 @@ namespace eternal_lands
 	SMART_PTR(Actor);
 	SMART_PTR(ActorDataCache);
 	SMART_PTR(ActorTextureBuilder);
+	SMART_PTR(ActorTextureCache);
 	SMART_PTR(Atlas);
 	SMART_PTR(BoundedObject);
 	SMART_PTR(ColorCorrection);
@@ -413,6 +421,7 @@ namespace eternal_lands
 	SMART_PTR(HardwareBufferMapper);
 	SMART_PTR(Image);
 	SMART_PTR(IndexUpdateSource);
+	SMART_PTR(JobSystem);
 	SMART_PTR(Light);
 	SMART_PTR(Map);
 	SMART_PTR(MappedUniformBuffer);
@@ -423,6 +432,7 @@ namespace eternal_lands
 	SMART_PTR(MaterialScript);
 	SMART_PTR(MaterialScriptCache);
 	SMART_PTR(MaterialScriptManager);
+	SMART_PTR(MemoryMappedFile);
 	SMART_PTR(MeshBuilder);
 	SMART_PTR(MeshCache);
 	SMART_PTR(MeshDataCache);
@@ -463,6 +473,7 @@ namespace eternal_lands
 	VECTOR(BoundedObjectConstSharedPtr);
 	VECTOR(BoundingBox);
 	VECTOR(ConvexBody);
+	VECTOR(EffectSharedPtr);
 	VECTOR(EffectNodePtr);
 	VECTOR(EffectNodePortPtr);
 	VECTOR(GlslProgramSharedPtr);
@@ -488,6 +499,7 @@ namespace eternal_lands
 	VECTOR(RenderObjectData);
 	VECTOR(RStarTreeNodeSharedPtr);
 	VECTOR(RStarTreeNodeConstSharedPtr);
+	VECTOR(RStarTreeSubTree);
 	VECTOR(ShaderSourceData);
 	VECTOR(ShaderSourceParameter);
 	VECTOR(ShadowObject);
@@ -265,6 +265,14 @@ namespace eternal_lands
 			frustum.get_planes_mask(), visitor);
 	}
 
+	void RStarTree::intersect(const Frustum &frustum, const Uint16 depth,
+		AbstractBoundedObjectVisitor &visitor,
+		RStarTreeSubTreeVector &sub_trees) const
+	{
+		get_root_node()->intersect_tree(frustum,
+			frustum.get_planes_mask(), depth, visitor, sub_trees);
+	}
+
 	void RStarTree::clear()
 	{
 		add_new_root_node(0);
@@ -278,6 +278,27 @@ namespace eternal_lands
 			void intersect(const Frustum &frustum,
 				AbstractBoundedObjectVisitor &visitor) const;
 
+			/**
+			 * @brief Tests the elements of the tree for
+			 * intersection down to the given depth.
+			 *
+			 * Test the frustum for intersection with the nodes of
+			 * the tree down to the given depth. Nodes in that
+			 * depth that are not outside of the frustum are added
+			 * as sub trees, that can be intersected independent
+			 * of each other, e.g. by several threads.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param depth The depth where the tree is split.
+			 * @param visitor The visitor that gets the
+			 * intersecting items of leafs above the depth.
+			 * @param sub_trees The sub trees still to intersect.
+			 */
+			void intersect(const Frustum &frustum,
+				const Uint16 depth,
+				AbstractBoundedObjectVisitor &visitor,
+				RStarTreeSubTreeVector &sub_trees) const;
+
 			/**
 			 * @brief Clears the tree.
 			 *
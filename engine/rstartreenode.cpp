@@ -361,6 +361,57 @@ namespace eternal_lands
 		}
 	}
 
+	void RStarTreeNode::intersect_tree(const Frustum &frustum,
+		const BitSet64 mask, const Uint16 depth,
+		AbstractBoundedObjectVisitor &visitor,
+		RStarTreeSubTreeVector &sub_trees) const
+	{
+		Uint32 i;
+		BitSet64 out_mask;
+		IntersectionType result;
+
+		if (get_leaf())
+		{
+			intersect_node(frustum, mask, visitor);
+			return;
+		}
+
+		if (depth == 0)
+		{
+			sub_trees.push_back(RStarTreeSubTree(this, mask,
+				false));
+			return;
+		}
+
+		for (i = 0; i < get_count(); ++i)
+		{
+			result = frustum.intersect(get_element_bounding_box(i),
+				mask, out_mask);
+
+			switch (result)
+			{
+				case it_inside:
+				{
+					sub_trees.push_back(RStarTreeSubTree(
+						get_node(i).get(), out_mask,
+						true));
+					break;
+				}
+				case it_intersect:
+				{
+					get_node(i)->intersect_tree(frustum,
+						out_mask, depth - 1, visitor,
+						sub_trees);
+					break;
+				}
+				case it_outside:
+				{
+					break;
+				}
+			}
+		}
+	}
+
 	Uint32 RStarTreeNode::get_item_count() const
 	{
 		Uint32 i, count;
@@ -15,6 +15,7 @@
 #include "prerequisites.hpp"
 #include "frustum.hpp"
 #include "boundedobject.hpp"
+#include "rstartreesubtree.hpp"
 
 /**
  * @file
@@ -35,6 +36,7 @@ namespace eternal_lands
 		public boost::enable_shared_from_this<RStarTreeNode>
 	{
 		friend class RStarTree;
+		friend class RStarTreeSubTree;
 		private:
 			/**
 			 * @brief Bounding volumes of the elements.
@@ -222,6 +224,28 @@ namespace eternal_lands
 				const BitSet64 in_mask,
 				AbstractBoundedObjectVisitor &visitor) const;
 
+			/**
+			 * @brief Tests the node and its children for
+			 * intersection down to the given depth.
+			 *
+			 * Like intersect_tree(), but children in the given
+			 * depth below this node that are inside or intersect
+			 * the frustum are not traversed. They are added to
+			 * the sub trees vector instead, so they can be
+			 * traversed later, e.g. in parallel. Elements of leafs
+			 * above the depth are passed to the visitor.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param depth The depth of the sub trees.
+			 * @param visitor The visitor that gets the pointers of
+			 * the intersecting elements above the depth.
+			 * @param sub_trees The sub trees still to traverse.
+			 */
+			void intersect_tree(const Frustum &frustum,
+				const BitSet64 in_mask, const Uint16 depth,
+				AbstractBoundedObjectVisitor &visitor,
+				RStarTreeSubTreeVector &sub_trees) const;
+
 			/**
 			 * @brief Number of items.
 			 *
@@ -0,0 +1,44 @@
+/****************************************************************************
+ *            rstartreesubtree.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "rstartreesubtree.hpp"
+#include "rstartreenode.hpp"
+#include "staticrstartree.hpp"
+
+namespace eternal_lands
+{
+
+	void RStarTreeSubTree::intersect(const Frustum &frustum,
+		AbstractBoundedObjectVisitor &visitor) const
+	{
+		if (get_static_tree() != nullptr)
+		{
+			if (get_inside())
+			{
+				get_static_tree()->view_node(get_index(),
+					visitor);
+
+				return;
+			}
+
+			get_static_tree()->intersect_tree(frustum, get_index(),
+				get_mask(), visitor);
+
+			return;
+		}
+
+		if (get_inside())
+		{
+			get_node()->view_node(visitor);
+
+			return;
+		}
+
+		get_node()->intersect_tree(frustum, get_mask(), visitor);
+	}
+
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+ *            rstartreesubtree.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_e2d47261_4441_44d4_baaf_c289fc9733db
+#define	UUID_e2d47261_4441_44d4_baaf_c289fc9733db
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+
+/**
+ * @file
+ * @brief The @c class RStarTreeSubTree.
+ * This file contains the @c class RStarTreeSubTree.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief Sub tree of a r*-tree still to intersect.
+	 *
+	 * Holds a node of the tree together with the frustum planes it
+	 * still needs to be tested against. The node is either a node of a
+	 * RStarTree or the index of a node of a StaticRStarTree. Only valid
+	 * as long as the tree is not changed.
+	 */
+	class RStarTreeSubTree
+	{
+		private:
+			const RStarTreeNode* m_node;
+			const StaticRStarTree* m_static_tree;
+			Uint32 m_index;
+			BitSet64 m_mask;
+
+			/**
+			 * True if the node is fully inside the frustum, then
+			 * all its elements are visited without any test.
+			 */
+			bool m_inside;
+
+		public:
+			/**
+			 * Default constructor.
+			 */
+			inline RStarTreeSubTree(const RStarTreeNode* node,
+				const BitSet64 mask, const bool inside):
+				m_node(node), m_static_tree(nullptr), m_index(0),
+				m_mask(mask), m_inside(inside)
+			{
+			}
+
+			/**
+			 * Constructor for a node of a static tree.
+			 */
+			inline RStarTreeSubTree(
+				const StaticRStarTree* static_tree,
+				const Uint32 index, const BitSet64 mask,
+				const bool inside): m_node(nullptr),
+				m_static_tree(static_tree), m_index(index),
+				m_mask(mask), m_inside(inside)
+			{
+			}
+
+			/**
+			 * Tests all elements of the sub tree for
+			 * intersection.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param visitor The visitor that gets the
+			 * intersecting items.
+			 */
+			void intersect(const Frustum &frustum,
+				AbstractBoundedObjectVisitor &visitor) const;
+
+			inline const RStarTreeNode* get_node() const noexcept
+			{
+				return m_node;
+			}
+
+			inline const StaticRStarTree* get_static_tree() const
+				noexcept
+			{
+				return m_static_tree;
+			}
+
+			inline Uint32 get_index() const noexcept
+			{
+				return m_index;
+			}
+
+			inline const BitSet64 &get_mask() const noexcept
+			{
+				return m_mask;
+			}
+
+			inline bool get_inside() const noexcept
+			{
+				return m_inside;
+			}
+
+	};
+
+}
+
+#endif	/* UUID_e2d47261_4441_44d4_baaf_c289fc9733db */
@@ -52,6 +52,8 @@
 
 #include "shader/uniformdescription.hpp"
 #include "shader/uniformbufferdescription.hpp"
+#include "rstartreesubtree.hpp"
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 //#define	USE_BLOOM
 
@@ -83,6 +85,32 @@ namespace eternal_lands
 	namespace
 	{
 
+		class StageTimer
+		{
+			private:
+				const boost::posix_time::ptime m_start;
+				float &m_time;
+
+			public:
+				inline StageTimer(float &time):
+					m_start(boost::posix_time::
+						microsec_clock::
+						universal_time()),
+					m_time(time)
+				{
+				}
+
+				inline ~StageTimer() noexcept
+				{
+					m_time = (boost::posix_time::
+						microsec_clock::
+						universal_time() - m_start
+						).total_microseconds() *
+						0.001f;
+				}
+
+		};
+
 		class StateManagerUtil
 		{
 			private:
@@ -199,6 +227,8 @@ namespace eternal_lands
 	{
 		MapSharedPtr map;
 
+		m_cull_times.assign(0.0f);
+
 		m_light_positions_array.resize(8);
 		m_light_colors_array.resize(8);
 
@@ -677,10 +707,25 @@ namespace eternal_lands
 	void Scene::intersect(const Frustum &frustum, const bool shadow,
 		ObjectVisitor &visitor) const
 	{
-		Uint32ActorSharedPtrMap::const_iterator it, end;
-
 		m_map->intersect(frustum, visitor);
 
+		intersect_actors(frustum, shadow, visitor);
+	}
+
+	void Scene::intersect(const Frustum &frustum, const bool shadow,
+		const Uint16 depth, ObjectVisitor &visitor,
+		RStarTreeSubTreeVector &sub_trees) const
+	{
+		m_map->intersect(frustum, depth, visitor, sub_trees);
+
+		intersect_actors(frustum, shadow, visitor);
+	}
+
+	void Scene::intersect_actors(const Frustum &frustum,
+		const bool shadow, ObjectVisitor &visitor) const
+	{
+		Uint32ActorSharedPtrMap::const_iterator it, end;
+
 		end = m_actors.end();
 
 		for (it = m_actors.begin(); it != end; ++it)
@@ -715,8 +760,12 @@ namespace eternal_lands
 	void Scene::cull(const Frustum &frustum,
 		const glm::mat4 &projection_view_matrix,
 		const glm::vec3 &camera, const bool shadow,
-		ObjectVisitor &objects) const
+		ObjectVisitor &objects, float &time) const
 	{
+		StageTimer timer(time);
+		RStarTreeSubTreeVector sub_trees;
+		Uint16 depth;
+
 		LOG_DEBUG(lt_rendering, UTF8("Culling objects %1%"),
 			UTF8("started"));
 
@@ -725,9 +774,24 @@ namespace eternal_lands
 			objects.set_projection_view_matrix(
 				projection_view_matrix);
 
-			intersect(frustum, shadow, objects);
+			depth = get_global_vars()->get_culling_split_depth();
+
+			if (get_global_vars()->get_use_multithreaded_culling()
+				&& (depth > 0))
+			{
+				intersect(frustum, shadow, depth, objects,
+					sub_trees);
+
+				objects.intersect_and_sort(frustum, sub_trees,
+					camera, *get_scene_resources(
+						).get_job_system());
+			}
+			else
+			{
+				intersect(frustum, shadow, objects);
 
-			objects.sort(camera);
+				objects.sort(camera);
+			}
 		}
 		catch (boost::exception &exception)
 		{
@@ -750,12 +814,94 @@ namespace eternal_lands
 			UTF8("done"));
 	}
 
+	void Scene::rasterize_occluders(float &time)
+	{
+		StageTimer timer(time);
+		std::vector<std::pair<float, Uint32> > occluders;
+		Uint32 i, j, count;
+		bool transparent;
+
+		m_cpu_rasterizer->clear_occluders(
+			get_scene_view().get_projection_view_matrix());
+
+		/**
+		 * The occluders are taken from the objects visible in the
+		 * last frame, but are rasterized with the current matrix, so
+		 * objects that became visible can only make the occlusion
+		 * less effective, not wrong.
+		 */
+		count = m_visible_objects.get_objects().size();
+
+		for (i = 0; i < count; ++i)
+		{
+			const RenderObjectData &object =
+				m_visible_objects.get_objects()[i];
+
+			if (object.get_blend_mask().any() ||
+				!object.get_object()->get_mesh(
+					)->get_occluder())
+			{
+				continue;
+			}
+
+			transparent = false;
+
+			for (j = 0; j < object.get_object()->get_material_count();
+				++j)
+			{
+				if (object.get_object()->get_material(j
+					)->get_effect_description(
+						).get_transparent())
+				{
+					transparent = true;
+
+					break;
+				}
+			}
+
+			if (!transparent)
+			{
+				occluders.push_back(std::pair<float, Uint32>(
+					object.get_distance(), i));
+			}
+		}
+
+		count = std::min(static_cast<Uint32>(occluders.size()),
+			static_cast<Uint32>(
+				get_global_vars()->get_max_occluders()));
+
+		std::partial_sort(occluders.begin(), occluders.begin() + count,
+			occluders.end());
+
+		for (i = 0; i < count; ++i)
+		{
+			const ObjectSharedPtr &object =
+				m_visible_objects.get_objects()[
+					occluders[i].second].get_object();
+
+			m_cpu_rasterizer->add_occluder(
+				object->get_world_transformation(
+					).get_matrix(),
+				object->get_mesh()->get_occluder_vertices(),
+				object->get_mesh()->get_occluder_indices());
+		}
+
+		m_cpu_rasterizer->rasterize_occluders(
+			get_scene_resources().get_job_system().get());
+
+		LOG_DEBUG(lt_rendering, UTF8("Rasterized %1% occluders with "
+			"%2% triangles"), count %
+			m_cpu_rasterizer->get_occluder_triangle_count());
+	}
+
 	void Scene::cull_terrain(const Frustum &frustum,
 		const AbstractWriteMemorySharedPtr &buffer,
 		const glm::vec3 &camera, const Uint64 offset,
-		const Uint16 max_instances, TerrainRenderingData &terrain_data)
-		const
+		const Uint16 max_instances, TerrainRenderingData &terrain_data,
+		float &time) const
 	{
+		StageTimer timer(time);
+
 		LOG_DEBUG(lt_rendering, UTF8("Culling terrain %1%"),
 			UTF8("started"));
 
@@ -809,6 +955,8 @@ namespace eternal_lands
 		use_terrain = get_global_vars()->get_opengl_3_3() &&
 			get_terrain();
 
+		get_scene_resources().get_texture_cache()->upload_textures();
+
 		get_scene_view().update();
 
 		get_scene_view().set_scale_view(get_map()->get_bounding_box());
@@ -909,6 +1057,14 @@ namespace eternal_lands
 				).get_shadow_projection_view_matrices()[i]);
 		}
 
+		m_cull_times.assign(0.0f);
+
+		if (get_global_vars()->get_use_cpu_rasterizer() &&
+			(m_cpu_rasterizer.get() != nullptr))
+		{
+			rasterize_occluders(m_cull_times[11]);
+		}
+
 		m_visible_objects.next_frame();
 
 		for (i = 0; i < count; ++i)
@@ -923,7 +1079,7 @@ namespace eternal_lands
 			cull(frustum,
 				get_scene_view().get_projection_view_matrix(),
 				glm::vec3(get_scene_view().get_camera()),
-				false, m_visible_objects);
+				false, m_visible_objects, m_cull_times[0]);
 
 			#pragma omp section
 			if (use_terrain)
@@ -935,12 +1091,15 @@ namespace eternal_lands
 				cull_terrain(frustum, visible_terrain_buffer,
 					glm::vec3(get_scene_view(
 						).get_camera()), offset,
-					max_instances, m_visible_terrain);
+					max_instances, m_visible_terrain,
+					m_cull_times[1]);
 			}
 
 			#pragma omp section
 			if (get_map()->get_dungeon() || get_lights())
 			{
+				StageTimer timer(m_cull_times[2]);
+
 				intersect(frustum, m_visible_lights);
 
 				m_visible_lights.update_camera(glm::vec3(
@@ -955,7 +1114,8 @@ namespace eternal_lands
 						)[0],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[0]),
-					true, m_shadow_objects[0]);
+					true, m_shadow_objects[0],
+					m_cull_times[3]);
 			}
 
 			#pragma omp section
@@ -970,7 +1130,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[0]),
 					offset, max_instances,
-					m_shadow_terrains[0]);
+					m_shadow_terrains[0],
+					m_cull_times[4]);
 			}
 
 			#pragma omp section
@@ -981,7 +1142,8 @@ namespace eternal_lands
 						)[1],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[1]),
-					true, m_shadow_objects[1]);
+					true, m_shadow_objects[1],
+					m_cull_times[5]);
 			}
 
 			#pragma omp section
@@ -996,7 +1158,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[1]),
 					offset, max_instances,
-					m_shadow_terrains[1]);
+					m_shadow_terrains[1],
+					m_cull_times[6]);
 			}
 
 			#pragma omp section
@@ -1007,7 +1170,8 @@ namespace eternal_lands
 						)[2],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[2]),
-					true, m_shadow_objects[2]);
+					true, m_shadow_objects[2],
+					m_cull_times[7]);
 			}
 
 			#pragma omp section
@@ -1022,7 +1186,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[2]),
 					offset, max_instances,
-					m_shadow_terrains[2]);
+					m_shadow_terrains[2],
+					m_cull_times[8]);
 			}
 
 			#pragma omp section
@@ -1033,7 +1198,8 @@ namespace eternal_lands
 						)[3],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[3]),
-					true, m_shadow_objects[3]);
+					true, m_shadow_objects[3],
+					m_cull_times[9]);
 			}
 
 			#pragma omp section
@@ -1048,7 +1214,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[3]),
 					offset, max_instances,
-					m_shadow_terrains[3]);
+					m_shadow_terrains[3],
+					m_cull_times[10]);
 			}
 		}
 		else
@@ -1056,7 +1223,7 @@ namespace eternal_lands
 			cull(frustum,
 				get_scene_view().get_projection_view_matrix(),
 				glm::vec3(get_scene_view().get_camera()),
-				false, m_visible_objects);
+				false, m_visible_objects, m_cull_times[0]);
 
 			if (use_terrain)
 			{
@@ -1067,11 +1234,14 @@ namespace eternal_lands
 				cull_terrain(frustum, visible_terrain_buffer,
 					glm::vec3(get_scene_view(
 						).get_camera()), offset,
-					max_instances, m_visible_terrain);
+					max_instances, m_visible_terrain,
+					m_cull_times[1]);
 			}
 
 			if (get_map()->get_dungeon() || get_lights())
 			{
+				StageTimer timer(m_cull_times[2]);
+
 				intersect(frustum, m_visible_lights);
 
 				m_visible_lights.update_camera(glm::vec3(
@@ -1085,7 +1255,8 @@ namespace eternal_lands
 						)[0],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[0]),
-					true, m_shadow_objects[0]);
+					true, m_shadow_objects[0],
+					m_cull_times[3]);
 			}
 
 			if ((count > 0) && use_terrain)
@@ -1099,7 +1270,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[0]),
 					offset, max_instances,
-					m_shadow_terrains[0]);
+					m_shadow_terrains[0],
+					m_cull_times[4]);
 			}
 
 			if (count > 1)
@@ -1109,7 +1281,8 @@ namespace eternal_lands
 						)[1],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[1]),
-					true, m_shadow_objects[1]);
+					true, m_shadow_objects[1],
+					m_cull_times[5]);
 			}
 
 			if ((count > 1) && use_terrain)
@@ -1123,7 +1296,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[1]),
 					offset, max_instances,
-					m_shadow_terrains[1]);
+					m_shadow_terrains[1],
+					m_cull_times[6]);
 			}
 
 			if (count > 2)
@@ -1133,7 +1307,8 @@ namespace eternal_lands
 						)[2],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[2]),
-					true, m_shadow_objects[2]);
+					true, m_shadow_objects[2],
+					m_cull_times[7]);
 			}
 
 			if ((count > 2) && use_terrain)
@@ -1147,7 +1322,8 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[2]),
 					offset, max_instances,
-					m_shadow_terrains[2]);
+					m_shadow_terrains[2],
+					m_cull_times[8]);
 			}
 
 			if (count > 3)
@@ -1157,7 +1333,8 @@ namespace eternal_lands
 						)[3],
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[3]),
-					true, m_shadow_objects[3]);
+					true, m_shadow_objects[3],
+					m_cull_times[9]);
 			}
 
 			if ((count > 3) && use_terrain)
@@ -1171,8 +1348,24 @@ namespace eternal_lands
 					glm::vec3(get_scene_view(
 						).get_shadow_cameras()[3]),
 					offset, max_instances,
-					m_shadow_terrains[3]);
+					m_shadow_terrains[3],
+					m_cull_times[10]);
+			}
+		}
+
+		if (get_log_level(lt_rendering) >= llt_debug)
+		{
+			StringStream cull_times;
+
+			BOOST_FOREACH(const float cull_time, m_cull_times)
+			{
+				cull_times << cull_time << UTF8(" ");
 			}
+
+			LOG_DEBUG(lt_rendering, UTF8("Culling stages %1%ms, "
+				"slowest %2%ms"), cull_times.str() %
+				*std::max_element(m_cull_times.begin(),
+					m_cull_times.end()));
 		}
 
 		if (use_terrain)
@@ -3149,6 +3342,8 @@ namespace eternal_lands
 			m_free_ids));
 
 		set_map(map_loader->load(name));
+
+		get_scene_resources().trim_caches();
 	}
 
 	void Scene::map_changed()
@@ -3404,7 +3599,7 @@ namespace eternal_lands
 		Uint16 mipmaps;
 
 		m_cpu_rasterizer = boost::make_shared<CpuRasterizer>(
-			view_port.y, view_port.w, 5.0f,
+			view_port.z, view_port.w, 5.0f,
 			get_global_vars()->get_use_simd());
 
 		if (!get_global_vars()->get_use_scene_fbo())
@@ -54,6 +54,16 @@ namespace eternal_lands
 			ObjectVisitor m_visible_objects;
 			boost::array<TerrainRenderingData, 4> m_shadow_terrains;
 			boost::array<ObjectVisitor, 4> m_shadow_objects;
+
+			/**
+			 * Time in ms each culling stage needed in the last
+			 * frame. The stages are the view objects, the view
+			 * terrain, the lights and then the objects and the
+			 * terrain for each of the four shadow maps. The last
+			 * one, index 11, is the rasterization of the
+			 * occluders that runs before the view objects.
+			 */
+			boost::array<float, 12> m_cull_times;
 			LightVisitor m_visible_lights;
 			MapSharedPtr m_map;
 			AbstractMeshSharedPtr m_screen_quad;
@@ -150,6 +160,7 @@ namespace eternal_lands
 			void do_draw_default();
 			void do_update_light_system();
 			void do_cull();
+			void rasterize_occluders(float &time);
 
 		protected:
 			virtual void intersect_terrain(const Frustum &frustum,
@@ -161,6 +172,10 @@ namespace eternal_lands
 			virtual void intersect(const Frustum &frustum,
 				const bool shadow, ObjectVisitor &visitor)
 				const;
+			virtual void intersect(const Frustum &frustum,
+				const bool shadow, const Uint16 depth,
+				ObjectVisitor &visitor,
+				RStarTreeSubTreeVector &sub_trees) const;
 			virtual void intersect(const Frustum &frustum,
 				LightVisitor &visitor) const;
 			virtual void terrain_depth_read();
@@ -168,15 +183,19 @@ namespace eternal_lands
 			virtual void map_changed();
 			bool switch_program(
 				const GlslProgramSharedPtr &program);
+			void intersect_actors(const Frustum &frustum,
+				const bool shadow, ObjectVisitor &visitor)
+				const;
 			void cull(const Frustum &frustum,
 				const glm::mat4 &projection_view_matrix,
 				const glm::vec3 &camera, const bool shadow,
-				ObjectVisitor &objects) const;
+				ObjectVisitor &objects, float &time) const;
 			void cull_terrain(const Frustum &frustum,
 				const AbstractWriteMemorySharedPtr &buffer,
 				const glm::vec3 &camera, const Uint64 offset,
 				const Uint16 max_instances,
-				TerrainRenderingData &terrain_data) const;
+				TerrainRenderingData &terrain_data,
+				float &time) const;
 			void draw_terrain(
 				const TerrainRenderingData &terrain_data,
 				const EffectProgramType type,
@@ -436,6 +455,18 @@ namespace eternal_lands
 				return m_scene_resources;
 			}
 
+			inline const SceneResources &get_scene_resources() const
+				noexcept
+			{
+				return m_scene_resources;
+			}
+
+			inline const boost::array<float, 12> &get_cull_times()
+				const noexcept
+			{
+				return m_cull_times;
+			}
+
 			inline const FreeIdsManagerSharedPtr &get_free_ids()
 				const noexcept
 			{
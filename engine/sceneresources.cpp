@@ -12,6 +12,7 @@
 #include "meshdatacache.hpp"
 #include "texturecache.hpp"
 #include "actordatacache.hpp"
+#include "actortexturecache.hpp"
 #include "shader/shadersourcebuilder.hpp"
 #include "filter.hpp"
 #include "framebufferbuilder.hpp"
@@ -25,7 +26,7 @@
 #include "script/scriptengine.hpp"
 #include "hardwarebuffer/hardwarebuffermapper.hpp"
 #include "terrainbuilder.hpp"
-#include "thread/threadpool.hpp"
+#include "thread/jobsystem.hpp"
 #include "tilebuilder.hpp"
 #include "walkheightbuilder.hpp"
 
@@ -36,7 +37,8 @@ namespace eternal_lands
 		const GlobalVarsConstSharedPtr &global_vars,
 		const FileSystemConstSharedPtr &file_system)
 	{
-		m_thread_pool = boost::make_shared<ThreadPool>(4);
+		m_job_system = boost::make_shared<JobSystem>(
+			JobSystem::get_default_thread_count());
 		m_script_engine = boost::make_shared<ScriptEngine>(file_system);
 		m_material_script_cache =
 			boost::make_shared<MaterialScriptCache>(
@@ -55,9 +57,10 @@ namespace eternal_lands
 				file_system,
 				get_uniform_buffer_description_cache());
 		m_glsl_program_cache = boost::make_shared<GlslProgramCache>(
-			get_uniform_buffer_description_cache());
+			global_vars, get_uniform_buffer_description_cache());
 		m_effect_cache = boost::make_shared<EffectCache>(
-			get_glsl_program_cache(), get_shader_source_builder());
+			get_glsl_program_cache(), get_shader_source_builder(),
+			get_job_system());
 		m_texture_cache = boost::make_shared<TextureCache>(
 			global_vars, file_system);
 		m_material_description_cache =
@@ -70,14 +73,17 @@ namespace eternal_lands
 			get_material_builder(),
 			get_material_description_cache());
 		m_mesh_data_cache = boost::make_shared<MeshDataCache>(
-			global_vars, file_system);
+			global_vars, file_system, get_job_system());
 		m_mesh_cache = boost::make_shared<MeshCache>(
 			get_mesh_builder(), get_mesh_data_cache());
+		m_actor_texture_cache =
+			boost::make_shared<ActorTextureCache>();
 		m_actor_data_cache = boost::make_shared<ActorDataCache>(
 			get_mesh_builder(), get_material_cache(),
 			get_material_builder(),
 			get_material_description_cache(), global_vars,
-			file_system);
+			file_system, get_job_system(),
+			get_actor_texture_cache());
 		m_framebuffer_builder = boost::make_shared<FrameBufferBuilder>(
 			global_vars);
 		m_terrain_builder = boost::make_shared<TerrainBuilder>(
@@ -97,6 +103,34 @@ namespace eternal_lands
 	{
 	}
 
+	void SceneResources::trim_caches()
+	{
+		// materials hold their textures, so they must go first
+		m_material_cache->trim();
+		m_texture_cache->trim();
+		m_mesh_data_cache->trim();
+		m_glsl_program_cache->trim();
+		m_actor_texture_cache->trim();
+	}
+
+	StringVector SceneResources::get_cache_statistics() const
+	{
+		StringVector result;
+
+		result.push_back(String(UTF8("textures: ") +
+			m_texture_cache->get_statistics().get()));
+		result.push_back(String(UTF8("mesh data: ") +
+			m_mesh_data_cache->get_statistics().get()));
+		result.push_back(String(UTF8("materials: ") +
+			m_material_cache->get_statistics().get()));
+		result.push_back(String(UTF8("glsl programs: ") +
+			m_glsl_program_cache->get_statistics().get()));
+		result.push_back(String(UTF8("actor textures: ") +
+			m_actor_texture_cache->get_statistics().get()));
+
+		return result;
+	}
+
 	void SceneResources::clear()
 	{
 		m_mesh_builder.reset();
@@ -105,6 +139,7 @@ namespace eternal_lands
 		m_texture_cache.reset();
 		m_mesh_data_cache.reset();
 		m_actor_data_cache.reset();
+		m_actor_texture_cache.reset();
 		m_shader_source_builder.reset();
 		m_framebuffer_builder.reset();
 		m_material_builder.reset();
@@ -119,7 +154,7 @@ namespace eternal_lands
 		m_hardware_buffer_mapper.reset();
 		m_terrain_builder.reset();
 		m_tile_builder.reset();
-		m_thread_pool.reset();
+		m_job_system.reset();
 		m_walk_height_builder.reset();
 	}
 
@@ -134,6 +169,8 @@ namespace eternal_lands
 		m_shader_source_builder->load_shader_sources(
 			String(UTF8("shaders/terrains")));
 
+		m_shader_source_builder->prune_cache();
+
 		m_effect_cache->load_xml(file_system,
 			String(UTF8("shaders/effects")));
 
@@ -31,6 +31,7 @@ namespace eternal_lands
 			TextureCacheSharedPtr m_texture_cache;
 			MeshDataCacheSharedPtr m_mesh_data_cache;
 			ActorDataCacheSharedPtr m_actor_data_cache;
+			ActorTextureCacheSharedPtr m_actor_texture_cache;
 			ShaderSourceBuilderSharedPtr m_shader_source_builder;
 			FrameBufferBuilderSharedPtr m_framebuffer_builder;
 			MaterialBuilderSharedPtr m_material_builder;
@@ -46,7 +47,7 @@ namespace eternal_lands
 			UniformBufferDescriptionCacheSharedPtr
 				m_uniform_buffer_description_cache;
 			HardwareBufferMapperSharedPtr m_hardware_buffer_mapper;
-			ThreadPoolSharedPtr m_thread_pool;
+			JobSystemSharedPtr m_job_system;
 			FilterSharedPtr m_filter;
 			TileBuilderSharedPtr m_tile_builder;
 			WalkHeightBuilderSharedPtr m_walk_height_builder;
@@ -59,6 +60,19 @@ namespace eternal_lands
 			void clear();
 			void init(const FileSystemConstSharedPtr &file_system);
 
+			/**
+			 * Removes the least recently used resources that are
+			 * not used any more from the caches, until they fit
+			 * into their budgets.
+			 */
+			void trim_caches();
+
+			/**
+			 * Returns the name and statistics of each cache, one
+			 * line per cache.
+			 */
+			StringVector get_cache_statistics() const;
+
 			inline const MeshBuilderSharedPtr &get_mesh_builder()
 				noexcept
 			{
@@ -95,6 +109,12 @@ namespace eternal_lands
 				return m_actor_data_cache;
 			}
 
+			inline const ActorTextureCacheSharedPtr
+				&get_actor_texture_cache() noexcept
+			{
+				return m_actor_texture_cache;
+			}
+
 			inline const ShaderSourceBuilderSharedPtr
 				&get_shader_source_builder() noexcept
 			{
@@ -167,10 +187,16 @@ namespace eternal_lands
 				return m_terrain_builder;;
 			}
 
-			inline const ThreadPoolSharedPtr &get_thread_pool()
+			inline const JobSystemSharedPtr &get_job_system()
+				noexcept
+			{
+				return m_job_system;
+			}
+
+			inline const JobSystemSharedPtr &get_job_system() const
 				noexcept
 			{
-				return m_thread_pool;
+				return m_job_system;
 			}
 
 			inline const FilterSharedPtr &get_filter() noexcept
@@ -17,6 +17,7 @@
 #include "shader/uniformbufferutil.hpp"
 #include "uniformbufferdescriptioncache.hpp"
 #include "utf.hpp"
+#include "readwritememory.hpp"
 
 namespace eternal_lands
 {
@@ -130,6 +131,36 @@ namespace eternal_lands
 				"successful: %1%"), get_shader_log());
 		}
 
+		bool get_binary_format_supported(const GLenum binary_format)
+		{
+			boost::scoped_array<GLint> formats;
+			GLint i, count;
+
+			count = 0;
+
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+
+			if (count <= 0)
+			{
+				return false;
+			}
+
+			formats.reset(new GLint[count]);
+
+			glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.get());
+
+			for (i = 0; i < count; ++i)
+			{
+				if (static_cast<GLenum>(formats[i]) ==
+					binary_format)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
 		String get_base_name(const String &name)
 		{
 			std::string tmp;
@@ -1001,16 +1032,29 @@ namespace eternal_lands
 			&uniform_buffer_description_cache,
 		const ShaderTypeStringMap &description,
 		const boost::uuids::uuid &uuid): m_uuid(uuid), m_last_used(0),
-		m_program(0)
+		m_program(0), m_loaded_from_binary(false)
+	{
+		build(uniform_buffer_description_cache, description, 0,
+			ReadWriteMemory());
+	}
+
+	GlslProgram::GlslProgram(const UniformBufferDescriptionCacheSharedPtr
+			&uniform_buffer_description_cache,
+		const ShaderTypeStringMap &description,
+		const GLenum binary_format, const AbstractReadMemory &binary,
+		const boost::uuids::uuid &uuid): m_uuid(uuid), m_last_used(0),
+		m_program(0), m_loaded_from_binary(false)
 	{
-		build(uniform_buffer_description_cache, description);
+		build(uniform_buffer_description_cache, description,
+			binary_format, binary);
 	}
 
 	GlslProgram::GlslProgram(const FileSystemSharedPtr &file_system,
 		const UniformBufferDescriptionCacheSharedPtr
 			&uniform_buffer_description_cache,
 		const String &file_name, const boost::uuids::uuid &uuid):
-		m_uuid(uuid), m_last_used(0), m_program(0)
+		m_uuid(uuid), m_last_used(0), m_program(0),
+		m_loaded_from_binary(false)
 	{
 		load_xml(uniform_buffer_description_cache, file_system,
 			file_name);
@@ -2531,16 +2575,13 @@ namespace eternal_lands
 
 		bind_attribute_locations();
 
-/*
-		glProgramParameteri(get_program(),
-			GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
-*/
+		if (GLEW_ARB_get_program_binary)
+		{
+			glProgramParameteri(get_program(),
+				GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
 		glLinkProgram(get_program());
-/*
-		glGetProgramiv(get_program(), GL_PROGRAM_BINARY_LENGTH, &size);
-		SetLength(binary, size);
-		glGetProgramBinary(get_program(), size, 0, &format, &binary);
-*/
 
 		if (!program_link_status())
 		{
@@ -2555,9 +2596,95 @@ namespace eternal_lands
 		log_uniforms(uniform_buffer_description_cache);
 	}
 
+	/**
+	 * The attribute locations and everything else set before linking
+	 * are part of the binary, so only the steps after linking are
+	 * needed. Binaries of another driver version are rejected by
+	 * the driver, that is reported as failed link.
+	 */
+	bool GlslProgram::do_load_binary(
+		const UniformBufferDescriptionCacheSharedPtr
+			&uniform_buffer_description_cache,
+		const GLenum binary_format, const AbstractReadMemory &binary)
+	{
+		if (!GLEW_ARB_get_program_binary || (binary.get_size() == 0))
+		{
+			return false;
+		}
+
+		if (!get_binary_format_supported(binary_format))
+		{
+			return false;
+		}
+
+		m_program = glCreateProgram();
+
+		glProgramBinary(get_program(), binary_format,
+			binary.get_ptr(), binary.get_size());
+
+		if (!program_link_status())
+		{
+			LOG_DEBUG(lt_glsl_program, UTF8("Program binary "
+				"rejected: %1%"), get_program_log());
+
+			glDeleteProgram(m_program);
+
+			m_program = 0;
+
+			return false;
+		}
+
+		LOG_DEBUG(lt_glsl_program, UTF8("Program binary loaded "
+			"successful: %1%"), get_program_log());
+
+		log_attribute_locations();
+		log_uniforms(uniform_buffer_description_cache);
+
+		return true;
+	}
+
+	bool GlslProgram::get_binary(GLenum &binary_format,
+		ReadWriteMemory &binary) const
+	{
+		GLint size;
+		GLsizei length;
+
+		if (!GLEW_ARB_get_program_binary)
+		{
+			return false;
+		}
+
+		size = 0;
+
+		glGetProgramiv(get_program(), GL_PROGRAM_BINARY_LENGTH,
+			&size);
+
+		if (size <= 0)
+		{
+			return false;
+		}
+
+		binary.resize(size);
+
+		length = 0;
+
+		glGetProgramBinary(get_program(), size, &length,
+			&binary_format, binary.get_ptr());
+
+		if (length <= 0)
+		{
+			return false;
+		}
+
+		binary.resize(length);
+
+		return true;
+	}
+
 	void GlslProgram::build(const UniformBufferDescriptionCacheSharedPtr
 			&uniform_buffer_description_cache,
-		const ShaderTypeStringMap &description)
+		const ShaderTypeStringMap &description,
+		const GLenum binary_format, const AbstractReadMemory &binary)
 	{
 		ShaderTypeStringMap::const_iterator found, end;
 		Uint32 i, count;
@@ -2567,7 +2694,15 @@ namespace eternal_lands
 
 		try
 		{
-			do_build(uniform_buffer_description_cache, description);
+			m_loaded_from_binary = do_load_binary(
+				uniform_buffer_description_cache,
+				binary_format, binary);
+
+			if (!m_loaded_from_binary)
+			{
+				do_build(uniform_buffer_description_cache,
+					description);
+			}
 		}
 		catch (boost::exception &exception)
 		{
@@ -2747,7 +2882,8 @@ namespace eternal_lands
 			description[st_fragment] = fragment_shader;
 		}
 
-		build(uniform_buffer_description_cache,	description);
+		build(uniform_buffer_description_cache,	description, 0,
+			ReadWriteMemory());
 	}
 
 	void GlslProgram::load_xml(const UniformBufferDescriptionCacheSharedPtr
@@ -42,6 +42,7 @@ namespace eternal_lands
 			GLuint m_program;
 			BitSet32 m_used_texture_units;
 			BitSet32 m_used_attributes;
+			bool m_loaded_from_binary;
 
 			void bind_attribute_location(
 				const VertexSemanticType type);
@@ -63,9 +64,16 @@ namespace eternal_lands
 				const UniformBufferDescriptionCacheSharedPtr
 					&uniform_buffer_description_cache,
 				const ShaderTypeStringMap &description);
+			bool do_load_binary(
+				const UniformBufferDescriptionCacheSharedPtr
+					&uniform_buffer_description_cache,
+				const GLenum binary_format,
+				const AbstractReadMemory &binary);
 			void build(const UniformBufferDescriptionCacheSharedPtr
 					&uniform_buffer_description_cache,
-				const ShaderTypeStringMap &description);
+				const ShaderTypeStringMap &description,
+				const GLenum binary_format,
+				const AbstractReadMemory &binary);
 			void update_used_texture_units();
 			void load_xml(
 				const UniformBufferDescriptionCacheSharedPtr
@@ -87,6 +95,18 @@ namespace eternal_lands
 					&uniform_buffer_description_cache,
 				const ShaderTypeStringMap &description,
 				const boost::uuids::uuid &uuid);
+
+			/**
+			 * Creates the program from a binary of a previous
+			 * link. If the driver rejects the binary, the
+			 * program is build from the description.
+			 */
+			GlslProgram(const UniformBufferDescriptionCacheSharedPtr
+					&uniform_buffer_description_cache,
+				const ShaderTypeStringMap &description,
+				const GLenum binary_format,
+				const AbstractReadMemory &binary,
+				const boost::uuids::uuid &uuid);
 			GlslProgram(const FileSystemSharedPtr &file_system,
 				const UniformBufferDescriptionCacheSharedPtr
 					&uniform_buffer_description_cache,
@@ -242,6 +262,15 @@ namespace eternal_lands
 			void unbind();
 			void log_validate_error();
 
+			/**
+			 * Returns the binary of the linked program, that can
+			 * be used to create the program again without
+			 * compiling and linking it.
+			 * @return False if the driver can't return binaries.
+			 */
+			bool get_binary(GLenum &binary_format,
+				ReadWriteMemory &binary) const;
+
 			inline void set_bool_parameter(
 				const AutoParameterType parameter,
 				const bool value)
@@ -297,6 +326,11 @@ namespace eternal_lands
 				return m_used_attributes;
 			}
 
+			inline bool get_loaded_from_binary() const noexcept
+			{
+				return m_loaded_from_binary;
+			}
+
 	};
 
 }
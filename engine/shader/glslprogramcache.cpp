@@ -10,27 +10,91 @@
 #include "xmlreader.hpp"
 #include "xmlutil.hpp"
 #include "xmlwriter.hpp"
+#include "globalvars.hpp"
+#include "filesystem.hpp"
+#include "logging.hpp"
+#include "memorymappedfile.hpp"
+#include "readwritememory.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
+#include "utf.hpp"
+#include "cachefilewriter.hpp"
+#include "sha1/sha1.h"
 
 namespace eternal_lands
 {
 
+	namespace
+	{
+
+		/**
+		 * The linked programs live in the driver, so each one is
+		 * counted with a rough guess of its size there.
+		 */
+		const Uint64 glsl_program_size = 64 * 1024;
+		const Uint64 glsl_program_cache_budget = 1024 *
+			glsl_program_size;
+
+		/**
+		 * Binaries are only valid for the driver that created them,
+		 * so the vendor, renderer and version strings are part of
+		 * the cache key. Increase the version if the file layout
+		 * changes. The sizes of the key and of the binary are
+		 * saved, so truncated files are found before the driver
+		 * sees them.
+		 */
+		const Uint32 program_binary_cache_magic = 0x42504C45;
+		const Uint32 program_binary_cache_version = 2;
+
+		String get_gl_string(const GLenum name)
+		{
+			const GLubyte* str;
+
+			str = glGetString(name);
+
+			if (str == nullptr)
+			{
+				return String();
+			}
+
+			return String(reinterpret_cast<const char*>(str));
+		}
+
+	}
+
 	GlslProgramCache::GlslProgramCache(
+		const GlobalVarsConstSharedPtr &global_vars,
 		const UniformBufferDescriptionCacheWeakPtr
 			&uniform_buffer_description_cache):
+		m_global_vars(global_vars),
 		m_uniform_buffer_description_cache(
 			uniform_buffer_description_cache),
-		m_uuid_generator(&m_ran)
-
+		m_uuid_generator(&m_ran), m_binary_hits(0),
+		m_binary_rejects(0), m_binary_misses(0)
 	{
 		assert(!m_uniform_buffer_description_cache.expired());
 
 		m_ran.seed(time(0));
+
+		m_glsl_program_cache.set_budget(glsl_program_cache_budget);
 	}
 
 	GlslProgramCache::~GlslProgramCache() noexcept
 	{
 	}
 
+	bool GlslProgramCache::GlslProgramCacheTraits::get_unused(
+		const GlslProgramSharedPtr &glsl_program) noexcept
+	{
+		return glsl_program.unique();
+	}
+
+	Uint64 GlslProgramCache::GlslProgramCacheTraits::get_memory_usage(
+		const GlslProgramSharedPtr &glsl_program) noexcept
+	{
+		return glsl_program_size;
+	}
+
 	String GlslProgramCache::get_index(
 		const ShaderTypeStringMap &description) const
 	{
@@ -59,31 +123,233 @@ namespace eternal_lands
 		return String(result.str());
 	}
 
-	const GlslProgramSharedPtr &GlslProgramCache::get_program(
+	GlslProgramSharedPtr GlslProgramCache::get_program(
 		const ShaderTypeStringMap &description)
 	{
-		GlslProgramCacheMap::iterator found;
 		GlslProgramSharedPtr glsl_program;
 		String index;
 
 		index = get_index(description);
 
-		found = m_glsl_program_cache.find(index);
+		if (m_glsl_program_cache.find(index, glsl_program))
+		{
+			assert(glsl_program.get() != nullptr);
+
+			return glsl_program;
+		}
+
+		glsl_program = build_program(description, index);
+
+		m_glsl_program_cache.add(index, glsl_program);
+
+		return glsl_program;
+	}
+
+	/**
+	 * The strings are read on first use, because the cache is also
+	 * created without an OpenGL context, e.g. by the shader cache tool.
+	 */
+	const String &GlslProgramCache::get_driver_id()
+	{
+		if (m_driver_id.get().empty())
+		{
+			m_driver_id = String(get_gl_string(GL_VENDOR).get() +
+				UTF8("\n") + get_gl_string(GL_RENDERER).get() +
+				UTF8("\n") + get_gl_string(GL_VERSION).get());
+		}
+
+		return m_driver_id;
+	}
+
+	bool GlslProgramCache::load_cached_binary(const String &file_name,
+		const String &key, GLenum &binary_format,
+		ReadWriteMemory &binary)
+	{
+		MemoryMappedFileSharedPtr memory;
+		ReaderSharedPtr reader;
+		Uint32 size;
+
+		binary.resize(0);
+
+		try
+		{
+			memory = boost::make_shared<MemoryMappedFile>(
+				file_name);
+
+			reader = boost::make_shared<Reader>(memory, file_name);
+
+			if (!reader->check_size(3 * sizeof(Uint32)))
+			{
+				return false;
+			}
+
+			if ((reader->read_u32_le() !=
+					program_binary_cache_magic) ||
+				(reader->read_u32_le() !=
+					program_binary_cache_version))
+			{
+				return false;
+			}
+
+			size = reader->read_u32_le();
+
+			if ((size != key.get().size()) ||
+				!reader->check_size(size + 2 * sizeof(Uint32)))
+			{
+				return false;
+			}
+
+			if (reader->read_utf8_string(size) != key)
+			{
+				return false;
+			}
+
+			binary_format = reader->read_u32_le();
+			size = reader->read_u32_le();
+
+			if ((size == 0) || (reader->get_bytes_left() != size))
+			{
+				return false;
+			}
+
+			reader->read(binary);
+
+			return true;
+		}
+		catch (const FileNotFoundException &)
+		{
+			return false;
+		}
+		catch (boost::exception &exception)
+		{
+			LOG_EXCEPTION(exception);
+		}
+		catch (std::exception &exception)
+		{
+			LOG_EXCEPTION(exception);
+		}
+
+		binary.resize(0);
+
+		return false;
+	}
+
+	bool GlslProgramCache::save_cached_binary(const String &file_name,
+		const String &key, const GLenum binary_format,
+		const ReadWriteMemory &binary)
+	{
+		CacheFileWriter file(file_name);
+
+		if (!file.get_open())
+		{
+			LOG_WARNING(lt_glsl_program, UTF8("Can't create "
+				"program binary cache file '%1%'"), file_name);
+
+			return false;
+		}
+
+		Writer &writer = file.get_writer();
+
+		writer.write_u32_le(program_binary_cache_magic);
+		writer.write_u32_le(program_binary_cache_version);
+		writer.write_u32_le(key.get().size());
+		writer.write_utf8_string(key, key.get().size());
+		writer.write_u32_le(binary_format);
+		writer.write_u32_le(binary.get_size());
+		writer.write(binary);
+
+		if (!file.commit())
+		{
+			LOG_WARNING(lt_glsl_program, UTF8("Can't write "
+				"program binary cache file '%1%'"), file_name);
+
+			return false;
+		}
+
+		return true;
+	}
 
-		if (found != m_glsl_program_cache.end())
+	GlslProgramSharedPtr GlslProgramCache::build_program(
+		const ShaderTypeStringMap &description, const String &index)
+	{
+		GlslProgramSharedPtr glsl_program;
+		ReadWriteMemory binary;
+		Uint8Array20 sha1;
+		String key, file_name;
+		std::string str;
+		GLenum binary_format;
+
+		if (get_global_vars()->get_program_binary_cache_dir(
+			).get().empty() || !GLEW_ARB_get_program_binary)
 		{
-			assert(found->second.get() != nullptr);
+			return boost::make_shared<GlslProgram>(
+				get_uniform_buffer_description_cache(),
+				description, boost::uuids::random_generator()());
+		}
+
+		str = index.get() + UTF8("\n") + get_driver_id().get();
+
+		sha1::calc(str.c_str(), str.size(), sha1.c_array());
+
+		key = FileSystem::get_sha1_string(sha1);
 
-			return found->second;
+		file_name = String(get_global_vars(
+			)->get_program_binary_cache_dir().get() + key.get() +
+			UTF8(".elpb"));
+
+		binary_format = 0;
+
+		if (!load_cached_binary(file_name, key, binary_format,
+			binary))
+		{
+			binary.resize(0);
 		}
 
 		glsl_program = boost::make_shared<GlslProgram>(
 			get_uniform_buffer_description_cache(), description,
+			binary_format, binary,
 			boost::uuids::random_generator()());
 
-		m_glsl_program_cache[index] = glsl_program;
+		if (glsl_program->get_loaded_from_binary())
+		{
+			m_binary_hits++;
+
+			return glsl_program;
+		}
+
+		if (binary.get_size() > 0)
+		{
+			LOG_INFO(lt_glsl_program, UTF8("Program binary cache "
+				"file '%1%' rejected by driver"), file_name);
+
+			m_binary_rejects++;
+		}
+		else
+		{
+			m_binary_misses++;
+		}
+
+		if (glsl_program->get_binary(binary_format, binary))
+		{
+			save_cached_binary(file_name, key, binary_format,
+				binary);
+		}
+
+		return glsl_program;
+	}
 
-		return m_glsl_program_cache[index];
+	void GlslProgramCache::trim()
+	{
+		m_glsl_program_cache.trim();
+	}
+
+	String GlslProgramCache::get_statistics() const
+	{
+		return String(m_glsl_program_cache.get_statistics().get() +
+			boost::str(boost::format(UTF8(", %1% binary hits, "
+				"%2% binary rejects, %3% binary misses")) %
+				m_binary_hits % m_binary_rejects %
+				m_binary_misses));
 	}
 
 }
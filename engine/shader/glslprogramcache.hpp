@@ -14,6 +14,7 @@
 
 #include "prerequisites.hpp"
 #include "shaderutil.hpp"
+#include "lrucache.hpp"
 
 /**
  * @file
@@ -31,14 +32,37 @@ namespace eternal_lands
 	class GlslProgramCache
 	{
 		private:
-			typedef std::map<String, GlslProgramSharedPtr>
-				GlslProgramCacheMap;
+			class GlslProgramCacheTraits
+			{
+				public:
+					static bool get_unused(
+						const GlslProgramSharedPtr
+							&glsl_program) noexcept;
+					static Uint64 get_memory_usage(
+						const GlslProgramSharedPtr
+							&glsl_program) noexcept;
+
+			};
 
+			typedef LruCache<GlslProgramSharedPtr,
+				GlslProgramCacheTraits> GlslProgramLruCache;
+
+			const GlobalVarsConstSharedPtr m_global_vars;
 			const UniformBufferDescriptionCacheWeakPtr
 				m_uniform_buffer_description_cache;
-			GlslProgramCacheMap m_glsl_program_cache;
+			GlslProgramLruCache m_glsl_program_cache;
 			boost::mt19937 m_ran;
 			Mt19937RandomUuidGenerator m_uuid_generator;
+			String m_driver_id;
+			Uint64 m_binary_hits;
+			Uint64 m_binary_rejects;
+			Uint64 m_binary_misses;
+
+			inline const GlobalVarsConstSharedPtr &get_global_vars()
+				const noexcept
+			{
+				return m_global_vars;
+			}
 
 			inline UniformBufferDescriptionCacheSharedPtr
 				get_uniform_buffer_description_cache() const
@@ -56,12 +80,17 @@ namespace eternal_lands
 
 			String get_index(	
 				const ShaderTypeStringMap &description) const;
+			const String &get_driver_id();
+			GlslProgramSharedPtr build_program(
+				const ShaderTypeStringMap &description,
+				const String &index);
 
 		public:
 			/**
 			 * Default constructor.
 			 */
 			GlslProgramCache(
+				const GlobalVarsConstSharedPtr &global_vars,
 				const UniformBufferDescriptionCacheWeakPtr
 					&uniform_buffer_description_cache);
 
@@ -70,9 +99,44 @@ namespace eternal_lands
 			 */
 			~GlslProgramCache() noexcept;
 
-			const GlslProgramSharedPtr &get_program(
+			GlslProgramSharedPtr get_program(
 				const ShaderTypeStringMap &description);
 
+			/**
+			 * Removes the least recently used programs that are
+			 * not used by any effect or filter, until the cache
+			 * fits into its budget.
+			 */
+			void trim();
+			String get_statistics() const;
+
+			/**
+			 * Loads a program binary from a disk cache file.
+			 * @param file_name The name of the cache file.
+			 * @param key The key the file must be saved with.
+			 * @param binary_format Returns the driver format of
+			 * the binary.
+			 * @param binary Returns the binary.
+			 * @return True if the file is complete and saved with
+			 * the key, else false.
+			 */
+			static bool load_cached_binary(const String &file_name,
+				const String &key, GLenum &binary_format,
+				ReadWriteMemory &binary);
+
+			/**
+			 * Saves a program binary into a disk cache file.
+			 * @param file_name The name of the cache file.
+			 * @param key The key of the binary.
+			 * @param binary_format The driver format of the
+			 * binary.
+			 * @param binary The binary.
+			 * @return True if the file was written, else false.
+			 */
+			static bool save_cached_binary(const String &file_name,
+				const String &key, const GLenum binary_format,
+				const ReadWriteMemory &binary);
+
 	};
 
 }
@@ -28,7 +28,16 @@
 #include "colorcorrection.hpp"
 #include "shadersource.hpp"
 #include "shadersourceterrain.hpp"
+#include "thread/autolock.hpp"
 #include "effect/effectnodes.hpp"
+#include "memorymappedfile.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
+#include "utf.hpp"
+#include "buildinformations.hpp"
+#include "cachefilewriter.hpp"
+#include "sha1/sha1.h"
+#include <cstdio>
 
 namespace eternal_lands
 {
@@ -843,27 +852,227 @@ namespace eternal_lands
 			return String();
 		}
 
+		/**
+		 * Magic number and version of the shader source disk cache
+		 * files. Increase the version when the format of the files
+		 * or the building of the sources changes. The version and
+		 * the git sha1 of the engine build are part of the cache
+		 * key and are saved in the files, so every build uses its
+		 * own cache files and the files of other builds are pruned.
+		 */
+		const Uint32 shader_source_cache_magic = 0x53534C45;
+		const Uint32 shader_source_cache_version = 2;
+
+		String get_sha1_string(const std::string &str)
+		{
+			Uint8Array20 sha1;
+
+			sha1::calc(str.c_str(), str.size(), sha1.c_array());
+
+			return FileSystem::get_sha1_string(sha1);
+		}
+
+		String get_program_source(
+			const ShaderTypeStringMap &program_description,
+			const ShaderType shader_type)
+		{
+			ShaderTypeStringMap::const_iterator found;
+
+			found = program_description.find(shader_type);
+
+			if (found == program_description.end())
+			{
+				return String();
+			}
+
+			return found->second;
+		}
+
+		bool load_cached_source(const String &file_name,
+			const String &key,
+			ShaderTypeStringMap &program_description)
+		{
+			MemoryMappedFileSharedPtr memory;
+
+			try
+			{
+				memory = boost::make_shared<MemoryMappedFile>(
+					file_name);
+			}
+			catch (const FileNotFoundException &)
+			{
+				return false;
+			}
+
+			Reader reader(memory, file_name);
+
+			try
+			{
+				if (!reader.check_size(2 * sizeof(Uint32)))
+				{
+					return false;
+				}
+
+				if ((reader.read_u32_le() !=
+						shader_source_cache_magic) ||
+					(reader.read_u32_le() !=
+						shader_source_cache_version))
+				{
+					return false;
+				}
+
+				if (reader.read_dynamic_utf8_string() !=
+					String(git_sha1_str))
+				{
+					return false;
+				}
+
+				if (reader.read_dynamic_utf8_string() != key)
+				{
+					return false;
+				}
+
+				program_description.clear();
+
+				program_description[st_vertex] =
+					reader.read_dynamic_utf8_string();
+				program_description[st_geometry] =
+					reader.read_dynamic_utf8_string();
+				program_description[st_fragment] =
+					reader.read_dynamic_utf8_string();
+
+				return true;
+			}
+			catch (boost::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+			catch (std::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+
+			program_description.clear();
+
+			return false;
+		}
+
+		/**
+		 * Returns if the cache file was written by this build of the
+		 * engine, only then its key can match again.
+		 */
+		bool get_cached_source_current(const String &file_name)
+		{
+			MemoryMappedFileSharedPtr memory;
+
+			try
+			{
+				memory = boost::make_shared<MemoryMappedFile>(
+					file_name);
+
+				Reader reader(memory, file_name);
+
+				if (!reader.check_size(2 * sizeof(Uint32)))
+				{
+					return false;
+				}
+
+				if ((reader.read_u32_le() !=
+						shader_source_cache_magic) ||
+					(reader.read_u32_le() !=
+						shader_source_cache_version))
+				{
+					return false;
+				}
+
+				return reader.read_dynamic_utf8_string() ==
+					String(git_sha1_str);
+			}
+			catch (boost::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+			catch (std::exception &exception)
+			{
+				LOG_EXCEPTION(exception);
+			}
+
+			return false;
+		}
+
+		void save_cached_source(const String &file_name,
+			const String &key,
+			const ShaderTypeStringMap &program_description)
+		{
+			CacheFileWriter file(file_name);
+
+			if (!file.get_open())
+			{
+				LOG_WARNING(lt_shader_source, UTF8("Can't "
+					"create shader source cache file "
+					"'%1%'"), file_name);
+
+				return;
+			}
+
+			Writer &writer = file.get_writer();
+
+			writer.write_u32_le(shader_source_cache_magic);
+			writer.write_u32_le(shader_source_cache_version);
+			writer.write_dynamic_utf8_string(String(git_sha1_str));
+			writer.write_dynamic_utf8_string(key);
+
+			writer.write_dynamic_utf8_string(get_program_source(
+				program_description, st_vertex));
+			writer.write_dynamic_utf8_string(get_program_source(
+				program_description, st_geometry));
+			writer.write_dynamic_utf8_string(get_program_source(
+				program_description, st_fragment));
+
+			if (!file.commit())
+			{
+				LOG_WARNING(lt_shader_source, UTF8("Can't "
+					"write shader source cache file "
+					"'%1%'"), file_name);
+			}
+		}
+
 	}
 
+	/**
+	 * The glsl optimizer uses global type and builtin function tables,
+	 * so it is not thread safe, not even with one context per thread.
+	 * Shader sources can be built by several threads at once, so the
+	 * optimizer is used by only one of them at a time.
+	 */
 	class ShaderSourceBuilder::ShaderSourceOptimizer
 	{
 		private:
 			glslopt_ctx* m_optimizer;
+			SDL_mutex* m_mutex;
 
 		public:
 			inline ShaderSourceOptimizer()
 			{
 				m_optimizer = glslopt_initialize(false, false);
+				m_mutex = SDL_CreateMutex();
 			}
 
 			inline ~ShaderSourceOptimizer() noexcept
 			{
+				SDL_DestroyMutex(m_mutex);
 				glslopt_cleanup(m_optimizer);
 			}
 
-			inline glslopt_ctx* get_optimizer() noexcept
+			inline String get_optimized_source(
+				const String &prefix,
+				const glslopt_shader_type type,
+				const String &source)
 			{
-				return m_optimizer;
+				AutoLock lock(m_mutex);
+
+				return eternal_lands::get_optimized_source(
+					m_optimizer, prefix, type, source);
 			}
 
 	};
@@ -1334,6 +1543,10 @@ namespace eternal_lands
 
 			m_shader_sources[index] = shader_source;
 
+			m_shader_sources_sha1 = get_sha1_string(
+				m_shader_sources_sha1.get() +
+				shader_source->save_xml_string().get());
+
 			LOG_DEBUG(lt_shader_source, UTF8("Shader source type "
 				"%1%-%2% loaded from file '%3%'"), index.first
 				% index.second % file_name);
@@ -3528,11 +3741,150 @@ namespace eternal_lands
 		return sources;
 	}
 
+	String ShaderSourceBuilder::get_cache_key(
+		const EffectDescription &description,
+		const ShaderBuildType shader_build,
+		const ShaderOutputType shader_output,
+		const Uint16 lights_count) const
+	{
+		ShaderSourceTypeStringMap::const_iterator it, end;
+		StringStream str;
+
+		str << shader_source_cache_version << UTF8(" ");
+		str << git_sha1_str << UTF8("\n");
+
+		str << description.get_name() << UTF8("\n");
+		str << description.get_world_transformation() << UTF8("\n");
+		str << description.get_texture_coodrinates() << UTF8("\n");
+		str << description.get_main() << UTF8("\n");
+		str << description.get_lighting() << UTF8("\n");
+		str << description.get_description() << UTF8("\n");
+		str << description.get_output() << UTF8("\n");
+		str << description.get_output_channels_str() << UTF8("\n");
+		str << description.get_receives_shadows();
+		str << description.get_transparent();
+		str << description.get_transparency() << UTF8("\n");
+
+		str << shader_build << UTF8("\n");
+		str << shader_output << UTF8("\n");
+		str << lights_count << UTF8("\n");
+
+		str << static_cast<Uint16>(
+			get_global_vars()->get_opengl_version());
+		str << UTF8(" ") << static_cast<Uint16>(
+			get_global_vars()->get_light_system());
+		str << UTF8(" ") << static_cast<Uint16>(
+			get_global_vars()->get_shadow_quality());
+		str << UTF8(" ") << static_cast<Uint16>(
+			get_global_vars()->get_terrain_quality());
+		str << UTF8(" ") << get_global_vars()->get_shadow_map_count();
+		str << UTF8(" ") <<
+			get_global_vars()->get_clipmap_terrain_slices();
+		str << UTF8(" ") <<
+			get_global_vars()->get_exponential_shadow_maps();
+		str << get_global_vars()->get_use_multisample_shadows();
+		str << get_global_vars()->get_use_block();
+		str << get_global_vars()->get_use_in_out();
+		str << get_global_vars()->get_use_functions();
+		str << get_global_vars()->get_optmize_shader_source();
+		str << get_global_vars()->get_fog() << UTF8("\n");
+
+		str << get_shadow_scale() << UTF8(" ");
+		str << get_vertex_lights_count() << UTF8(" ");
+		str << get_fragment_lights_count() << UTF8(" ");
+		str << get_bones_count() << UTF8(" ");
+		str << get_dynamic_lights_count() << UTF8("\n");
+
+		end = get_default_sources().end();
+
+		for (it = get_default_sources().begin(); it != end; ++it)
+		{
+			str << it->first << UTF8(" ") << it->second;
+			str << UTF8("\n");
+		}
+
+		str << m_shader_sources_sha1;
+
+		return get_sha1_string(str.str());
+	}
+
+	void ShaderSourceBuilder::prune_cache() const
+	{
+		StringSet files;
+		String dir, file_name;
+
+		dir = get_global_vars()->get_shader_source_cache_dir();
+
+		if (dir.get().empty())
+		{
+			return;
+		}
+
+		files = FileSystem::get_dir_files(dir, String(UTF8("*.elsc")));
+
+		BOOST_FOREACH(const String &file, files)
+		{
+			file_name = String(dir.get() + file.get());
+
+			if (get_cached_source_current(file_name))
+			{
+				continue;
+			}
+
+			LOG_DEBUG(lt_shader_source, UTF8("Removing shader "
+				"source cache file '%1%' of another build"),
+				file_name);
+
+			std::remove(utf8_to_string(file_name).c_str());
+		}
+	}
+
 	void ShaderSourceBuilder::build(const EffectDescription &description,
 		const ShaderBuildType shader_build,
 		const ShaderOutputType shader_output,
 		const Uint16 lights_count,
 		ShaderTypeStringMap &program_description) const
+	{
+		String key, file_name;
+
+		if (get_global_vars()->get_shader_source_cache_dir(
+			).get().empty())
+		{
+			do_build(description, shader_build, shader_output,
+				lights_count, program_description);
+
+			return;
+		}
+
+		key = get_cache_key(description, shader_build, shader_output,
+			lights_count);
+
+		file_name = String(get_global_vars(
+			)->get_shader_source_cache_dir().get() + key.get() +
+			UTF8(".elsc"));
+
+		if (load_cached_source(file_name, key, program_description))
+		{
+			LOG_DEBUG(lt_shader_source, UTF8("Shader source %1% "
+				"of effect '%2%' loaded from cache file '%3%'"),
+				shader_build % description.get_name() %
+				file_name);
+
+			return;
+		}
+
+		do_build(description, shader_build, shader_output,
+			lights_count, program_description);
+
+		save_cached_source(file_name, key, program_description);
+	}
+
+	void ShaderSourceBuilder::do_build(
+		const EffectDescription &description,
+		const ShaderBuildType shader_build,
+		const ShaderOutputType shader_output,
+		const Uint16 lights_count,
+		ShaderTypeStringMap &program_description) const
 	{
 		ShaderSourceBuildData build_data;
 		ShaderSourceParameterVector attributes, varyings;
@@ -4028,9 +4380,8 @@ namespace eternal_lands
 		{
 			try
 			{
-				vertex = get_optimized_source(
-					m_optimizer->get_optimizer(), vertex,
-					kGlslOptShaderVertex,
+				vertex = m_optimizer->get_optimized_source(
+					vertex, kGlslOptShaderVertex,
 					String(vertex_source.str()));
 			}
 			catch (boost::exception &exception)
@@ -4046,9 +4397,8 @@ namespace eternal_lands
 
 			try
 			{
-				fragment = get_optimized_source(
-					m_optimizer->get_optimizer(), fragment,
-					kGlslOptShaderFragment,
+				fragment = m_optimizer->get_optimized_source(
+					fragment, kGlslOptShaderFragment,
 					String(fragment_source.str()));
 			}
 			catch (boost::exception &exception)
@@ -47,6 +47,7 @@ namespace eternal_lands
 			const UniformBufferDescriptionCacheWeakPtr
 				m_uniform_buffer_description_cache;
 			boost::scoped_ptr<ShaderSourceOptimizer> m_optimizer;
+			String m_shader_sources_sha1;
 			float m_shadow_scale;
 			Uint16 m_vertex_lights_count;
 			Uint16 m_fragment_lights_count;
@@ -186,6 +187,24 @@ namespace eternal_lands
 				const EffectDescription &description) const;
 			void load_xml(const xmlNodePtr node);
 			void load_sources(const xmlNodePtr node);
+			void do_build(const EffectDescription &description,
+				const ShaderBuildType shader_build,
+				const ShaderOutputType shader_output,
+				const Uint16 lights_count,
+				ShaderTypeStringMap &program_description) const;
+
+			/**
+			 * Returns the key of the shader source disk cache. It
+			 * is the sha1 of everything the built source depends
+			 * on: the effect description, the build parameters,
+			 * the global vars used, the loaded shader sources and
+			 * the cache version and git sha1 of the engine build.
+			 */
+			String get_cache_key(
+				const EffectDescription &description,
+				const ShaderBuildType shader_build,
+				const ShaderOutputType shader_output,
+				const Uint16 lights_count) const;
 
 		public:
 			ShaderSourceBuilder(
@@ -196,6 +215,21 @@ namespace eternal_lands
 			~ShaderSourceBuilder() noexcept;
 			void load_xml(const String &file_name);
 			void load_shader_sources(const String &dir);
+
+			/**
+			 * Removes the files of other engine builds from the
+			 * shader source cache dir, their keys never match
+			 * again. Must not be called while sources are built.
+			 */
+			void prune_cache() const;
+
+			/**
+			 * Builds the shader source of the effect. If the
+			 * shader source cache dir of the global vars is set,
+			 * the source is read from the disk cache or saved
+			 * there after it is built. Can be called from several
+			 * threads at the same time.
+			 */
 			void build(const EffectDescription &description,
 				const ShaderBuildType shader_build,
 				const ShaderOutputType shader_output,
@@ -13,6 +13,16 @@ namespace eternal_lands
 
 	UniformBufferDescriptionCache::UniformBufferDescriptionCache()
 	{
+		Uint32 i, count;
+
+		/* Shader sources are built from several threads */
+		count = UniformBufferUtil::get_uniform_buffer_count();
+
+		for (i = 0; i < count; ++i)
+		{
+			get_uniform_buffer_description(
+				static_cast<UniformBufferType>(i));
+		}
 	}
 
 	UniformBufferDescriptionCache::~UniformBufferDescriptionCache()
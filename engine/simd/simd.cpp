@@ -6,6 +6,14 @@
  ****************************************************************************/
 
 #include "simd.hpp"
+#include "simdavx.hpp"
+#ifdef	USE_AVX2
+#ifdef	_MSC_VER
+#include <intrin.h>
+#else	/* _MSC_VER */
+#include <cpuid.h>
+#endif	/* _MSC_VER */
+#endif	/* USE_AVX2 */
 #ifdef	USE_SSE2
 #include <emmintrin.h>
 #endif	/* USE_SSE2 */
@@ -16,9 +24,136 @@
 namespace eternal_lands
 {
 
+	namespace
+	{
+
+#ifdef	USE_AVX2
+		void get_cpuid(const Uint32 leaf, Uint32 &eax, Uint32 &ebx,
+			Uint32 &ecx, Uint32 &edx)
+		{
+#ifdef	_MSC_VER
+			int info[4];
+
+			__cpuidex(info, leaf, 0);
+
+			eax = info[0];
+			ebx = info[1];
+			ecx = info[2];
+			edx = info[3];
+#else	/* _MSC_VER */
+			__cpuid_count(leaf, 0, eax, ebx, ecx, edx);
+#endif	/* _MSC_VER */
+		}
+
+		/**
+		 * Returns the register state the os saves, AVX needs the
+		 * SSE and AVX state (bits one and two).
+		 */
+		Uint32 get_xcr0()
+		{
+#ifdef	_MSC_VER
+			return _xgetbv(0);
+#else	/* _MSC_VER */
+			Uint32 eax, edx;
+
+			__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx)
+				: "c" (0));
+
+			return eax;
+#endif	/* _MSC_VER */
+		}
+#endif	/* USE_AVX2 */
+
+		BitSet16 detect_instruction_sets()
+		{
+			BitSet16 result;
+#ifdef	USE_AVX2
+			Uint32 eax, ebx, ecx, edx, max_leaf;
+			bool avx_state;
+
+			get_cpuid(0, max_leaf, ebx, ecx, edx);
+
+			if (max_leaf < 1)
+			{
+				return result;
+			}
+
+			get_cpuid(1, eax, ebx, ecx, edx);
+
+			avx_state = false;
+
+			/* osxsave */
+			if ((ecx & (1 << 27)) != 0)
+			{
+				avx_state = (get_xcr0() & 0x6) == 0x6;
+			}
+
+			result[sist_sse4_1] = (ecx & (1 << 19)) != 0;
+			result[sist_avx] = avx_state && ((ecx & (1 << 28)) != 0);
+			result[sist_f16c] = result[sist_avx] &&
+				((ecx & (1 << 29)) != 0);
+
+			if (max_leaf >= 7)
+			{
+				get_cpuid(7, eax, ebx, ecx, edx);
+
+				result[sist_avx2] = result[sist_avx] &&
+					((ebx & (1 << 5)) != 0);
+			}
+#endif	/* USE_AVX2 */
+
+			return result;
+		}
+
+		const BitSet16 supported_instruction_sets =
+			detect_instruction_sets();
+		BitSet16 used_instruction_sets = supported_instruction_sets;
+
+	}
+
+	BitSet16 SIMD::get_supported_instruction_sets()
+	{
+		return supported_instruction_sets;
+	}
+
+	BitSet16 SIMD::get_instruction_sets()
+	{
+		return used_instruction_sets;
+	}
+
+	void SIMD::set_instruction_sets(const BitSet16 instruction_sets)
+	{
+		used_instruction_sets = instruction_sets &
+			supported_instruction_sets;
+	}
+
+	String SIMD::get_str(const SimdInstructionSetType instruction_set)
+	{
+		switch (instruction_set)
+		{
+			case sist_sse4_1:
+				return String(UTF8("sse4.1"));
+			case sist_avx:
+				return String(UTF8("avx"));
+			case sist_avx2:
+				return String(UTF8("avx2"));
+			case sist_f16c:
+				return String(UTF8("f16c"));
+		}
+
+		return String(UTF8("unknown"));
+	}
+
 	void SIMD::float_to_half_4(const float* source, const Uint32 count,
 		const Uint32 stride, unsigned char* dest)
 	{
+		if (used_instruction_sets[sist_f16c])
+		{
+			SIMDAVX::float_to_half_4(source, count, stride, dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
 		__m128i t10, t11, t12, t13, t14, t15, t16, t17, t18;
@@ -91,6 +226,13 @@ namespace eternal_lands
 	void SIMD::float_to_half_2(const float* source, const Uint32 count,
 		const Uint32 stride, Uint8* dest)
 	{
+		if (used_instruction_sets[sist_f16c])
+		{
+			SIMDAVX::float_to_half_2(source, count, stride, dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
 		__m128i t10, t11, t12, t13, t14, t15, t16, t17, t18;
@@ -726,6 +868,13 @@ namespace eternal_lands
 
 	void SIMD::fill(const glm::vec4 &data, const Uint32 count, float* dest)
 	{
+		if (used_instruction_sets[sist_avx])
+		{
+			SIMDAVX::fill(glm::value_ptr(data), count, dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128 t0;
 		Uint32 i;
@@ -739,9 +888,182 @@ namespace eternal_lands
 #endif	/* USE_SSE2 */
 	}
 
+#ifdef	USE_SSE2
+
+	namespace
+	{
+
+		/**
+		 * Loads one vertex of four triangles, x, y and z of the
+		 * four vertices are returned in one register each.
+		 */
+		void load_triangle_vertex(const float* data,
+			const Uint32* indices, const Uint32 vertex, __m128 &x,
+			__m128 &y, __m128 &z)
+		{
+			__m128 t0, t1, t2, t3;
+
+			t0 = _mm_load_ps(data + 4 * indices[vertex]);
+			t1 = _mm_load_ps(data + 4 * indices[vertex + 3]);
+			t2 = _mm_load_ps(data + 4 * indices[vertex + 6]);
+			t3 = _mm_load_ps(data + 4 * indices[vertex + 9]);
+
+			_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+
+			x = t0;
+			y = t1;
+			z = t2;
+		}
+
+		/**
+		 * Stores x, y and z of four triangles as four blocks of
+		 * four floats, w is set to zero.
+		 */
+		void store_triangle_data(const __m128 x, const __m128 y,
+			const __m128 z, float* dest)
+		{
+			__m128 t0, t1, t2, t3;
+
+			t0 = x;
+			t1 = y;
+			t2 = z;
+			t3 = _mm_setzero_ps();
+
+			_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+
+			_mm_store_ps(dest, t0);
+			_mm_store_ps(dest + 4, t1);
+			_mm_store_ps(dest + 8, t2);
+			_mm_store_ps(dest + 12, t3);
+		}
+
+	}
+
+#endif	/* USE_SSE2 */
+
+	void SIMD::build_face_normals(const float* positions,
+		const Uint32* indices, const Uint32 count, float* normals)
+	{
+#ifdef	USE_SSE2
+		__m128 x0, y0, z0, x1, y1, z1, x2, y2, z2, x, y, z;
+		__m128 len, mask, min_len;
+		Uint32 i;
+
+		min_len = _mm_set1_ps(epsilon);
+
+		for (i = 0; i < count; i += 4)
+		{
+			load_triangle_vertex(positions, indices + 3 * i, 0,
+				x0, y0, z0);
+			load_triangle_vertex(positions, indices + 3 * i, 1,
+				x1, y1, z1);
+			load_triangle_vertex(positions, indices + 3 * i, 2,
+				x2, y2, z2);
+
+			x1 = _mm_sub_ps(x1, x0);
+			y1 = _mm_sub_ps(y1, y0);
+			z1 = _mm_sub_ps(z1, z0);
+			x2 = _mm_sub_ps(x2, x0);
+			y2 = _mm_sub_ps(y2, y0);
+			z2 = _mm_sub_ps(z2, z0);
+
+			/* cross */
+			x = _mm_sub_ps(_mm_mul_ps(y1, z2), _mm_mul_ps(y2, z1));
+			y = _mm_sub_ps(_mm_mul_ps(z1, x2), _mm_mul_ps(z2, x1));
+			z = _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(x2, y1));
+
+			len = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+			len = _mm_add_ps(len, _mm_mul_ps(z, z));
+
+			/* degenerated triangles get a zero normal */
+			mask = _mm_cmpge_ps(len, min_len);
+			len = _mm_sqrt_ps(len);
+
+			x = _mm_and_ps(_mm_div_ps(x, len), mask);
+			y = _mm_and_ps(_mm_div_ps(y, len), mask);
+			z = _mm_and_ps(_mm_div_ps(z, len), mask);
+
+			store_triangle_data(x, y, z, normals + 4 * i);
+		}
+#endif	/* USE_SSE2 */
+	}
+
+	void SIMD::build_face_tangents(const float* positions,
+		const float* texture_coords, const Uint32* indices,
+		const Uint32 count, float* tangents, float* bitangents)
+	{
+#ifdef	USE_SSE2
+		__m128 x0, y0, z0, x1, y1, z1, x2, y2, z2, x, y, z;
+		__m128 u0, v0, u1, v1, u2, v2, det, r, mask, one, sign;
+		Uint32 i;
+
+		one = _mm_set1_ps(1.0f);
+		sign = _mm_set1_ps(-0.0f);
+
+		for (i = 0; i < count; i += 4)
+		{
+			load_triangle_vertex(positions, indices + 3 * i, 0,
+				x0, y0, z0);
+			load_triangle_vertex(positions, indices + 3 * i, 1,
+				x1, y1, z1);
+			load_triangle_vertex(positions, indices + 3 * i, 2,
+				x2, y2, z2);
+			load_triangle_vertex(texture_coords, indices + 3 * i,
+				0, u0, v0, z);
+			load_triangle_vertex(texture_coords, indices + 3 * i,
+				1, u1, v1, z);
+			load_triangle_vertex(texture_coords, indices + 3 * i,
+				2, u2, v2, z);
+
+			x1 = _mm_sub_ps(x1, x0);
+			y1 = _mm_sub_ps(y1, y0);
+			z1 = _mm_sub_ps(z1, z0);
+			x2 = _mm_sub_ps(x2, x0);
+			y2 = _mm_sub_ps(y2, y0);
+			z2 = _mm_sub_ps(z2, z0);
+
+			u1 = _mm_sub_ps(u1, u0);
+			v1 = _mm_sub_ps(v1, v0);
+			u2 = _mm_sub_ps(u2, u0);
+			v2 = _mm_sub_ps(v2, v0);
+
+			det = _mm_sub_ps(_mm_mul_ps(u1, v2),
+				_mm_mul_ps(u2, v1));
+
+			/* r is one for degenerated texture coordinates */
+			mask = _mm_cmpgt_ps(_mm_andnot_ps(sign, det),
+				_mm_setzero_ps());
+			r = _mm_or_ps(_mm_and_ps(mask, _mm_div_ps(one, det)),
+				_mm_andnot_ps(mask, one));
+
+			x = _mm_sub_ps(_mm_mul_ps(v2, x1), _mm_mul_ps(v1, x2));
+			y = _mm_sub_ps(_mm_mul_ps(v2, y1), _mm_mul_ps(v1, y2));
+			z = _mm_sub_ps(_mm_mul_ps(v2, z1), _mm_mul_ps(v1, z2));
+
+			store_triangle_data(_mm_mul_ps(x, r), _mm_mul_ps(y, r),
+				_mm_mul_ps(z, r), tangents + 4 * i);
+
+			x = _mm_sub_ps(_mm_mul_ps(u1, x2), _mm_mul_ps(u2, x1));
+			y = _mm_sub_ps(_mm_mul_ps(u1, y2), _mm_mul_ps(u2, y1));
+			z = _mm_sub_ps(_mm_mul_ps(u1, z2), _mm_mul_ps(u2, z1));
+
+			store_triangle_data(_mm_mul_ps(x, r), _mm_mul_ps(y, r),
+				_mm_mul_ps(z, r), bitangents + 4 * i);
+		}
+#endif	/* USE_SSE2 */
+	}
+
 	void SIMD::transform(const float* source, const Uint32 count,
 		const glm::mat4x3 &matrix, float* dest)
 	{
+		if (used_instruction_sets[sist_avx])
+		{
+			SIMDAVX::transform_4x3(source, count,
+				glm::value_ptr(matrix), dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128 tmp, m0, m1, m2, m3, x, y, z;
 		Uint32 i;
@@ -775,9 +1097,53 @@ namespace eternal_lands
 #endif	/* USE_SSE2 */
 	}
 
+	void SIMD::transform(const float* source, const Uint32 count,
+		const glm::mat4x4 &matrix, float* dest)
+	{
+#ifdef	USE_SSE2
+		__m128 tmp, m0, m1, m2, m3, x, y, z;
+		Uint32 i;
+
+		m0 = _mm_loadu_ps(glm::value_ptr(matrix[0]));
+		m1 = _mm_loadu_ps(glm::value_ptr(matrix[1]));
+		m2 = _mm_loadu_ps(glm::value_ptr(matrix[2]));
+		m3 = _mm_loadu_ps(glm::value_ptr(matrix[3]));
+
+		for (i = 0; i < count; ++i)
+		{
+			tmp = _mm_load_ps(source + 4 * i);
+
+			x = (__m128)_mm_shuffle_epi32((__m128i)tmp,
+				_MM_SHUFFLE(0, 0, 0, 0));
+			y = (__m128)_mm_shuffle_epi32((__m128i)tmp,
+				_MM_SHUFFLE(1, 1, 1, 1));
+			z = (__m128)_mm_shuffle_epi32((__m128i)tmp,
+				_MM_SHUFFLE(2, 2, 2, 2));
+
+			x = _mm_mul_ps(x, m0);
+			y = _mm_mul_ps(y, m1);
+			z = _mm_mul_ps(z, m2);
+
+			tmp = _mm_add_ps(m3, x);
+			tmp = _mm_add_ps(tmp, y);
+			tmp = _mm_add_ps(tmp, z);
+
+			_mm_store_ps(dest + 4 * i, tmp);
+		}
+#endif	/* USE_SSE2 */
+	}
+
 	void SIMD::transform(const float* source, const Uint32 count,
 		const glm::mat3x3 &matrix, float* dest)
 	{
+		if (used_instruction_sets[sist_avx])
+		{
+			SIMDAVX::transform_3x3(source, count,
+				glm::value_ptr(matrix), dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128 tmp, m0, m1, m2, x, y, z, w, mask, normal;
 		Uint32 i;
@@ -835,6 +1201,14 @@ namespace eternal_lands
 	void SIMD::transform(const float* source, const Uint32 count,
 		const glm::vec4 &scale_offset, float* dest)
 	{
+		if (used_instruction_sets[sist_avx])
+		{
+			SIMDAVX::transform_scale_offset(source, count,
+				glm::value_ptr(scale_offset), dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128 tmp, offset, scale;
 		Uint32 i;
@@ -1031,6 +1405,14 @@ namespace eternal_lands
 	void SIMD::float_to_signed_short_8_scale(const float* source,
 		const Uint32 count, const float scale, Sint16* dest)
 	{
+		if (used_instruction_sets[sist_avx2])
+		{
+			SIMDAVX::float_to_signed_short_8_scale(source,
+				count, scale, dest);
+
+			return;
+		}
+
 #ifdef	USE_SSE2
 		__m128 t0, t1, s;
 		__m128i t2, t3, t4;
@@ -1059,6 +1441,12 @@ namespace eternal_lands
 		const Sint16* min_max_boxes, const Uint32 count,
 		const float view_x, const float view_y, const float threshold)
 	{
+		if (used_instruction_sets[sist_avx])
+		{
+			return SIMDAVX::check_coverage(matrix, min_max_boxes,
+				count, view_x, view_y, threshold);
+		}
+
 #ifdef	USE_SSE2
 		__m128 m0, m1, m2, m3, tmp, low, high, min, max, view, x, y, z;
 		__m128 w_rcp, t;
@@ -1305,6 +1693,24 @@ namespace eternal_lands
 		const Sint16* min_max_boxes, const Uint32 count,
 		const float view_x, const float view_y, const float threshold)
 	{
+		if (used_instruction_sets[sist_avx])
+		{
+			Uint64 mask;
+			BitSet64 result;
+			Uint32 i;
+
+			mask = SIMDAVX::check_coverage_simple(matrix,
+				min_max_boxes, count, view_x, view_y,
+				threshold);
+
+			for (i = 0; i < count; ++i)
+			{
+				result[i] = ((mask >> i) & 1) != 0;
+			}
+
+			return result;
+		}
+
 #ifdef	USE_SSE2
 		__m128 m0, m1, m2, m3, tmp, low, high, min, max, view, x, y, z;
 		__m128 w_rcp, t;
@@ -22,12 +22,57 @@
 namespace eternal_lands
 {
 
+	/**
+	 * @brief Instruction sets used for wider SIMD functions.
+	 *
+	 * SSE2 is always used when available, these are only used when
+	 * supported by the cpu and the os.
+	 */
+	enum SimdInstructionSetType
+	{
+		sist_sse4_1 = 0,
+		sist_avx,
+		sist_avx2,
+		sist_f16c
+	};
+
 	class SIMD
 	{
 		public:
+			/**
+			 * Returns the instruction sets that are supported by
+			 * the cpu, the os and the build. They are detected
+			 * once at startup.
+			 * @return The supported instruction sets, indexed by
+			 * SimdInstructionSetType.
+			 */
+			static BitSet16 get_supported_instruction_sets();
+
+			/**
+			 * Returns the instruction sets used by the SIMD
+			 * functions, all supported ones by default.
+			 * @return The used instruction sets, indexed by
+			 * SimdInstructionSetType.
+			 */
+			static BitSet16 get_instruction_sets();
+
+			/**
+			 * Sets the instruction sets used by the SIMD
+			 * functions, unsupported ones are ignored. Used to
+			 * compare or benchmark the versions of the functions.
+			 * Must not be called while any SIMD function runs.
+			 * @param instruction_sets The instruction sets to use,
+			 * indexed by SimdInstructionSetType.
+			 */
+			static void set_instruction_sets(
+				const BitSet16 instruction_sets);
+
+			static String get_str(
+				const SimdInstructionSetType instruction_set);
+
 			/**
 			 * Converts an array of floats to half floats using
-			 * SSE2. Floats are processed in blocks of four each
+			 * SSE2 or F16C. Floats are processed in blocks of four each
 			 * and are stored as blocks of four half floats.
 			 * Be carefull when using these functions, no error
 			 * checking is done!
@@ -46,7 +91,7 @@ namespace eternal_lands
 
 			/**
 			 * Converts an array of floats to half floats using
-			 * SSE2. Floats are processed in blocks of four each
+			 * SSE2 or F16C. Floats are processed in blocks of four each
 			 * and are stored as blocks of two half floats. Only
 			 * the two lower floats are processed.
 			 * Be carefull when using these functions, no error
@@ -259,10 +304,10 @@ namespace eternal_lands
 				const Uint32 stride, Uint8* dest);
 
 			/**
-			 * Transforms an array of floats using SSE2. Floats are
-			 * processed in blocks of four each and transformed
-			 * using the matrix and are stored as blocks of four
-			 * floats.
+			 * Transforms an array of floats using SSE2 or AVX.
+			 * Floats are processed in blocks of four each and
+			 * transformed using the matrix and are stored as
+			 * blocks of four floats.
 			 * Be carefull when using these functions, no error
 			 * checking is done!
 			 * @param source The source memory must be 16 byte
@@ -278,10 +323,30 @@ namespace eternal_lands
 				float* dest);
 
 			/**
-			 * Transforms an array of floats using SSE2. Floats are
-			 * processed in blocks of three each and transformed
-			 * using the matrix and are stored as blocks of four
-			 * floats.
+			 * Transforms an array of floats using SSE2.
+			 * Floats are processed in blocks of three each and
+			 * transformed using the matrix and are stored as
+			 * blocks of four floats, keeping the w component of
+			 * the result. Used to project vertices into clip
+			 * space. Be carefull when using these functions, no
+			 * error checking is done!
+			 * @param source The source memory must be 16 byte
+			 * aligned.
+			 * @param count The Number of four float blocks to
+			 * process.
+			 * @param matrix The transformation matrix to use.
+			 * @param dest The dest memory must be 16 byte
+			 * aligned.
+			 */
+			static void transform(const float* source,
+				const Uint32 count, const glm::mat4x4 &matrix,
+				float* dest);
+
+			/**
+			 * Transforms an array of floats using SSE2 or AVX.
+			 * Floats are processed in blocks of three each and
+			 * transformed using the matrix and are stored as
+			 * blocks of four floats.
 			 * Be carefull when using these functions, no error
 			 * checking is done!
 			 * @param source The source memory must be 16 byte
@@ -297,10 +362,10 @@ namespace eternal_lands
 				float* dest);
 
 			/**
-			 * Transforms an array of floats using SSE2. Floats are
-			 * processed in blocks of three each and transformed
-			 * using the scale offset and are stored as blocks of
-			 * four floats.
+			 * Transforms an array of floats using SSE2 or AVX.
+			 * Floats are processed in blocks of three each and
+			 * transformed using the scale offset and are stored
+			 * as blocks of four floats.
 			 * Be carefull when using these functions, no error
 			 * checking is done!
 			 * @param source The source memory must be 16 byte
@@ -328,6 +393,48 @@ namespace eternal_lands
 			static void fill(const glm::vec4 &data,
 				const Uint32 count, float* dest);
 
+			/**
+			 * Calculates the normals of triangles using SSE2.
+			 * Triangles are processed in blocks of four, the
+			 * normals of degenerated triangles are zero.
+			 * Be carefull when using these functions, no error
+			 * checking is done!
+			 * @param positions The positions as blocks of four
+			 * floats, the memory must be 16 byte aligned.
+			 * @param indices The three indices of each triangle.
+			 * @param count The Number of triangles to process,
+			 * must be a multiple of four.
+			 * @param normals The dest memory for one block of four
+			 * floats per triangle, must be 16 byte aligned.
+			 */
+			static void build_face_normals(const float* positions,
+				const Uint32* indices, const Uint32 count,
+				float* normals);
+
+			/**
+			 * Calculates the not normalized tangents and
+			 * bitangents of triangles using SSE2. Triangles are
+			 * processed in blocks of four.
+			 * Be carefull when using these functions, no error
+			 * checking is done!
+			 * @param positions The positions as blocks of four
+			 * floats, the memory must be 16 byte aligned.
+			 * @param texture_coords The texture coordinates as
+			 * blocks of four floats, the memory must be 16 byte
+			 * aligned.
+			 * @param indices The three indices of each triangle.
+			 * @param count The Number of triangles to process,
+			 * must be a multiple of four.
+			 * @param tangents The dest memory for one block of
+			 * four floats per triangle, must be 16 byte aligned.
+			 * @param bitangents The dest memory for one block of
+			 * four floats per triangle, must be 16 byte aligned.
+			 */
+			static void build_face_tangents(const float* positions,
+				const float* texture_coords,
+				const Uint32* indices, const Uint32 count,
+				float* tangents, float* bitangents);
+
 			/**
 			 * Converts an array of floats to signed shorts using
 			 * SSE2. Floats are scaled and processed in blocks of
@@ -0,0 +1,555 @@
+/****************************************************************************
+ *            simdavx.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "simdavx.hpp"
+#ifdef	USE_AVX2
+#include <immintrin.h>
+#endif	/* USE_AVX2 */
+
+namespace eternal_lands
+{
+
+#ifdef	USE_AVX2
+	namespace
+	{
+
+		/**
+		 * The dest memory of the SIMD functions is only 16 byte
+		 * aligned, but streaming stores of eight floats need 32
+		 * byte aligned memory.
+		 */
+		inline bool get_aligned_32(const void* ptr)
+		{
+			return (reinterpret_cast<size_t>(ptr) & 31) == 0;
+		}
+
+		inline __m128 transform_value_4x3(const __m128 value,
+			const __m128 m0, const __m128 m1, const __m128 m2,
+			const __m128 m3)
+		{
+			__m128 tmp, x, y, z;
+
+			x = _mm_permute_ps(value, _MM_SHUFFLE(0, 0, 0, 0));
+			y = _mm_permute_ps(value, _MM_SHUFFLE(1, 1, 1, 1));
+			z = _mm_permute_ps(value, _MM_SHUFFLE(2, 2, 2, 2));
+
+			x = _mm_mul_ps(x, m0);
+			y = _mm_mul_ps(y, m1);
+			z = _mm_mul_ps(z, m2);
+
+			tmp = _mm_add_ps(m3, x);
+			tmp = _mm_add_ps(tmp, y);
+			tmp = _mm_add_ps(tmp, z);
+
+			return tmp;
+		}
+
+		inline __m256 transform_value_4x3(const __m256 value,
+			const __m256 m0, const __m256 m1, const __m256 m2,
+			const __m256 m3)
+		{
+			__m256 tmp, x, y, z;
+
+			x = _mm256_permute_ps(value, _MM_SHUFFLE(0, 0, 0, 0));
+			y = _mm256_permute_ps(value, _MM_SHUFFLE(1, 1, 1, 1));
+			z = _mm256_permute_ps(value, _MM_SHUFFLE(2, 2, 2, 2));
+
+			x = _mm256_mul_ps(x, m0);
+			y = _mm256_mul_ps(y, m1);
+			z = _mm256_mul_ps(z, m2);
+
+			tmp = _mm256_add_ps(m3, x);
+			tmp = _mm256_add_ps(tmp, y);
+			tmp = _mm256_add_ps(tmp, z);
+
+			return tmp;
+		}
+
+		inline __m128 transform_value_3x3(const __m128 value,
+			const __m128 m0, const __m128 m1, const __m128 m2,
+			const __m128 mask)
+		{
+			__m128 tmp, x, y, z, w, normal;
+
+			x = _mm_permute_ps(value, _MM_SHUFFLE(0, 0, 0, 0));
+			y = _mm_permute_ps(value, _MM_SHUFFLE(1, 1, 1, 1));
+			z = _mm_permute_ps(value, _MM_SHUFFLE(2, 2, 2, 2));
+			w = _mm_and_ps(value, mask);
+
+			x = _mm_mul_ps(x, m0);
+			y = _mm_mul_ps(y, m1);
+			z = _mm_mul_ps(z, m2);
+
+			normal = _mm_add_ps(x, y);
+			normal = _mm_add_ps(normal, z);
+
+			tmp = _mm_mul_ps(normal, normal);
+
+			x = _mm_permute_ps(tmp, _MM_SHUFFLE(0, 0, 0, 0));
+			y = _mm_permute_ps(tmp, _MM_SHUFFLE(1, 1, 1, 1));
+			z = _mm_permute_ps(tmp, _MM_SHUFFLE(2, 2, 2, 2));
+
+			tmp = _mm_add_ps(x, y);
+			tmp = _mm_add_ps(tmp, z);
+			tmp = _mm_rsqrt_ps(tmp);
+
+			normal = _mm_mul_ps(normal, tmp);
+
+			return _mm_or_ps(normal, w);
+		}
+
+		inline __m256 transform_value_3x3(const __m256 value,
+			const __m256 m0, const __m256 m1, const __m256 m2,
+			const __m256 mask)
+		{
+			__m256 tmp, x, y, z, w, normal;
+
+			x = _mm256_permute_ps(value, _MM_SHUFFLE(0, 0, 0, 0));
+			y = _mm256_permute_ps(value, _MM_SHUFFLE(1, 1, 1, 1));
+			z = _mm256_permute_ps(value, _MM_SHUFFLE(2, 2, 2, 2));
+			w = _mm256_and_ps(value, mask);
+
+			x = _mm256_mul_ps(x, m0);
+			y = _mm256_mul_ps(y, m1);
+			z = _mm256_mul_ps(z, m2);
+
+			normal = _mm256_add_ps(x, y);
+			normal = _mm256_add_ps(normal, z);
+
+			tmp = _mm256_mul_ps(normal, normal);
+
+			x = _mm256_permute_ps(tmp, _MM_SHUFFLE(0, 0, 0, 0));
+			y = _mm256_permute_ps(tmp, _MM_SHUFFLE(1, 1, 1, 1));
+			z = _mm256_permute_ps(tmp, _MM_SHUFFLE(2, 2, 2, 2));
+
+			tmp = _mm256_add_ps(x, y);
+			tmp = _mm256_add_ps(tmp, z);
+			tmp = _mm256_rsqrt_ps(tmp);
+
+			normal = _mm256_mul_ps(normal, tmp);
+
+			return _mm256_or_ps(normal, w);
+		}
+
+		inline __m256 get_lanes(const __m128 value)
+		{
+			return _mm256_insertf128_ps(_mm256_castps128_ps256(
+				value), value, 1);
+		}
+
+		inline __m128 reduce_min(const __m256 value)
+		{
+			__m128 tmp;
+
+			tmp = _mm_min_ps(_mm256_castps256_ps128(value),
+				_mm256_extractf128_ps(value, 1));
+			tmp = _mm_min_ps(tmp, _mm_permute_ps(tmp,
+				_MM_SHUFFLE(1, 0, 3, 2)));
+			tmp = _mm_min_ps(tmp, _mm_permute_ps(tmp,
+				_MM_SHUFFLE(2, 3, 0, 1)));
+
+			return tmp;
+		}
+
+		inline __m128 reduce_max(const __m256 value)
+		{
+			__m128 tmp;
+
+			tmp = _mm_max_ps(_mm256_castps256_ps128(value),
+				_mm256_extractf128_ps(value, 1));
+			tmp = _mm_max_ps(tmp, _mm_permute_ps(tmp,
+				_MM_SHUFFLE(1, 0, 3, 2)));
+			tmp = _mm_max_ps(tmp, _mm_permute_ps(tmp,
+				_MM_SHUFFLE(2, 3, 0, 1)));
+
+			return tmp;
+		}
+
+		/**
+		 * Projects the eight corners of the box, with one corner
+		 * in each lane, and returns the covered area of their
+		 * bounding rectangle in the lowest float.
+		 */
+		inline __m128 get_coverage(const float* matrix,
+			const Sint16* min_max_box, const __m128 view)
+		{
+			__m256 low, high, x, y, z, px, py, pw;
+			__m128i tmp_i;
+			__m128 min, max, tmp;
+
+			tmp_i = _mm_load_si128((const __m128i*)min_max_box);
+
+			low = get_lanes(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(
+				tmp_i)));
+			high = get_lanes(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(
+				_mm_srli_si128(tmp_i, 8))));
+
+			x = _mm256_blend_ps(_mm256_permute_ps(low,
+				_MM_SHUFFLE(0, 0, 0, 0)), _mm256_permute_ps(
+				high, _MM_SHUFFLE(0, 0, 0, 0)), 0xAA);
+			y = _mm256_blend_ps(_mm256_permute_ps(low,
+				_MM_SHUFFLE(1, 1, 1, 1)), _mm256_permute_ps(
+				high, _MM_SHUFFLE(1, 1, 1, 1)), 0xCC);
+			z = _mm256_blend_ps(_mm256_permute_ps(low,
+				_MM_SHUFFLE(2, 2, 2, 2)), _mm256_permute_ps(
+				high, _MM_SHUFFLE(2, 2, 2, 2)), 0xF0);
+
+			px = _mm256_mul_ps(x, _mm256_set1_ps(matrix[0]));
+			px = _mm256_add_ps(px, _mm256_mul_ps(y,
+				_mm256_set1_ps(matrix[4])));
+			px = _mm256_add_ps(px, _mm256_mul_ps(z,
+				_mm256_set1_ps(matrix[8])));
+			px = _mm256_add_ps(px, _mm256_set1_ps(matrix[12]));
+
+			py = _mm256_mul_ps(x, _mm256_set1_ps(matrix[1]));
+			py = _mm256_add_ps(py, _mm256_mul_ps(y,
+				_mm256_set1_ps(matrix[5])));
+			py = _mm256_add_ps(py, _mm256_mul_ps(z,
+				_mm256_set1_ps(matrix[9])));
+			py = _mm256_add_ps(py, _mm256_set1_ps(matrix[13]));
+
+			pw = _mm256_mul_ps(x, _mm256_set1_ps(matrix[3]));
+			pw = _mm256_add_ps(pw, _mm256_mul_ps(y,
+				_mm256_set1_ps(matrix[7])));
+			pw = _mm256_add_ps(pw, _mm256_mul_ps(z,
+				_mm256_set1_ps(matrix[11])));
+			pw = _mm256_add_ps(pw, _mm256_set1_ps(matrix[15]));
+
+			pw = _mm256_rcp_ps(pw);
+
+			px = _mm256_mul_ps(px, pw);
+			py = _mm256_mul_ps(py, pw);
+
+			/* the lowest two floats are x and y */
+			min = _mm_unpacklo_ps(reduce_min(px), reduce_min(py));
+			max = _mm_unpacklo_ps(reduce_max(px), reduce_max(py));
+
+			min = _mm_min_ps(min, _mm_set1_ps(1.0f));
+			max = _mm_min_ps(max, _mm_set1_ps(1.0f));
+			min = _mm_max_ps(min, _mm_set1_ps(-1.0f));
+			max = _mm_max_ps(max, _mm_set1_ps(-1.0f));
+
+			tmp = _mm_sub_ps(max, min);
+
+			tmp = _mm_mul_ps(tmp, view);
+
+			return _mm_mul_ss(tmp, _mm_permute_ps(tmp,
+				_MM_SHUFFLE(1, 1, 1, 1)));
+		}
+
+	}
+#endif	/* USE_AVX2 */
+
+	void SIMDAVX::float_to_half_4(const float* source, const Uint32 count,
+		const Uint32 stride, Uint8* dest)
+	{
+#ifdef	USE_AVX2
+		__m128i tmp;
+		Uint32 i;
+
+		for (i = 0; i < count; ++i)
+		{
+			tmp = _mm_cvtps_ph(_mm_load_ps(source + i * 4), 0);
+
+			_mm_storel_epi64((__m128i*)(dest + i * stride), tmp);
+		}
+#endif	/* USE_AVX2 */
+	}
+
+	void SIMDAVX::float_to_half_2(const float* source, const Uint32 count,
+		const Uint32 stride, Uint8* dest)
+	{
+#ifdef	USE_AVX2
+		__m128i tmp;
+		Uint32 i;
+
+		for (i = 0; i < count; ++i)
+		{
+			tmp = _mm_cvtps_ph(_mm_castpd_ps(_mm_load_sd(
+				(const double*)(source + i * 4))), 0);
+
+			_mm_store_ss((float*)(dest + i * stride),
+				_mm_castsi128_ps(tmp));
+		}
+#endif	/* USE_AVX2 */
+	}
+
+	void SIMDAVX::transform_4x3(const float* source, const Uint32 count,
+		const float* matrix, float* dest)
+	{
+#ifdef	USE_AVX2
+		__m128 m0, m1, m2, m3;
+		__m256 n0, n1, n2, n3;
+		Uint32 i;
+
+		m0 = _mm_setr_ps(matrix[0], matrix[1], matrix[2], 0.0f);
+		m1 = _mm_setr_ps(matrix[3], matrix[4], matrix[5], 0.0f);
+		m2 = _mm_setr_ps(matrix[6], matrix[7], matrix[8], 0.0f);
+		m3 = _mm_setr_ps(matrix[9], matrix[10], matrix[11], 1.0f);
+
+		n0 = get_lanes(m0);
+		n1 = get_lanes(m1);
+		n2 = get_lanes(m2);
+		n3 = get_lanes(m3);
+
+		i = 0;
+
+		if ((count > 0) && !get_aligned_32(dest))
+		{
+			_mm_stream_ps(dest, transform_value_4x3(_mm_load_ps(
+				source), m0, m1, m2, m3));
+			i++;
+		}
+
+		for (; (i + 1) < count; i += 2)
+		{
+			_mm256_stream_ps(dest + 4 * i, transform_value_4x3(
+				_mm256_loadu_ps(source + 4 * i), n0, n1, n2,
+				n3));
+		}
+
+		if (i < count)
+		{
+			_mm_stream_ps(dest + 4 * i, transform_value_4x3(
+				_mm_load_ps(source + 4 * i), m0, m1, m2, m3));
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+	}
+
+	void SIMDAVX::transform_3x3(const float* source, const Uint32 count,
+		const float* matrix, float* dest)
+	{
+#ifdef	USE_AVX2
+		__m128 m0, m1, m2, mask;
+		__m256 n0, n1, n2, n_mask;
+		Uint32 i;
+
+		m0 = _mm_setr_ps(matrix[0], matrix[1], matrix[2], 0.0f);
+		m1 = _mm_setr_ps(matrix[3], matrix[4], matrix[5], 0.0f);
+		m2 = _mm_setr_ps(matrix[6], matrix[7], matrix[8], 0.0f);
+		mask = _mm_castsi128_ps(_mm_setr_epi32(0x00000000,
+			0x00000000, 0x00000000, 0xFFFFFFFF));
+
+		n0 = get_lanes(m0);
+		n1 = get_lanes(m1);
+		n2 = get_lanes(m2);
+		n_mask = get_lanes(mask);
+
+		i = 0;
+
+		if ((count > 0) && !get_aligned_32(dest))
+		{
+			_mm_stream_ps(dest, transform_value_3x3(_mm_load_ps(
+				source), m0, m1, m2, mask));
+			i++;
+		}
+
+		for (; (i + 1) < count; i += 2)
+		{
+			_mm256_stream_ps(dest + 4 * i, transform_value_3x3(
+				_mm256_loadu_ps(source + 4 * i), n0, n1, n2,
+				n_mask));
+		}
+
+		if (i < count)
+		{
+			_mm_stream_ps(dest + 4 * i, transform_value_3x3(
+				_mm_load_ps(source + 4 * i), m0, m1, m2,
+				mask));
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+	}
+
+	void SIMDAVX::transform_scale_offset(const float* source,
+		const Uint32 count, const float* scale_offset, float* dest)
+	{
+#ifdef	USE_AVX2
+		__m128 scale, offset;
+		__m256 n_scale, n_offset;
+		Uint32 i;
+
+		scale = _mm_setr_ps(scale_offset[0], scale_offset[1], 1.0f,
+			1.0f);
+		offset = _mm_setr_ps(scale_offset[2], scale_offset[3], 0.0f,
+			0.0f);
+
+		n_scale = get_lanes(scale);
+		n_offset = get_lanes(offset);
+
+		i = 0;
+
+		if ((count > 0) && !get_aligned_32(dest))
+		{
+			_mm_stream_ps(dest, _mm_add_ps(_mm_mul_ps(
+				_mm_load_ps(source), scale), offset));
+			i++;
+		}
+
+		for (; (i + 1) < count; i += 2)
+		{
+			_mm256_stream_ps(dest + 4 * i, _mm256_add_ps(
+				_mm256_mul_ps(_mm256_loadu_ps(source + 4 * i),
+					n_scale), n_offset));
+		}
+
+		if (i < count)
+		{
+			_mm_stream_ps(dest + 4 * i, _mm_add_ps(_mm_mul_ps(
+				_mm_load_ps(source + 4 * i), scale), offset));
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+	}
+
+	void SIMDAVX::fill(const float* data, const Uint32 count, float* dest)
+	{
+#ifdef	USE_AVX2
+		__m128 tmp;
+		__m256 n_tmp;
+		Uint32 i;
+
+		tmp = _mm_loadu_ps(data);
+		n_tmp = get_lanes(tmp);
+
+		i = 0;
+
+		if ((count > 0) && !get_aligned_32(dest))
+		{
+			_mm_stream_ps(dest, tmp);
+			i++;
+		}
+
+		for (; (i + 1) < count; i += 2)
+		{
+			_mm256_stream_ps(dest + 4 * i, n_tmp);
+		}
+
+		if (i < count)
+		{
+			_mm_stream_ps(dest + 4 * i, tmp);
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+	}
+
+	void SIMDAVX::float_to_signed_short_8_scale(const float* source,
+		const Uint32 count, const float scale, Sint16* dest)
+	{
+#ifdef	USE_AVX2
+		__m128 s;
+		__m256 n_s;
+		__m256i t0, t1;
+		Uint32 i;
+
+		s = _mm_set1_ps(scale);
+		n_s = get_lanes(s);
+
+		i = 0;
+
+		if ((count > 0) && !get_aligned_32(dest))
+		{
+			_mm_stream_si128((__m128i*)dest, _mm_packs_epi32(
+				_mm_cvttps_epi32(_mm_mul_ps(_mm_load_ps(
+					source), s)),
+				_mm_cvttps_epi32(_mm_mul_ps(_mm_load_ps(
+					source + 4), s))));
+			i++;
+		}
+
+		for (; (i + 1) < count; i += 2)
+		{
+			t0 = _mm256_cvttps_epi32(_mm256_mul_ps(
+				_mm256_loadu_ps(source + i * 8 + 0), n_s));
+			t1 = _mm256_cvttps_epi32(_mm256_mul_ps(
+				_mm256_loadu_ps(source + i * 8 + 8), n_s));
+
+			/* packs works on each 128 bit lane */
+			t0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(t0,
+				t1), _MM_SHUFFLE(3, 1, 2, 0));
+
+			_mm256_stream_si256(((__m256i*)(dest + i * 8)), t0);
+		}
+
+		if (i < count)
+		{
+			_mm_stream_si128((__m128i*)(dest + i * 8),
+				_mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(
+					_mm_load_ps(source + i * 8), s)),
+				_mm_cvttps_epi32(_mm_mul_ps(_mm_load_ps(
+					source + i * 8 + 4), s))));
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+	}
+
+	bool SIMDAVX::check_coverage(const float* matrix,
+		const Sint16* min_max_boxes, const Uint32 count,
+		const float view_x, const float view_y, const float threshold)
+	{
+#ifdef	USE_AVX2
+		__m128 view, t;
+		Uint32 i;
+
+		/**
+		 * Scaled with four, see SIMD::check_coverage().
+		 */
+		t = _mm_set1_ps(threshold * 4.0f);
+		view = _mm_setr_ps(view_x, view_y, 1.0f, 1.0f);
+
+		for (i = 0; i < count; ++i)
+		{
+			if (_mm_comigt_ss(get_coverage(matrix,
+				min_max_boxes + i * 8, view), t) == 1)
+			{
+				_mm256_zeroupper();
+
+				return true;
+			}
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+		return false;
+	}
+
+	Uint64 SIMDAVX::check_coverage_simple(const float* matrix,
+		const Sint16* min_max_boxes, const Uint32 count,
+		const float view_x, const float view_y, const float threshold)
+	{
+		Uint64 result;
+
+		result = 0;
+
+#ifdef	USE_AVX2
+		__m128 view, t;
+		Uint32 i;
+
+		t = _mm_set1_ps(threshold * 4.0f);
+		view = _mm_setr_ps(view_x, view_y, 1.0f, 1.0f);
+
+		for (i = 0; i < count; ++i)
+		{
+			if (_mm_comigt_ss(get_coverage(matrix,
+				min_max_boxes + i * 8, view), t) == 1)
+			{
+				result |= static_cast<Uint64>(1) << i;
+			}
+		}
+
+		_mm256_zeroupper();
+#endif	/* USE_AVX2 */
+		return result;
+	}
+
+}
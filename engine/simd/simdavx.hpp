@@ -0,0 +1,110 @@
+/****************************************************************************
+ *            simdavx.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_9d3eea6c_6922_4358_82ab_e43f0e62f1ea
+#define	UUID_9d3eea6c_6922_4358_82ab_e43f0e62f1ea
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include <SDL_stdinc.h>
+
+/**
+ * @file
+ * @brief The @c class SIMDAVX.
+ * This file contains the @c class SIMDAVX.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief AVX, AVX2 and F16C versions of the SIMD functions.
+	 *
+	 * The source file is compiled with AVX2 and F16C enabled, so
+	 * these functions must only be called by SIMD after the cpu is
+	 * checked. Only plain types are used here, because inline
+	 * functions of other headers compiled with AVX could end up in
+	 * code run on cpus without AVX. The parameters are the same as
+	 * for the SIMD functions with the same names, matrices are
+	 * column major float arrays.
+	 */
+	class SIMDAVX
+	{
+		public:
+			/**
+			 * Uses F16C.
+			 */
+			static void float_to_half_4(const float* source,
+				const Uint32 count, const Uint32 stride,
+				Uint8* dest);
+
+			/**
+			 * Uses F16C.
+			 */
+			static void float_to_half_2(const float* source,
+				const Uint32 count, const Uint32 stride,
+				Uint8* dest);
+
+			/**
+			 * Uses AVX, matrix is a 4x3 matrix.
+			 */
+			static void transform_4x3(const float* source,
+				const Uint32 count, const float* matrix,
+				float* dest);
+
+			/**
+			 * Uses AVX, matrix is a 3x3 matrix.
+			 */
+			static void transform_3x3(const float* source,
+				const Uint32 count, const float* matrix,
+				float* dest);
+
+			/**
+			 * Uses AVX, scale_offset are four floats.
+			 */
+			static void transform_scale_offset(const float* source,
+				const Uint32 count, const float* scale_offset,
+				float* dest);
+
+			/**
+			 * Uses AVX, data are four floats.
+			 */
+			static void fill(const float* data, const Uint32 count,
+				float* dest);
+
+			/**
+			 * Uses AVX2.
+			 */
+			static void float_to_signed_short_8_scale(
+				const float* source, const Uint32 count,
+				const float scale, Sint16* dest);
+
+			/**
+			 * Uses AVX, projects the eight corners of a box at
+			 * once.
+			 */
+			static bool check_coverage(const float* matrix,
+				const Sint16* min_max_boxes, const Uint32 count,
+				const float view_x, const float view_y,
+				const float threshold);
+
+			/**
+			 * Uses AVX, bit i of the result is set if box i
+			 * covers more samples than the threshold.
+			 */
+			static Uint64 check_coverage_simple(
+				const float* matrix,
+				const Sint16* min_max_boxes,
+				const Uint32 count, const float view_x,
+				const float view_y, const float threshold);
+
+	};
+
+}
+
+#endif	/* UUID_9d3eea6c_6922_4358_82ab_e43f0e62f1ea */
@@ -0,0 +1,520 @@
+/****************************************************************************
+ *            staticrstartree.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "staticrstartree.hpp"
+#include "abstractboundedobjectvisitor.hpp"
+#include "boundedobject.hpp"
+#include "frustum.hpp"
+#include "rstartreesubtree.hpp"
+#ifdef	__SSE__
+#include <xmmintrin.h>
+#endif	/* __SSE__ */
+
+namespace eternal_lands
+{
+
+	namespace
+	{
+
+		const Uint32 node_size = 8;
+		const Uint32 invalid_index = 0xFFFFFFFF;
+
+		class Entry
+		{
+			public:
+				glm::vec3 m_min;
+				glm::vec3 m_max;
+				glm::vec3 m_center;
+				Uint32 m_index;
+
+				inline Entry(const glm::vec3 &min,
+					const glm::vec3 &max, const Uint32 index):
+					m_min(min), m_max(max),
+					m_center((min + max) * 0.5f), m_index(index)
+				{
+				}
+
+		};
+
+		typedef std::vector<Entry> EntryVector;
+
+		class EntryCompare
+		{
+			private:
+				const Uint16 m_axis;
+
+			public:
+				inline EntryCompare(const Uint16 axis): m_axis(axis)
+				{
+				}
+
+				inline bool operator()(const Entry &entry0,
+					const Entry &entry1) const
+				{
+					return entry0.m_center[m_axis] <
+						entry1.m_center[m_axis];
+				}
+
+		};
+
+		/**
+		 * Sort-Tile-Recursive order. The entries are sorted along x
+		 * and cut into vertical slabs, each slab is sorted along y, so
+		 * every run of node_size entries forms a tile. Map objects
+		 * are spread over x and y, but hardly along z, so z is not
+		 * used.
+		 */
+		void sort_tile(EntryVector &entries)
+		{
+			EntryVector::iterator begin, end;
+			Uint32 leafs, slabs, slab_size, i, count;
+
+			count = entries.size();
+			leafs = (count + node_size - 1) / node_size;
+			slabs = static_cast<Uint32>(std::ceil(std::sqrt(
+				static_cast<float>(leafs))));
+			slab_size = slabs * node_size;
+
+			std::sort(entries.begin(), entries.end(), EntryCompare(0));
+
+			for (i = 0; i < count; i += slab_size)
+			{
+				begin = entries.begin() + i;
+				end = entries.begin() + std::min(i + slab_size,
+					count);
+
+				std::sort(begin, end, EntryCompare(1));
+			}
+		}
+
+	}
+
+	StaticRStarTree::StaticRStarTree(): m_root(invalid_index),
+		m_leaf_count(0)
+	{
+	}
+
+	StaticRStarTree::~StaticRStarTree() noexcept
+	{
+	}
+
+	void StaticRStarTree::clear()
+	{
+		m_center_x.clear();
+		m_center_y.clear();
+		m_center_z.clear();
+		m_half_size_x.clear();
+		m_half_size_y.clear();
+		m_half_size_z.clear();
+		m_indices.clear();
+		m_counts.clear();
+		m_objects.clear();
+		m_bounding_box.set_empty();
+		m_root = invalid_index;
+		m_leaf_count = 0;
+	}
+
+	void StaticRStarTree::build(const BoundedObjectSharedPtrVector &objects)
+	{
+		EntryVector entries, nodes;
+		glm::vec3 min, max, center, half_size;
+		Uint32 i, j, count, node_count, index;
+
+		clear();
+
+		if (objects.empty())
+		{
+			return;
+		}
+
+		m_objects = objects;
+
+		count = objects.size();
+
+		entries.reserve(count);
+
+		for (i = 0; i < count; ++i)
+		{
+			entries.push_back(Entry(
+				objects[i]->get_bounding_box().get_min(),
+				objects[i]->get_bounding_box().get_max(), i));
+		}
+
+		node_count = 0;
+		index = (count + node_size - 1) / node_size;
+
+		while (index > 1)
+		{
+			node_count += index;
+			index = (index + node_size - 1) / node_size;
+		}
+
+		node_count += 1;
+
+		m_center_x.reserve(node_count * node_size);
+		m_center_y.reserve(node_count * node_size);
+		m_center_z.reserve(node_count * node_size);
+		m_half_size_x.reserve(node_count * node_size);
+		m_half_size_y.reserve(node_count * node_size);
+		m_half_size_z.reserve(node_count * node_size);
+		m_indices.reserve(node_count * node_size);
+		m_counts.reserve(node_count);
+
+		/**
+		 * Builds the tree bottom up, one level after the other, so
+		 * the leafs get the lowest indices and the root the highest.
+		 */
+		do
+		{
+			sort_tile(entries);
+
+			nodes.clear();
+
+			count = entries.size();
+
+			for (i = 0; i < count; i += node_size)
+			{
+				index = m_counts.size();
+				min = entries[i].m_min;
+				max = entries[i].m_max;
+
+				for (j = 0; j < node_size; ++j)
+				{
+					if ((i + j) >= count)
+					{
+						/**
+						 * Padding, always outside of any
+						 * frustum.
+						 */
+						m_center_x.push_back(0.0f);
+						m_center_y.push_back(0.0f);
+						m_center_z.push_back(0.0f);
+						m_half_size_x.push_back(-1e30f);
+						m_half_size_y.push_back(-1e30f);
+						m_half_size_z.push_back(-1e30f);
+						m_indices.push_back(invalid_index);
+
+						continue;
+					}
+
+					center = entries[i + j].m_center;
+					half_size = (entries[i + j].m_max -
+						entries[i + j].m_min) * 0.5f;
+
+					m_center_x.push_back(center.x);
+					m_center_y.push_back(center.y);
+					m_center_z.push_back(center.z);
+					m_half_size_x.push_back(half_size.x);
+					m_half_size_y.push_back(half_size.y);
+					m_half_size_z.push_back(half_size.z);
+					m_indices.push_back(entries[i + j].m_index);
+
+					min = glm::min(min, entries[i + j].m_min);
+					max = glm::max(max, entries[i + j].m_max);
+				}
+
+				m_counts.push_back(std::min(node_size, count - i));
+
+				nodes.push_back(Entry(min, max, index));
+			}
+
+			if (m_leaf_count == 0)
+			{
+				m_leaf_count = m_counts.size();
+			}
+
+			entries.swap(nodes);
+		}
+		while (entries.size() > 1);
+
+		m_root = entries[0].m_index;
+		m_bounding_box = BoundingBox(entries[0].m_min,
+			entries[0].m_max);
+	}
+
+	bool StaticRStarTree::remove(const BoundedObjectSharedPtr &object)
+	{
+		BoundedObjectSharedPtrVector::iterator found;
+
+		found = std::find(m_objects.begin(), m_objects.end(), object);
+
+		if (found == m_objects.end())
+		{
+			return false;
+		}
+
+		found->reset();
+
+		return true;
+	}
+
+	void StaticRStarTree::intersect_children(const Frustum &frustum,
+		const Uint32 index, const BitSet64 in_mask, Uint32 &outside,
+		Uint32Array8 &planes) const
+	{
+#ifdef	__SSE__
+		__m128 n_x, n_y, n_z, n_w, a_x, a_y, a_z, dist, size;
+		Uint32 offset;
+#else	/* __SSE__ */
+		float dist, size;
+#endif	/* __SSE__ */
+		glm::vec4 data;
+		Uint32 i, j, count, all;
+
+		count = frustum.get_plane_count();
+		all = (1 << node_size) - 1;
+		outside = 0;
+
+		assert(count <= planes.size());
+
+		planes.assign(0);
+
+		for (i = 0; i < count; ++i)
+		{
+			if (!in_mask[i])
+			{
+				continue;
+			}
+
+			data = frustum.get_plane(i).get_data();
+
+#ifdef	__SSE__
+			n_x = _mm_set1_ps(data.x);
+			n_y = _mm_set1_ps(data.y);
+			n_z = _mm_set1_ps(data.z);
+			n_w = _mm_set1_ps(data.w);
+			a_x = _mm_set1_ps(std::abs(data.x));
+			a_y = _mm_set1_ps(std::abs(data.y));
+			a_z = _mm_set1_ps(std::abs(data.z));
+
+			for (j = 0; j < node_size; j += 4)
+			{
+				offset = index * node_size + j;
+
+				dist = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(n_x, _mm_loadu_ps(
+						&m_center_x[offset])),
+					_mm_mul_ps(n_y, _mm_loadu_ps(
+						&m_center_y[offset]))),
+					_mm_add_ps(_mm_mul_ps(n_z, _mm_loadu_ps(
+						&m_center_z[offset])), n_w));
+				size = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(a_x, _mm_loadu_ps(
+						&m_half_size_x[offset])),
+					_mm_mul_ps(a_y, _mm_loadu_ps(
+						&m_half_size_y[offset]))),
+					_mm_mul_ps(a_z, _mm_loadu_ps(
+						&m_half_size_z[offset])));
+
+				outside |= _mm_movemask_ps(_mm_cmplt_ps(dist,
+					_mm_sub_ps(_mm_setzero_ps(), size))) << j;
+				planes[i] |= _mm_movemask_ps(_mm_cmple_ps(dist,
+					size)) << j;
+			}
+#else	/* __SSE__ */
+			for (j = 0; j < node_size; ++j)
+			{
+				dist = data.x * m_center_x[index * node_size + j] +
+					data.y * m_center_y[index * node_size + j] +
+					data.z * m_center_z[index * node_size + j] +
+					data.w;
+				size = std::abs(data.x) *
+					m_half_size_x[index * node_size + j] +
+					std::abs(data.y) *
+					m_half_size_y[index * node_size + j] +
+					std::abs(data.z) *
+					m_half_size_z[index * node_size + j];
+
+				if (dist < -size)
+				{
+					outside |= 1 << j;
+				}
+
+				if (dist <= size)
+				{
+					planes[i] |= 1 << j;
+				}
+			}
+#endif	/* __SSE__ */
+
+			if (outside == all)
+			{
+				return;
+			}
+		}
+	}
+
+	void StaticRStarTree::view_node(const Uint32 index,
+		AbstractBoundedObjectVisitor &visitor) const
+	{
+		Uint32 i, child;
+
+		for (i = 0; i < m_counts[index]; ++i)
+		{
+			child = m_indices[index * node_size + i];
+
+			if (!get_leaf(index))
+			{
+				view_node(child, visitor);
+
+				continue;
+			}
+
+			if (m_objects[child].get() != nullptr)
+			{
+				visitor(m_objects[child]);
+			}
+		}
+	}
+
+	void StaticRStarTree::intersect_tree(const Frustum &frustum,
+		const Uint32 index, const BitSet64 mask,
+		AbstractBoundedObjectVisitor &visitor) const
+	{
+		Uint32Array8 planes;
+		BitSet64 out_mask;
+		Uint32 i, j, child, outside;
+
+		intersect_children(frustum, index, mask, outside, planes);
+
+		for (i = 0; i < m_counts[index]; ++i)
+		{
+			if ((outside & (1 << i)) != 0)
+			{
+				continue;
+			}
+
+			child = m_indices[index * node_size + i];
+
+			if (get_leaf(index))
+			{
+				if (m_objects[child].get() != nullptr)
+				{
+					visitor(m_objects[child]);
+				}
+
+				continue;
+			}
+
+			out_mask.reset();
+
+			for (j = 0; j < planes.size(); ++j)
+			{
+				out_mask[j] = mask[j] && ((planes[j] &
+					(1 << i)) != 0);
+			}
+
+			if (out_mask.none())
+			{
+				view_node(child, visitor);
+			}
+			else
+			{
+				intersect_tree(frustum, child, out_mask,
+					visitor);
+			}
+		}
+	}
+
+	void StaticRStarTree::intersect_tree(const Frustum &frustum,
+		const Uint32 index, const BitSet64 mask, const Uint16 depth,
+		AbstractBoundedObjectVisitor &visitor,
+		RStarTreeSubTreeVector &sub_trees) const
+	{
+		Uint32Array8 planes;
+		BitSet64 out_mask;
+		Uint32 i, j, child, outside;
+
+		if (get_leaf(index))
+		{
+			intersect_tree(frustum, index, mask, visitor);
+
+			return;
+		}
+
+		if (depth == 0)
+		{
+			sub_trees.push_back(RStarTreeSubTree(this, index, mask,
+				false));
+
+			return;
+		}
+
+		intersect_children(frustum, index, mask, outside, planes);
+
+		for (i = 0; i < m_counts[index]; ++i)
+		{
+			if ((outside & (1 << i)) != 0)
+			{
+				continue;
+			}
+
+			child = m_indices[index * node_size + i];
+
+			out_mask.reset();
+
+			for (j = 0; j < planes.size(); ++j)
+			{
+				out_mask[j] = mask[j] && ((planes[j] &
+					(1 << i)) != 0);
+			}
+
+			if (out_mask.none())
+			{
+				sub_trees.push_back(RStarTreeSubTree(this,
+					child, out_mask, true));
+			}
+			else
+			{
+				intersect_tree(frustum, child, out_mask,
+					depth - 1, visitor, sub_trees);
+			}
+		}
+	}
+
+	void StaticRStarTree::intersect(const Frustum &frustum,
+		AbstractBoundedObjectVisitor &visitor) const
+	{
+		if (get_empty())
+		{
+			return;
+		}
+
+		intersect_tree(frustum, m_root, frustum.get_planes_mask(),
+			visitor);
+	}
+
+	void StaticRStarTree::intersect(const Frustum &frustum,
+		const Uint16 depth, AbstractBoundedObjectVisitor &visitor,
+		RStarTreeSubTreeVector &sub_trees) const
+	{
+		if (get_empty())
+		{
+			return;
+		}
+
+		intersect_tree(frustum, m_root, frustum.get_planes_mask(),
+			depth, visitor, sub_trees);
+	}
+
+	Uint32 StaticRStarTree::get_memory_usage() const noexcept
+	{
+		return sizeof(StaticRStarTree) + (m_center_x.capacity() +
+			m_center_y.capacity() + m_center_z.capacity() +
+			m_half_size_x.capacity() + m_half_size_y.capacity() +
+			m_half_size_z.capacity()) * sizeof(float) +
+			(m_indices.capacity() + m_counts.capacity()) *
+			sizeof(Uint32) + m_objects.capacity() *
+			sizeof(BoundedObjectSharedPtr);
+	}
+
+	Uint32 StaticRStarTree::get_max_elements_per_node() noexcept
+	{
+		return node_size;
+	}
+
+}
@@ -0,0 +1,216 @@
+/****************************************************************************
+ *            staticrstartree.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_5192b8ae_48d7_4d38_8e7b_7805de8a6108
+#define	UUID_5192b8ae_48d7_4d38_8e7b_7805de8a6108
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include "boundingbox.hpp"
+
+/**
+ * @file
+ * @brief The @c class StaticRStarTree.
+ * This file contains the @c class StaticRStarTree.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief Immutable r-tree for objects that never move.
+	 *
+	 * The tree is build at once from all objects using the
+	 * Sort-Tile-Recursive bulk loader. All nodes are stored in flat
+	 * arrays, the bounding boxes of the children of a node are stored
+	 * as structure of arrays, so that the frustum test can check four
+	 * children at once with SSE. Objects can't be added, removed
+	 * objects are only skipped until the tree is build again. Use the
+	 * RStarTree for objects that move.
+	 */
+	class StaticRStarTree: public boost::noncopyable
+	{
+		friend class RStarTreeSubTree;
+		private:
+			FloatVector m_center_x;
+			FloatVector m_center_y;
+			FloatVector m_center_z;
+			FloatVector m_half_size_x;
+			FloatVector m_half_size_y;
+			FloatVector m_half_size_z;
+
+			/**
+			 * Index of the child node for inner nodes, index of
+			 * the object for leafs.
+			 */
+			Uint32Vector m_indices;
+			Uint32Vector m_counts;
+			BoundedObjectSharedPtrVector m_objects;
+			BoundingBox m_bounding_box;
+			Uint32 m_root;
+
+			/**
+			 * The leafs are build first, so all nodes with an
+			 * index below are leafs.
+			 */
+			Uint32 m_leaf_count;
+
+			/**
+			 * Tests all children of the node against the frustum.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param index The index of the node.
+			 * @param in_mask The planes to test.
+			 * @param outside Bit mask of the children outside of
+			 * the frustum.
+			 * @param planes For each plane a bit mask of the
+			 * children intersecting it.
+			 */
+			void intersect_children(const Frustum &frustum,
+				const Uint32 index, const BitSet64 in_mask,
+				Uint32 &outside, Uint32Array8 &planes) const;
+			void intersect_tree(const Frustum &frustum,
+				const Uint32 index, const BitSet64 mask,
+				AbstractBoundedObjectVisitor &visitor) const;
+			void intersect_tree(const Frustum &frustum,
+				const Uint32 index, const BitSet64 mask,
+				const Uint16 depth,
+				AbstractBoundedObjectVisitor &visitor,
+				RStarTreeSubTreeVector &sub_trees) const;
+			void view_node(const Uint32 index,
+				AbstractBoundedObjectVisitor &visitor) const;
+
+			inline bool get_leaf(const Uint32 index) const noexcept
+			{
+				return index < m_leaf_count;
+			}
+
+		public:
+			/**
+			 * @brief Default constructor.
+			 *
+			 * Default constructor.
+			 */
+			StaticRStarTree();
+
+			/**
+			 * @brief Default destructor.
+			 *
+			 * Default destructor.
+			 */
+			~StaticRStarTree() noexcept;
+
+			/**
+			 * @brief Builds the tree.
+			 *
+			 * Builds the tree from the objects using the
+			 * Sort-Tile-Recursive algorithm. The old content of
+			 * the tree is removed.
+			 * @param objects The objects of the tree.
+			 */
+			void build(const BoundedObjectSharedPtrVector &objects);
+
+			/**
+			 * @brief Removes an object.
+			 *
+			 * Removes the object from the tree. The bounding
+			 * boxes of the nodes are not changed.
+			 * @param object The object to remove.
+			 * @return True if the object was in the tree.
+			 */
+			bool remove(const BoundedObjectSharedPtr &object);
+
+			/**
+			 * @brief Tests all elements of the tree for
+			 * intersection.
+			 *
+			 * Test the frustum for intersection with all elements
+			 * in the tree.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param visitor The visitor that gets the
+			 * intersecting items.
+			 */
+			void intersect(const Frustum &frustum,
+				AbstractBoundedObjectVisitor &visitor) const;
+
+			/**
+			 * @brief Tests the elements of the tree for
+			 * intersection down to the given depth.
+			 *
+			 * Same as RStarTree::intersect() with a depth.
+			 * @param frustum The frustum used for the intersection
+			 * test.
+			 * @param depth The depth where the tree is split.
+			 * @param visitor The visitor that gets the
+			 * intersecting items of leafs above the depth.
+			 * @param sub_trees The sub trees still to intersect.
+			 */
+			void intersect(const Frustum &frustum,
+				const Uint16 depth,
+				AbstractBoundedObjectVisitor &visitor,
+				RStarTreeSubTreeVector &sub_trees) const;
+
+			/**
+			 * @brief Clears the tree.
+			 *
+			 * Clears the tree and removes all nodes and objects.
+			 */
+			void clear();
+
+			/**
+			 * @brief Memory usage.
+			 *
+			 * Returns the memory usage of the tree.
+			 * @return The memory usage.
+			 */
+			Uint32 get_memory_usage() const noexcept;
+
+			/**
+			 * @brief Returns the maximun of elements per node.
+			 *
+			 * Returns the maximun of elements per node.
+			 * @return The maximun of elements per node.
+			 */
+			static Uint32 get_max_elements_per_node() noexcept;
+
+			/**
+			 * @brief Axis aligned bounding box of the tree.
+			 *
+			 * The axis aligned bounding box of the tree that
+			 * encloses all items of the tree.
+			 * @return The axis aligned bounding box of the tree.
+			 */
+			inline const BoundingBox &get_bounding_box() const
+				noexcept
+			{
+				return m_bounding_box;
+			}
+
+			inline bool get_empty() const noexcept
+			{
+				return m_counts.empty();
+			}
+
+			inline Uint32 get_nodes_count() const noexcept
+			{
+				return m_counts.size();
+			}
+
+			inline const BoundedObjectSharedPtrVector &get_objects()
+				const noexcept
+			{
+				return m_objects;
+			}
+
+	};
+
+}
+
+#endif	/* UUID_5192b8ae_48d7_4d38_8e7b_7805de8a6108 */
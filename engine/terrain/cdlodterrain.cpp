@@ -193,7 +193,7 @@ namespace eternal_lands
 	void CdLodTerrain::do_update_geometry_maps(
 		const ImageConstSharedPtr &displacement_map,
 		const ImageConstSharedPtr &normal_tangent_map,
-		const ImageConstSharedPtr &dudv_map)
+		const ImageConstSharedPtr &dudv_map, const glm::uvec4 &rect)
 	{
 		glm::vec3 min, max;
 		float patch_scale;
@@ -217,9 +217,9 @@ namespace eternal_lands
 
 		set_bounding_box(BoundingBox(min, max));
 
-		m_displacement_texture->update_image(displacement_map);
-		m_normal_texture->update_image(normal_tangent_map);
-		m_dudv_texture->update_image(dudv_map);
+		update_texture(m_displacement_texture, displacement_map, rect);
+		update_texture(m_normal_texture, normal_tangent_map, rect);
+		update_texture(m_dudv_texture, dudv_map, rect);
 	}
 
 	void CdLodTerrain::clear()
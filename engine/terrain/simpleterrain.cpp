@@ -467,9 +467,9 @@ namespace eternal_lands
 	void SimpleTerrain::do_update_geometry_maps(
 		const ImageConstSharedPtr &displacement_map,
 		const ImageConstSharedPtr &normal_tangent_map,
-		const ImageConstSharedPtr &dudv_map)
+		const ImageConstSharedPtr &dudv_map, const glm::uvec4 &rect)
 	{
-		
+
 		ImageConstSharedPtr displacement_map_tmp;
 		ImageConstSharedPtr normal_tangent_map_tmp, dudv_map_tmp;
 		Uint32 x, y, height, width;
@@ -53,7 +53,8 @@ namespace eternal_lands
 			virtual void do_update_geometry_maps(
 				const ImageConstSharedPtr &displacement_map,
 				const ImageConstSharedPtr &normal_tangent_map,
-				const ImageConstSharedPtr &dudv_map) override;
+				const ImageConstSharedPtr &dudv_map,
+				const glm::uvec4 &rect) override;
 
 		protected:
 			void add_terrain_page(
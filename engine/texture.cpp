@@ -2318,6 +2318,43 @@ namespace eternal_lands
         m_texture_id = 0;
     }
 
+    void Texture::swap(Texture &texture) noexcept
+    {
+        Uint32 width, height;
+        Uint16 samples;
+        TextureFormatType format;
+
+        width = get_width();
+        height = get_height();
+        samples = get_samples();
+        format = get_format();
+
+        set_width(texture.get_width());
+        set_height(texture.get_height());
+        set_samples(texture.get_samples());
+        set_format(texture.get_format());
+
+        texture.set_width(width);
+        texture.set_height(height);
+        texture.set_samples(samples);
+        texture.set_format(format);
+
+        std::swap(m_anisotropic_filter, texture.m_anisotropic_filter);
+        std::swap(m_texture_id, texture.m_texture_id);
+        std::swap(m_depth, texture.m_depth);
+        std::swap(m_size, texture.m_size);
+        std::swap(m_target, texture.m_target);
+        std::swap(m_mag_filter, texture.m_mag_filter);
+        std::swap(m_min_filter, texture.m_min_filter);
+        std::swap(m_mipmap_filter, texture.m_mipmap_filter);
+        std::swap(m_wrap_s, texture.m_wrap_s);
+        std::swap(m_wrap_t, texture.m_wrap_t);
+        std::swap(m_wrap_r, texture.m_wrap_r);
+        std::swap(m_mipmap_count, texture.m_mipmap_count);
+        std::swap(m_used_mipmap_count, texture.m_used_mipmap_count);
+        std::swap(m_rebuild, texture.m_rebuild);
+    }
+
     String Texture::get_str(const TextureFilterType value)
     {
         switch (value)
@@ -243,6 +243,17 @@ namespace eternal_lands
 				const TextureTargetType target);
 			~Texture() noexcept;
 			void unload() noexcept;
+
+			/**
+			 * @brief Swaps the contents of the textures.
+			 *
+			 * Swaps the OpenGL texture and all parameters, only
+			 * the names are kept. Used to replace a texture
+			 * with a new one without changing the objects that
+			 * use it.
+			 * @param texture The texture to swap with.
+			 */
+			void swap(Texture &texture) noexcept;
 			static String get_str(const TextureFilterType value);
 			static String get_str(const TextureMipmapType value);
 			static String get_str(const TextureWrapType value);
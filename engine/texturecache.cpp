@@ -15,6 +15,9 @@
 #include "xmlreader.hpp"
 #include "xmlutil.hpp"
 #include "globalvars.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/atomicutil.hpp"
+#include "thread/threadpool.hpp"
 
 namespace eternal_lands
 {
@@ -125,12 +128,10 @@ namespace eternal_lands
             }
         }
 
-        TextureSharedPtr build_error_texture(const bool rectangle)
-            noexcept
+        ImageSharedPtr build_error_image() noexcept
         {
             glm::uvec3 size;
             ImageSharedPtr image;
-            TextureSharedPtr texture;
 
             size[0] = image_width;
             size[1] = image_height;
@@ -141,6 +142,14 @@ namespace eternal_lands
 
             rle_decode(rle_pixel_data, image->get_buffer());
 
+            return image;
+        }
+
+        TextureSharedPtr build_error_texture(const ImageSharedPtr &image,
+            const bool rectangle) noexcept
+        {
+            TextureSharedPtr texture;
+
             texture = boost::make_shared<Texture>(String(UTF8(
                 "error")), image_width, image_height, 0,
                 0xFFFF, 0, image->get_texture_format(),
@@ -152,6 +161,126 @@ namespace eternal_lands
             return texture;
         }
 
+        /**
+         * Reading from the archives is mostly waiting for the disk, two
+         * threads keep the decoding busy without taking the cpu away
+         * from the culling tasks.
+         */
+        const Uint16 texture_loader_threads = 2;
+
+    }
+
+    /**
+     * Image of a texture that is read and decoded by a loader thread.
+     * The render thread only reads the image after get_done() returns
+     * true.
+     */
+    class TextureCache::TextureLoadRequest: public boost::noncopyable
+    {
+        private:
+            const FileSystemConstSharedPtr m_file_system;
+            const ImageCompressionTypeSet m_compressions;
+            const String m_name;
+            ImageSharedPtr m_image;
+            volatile Sint32 m_done;
+            const bool m_rg_formats;
+            const bool m_sRGB;
+            const bool m_rectangle;
+
+        public:
+            TextureLoadRequest(
+                const FileSystemConstSharedPtr &file_system,
+                const ImageCompressionTypeSet &compressions,
+                const String &name, const bool rg_formats,
+                const bool sRGB, const bool rectangle);
+            ~TextureLoadRequest() noexcept;
+            void load();
+
+            inline bool get_done() const
+            {
+                return AtomicUtil::load(&m_done) != 0;
+            }
+
+            inline const ImageSharedPtr &get_image() const noexcept
+            {
+                return m_image;
+            }
+
+            inline bool get_rectangle() const noexcept
+            {
+                return m_rectangle;
+            }
+
+    };
+
+    TextureCache::TextureLoadRequest::TextureLoadRequest(
+        const FileSystemConstSharedPtr &file_system,
+        const ImageCompressionTypeSet &compressions, const String &name,
+        const bool rg_formats, const bool sRGB, const bool rectangle):
+        m_file_system(file_system), m_compressions(compressions),
+        m_name(name), m_done(0), m_rg_formats(rg_formats),
+        m_sRGB(sRGB), m_rectangle(rectangle)
+    {
+    }
+
+    TextureCache::TextureLoadRequest::~TextureLoadRequest() noexcept
+    {
+    }
+
+    void TextureCache::TextureLoadRequest::load()
+    {
+        ReaderSharedPtr reader;
+
+        try
+        {
+            reader = m_file_system->get_file(m_name);
+
+            m_image = CodecManager::load_image(reader, m_compressions,
+                m_rg_formats, m_sRGB, false);
+        }
+        catch (const boost::exception &exception)
+        {
+            LOG_EXCEPTION(exception);
+        }
+        catch (const std::exception &exception)
+        {
+            LOG_EXCEPTION(exception);
+        }
+
+        /* The image must be complete before the render thread sees it */
+        AtomicUtil::increment(&m_done);
+    }
+
+    class TextureCache::TextureLoadTask: public AbstractThreadTask
+    {
+        private:
+            const TextureLoadRequestSharedPtr m_request;
+
+        public:
+            TextureLoadTask(const TextureLoadRequestSharedPtr &request);
+            virtual ~TextureLoadTask() noexcept;
+            virtual void operator()();
+
+    };
+
+    TextureCache::TextureLoadTask::TextureLoadTask(
+        const TextureLoadRequestSharedPtr &request): m_request(request)
+    {
+    }
+
+    TextureCache::TextureLoadTask::~TextureLoadTask() noexcept
+    {
+    }
+
+    void TextureCache::TextureLoadTask::operator()()
+    {
+        /* Nobody waits for the texture any more */
+        if (m_request.unique())
+        {
+            return;
+        }
+
+        m_request->load();
     }
 
     TextureCache::TextureCache(const GlobalVarsConstSharedPtr &global_vars,
@@ -160,10 +289,41 @@ namespace eternal_lands
     {
         assert(m_global_vars.get() != nullptr);
         assert(m_file_system.get() != nullptr);
+
+        m_thread_pool.reset(new ThreadPool(texture_loader_threads));
     }
 
     TextureCache::~TextureCache() noexcept
     {
+        /**
+         * The loader threads skip the requests that are only used by
+         * them, so the thread pool is not kept busy with textures
+         * nobody waits for.
+         */
+        m_pending_textures.clear();
+        m_thread_pool.reset();
+    }
+
+    bool TextureCache::TextureCacheTraits::get_unused(
+        const TextureSharedPtr &texture) noexcept
+    {
+        return texture.unique();
+    }
+
+    Uint64 TextureCache::TextureCacheTraits::get_memory_usage(
+        const TextureSharedPtr &texture) noexcept
+    {
+        return texture->get_size();
+    }
+
+    const ImageSharedPtr &TextureCache::get_error_image()
+    {
+        if (m_error_image.get() == nullptr)
+        {
+            m_error_image = build_error_image();
+        }
+
+        return m_error_image;
     }
 
     const TextureSharedPtr &TextureCache::get_error_texture(
@@ -173,8 +333,8 @@ namespace eternal_lands
         {
             if (m_error_texture_rectangle.get() == nullptr)
             {
-                m_error_texture_rectangle =
-                    build_error_texture(true);
+                m_error_texture_rectangle = build_error_texture(
+                    get_error_image(), true);
             }
 
             return m_error_texture_rectangle;
@@ -182,21 +342,16 @@ namespace eternal_lands
 
         if (m_error_texture.get() == nullptr)
         {
-            m_error_texture = build_error_texture(false);
+            m_error_texture = build_error_texture(get_error_image(),
+                false);
         }
 
         return m_error_texture;
     }
 
-    TextureSharedPtr TextureCache::do_load_texture(const String &name,
-        const String &index, const bool sRGB, const bool rectangle,
-        const bool merge_layers) const
+    void TextureCache::get_compressions(
+        ImageCompressionTypeSet &compressions, bool &rg_formats) const
     {
-        ImageSharedPtr image;
-        ReaderSharedPtr reader;
-        ImageCompressionTypeSet compressions;
-        bool rg_formats;
-
         if (GLEW_EXT_texture_compression_s3tc)
         {
             compressions.insert(ict_s3tc);
@@ -209,6 +364,18 @@ namespace eternal_lands
             compressions.insert(ict_rgtc);
             rg_formats = true;
         }
+    }
+
+    TextureSharedPtr TextureCache::do_load_texture(const String &name,
+        const String &index, const bool sRGB, const bool rectangle,
+        const bool merge_layers) const
+    {
+        ImageSharedPtr image;
+        ReaderSharedPtr reader;
+        ImageCompressionTypeSet compressions;
+        bool rg_formats;
+
+        get_compressions(compressions, rg_formats);
 
         reader = get_file_system()->get_file(name);
 
@@ -266,27 +433,109 @@ namespace eternal_lands
         return get_error_texture(rectangle);
     }
 
-    const TextureSharedPtr &TextureCache::get_texture(const String &name,
+    TextureSharedPtr TextureCache::get_texture(const String &name,
         const bool sRGB, const bool rectangle)
     {
         TextureSharedPtr texture;
-        TextureCacheMap::iterator found;
         String index;
 
         index = FileSystem::get_name_without_extension(name);
 
-        found = m_texture_cache.find(index);
-
-        if (found != m_texture_cache.end())
+        if (m_texture_cache.find(index, texture))
         {
-            return found->second;
+            return texture;
         }
 
         texture = load_texture(name, index, sRGB, rectangle, false);
 
-        m_texture_cache[index] = texture;
+        m_texture_cache.add(index, texture);
+
+        return texture;
+    }
+
+    TextureSharedPtr TextureCache::get_streamed_texture(const String &name,
+        const bool sRGB, const bool rectangle)
+    {
+        TextureSharedPtr texture;
+        TextureLoadRequestSharedPtr request;
+        std::auto_ptr<AbstractThreadTask> task;
+        ImageCompressionTypeSet compressions;
+        String index;
+        bool rg_formats;
+
+        if (!get_global_vars()->get_use_texture_streaming())
+        {
+            return get_texture(name, sRGB, rectangle);
+        }
+
+        index = FileSystem::get_name_without_extension(name);
+
+        if (m_texture_cache.find(index, texture))
+        {
+            return texture;
+        }
+
+        texture = do_load_texture(get_error_image(), index, rectangle);
+
+        get_compressions(compressions, rg_formats);
+
+        request = boost::make_shared<TextureLoadRequest>(
+            get_file_system(), compressions, name, rg_formats, sRGB,
+            rectangle);
+
+        m_pending_textures.push_back(PendingTexture(request, texture));
+        m_texture_cache.add(index, texture);
+
+        task.reset(new TextureLoadTask(request));
 
-        return m_texture_cache[index];
+        m_thread_pool->add(task);
+
+        return texture;
+    }
+
+    void TextureCache::upload_textures()
+    {
+        ImageSharedPtr image;
+        TextureSharedPtr texture;
+        Uint64 size, budget;
+        Uint32 i, count, used;
+
+        budget = static_cast<Uint64>(
+            get_global_vars()->get_texture_upload_budget()) * 1024;
+        size = 0;
+        used = 0;
+        count = m_pending_textures.size();
+
+        for (i = 0; i < count; ++i)
+        {
+            if ((size >= budget) ||
+                !m_pending_textures[i].first->get_done())
+            {
+                m_pending_textures[used] = m_pending_textures[i];
+                used++;
+
+                continue;
+            }
+
+            image = m_pending_textures[i].first->get_image();
+
+            /**
+             * On errors the texture keeps the error image, like the
+             * textures loaded by get_texture().
+             */
+            if (image.get() != nullptr)
+            {
+                texture = do_load_texture(image,
+                    m_pending_textures[i].second->get_name(),
+                    m_pending_textures[i].first->get_rectangle());
+
+                m_pending_textures[i].second->swap(*texture);
+
+                size += image->get_buffer()->get_size();
+            }
+        }
+
+        m_pending_textures.resize(used);
     }
 
     TextureSharedPtr TextureCache::get_texture(
@@ -324,18 +573,7 @@ namespace eternal_lands
         RANGE_CECK_MIN(image_names.size(), 1,
             UTF8("not enough images."));
 
-        if (GLEW_EXT_texture_compression_s3tc)
-        {
-            compressions.insert(ict_s3tc);
-        }
-
-        rg_formats = false;
-
-        if (get_global_vars()->get_opengl_3_0())
-        {
-            compressions.insert(ict_rgtc);
-            rg_formats = true;
-        }
+        get_compressions(compressions, rg_formats);
 
         BOOST_FOREACH(const String &image_name, image_names)
         {
@@ -365,4 +603,16 @@ namespace eternal_lands
         return texture;
     }
 
+    void TextureCache::trim()
+    {
+        m_texture_cache.set_budget(static_cast<Uint64>(
+            get_global_vars()->get_texture_cache_size()) * 1024 * 1024);
+        m_texture_cache.trim();
+    }
+
+    String TextureCache::get_statistics() const
+    {
+        return m_texture_cache.get_statistics();
+    }
+
 }
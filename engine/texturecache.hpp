@@ -14,6 +14,7 @@
 
 #include "prerequisites.hpp"
 #include "textureformatutil.hpp"
+#include "lrucache.hpp"
 
 /**
  * @file
@@ -26,14 +27,46 @@ namespace eternal_lands
 	class TextureCache: public boost::noncopyable
 	{
 		private:
-			typedef std::map<String, TextureSharedPtr>
-				TextureCacheMap;
+			class TextureCacheTraits
+			{
+				public:
+					static bool get_unused(
+						const TextureSharedPtr &texture)
+						noexcept;
+					static Uint64 get_memory_usage(
+						const TextureSharedPtr &texture)
+						noexcept;
+
+			};
+
+			class TextureLoadRequest;
+			class TextureLoadTask;
+
+			typedef LruCache<TextureSharedPtr, TextureCacheTraits>
+				TextureLruCache;
+			typedef boost::shared_ptr<TextureLoadRequest>
+				TextureLoadRequestSharedPtr;
+			/**
+			 * The request is shared with the loader thread, the
+			 * texture is only used by the render thread.
+			 */
+			typedef std::pair<TextureLoadRequestSharedPtr,
+				TextureSharedPtr> PendingTexture;
+			typedef std::vector<PendingTexture> PendingTextureVector;
 
-			TextureCacheMap m_texture_cache;
+			TextureLruCache m_texture_cache;
+			PendingTextureVector m_pending_textures;
 			const GlobalVarsConstSharedPtr m_global_vars;
 			const FileSystemConstSharedPtr m_file_system;
 			TextureSharedPtr m_error_texture;
 			TextureSharedPtr m_error_texture_rectangle;
+			ImageSharedPtr m_error_image;
+			boost::scoped_ptr<ThreadPool> m_thread_pool;
+
+			void get_compressions(
+				ImageCompressionTypeSet &compressions,
+				bool &rg_formats) const;
+			const ImageSharedPtr &get_error_image();
 
 			TextureSharedPtr load_texture(const String &name,
 				const String &index, const bool sRGB,
@@ -63,8 +96,43 @@ namespace eternal_lands
 				const GlobalVarsConstSharedPtr &global_vars,
 				const FileSystemConstSharedPtr &file_system);
 			~TextureCache() noexcept;
-			const TextureSharedPtr &get_texture(const String &name,
+			TextureSharedPtr get_texture(const String &name,
 				const bool sRGB, const bool rectangle);
+
+			/**
+			 * @brief Returns the texture, loading it in the
+			 * background.
+			 *
+			 * If the texture is not in the cache, a texture
+			 * showing the error image is returned at once and the
+			 * image is read and decoded by a loader thread. The
+			 * texture is switched to the loaded image by
+			 * upload_textures(). Falls back to get_texture() if
+			 * texture streaming is disabled.
+			 */
+			TextureSharedPtr get_streamed_texture(
+				const String &name, const bool sRGB,
+				const bool rectangle);
+
+			/**
+			 * @brief Uploads loaded textures.
+			 *
+			 * Uploads the textures the loader threads are done
+			 * with, until the texture upload budget of the global
+			 * vars is used up. Must be called once per frame from
+			 * the render thread.
+			 */
+			void upload_textures();
+
+			/**
+			 * Returns the number of textures that are loading or
+			 * waiting for the upload.
+			 */
+			inline Uint32 get_pending_texture_count() const
+			{
+				return m_pending_textures.size();
+			}
+
 			const TextureSharedPtr &get_error_texture(
 				const bool rectangle);
 			TextureSharedPtr get_texture(
@@ -80,6 +148,14 @@ namespace eternal_lands
 				const ImageConstSharedPtr &image,
 				const String &name) const;
 
+			/**
+			 * Removes the least recently used textures that are
+			 * not used any more, until the cache fits into the
+			 * texture cache size of the global vars.
+			 */
+			void trim();
+			String get_statistics() const;
+
 	};
 
 }
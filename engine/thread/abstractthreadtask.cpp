@@ -10,7 +10,8 @@
 namespace eternal_lands
 {
 
-	AbstractThreadTask::AbstractThreadTask()
+	AbstractThreadTask::AbstractThreadTask(): m_parent(0),
+		m_task_group(0), m_open_tasks(1)
 	{
 	}
 
@@ -18,4 +19,10 @@ namespace eternal_lands
 	{
 	}
 
+	void AbstractThreadTask::set_continuation(
+		std::auto_ptr<AbstractThreadTask> &task)
+	{
+		m_continuation.reset(task.release());
+	}
+
 }
@@ -19,8 +19,16 @@ namespace eternal_lands
 
 	class AbstractThreadTask
 	{
+		friend class JobSystem;
 		private:
-			Uint32 m_group_id;
+			std::auto_ptr<AbstractThreadTask> m_continuation;
+			AbstractThreadTask* m_parent;
+			TaskGroup* m_task_group;
+			/**
+			 * Number of unfinished children plus one for the
+			 * task itself.
+			 */
+			volatile Sint32 m_open_tasks;
 
 		protected:
 			AbstractThreadTask();
@@ -30,6 +38,20 @@ namespace eternal_lands
 
 			virtual void operator()() = 0;
 
+			/**
+			 * Sets the task that is added to the job system when
+			 * this task and all of its children are done. The
+			 * continuation takes over the parent and task group
+			 * of this task.
+			 */
+			void set_continuation(
+				std::auto_ptr<AbstractThreadTask> &task);
+
+			inline AbstractThreadTask* get_parent() const noexcept
+			{
+				return m_parent;
+			}
+
 	};
 
 }
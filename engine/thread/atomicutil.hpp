@@ -0,0 +1,128 @@
+/****************************************************************************
+ *            atomicutil.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_ca7549f7_bba3_42f2_8d1e_304a7cf0d81f
+#define	UUID_ca7549f7_bba3_42f2_8d1e_304a7cf0d81f
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+
+#ifdef	_MSC_VER
+#include <intrin.h>
+#endif	/* _MSC_VER */
+
+/**
+ * @file
+ * @brief The @c class AtomicUtil.
+ * This file contains the @c class AtomicUtil.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief Atomic operations.
+	 *
+	 * Minimal set of atomic operations used by the lock free parts of
+	 * the job system. All operations are full memory barriers.
+	 */
+	class AtomicUtil
+	{
+		public:
+			/**
+			 * Atomically increments the value.
+			 * @param value The value to increment.
+			 * @result The incremented value.
+			 */
+			static inline Sint32 increment(volatile Sint32* value)
+			{
+#ifdef	_MSC_VER
+				return _InterlockedIncrement(
+					reinterpret_cast<volatile long*>(
+						value));
+#else	/* _MSC_VER */
+				return __sync_add_and_fetch(value, 1);
+#endif	/* _MSC_VER */
+			}
+
+			/**
+			 * Atomically decrements the value.
+			 * @param value The value to decrement.
+			 * @result The decremented value.
+			 */
+			static inline Sint32 decrement(volatile Sint32* value)
+			{
+#ifdef	_MSC_VER
+				return _InterlockedDecrement(
+					reinterpret_cast<volatile long*>(
+						value));
+#else	/* _MSC_VER */
+				return __sync_sub_and_fetch(value, 1);
+#endif	/* _MSC_VER */
+			}
+
+			/**
+			 * Atomically replaces the value with new_value if it
+			 * is equal to old_value.
+			 * @param value The value to change.
+			 * @param old_value The expected value.
+			 * @param new_value The new value.
+			 * @result True if the value was replaced.
+			 */
+			static inline bool compare_and_swap(
+				volatile Uint32* value, const Uint32 old_value,
+				const Uint32 new_value)
+			{
+#ifdef	_MSC_VER
+				return static_cast<Uint32>(
+					_InterlockedCompareExchange(
+						reinterpret_cast<volatile long*>(
+							value), new_value,
+						old_value)) == old_value;
+#else	/* _MSC_VER */
+				return __sync_bool_compare_and_swap(value,
+					old_value, new_value);
+#endif	/* _MSC_VER */
+			}
+
+			/**
+			 * Atomically reads the value.
+			 * @param value The value to read.
+			 * @result The value.
+			 */
+			static inline Sint32 load(const volatile Sint32* value)
+			{
+				Sint32 result;
+
+				result = *value;
+
+				memory_barrier();
+
+				return result;
+			}
+
+			/**
+			 * Full memory barrier, no loads or stores are moved
+			 * across it by the compiler or the cpu.
+			 */
+			static inline void memory_barrier()
+			{
+#ifdef	_MSC_VER
+				_ReadWriteBarrier();
+				_mm_mfence();
+#else	/* _MSC_VER */
+				__sync_synchronize();
+#endif	/* _MSC_VER */
+			}
+
+	};
+
+}
+
+#endif	/* UUID_ca7549f7_bba3_42f2_8d1e_304a7cf0d81f */
@@ -0,0 +1,453 @@
+/****************************************************************************
+ *            jobsystem.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "jobsystem.hpp"
+#include "abstractthreadtask.hpp"
+#include "atomicutil.hpp"
+#include "autolock.hpp"
+#include "taskgroup.hpp"
+#include "workstealingdeque.hpp"
+#include "logging.hpp"
+#ifdef	WINDOWS
+#include <windows.h>
+#else	/* WINDOWS */
+#include <unistd.h>
+#endif	/* WINDOWS */
+
+namespace eternal_lands
+{
+
+	namespace
+	{
+
+		const Uint32 deque_size = 4096;
+		const Uint32 invalid_index = 0xFFFFFFFF;
+
+		typedef std::pair<JobSystem*, Uint32> JobSystemUint32Pair;
+
+		inline Uint32 get_random(Uint32 &seed)
+		{
+			/**
+			 * xorshift, only used to spread the stealing.
+			 */
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+
+			return seed;
+		}
+
+	}
+
+	int job_system_thread_function(void* data)
+	{
+		JobSystemUint32Pair* job_system;
+
+		job_system = static_cast<JobSystemUint32Pair*>(data);
+
+		job_system->first->thread_function(job_system->second);
+
+		return 0;
+	}
+
+	JobSystem::JobSystem(const Uint16 threads):
+		m_thread_ids(new volatile Uint32[threads + 1]),
+		m_random_seeds(new Uint32[threads + 1]),
+		m_shared_task_count(0), m_sleeping_threads(0),
+		m_started_threads(0), m_running(true)
+	{
+		boost::scoped_array<JobSystemUint32Pair> datas;
+		Uint32 i;
+
+		m_mutex = SDL_CreateMutex();
+		m_semaphore = SDL_CreateSemaphore(0);
+
+		/**
+		 * Index zero belongs to the creating thread.
+		 */
+		for (i = 0; i <= threads; ++i)
+		{
+			m_deques.push_back(new WorkStealingDeque(deque_size));
+			m_thread_ids[i] = 0;
+			m_random_seeds[i] = 2463534242u + i * 7919;
+		}
+
+		m_thread_ids[0] = SDL_ThreadID();
+
+		datas.reset(new JobSystemUint32Pair[threads]);
+
+		for (i = 0; i < threads; ++i)
+		{
+			datas[i] = JobSystemUint32Pair(this, i + 1);
+
+#if	SDL_VERSION_ATLEAST(2, 0, 0)
+			m_threads.push_back(SDL_CreateThread(
+				job_system_thread_function,
+				UTF8("JobSystem"), &datas[i]));
+#else	/* SDL_VERSION_ATLEAST(2, 0, 0) */
+			m_threads.push_back(SDL_CreateThread(
+				job_system_thread_function, &datas[i]));
+#endif	/* SDL_VERSION_ATLEAST(2, 0, 0) */
+		}
+
+		/**
+		 * All workers must have registered their thread id before
+		 * the first task is added.
+		 */
+		while (AtomicUtil::load(&m_started_threads) < threads)
+		{
+			SDL_Delay(0);
+		}
+	}
+
+	JobSystem::~JobSystem() noexcept
+	{
+		Uint32 i, count;
+		AbstractThreadTask* task;
+
+		m_running = false;
+
+		AtomicUtil::memory_barrier();
+
+		count = m_threads.size();
+
+		for (i = 0; i < count; ++i)
+		{
+			SDL_SemPost(m_semaphore);
+		}
+
+		for (i = 0; i < count; ++i)
+		{
+			SDL_WaitThread(m_threads[i], 0);
+		}
+
+		count = m_deques.size();
+
+		for (i = 0; i < count; ++i)
+		{
+			while ((task = m_deques[i].pop()) != 0)
+			{
+				delete task;
+			}
+		}
+
+		while (!m_shared_tasks.empty())
+		{
+			delete m_shared_tasks.front();
+			m_shared_tasks.pop_front();
+		}
+
+		SDL_DestroySemaphore(m_semaphore);
+		SDL_DestroyMutex(m_mutex);
+	}
+
+	void JobSystem::thread_function(const Uint32 index)
+	{
+		AbstractThreadTask* task;
+
+		m_thread_ids[index] = SDL_ThreadID();
+
+		AtomicUtil::increment(&m_started_threads);
+
+		while (get_running())
+		{
+			task = get_task(index);
+
+			if (task != 0)
+			{
+				execute(task);
+
+				continue;
+			}
+
+			/**
+			 * Announce that we go to sleep before checking a
+			 * last time, so that a task added after the check
+			 * always posts the semaphore.
+			 */
+			AtomicUtil::increment(&m_sleeping_threads);
+
+			task = get_task(index);
+
+			if (task != 0)
+			{
+				AtomicUtil::decrement(&m_sleeping_threads);
+
+				execute(task);
+
+				continue;
+			}
+
+			if (get_running())
+			{
+				SDL_SemWaitTimeout(m_semaphore, 10);
+			}
+
+			AtomicUtil::decrement(&m_sleeping_threads);
+		}
+	}
+
+	Uint32 JobSystem::get_index() const
+	{
+		Uint32 i, count, thread_id;
+
+		thread_id = SDL_ThreadID();
+		count = m_deques.size();
+
+		for (i = 0; i < count; ++i)
+		{
+			if (m_thread_ids[i] == thread_id)
+			{
+				return i;
+			}
+		}
+
+		return invalid_index;
+	}
+
+	AbstractThreadTask* JobSystem::get_shared_task()
+	{
+		AbstractThreadTask* task;
+
+		if (AtomicUtil::load(&m_shared_task_count) <= 0)
+		{
+			return 0;
+		}
+
+		AutoLock lock(m_mutex);
+
+		if (m_shared_tasks.empty())
+		{
+			return 0;
+		}
+
+		task = m_shared_tasks.front();
+		m_shared_tasks.pop_front();
+
+		AtomicUtil::decrement(&m_shared_task_count);
+
+		return task;
+	}
+
+	AbstractThreadTask* JobSystem::get_task(const Uint32 index)
+	{
+		AbstractThreadTask* task;
+		Uint32 i, count, offset;
+
+		count = m_deques.size();
+		offset = 0;
+
+		if (index != invalid_index)
+		{
+			task = m_deques[index].pop();
+
+			if (task != 0)
+			{
+				return task;
+			}
+
+			offset = get_random(m_random_seeds[index]);
+		}
+
+		task = get_shared_task();
+
+		if (task != 0)
+		{
+			return task;
+		}
+
+		for (i = 0; i < count; ++i)
+		{
+			if (((i + offset) % count) == index)
+			{
+				continue;
+			}
+
+			task = m_deques[(i + offset) % count].steal();
+
+			if (task != 0)
+			{
+				return task;
+			}
+		}
+
+		return 0;
+	}
+
+	void JobSystem::wake_up()
+	{
+		AtomicUtil::memory_barrier();
+
+		if (AtomicUtil::load(&m_sleeping_threads) <= 0)
+		{
+			return;
+		}
+
+		if (SDL_SemValue(m_semaphore) <
+			static_cast<Uint32>(m_threads.size()))
+		{
+			SDL_SemPost(m_semaphore);
+		}
+	}
+
+	void JobSystem::schedule(AbstractThreadTask* task)
+	{
+		Uint32 index;
+
+		index = get_index();
+
+		if ((index == invalid_index) || !m_deques[index].push(task))
+		{
+			AutoLock lock(m_mutex);
+
+			m_shared_tasks.push_back(task);
+
+			AtomicUtil::increment(&m_shared_task_count);
+		}
+
+		wake_up();
+	}
+
+	void JobSystem::execute(AbstractThreadTask* task)
+	{
+		try
+		{
+			(*task)();
+		}
+		catch (const boost::exception &exception)
+		{
+			LOG_EXCEPTION(exception);
+		}
+		catch (const std::exception &exception)
+		{
+			LOG_EXCEPTION(exception);
+		}
+		catch (...)
+		{
+			LOG_EXCEPTION_STR(UTF8("%1%"),
+				UTF8("Unknown exception in task"));
+		}
+
+		finish(task);
+	}
+
+	void JobSystem::finish(AbstractThreadTask* task)
+	{
+		AbstractThreadTask* parent;
+		AbstractThreadTask* continuation;
+		TaskGroup* task_group;
+
+		while (task != 0)
+		{
+			if (AtomicUtil::decrement(&task->m_open_tasks) > 0)
+			{
+				return;
+			}
+
+			parent = task->m_parent;
+			task_group = task->m_task_group;
+			continuation = task->m_continuation.release();
+
+			delete task;
+
+			if (continuation != 0)
+			{
+				/**
+				 * The continuation replaces the task, so the
+				 * parent and the task group stay open.
+				 */
+				continuation->m_parent = parent;
+				continuation->m_task_group = task_group;
+
+				schedule(continuation);
+
+				return;
+			}
+
+			if (task_group != 0)
+			{
+				task_group->remove_task();
+			}
+
+			task = parent;
+		}
+	}
+
+	void JobSystem::add(std::auto_ptr<AbstractThreadTask> &task)
+	{
+		schedule(task.release());
+	}
+
+	void JobSystem::add(std::auto_ptr<AbstractThreadTask> &task,
+		TaskGroup &task_group)
+	{
+		task->m_task_group = &task_group;
+
+		task_group.add_task();
+
+		schedule(task.release());
+	}
+
+	void JobSystem::add_child(std::auto_ptr<AbstractThreadTask> &task,
+		AbstractThreadTask* parent)
+	{
+		assert(parent != 0);
+
+		task->m_parent = parent;
+
+		AtomicUtil::increment(&parent->m_open_tasks);
+
+		schedule(task.release());
+	}
+
+	void JobSystem::wait(const TaskGroup &task_group)
+	{
+		AbstractThreadTask* task;
+		Uint32 index;
+
+		index = get_index();
+
+		while (!task_group.get_done())
+		{
+			task = get_task(index);
+
+			if (task != 0)
+			{
+				execute(task);
+			}
+			else
+			{
+				SDL_Delay(0);
+			}
+		}
+	}
+
+	Uint16 JobSystem::get_cpu_count()
+	{
+		long count;
+
+#if	SDL_VERSION_ATLEAST(2, 0, 0)
+		count = SDL_GetCPUCount();
+#elif	defined(WINDOWS)
+		SYSTEM_INFO system_info;
+
+		GetSystemInfo(&system_info);
+
+		count = system_info.dwNumberOfProcessors;
+#else	/* SDL_VERSION_ATLEAST(2, 0, 0) */
+		count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif	/* SDL_VERSION_ATLEAST(2, 0, 0) */
+
+		return std::max(1l, std::min(count, 256l));
+	}
+
+	Uint16 JobSystem::get_default_thread_count()
+	{
+		return std::max(1, get_cpu_count() - 1);
+	}
+
+}
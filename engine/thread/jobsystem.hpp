@@ -0,0 +1,132 @@
+/****************************************************************************
+ *            jobsystem.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_cfa343bb_28c8_4025_bf5c_f577eabff7d8
+#define	UUID_cfa343bb_28c8_4025_bf5c_f577eabff7d8
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+
+/**
+ * @file
+ * @brief The @c class JobSystem.
+ * This file contains the @c class JobSystem.
+ */
+namespace eternal_lands
+{
+
+	class WorkStealingDeque;
+
+	/**
+	 * @brief Work stealing job system.
+	 *
+	 * Every worker thread and the thread that created the job system
+	 * own a lock free deque. Tasks added from these threads are pushed
+	 * on their own deque and idle workers steal from the others. Tasks
+	 * added from any other thread go through a shared queue. Instead
+	 * of one global wait, tasks are waited on through a TaskGroup and
+	 * waiting threads execute tasks until the group is done.
+	 */
+	class JobSystem: public boost::noncopyable
+	{
+		friend int job_system_thread_function(void* data);
+		private:
+			boost::ptr_vector<WorkStealingDeque> m_deques;
+			std::vector<SDL_Thread*> m_threads;
+			boost::scoped_array<volatile Uint32> m_thread_ids;
+			boost::scoped_array<Uint32> m_random_seeds;
+			std::deque<AbstractThreadTask*> m_shared_tasks;
+			SDL_mutex* m_mutex;
+			SDL_sem* m_semaphore;
+			volatile Sint32 m_shared_task_count;
+			volatile Sint32 m_sleeping_threads;
+			volatile Sint32 m_started_threads;
+			volatile bool m_running;
+
+			void thread_function(const Uint32 index);
+			Uint32 get_index() const;
+			AbstractThreadTask* get_task(const Uint32 index);
+			AbstractThreadTask* get_shared_task();
+			void schedule(AbstractThreadTask* task);
+			void execute(AbstractThreadTask* task);
+			void finish(AbstractThreadTask* task);
+			void wake_up();
+
+		public:
+			/**
+			 * Default constructor.
+			 * @param threads The number of worker threads.
+			 */
+			JobSystem(const Uint16 threads);
+
+			/**
+			 * Default destructor. All task groups should be
+			 * waited for before, not yet executed tasks are
+			 * deleted.
+			 */
+			~JobSystem() noexcept;
+
+			/**
+			 * Adds a task that is not waited for.
+			 */
+			void add(std::auto_ptr<AbstractThreadTask> &task);
+
+			/**
+			 * Adds a task to the task group.
+			 */
+			void add(std::auto_ptr<AbstractThreadTask> &task,
+				TaskGroup &task_group);
+
+			/**
+			 * Adds a child task, the parent task is not finished
+			 * before the child is. Must be called while the parent
+			 * is still running, normaly from inside its
+			 * operator().
+			 */
+			void add_child(std::auto_ptr<AbstractThreadTask> &task,
+				AbstractThreadTask* parent);
+
+			/**
+			 * Waits until all tasks of the group are done. The
+			 * calling thread executes tasks while waiting.
+			 */
+			void wait(const TaskGroup &task_group);
+
+			/**
+			 * Returns the number of threads executing tasks,
+			 * including the thread that created the job system.
+			 */
+			inline Uint32 get_thread_count() const noexcept
+			{
+				return m_deques.size();
+			}
+
+			inline bool get_running() const noexcept
+			{
+				return m_running;
+			}
+
+			/**
+			 * Returns the number of online cpu cores.
+			 */
+			static Uint16 get_cpu_count();
+
+			/**
+			 * Returns the number of worker threads to use, one
+			 * less than the number of cpu cores, because the
+			 * creating thread executes tasks too.
+			 */
+			static Uint16 get_default_thread_count();
+
+	};
+
+}
+
+#endif	/* UUID_cfa343bb_28c8_4025_bf5c_f577eabff7d8 */
@@ -0,0 +1,79 @@
+/****************************************************************************
+ *            taskgroup.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_3f012a52_9a23_4c95_96af_7e48792d87a3
+#define	UUID_3f012a52_9a23_4c95_96af_7e48792d87a3
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include "atomicutil.hpp"
+
+/**
+ * @file
+ * @brief The @c class TaskGroup.
+ * This file contains the @c class TaskGroup.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief Counter of unfinished tasks.
+	 *
+	 * Tasks added to the job system with a task group increment its
+	 * counter and decrement it when they and all their children are
+	 * done. JobSystem::wait() waits for the counter to become zero and
+	 * executes tasks while waiting.
+	 */
+	class TaskGroup: public boost::noncopyable
+	{
+		private:
+			volatile Sint32 m_pending;
+
+		public:
+			/**
+			 * Default constructor.
+			 */
+			inline TaskGroup(): m_pending(0)
+			{
+			}
+
+			/**
+			 * Default destructor.
+			 */
+			inline ~TaskGroup() noexcept
+			{
+				assert(get_done());
+			}
+
+			inline void add_task()
+			{
+				AtomicUtil::increment(&m_pending);
+			}
+
+			inline void remove_task()
+			{
+				AtomicUtil::decrement(&m_pending);
+			}
+
+			inline Sint32 get_pending() const
+			{
+				return AtomicUtil::load(&m_pending);
+			}
+
+			inline bool get_done() const
+			{
+				return get_pending() <= 0;
+			}
+
+	};
+
+}
+
+#endif	/* UUID_3f012a52_9a23_4c95_96af_7e48792d87a3 */
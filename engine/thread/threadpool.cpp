@@ -26,8 +26,6 @@ namespace eternal_lands
 					return;
 				}
 
-				SDL_CondSignal(thread_pool->m_wait_condition);
-
 				SDL_CondWait(thread_pool->m_thread_condition,
 					thread_pool->m_mutex);
 			}
@@ -48,6 +46,13 @@ namespace eternal_lands
 			AutoLock lock(thread_pool->m_mutex);
 
 			thread_pool->m_done_tasks++;
+
+			if (thread_pool->m_done_tasks ==
+				thread_pool->m_total_tasks)
+			{
+				SDL_CondBroadcast(
+					thread_pool->m_wait_condition);
+			}
 		}
 	}
 
@@ -65,12 +70,11 @@ namespace eternal_lands
 		return 0;
 	}
 
-	ThreadPool::ThreadPool(const Uint16 threads)
+	ThreadPool::ThreadPool(const Uint16 threads): m_total_tasks(0),
+		m_done_tasks(0), m_running(true)
 	{
 		Uint16 i;
 
-		m_running = true;
-
 		m_mutex = SDL_CreateMutex();
 		m_thread_condition = SDL_CreateCond();
 		m_wait_condition = SDL_CreateCond();
@@ -120,7 +124,7 @@ namespace eternal_lands
 	{
 		AutoLock lock(m_mutex);
 
-		while (m_total_tasks == m_done_tasks)
+		while (m_total_tasks != m_done_tasks)
 		{
 			SDL_CondWait(m_wait_condition, m_mutex);
 		}
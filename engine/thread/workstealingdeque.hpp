@@ -0,0 +1,193 @@
+/****************************************************************************
+ *            workstealingdeque.hpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_ae7c8397_cc02_4be6_8818_2c234d651f22
+#define	UUID_ae7c8397_cc02_4be6_8818_2c234d651f22
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include "atomicutil.hpp"
+
+/**
+ * @file
+ * @brief The @c class WorkStealingDeque.
+ * This file contains the @c class WorkStealingDeque.
+ */
+namespace eternal_lands
+{
+
+	/**
+	 * @brief Lock free work stealing deque.
+	 *
+	 * Bounded Chase-Lev deque of task pointers. Only the owning worker
+	 * calls push() and pop() and works on the bottom end, any other
+	 * thread may call steal(), which takes from the top end. Indices
+	 * are unsigned and only compared through their difference, so they
+	 * can wrap around.
+	 */
+	class WorkStealingDeque: public boost::noncopyable
+	{
+		private:
+			boost::scoped_array<AbstractThreadTask* volatile>
+				m_tasks;
+			volatile Uint32 m_top;
+			volatile Uint32 m_bottom;
+			const Uint32 m_mask;
+
+			static inline Uint32 get_capacity(const Uint32 size)
+			{
+				Uint32 result;
+
+				result = 1;
+
+				while (result < size)
+				{
+					result *= 2;
+				}
+
+				return result;
+			}
+
+		public:
+			/**
+			 * Default constructor.
+			 * @param size The minimum number of tasks the deque
+			 * can hold, rounded up to a power of two.
+			 */
+			inline WorkStealingDeque(const Uint32 size):
+				m_tasks(new AbstractThreadTask* volatile[
+					get_capacity(size)]), m_top(0),
+				m_bottom(0), m_mask(get_capacity(size) - 1)
+			{
+			}
+
+			/**
+			 * Pushes the task at the bottom. Only the owner thread
+			 * is allowed to call this.
+			 * @param task The task to push.
+			 * @result False if the deque is full.
+			 */
+			inline bool push(AbstractThreadTask* task)
+			{
+				Uint32 bottom, top;
+
+				bottom = m_bottom;
+				top = m_top;
+
+				if ((bottom - top) > m_mask)
+				{
+					return false;
+				}
+
+				m_tasks[bottom & m_mask] = task;
+
+				AtomicUtil::memory_barrier();
+
+				m_bottom = bottom + 1;
+
+				return true;
+			}
+
+			/**
+			 * Pops the last pushed task. Only the owner thread is
+			 * allowed to call this.
+			 * @result The task or zero if the deque is empty.
+			 */
+			inline AbstractThreadTask* pop()
+			{
+				AbstractThreadTask* task;
+				Uint32 bottom, top;
+
+				bottom = m_bottom - 1;
+				m_bottom = bottom;
+
+				AtomicUtil::memory_barrier();
+
+				top = m_top;
+
+				if (static_cast<Sint32>(bottom - top) < 0)
+				{
+					m_bottom = top;
+
+					return 0;
+				}
+
+				task = m_tasks[bottom & m_mask];
+
+				if (bottom != top)
+				{
+					return task;
+				}
+
+				/**
+				 * Last task, race against the stealing threads.
+				 */
+				if (!AtomicUtil::compare_and_swap(&m_top, top,
+					top + 1))
+				{
+					task = 0;
+				}
+
+				m_bottom = top + 1;
+
+				return task;
+			}
+
+			/**
+			 * Steals the first pushed task. Can be called from any
+			 * thread.
+			 * @result The task or zero if the deque is empty or
+			 * an other thread was faster.
+			 */
+			inline AbstractThreadTask* steal()
+			{
+				AbstractThreadTask* task;
+				Uint32 bottom, top;
+
+				top = m_top;
+
+				AtomicUtil::memory_barrier();
+
+				bottom = m_bottom;
+
+				if (static_cast<Sint32>(bottom - top) <= 0)
+				{
+					return 0;
+				}
+
+				task = m_tasks[top & m_mask];
+
+				if (!AtomicUtil::compare_and_swap(&m_top, top,
+					top + 1))
+				{
+					return 0;
+				}
+
+				return task;
+			}
+
+			/**
+			 * Estimate of the tasks in the deque, only exact if
+			 * no other thread is working on it.
+			 */
+			inline Uint32 get_size() const
+			{
+				Sint32 size;
+
+				size = static_cast<Sint32>(m_bottom - m_top);
+
+				return std::max(size, 0);
+			}
+
+	};
+
+}
+
+#endif	/* UUID_ae7c8397_cc02_4be6_8818_2c234d651f22 */
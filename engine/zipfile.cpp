@@ -6,11 +6,12 @@
  ****************************************************************************/
 
 #include "zipfile.hpp"
-#include <unzip.h>
+#include "memorymappedfile.hpp"
 #include "readwritememory.hpp"
 #include "reader.hpp"
 #include "utf.hpp"
 #include "exceptions.hpp"
+#include <zlib.h>
 
 namespace eternal_lands
 {
@@ -18,279 +19,393 @@ namespace eternal_lands
 	namespace
 	{
 
-		class ZipFileReader
+		const Uint32 local_file_header_signature = 0x04034B50;
+		const Uint32 central_file_header_signature = 0x02014B50;
+		const Uint32 end_of_central_dir_signature = 0x06054B50;
+		const Uint32 zip64_end_of_central_dir_signature = 0x06064B50;
+		const Uint32 zip64_end_of_central_dir_locator_signature =
+			0x07064B50;
+		const Uint32 local_file_header_size = 30;
+		const Uint32 central_file_header_size = 46;
+		const Uint32 end_of_central_dir_size = 22;
+		const Uint32 zip64_end_of_central_dir_size = 56;
+		const Uint32 zip64_end_of_central_dir_locator_size = 20;
+		const Uint32 max_comment_size = 0xFFFF;
+		const Uint16 zip64_extra_field_id = 0x0001;
+		const Uint16 method_stored = 0;
+		const Uint16 method_deflated = 8;
+		const Uint16 flag_encrypted = 0x0001;
+
+		/**
+		 * All values in zip files are little endian and not aligned.
+		 */
+		inline Uint16 read_u16(const Uint8* ptr) noexcept
+		{
+			return ptr[0] | (ptr[1] << 8);
+		}
+
+		inline Uint32 read_u32(const Uint8* ptr) noexcept
+		{
+			return static_cast<Uint32>(read_u16(ptr)) |
+				(static_cast<Uint32>(read_u16(ptr + 2)) << 16);
+		}
+
+		inline Uint64 read_u64(const Uint8* ptr) noexcept
+		{
+			return static_cast<Uint64>(read_u32(ptr)) |
+				(static_cast<Uint64>(read_u32(ptr + 4)) << 32);
+		}
+
+		/**
+		 * @brief Memory of a stored file.
+		 *
+		 * Points into the memory mapped zip file and keeps the
+		 * mapping alive.
+		 */
+		class ZipFileView: public AbstractReadMemory
 		{
 			private:
-				unzFile m_file;
+				const MemoryMappedFileConstSharedPtr m_memory;
+				const Uint8* m_ptr;
+				const Uint64 m_size;
 
 			public:
-				ZipFileReader(const unzFile file,
-					const unz64_file_pos &position);
-				~ZipFileReader() noexcept;
-				ReadWriteMemorySharedPtr get_buffer();
-				Uint64 get_size();
+				ZipFileView(
+					const MemoryMappedFileConstSharedPtr
+						&memory, const Uint8* ptr,
+					const Uint64 size);
+				virtual ~ZipFileView() noexcept;
+				virtual const void* get_ptr() const noexcept;
+				virtual Uint64 get_size() const noexcept;
 
 		};
 
-		ZipFileReader::ZipFileReader(const unzFile file,
-			const unz64_file_pos &position): m_file(file)
+		ZipFileView::ZipFileView(
+			const MemoryMappedFileConstSharedPtr &memory,
+			const Uint8* ptr, const Uint64 size): m_memory(memory),
+			m_ptr(ptr), m_size(size)
 		{
-			unzGoToFilePos64(m_file, &position);
-			unzOpenCurrentFile(m_file);
 		}
 
-		ZipFileReader::~ZipFileReader() noexcept
+		ZipFileView::~ZipFileView() noexcept
 		{
-			unzCloseCurrentFile(m_file);
 		}
 
-		Uint64 ZipFileReader::get_size()
+		const void* ZipFileView::get_ptr() const noexcept
 		{
-			unz_file_info64 info;
-
-			unzGetCurrentFileInfo64(m_file, &info, 0, 0, 0, 0, 0,
-				0);
-
-			return info.uncompressed_size;
+			return m_ptr;
 		}
 
-		ReadWriteMemorySharedPtr ZipFileReader::get_buffer()
+		Uint64 ZipFileView::get_size() const noexcept
 		{
-			ReadWriteMemorySharedPtr buffer;
-
-			buffer = boost::make_shared<ReadWriteMemory>(
-				get_size());
-
-			unzReadCurrentFile(m_file, buffer->get_ptr(),
-				buffer->get_size());
-
-			return buffer;
+			return m_size;
 		}
 
-		voidpf ZCALLBACK open_ifstream_func(voidpf opaque,
-			const void* file_name, int mode)
+		void throw_corrupt(const String &name, const char* message)
 		{
-			return new std::ifstream(
-				static_cast<const char*>(file_name),
-				std::ifstream::binary);
+			EL_THROW_EXCEPTION(ReadErrorException()
+				<< errinfo_message(message)
+				<< boost::errinfo_file_name(name));
 		}
 
-		uLong ZCALLBACK read_istream_func(voidpf opaque,
-			voidpf ptr, void* buf, uLong size)
+		/**
+		 * Replaces the values that don't fit into 32 bit with the
+		 * ones from the zip64 extra field. Only the values set to
+		 * 0xFFFFFFFF are in the field, in this order.
+		 */
+		void read_zip64_extra_field(const Uint8* ptr, const Uint32 size,
+			Uint64 &uncompressed_size, Uint64 &compressed_size,
+			Uint64 &offset)
 		{
-			std::istream* stream;
-
-			assert(ptr != 0);
+			Uint32 pos, id, field_size, field_pos;
 
-			stream = static_cast<std::istream*>(ptr);
+			pos = 0;
 
-			stream->read(static_cast<char*>(buf), size);
-
-			if (stream->bad())
+			while ((pos + 4) <= size)
 			{
-				return 0;
+				id = read_u16(ptr + pos);
+				field_size = read_u16(ptr + pos + 2);
+				pos += 4;
+
+				if ((pos + field_size) > size)
+				{
+					return;
+				}
+
+				if (id != zip64_extra_field_id)
+				{
+					pos += field_size;
+
+					continue;
+				}
+
+				field_pos = pos;
+
+				if ((uncompressed_size == 0xFFFFFFFF) &&
+					((field_pos + 8) <= (pos + field_size)))
+				{
+					uncompressed_size = read_u64(ptr +
+						field_pos);
+					field_pos += 8;
+				}
+
+				if ((compressed_size == 0xFFFFFFFF) &&
+					((field_pos + 8) <= (pos + field_size)))
+				{
+					compressed_size = read_u64(ptr +
+						field_pos);
+					field_pos += 8;
+				}
+
+				if ((offset == 0xFFFFFFFF) &&
+					((field_pos + 8) <= (pos + field_size)))
+				{
+					offset = read_u64(ptr + field_pos);
+				}
+
+				return;
 			}
-
-			return size;
 		}
 
-		uLong ZCALLBACK write_istream_func(voidpf opaque,
-			voidpf ptr, const void* buf, uLong size)
-		{
-			assert(ptr != 0);
+	}
 
-			return 0;
-		}
+	ZipFile::ZipFile(const String &name): AbstractArchive(name)
+	{
+		init();
+	}
 
-		ZPOS64_T ZCALLBACK tell_istream_func(voidpf opaque, voidpf ptr)
-		{
-			std::istream* stream;
+	ZipFile::~ZipFile() noexcept
+	{
+	}
 
-			assert(ptr != 0);
+	void ZipFile::init()
+	{
+		ZipFileEntry entry;
+		String index;
+		const Uint8* ptr;
+		const Uint8* name;
+		Uint64 size, pos, end, dir_offset, dir_size, count, i;
+		Uint32 name_size, extra_size, comment_size;
 
-			stream = static_cast<std::istream*>(ptr);
+		m_memory = boost::make_shared<MemoryMappedFile>(get_name());
 
-			return stream->tellg();
-		}
+		ptr = static_cast<const Uint8*>(m_memory->get_ptr());
+		size = m_memory->get_size();
 
-		long ZCALLBACK seek_istream_func(voidpf opaque, voidpf ptr,
-			ZPOS64_T offset, int origin)
+		if (size < end_of_central_dir_size)
 		{
-			std::istream* stream;
-
-			assert(ptr != 0);
+			throw_corrupt(get_name(), UTF8("No zip file"));
+		}
 
-			stream = static_cast<std::istream*>(ptr);
+		/**
+		 * The end of central directory record is at the end of the
+		 * file, followed by a comment of up to 64 KiB.
+		 */
+		pos = size - end_of_central_dir_size;
+		end = 0;
 
-			switch (origin)
-			{
-				case ZLIB_FILEFUNC_SEEK_CUR:
-					stream->seekg(offset,
-						std::ios_base::cur);
-					break;
-				case ZLIB_FILEFUNC_SEEK_END:
-					stream->seekg(offset,
-						std::ios_base::end);
-					break;
-				case ZLIB_FILEFUNC_SEEK_SET:
-					stream->seekg(offset,
-						std::ios_base::beg);
-					break;
-				default:
-					return -1;
-			}
+		if (pos > max_comment_size)
+		{
+			end = pos - max_comment_size;
+		}
 
-			if (stream->bad())
+		while (read_u32(ptr + pos) != end_of_central_dir_signature)
+		{
+			if (pos == end)
 			{
-				return -1;
+				throw_corrupt(get_name(), UTF8("No end of "
+					"central directory found"));
 			}
 
-			return 0;
+			pos--;
 		}
 
-		int ZCALLBACK close_istream_func(voidpf opaque, voidpf ptr)
-		{
-			std::istream* stream;
-
-			assert(ptr != 0);
-
-			stream = static_cast<std::istream*>(ptr);
+		count = read_u16(ptr + pos + 10);
+		dir_size = read_u32(ptr + pos + 12);
+		dir_offset = read_u32(ptr + pos + 16);
 
-			delete stream;
-
-			return 0;
-		}
-
-		int ZCALLBACK error_istream_func(voidpf opaque, voidpf ptr)
+		if ((pos >= zip64_end_of_central_dir_locator_size) &&
+			(read_u32(ptr + pos -
+				zip64_end_of_central_dir_locator_size) ==
+			zip64_end_of_central_dir_locator_signature))
 		{
-			std::istream* stream;
+			pos = read_u64(ptr + pos -
+				zip64_end_of_central_dir_locator_size + 8);
 
-			stream = static_cast<std::istream*>(ptr);
-
-			if (stream == 0)
+			if (((pos + zip64_end_of_central_dir_size) > size) ||
+				(read_u32(ptr + pos) !=
+					zip64_end_of_central_dir_signature))
 			{
-				return -1;
+				throw_corrupt(get_name(), UTF8("Invalid zip64 "
+					"end of central directory"));
 			}
 
-			if (stream->bad())
-			{
-				return -1;
-			}
+			count = read_u64(ptr + pos + 32);
+			dir_size = read_u64(ptr + pos + 40);
+			dir_offset = read_u64(ptr + pos + 48);
+		}
 
-			return 0;
+		if ((dir_offset > size) || (dir_size > (size - dir_offset)))
+		{
+			throw_corrupt(get_name(), UTF8("Invalid central "
+				"directory"));
 		}
 
-	}
+		m_files.rehash(count);
 
-	class ZipFile::ZipFileEntry
-	{
-		private:
-			unz64_file_pos m_position;
+		pos = dir_offset;
+		end = dir_offset + dir_size;
 
-		public:
-			inline ZipFileEntry()
+		for (i = 0; i < count; ++i)
+		{
+			if (((pos + central_file_header_size) > end) ||
+				(read_u32(ptr + pos) !=
+					central_file_header_signature))
 			{
+				throw_corrupt(get_name(), UTF8("Invalid central"
+					" directory entry"));
 			}
 
-			inline ZipFileEntry(const unz64_file_pos &position)
-			{
-				set_position(position);
-			}
+			entry.m_flags = read_u16(ptr + pos + 8);
+			entry.m_method = read_u16(ptr + pos + 10);
+			entry.m_compressed_size = read_u32(ptr + pos + 20);
+			entry.m_size = read_u32(ptr + pos + 24);
+			name_size = read_u16(ptr + pos + 28);
+			extra_size = read_u16(ptr + pos + 30);
+			comment_size = read_u16(ptr + pos + 32);
+			entry.m_offset = read_u32(ptr + pos + 42);
 
-			inline ~ZipFileEntry() noexcept
-			{
-			}
+			pos += central_file_header_size;
 
-			inline unz64_file_pos &get_position() noexcept
+			if ((pos + name_size + extra_size + comment_size) > end)
 			{
-				return m_position;
+				throw_corrupt(get_name(), UTF8("Invalid central"
+					" directory entry"));
 			}
 
-			inline const unz64_file_pos &get_position() const
-				noexcept
-			{
-				return m_position;
-			}
+			name = ptr + pos;
 
-			inline void set_position(const unz64_file_pos &position)
-				noexcept
-			{
-				m_position = position;
-			}
-	};
+			read_zip64_extra_field(name + name_size, extra_size,
+				entry.m_size, entry.m_compressed_size,
+				entry.m_offset);
 
-	ZipFile::ZipFile(const String &name): AbstractArchive(name)
-	{
-		init();
-	}
+			index = String(string_to_utf8(std::string(
+				reinterpret_cast<const char*>(name),
+				name_size)));
 
-	ZipFile::~ZipFile() noexcept
-	{
-		unzClose(m_file);
+			m_files[index] = entry;
+
+			pos += name_size + extra_size + comment_size;
+		}
 	}
 
-	void ZipFile::init()
+	AbstractReadMemorySharedPtr ZipFile::get_buffer(
+		const ZipFileEntry &entry) const
 	{
-		zlib_filefunc64_def file_functions;
-		unz_file_info64 info;
-		unz64_file_pos position;
-		boost::scoped_array<char> file_name;
-		String index;
-		Uint32 size;
-		Sint32 ok;
+		ReadWriteMemorySharedPtr buffer;
+		z_stream stream;
+		const Uint8* ptr;
+		Uint64 size, pos;
+		Sint32 err;
+
+		ptr = static_cast<const Uint8*>(m_memory->get_ptr());
+		size = m_memory->get_size();
+		pos = entry.m_offset;
+
+		if (((pos + local_file_header_size) > size) ||
+			(read_u32(ptr + pos) != local_file_header_signature))
+		{
+			throw_corrupt(get_name(), UTF8("Invalid local file "
+				"header"));
+		}
 
-		file_functions.zopen64_file = open_ifstream_func;
-		file_functions.zread_file = read_istream_func;
-		file_functions.zwrite_file = write_istream_func;
-		file_functions.ztell64_file = tell_istream_func;
-		file_functions.zseek64_file = seek_istream_func;
-		file_functions.zclose_file = close_istream_func;
-		file_functions.zerror_file = error_istream_func;
+		/**
+		 * The extra field of the local header can differ from the
+		 * one in the central directory.
+		 */
+		pos += local_file_header_size + read_u16(ptr + pos + 26) +
+			read_u16(ptr + pos + 28);
 
-		m_file = unzOpen2_64(utf8_to_string(get_name()).c_str(),
-			&file_functions);
+		if ((pos > size) || (entry.m_compressed_size > (size - pos)))
+		{
+			throw_corrupt(get_name(), UTF8("File data out of "
+				"range"));
+		}
 
-		ok = unzGoToFirstFile(m_file);
+		if ((entry.m_flags & flag_encrypted) != 0)
+		{
+			EL_THROW_EXCEPTION(NotImplementedException()
+				<< errinfo_message(UTF8("Encrypted files are "
+					"not supported"))
+				<< boost::errinfo_file_name(get_name()));
+		}
 
-		while (ok == UNZ_OK)
+		if (entry.m_method == method_stored)
 		{
-			unzGetFilePos64(m_file, &position);
+			if (entry.m_compressed_size != entry.m_size)
+			{
+				throw_corrupt(get_name(), UTF8("Invalid size "
+					"of stored file"));
+			}
 
-			unzGetCurrentFileInfo64(m_file, &info, 0, 0, 0, 0, 0,
-				0);
+			return boost::make_shared<ZipFileView>(m_memory,
+				ptr + pos, entry.m_size);
+		}
 
-			size = info.size_filename;
+		if (entry.m_method != method_deflated)
+		{
+			EL_THROW_EXCEPTION(NotImplementedException()
+				<< errinfo_message(UTF8("Compression method not"
+					" supported"))
+				<< errinfo_value(entry.m_method)
+				<< boost::errinfo_file_name(get_name()));
+		}
 
-			file_name.reset(new char[size + 1]);
+		buffer = boost::make_shared<ReadWriteMemory>(entry.m_size);
 
-			unzGetCurrentFileInfo64(m_file, 0, file_name.get(),
-				size, 0, 0, 0, 0);
+		memset(&stream, 0, sizeof(stream));
 
-			index = String(string_to_utf8(std::string(
-				file_name.get(), size)));
+		stream.next_in = const_cast<Bytef*>(ptr + pos);
+		stream.avail_in = entry.m_compressed_size;
+		stream.next_out = static_cast<Bytef*>(buffer->get_ptr());
+		stream.avail_out = entry.m_size;
 
-			m_files[index] = ZipFileEntry(position);
+		/* Zip files contain raw deflate streams without header */
+		err = inflateInit2(&stream, -MAX_WBITS);
 
-			ok = unzGoToNextFile(m_file);
+		if (err != Z_OK)
+		{
+			EL_THROW_EXCEPTION(DecompressException()
+				<< errinfo_message(UTF8("zip decompression "
+					"error"))
+				<< boost::errinfo_file_name(get_name()));
 		}
+
+		err = inflate(&stream, Z_FINISH);
+
+		inflateEnd(&stream);
+
+		if ((err != Z_STREAM_END) || (stream.total_out != entry.m_size))
+		{
+			EL_THROW_EXCEPTION(DecompressException()
+				<< errinfo_message(UTF8("zip decompression "
+					"error"))
+				<< boost::errinfo_file_name(get_name()));
+		}
+
+		return buffer;
 	}
 
 	ReaderSharedPtr ZipFile::get_file(const String &file_name) const
 	{
 		ZipFileEntries::const_iterator found;
-		ReaderSharedPtr reader;
 
 		found = m_files.find(file_name);
 
 		if (found != m_files.end())
 		{
-			ZipFileReader zip_reader(m_file,
-				found->second.get_position());
-
-			reader = boost::make_shared<Reader>(
-				zip_reader.get_buffer(), file_name);
-
-			return reader;
+			return boost::make_shared<Reader>(
+				get_buffer(found->second), file_name);
 		}
 
 		EL_THROW_EXCEPTION(FileNotFoundException()
@@ -14,6 +14,7 @@
 
 #include "prerequisites.hpp"
 #include "abstractarchive.hpp"
+#include <boost/unordered_map.hpp>
 
 /**
  * @file
@@ -23,16 +24,41 @@
 namespace eternal_lands
 {
 
+	/**
+	 * @brief @c class for zip archives.
+	 *
+	 * The archive is memory mapped and the central directory is read
+	 * once into a hash table. Stored files are returned without
+	 * copying them, deflated files are inflated into a new buffer.
+	 * There is no shared read position, so files can be read from
+	 * many threads at the same time.
+	 */
 	class ZipFile: public AbstractArchive
 	{
 		private:
-			class ZipFileEntry;
-			typedef std::map<String, ZipFileEntry> ZipFileEntries;
+			class ZipFileEntry
+			{
+				public:
+					/**
+					 * Offset of the local file header.
+					 */
+					Uint64 m_offset;
+					Uint64 m_compressed_size;
+					Uint64 m_size;
+					Uint16 m_method;
+					Uint16 m_flags;
+
+			};
+
+			typedef boost::unordered_map<String, ZipFileEntry>
+				ZipFileEntries;
 
 			ZipFileEntries m_files;
-			void* m_file;
+			MemoryMappedFileSharedPtr m_memory;
 
 			void init();
+			AbstractReadMemorySharedPtr get_buffer(
+				const ZipFileEntry &entry) const;
 
 		public:
 			/**
@@ -317,6 +317,9 @@ int HandleEvent (SDL_Event *event)
 			case	EVENT_MOVEMENT_TIMER:
 				pf_move();
 				break;
+			case	EVENT_PATH_FOUND:
+				pf_path_found();
+				break;
 			case	EVENT_UPDATE_PARTICLES:
 #if	0
 				update_particles();
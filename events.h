@@ -24,6 +24,7 @@ enum {
 	EVENT_UPDATE_PARTICLES,	 /*!< update the particles */
 	EVENT_UPDATES_DOWNLOADED,/*!< the event to send when the main updates.lst has been downloaded */
 	EVENT_DOWNLOAD_COMPLETE, /*!< the normal event to send when a download finishes */
+	EVENT_PATH_FOUND,	 /*!< the pathfinder thread has a result */
 #ifdef PAWN
 	EVENT_PAWN_TIMER,        /*!< event for running Pawn timer callbacks */
 #endif
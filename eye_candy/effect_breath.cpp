@@ -100,7 +100,7 @@ namespace ec
 					if ((state == 1) && (alpha < 0.04))
 					{
 						state = 2;
-						if ((rand() & 0x07) == 0x07)
+						if (randint(8) == 7)
 						{
 							Vec3 velocity_offset;
 							velocity_offset.randomize(1.0);
@@ -133,7 +133,7 @@ namespace ec
 					if ((state == 1) && (alpha < 0.04))
 					{
 						state = 2;
-						if ((rand() & 0x3F) == 0x3F)
+						if (randint(64) == 63)
 						{
 							Vec3 velocity_offset;
 							velocity_offset.randomize();
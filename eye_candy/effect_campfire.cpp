@@ -289,7 +289,7 @@ namespace ec
 			&& (pow_randfloat((interval_t)usec / 80000 * LOD) < 0.5))
 		{
 			int state = 0;
-			if (rand() & 1)
+			if (randint(2))
 				state = 1;
 			else if (randfloat() < 0.15) // Smoke
 				state = 2;
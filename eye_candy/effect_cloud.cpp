@@ -79,16 +79,10 @@ namespace ec
 
 		if (!neighbors.size())
 		{
-			std::map<Particle*, bool>::iterator next_iter;
-			int offset;
 			CloudParticle* next;
 			while (true)
 			{
-				next_iter = effect->particles.begin();
-				offset = randint((int)effect->particles.size());
-				for (int j = 0; j < offset; j++)
-					next_iter++;
-				next = (CloudParticle*)next_iter->first;
+				next = (CloudParticle*)effect->particles[randint((int)effect->particles.size())];
 				if (next != this)
 					break;
 			}
@@ -111,16 +105,10 @@ namespace ec
 		coord_t maxdist = neighbors_map.rbegin()->first;
 		for (int i = 0; (i < 1) || ((neighbors_map.size() < 20) && (i < 40)); i++)
 		{
-			std::map<Particle*, bool>::iterator iter;
-			int offset;
 			CloudParticle* neighbor;
 			while (true)
 			{
-				iter = eff->particles.begin();
-				offset = randint((int)eff->particles.size());
-				for (int j = 0; j < offset; j++)
-					iter++;
-				neighbor = (CloudParticle*)iter->first;
+				neighbor = (CloudParticle*)eff->particles[randint((int)eff->particles.size())];
 				if (neighbor != this)
 					break;
 			}
@@ -231,16 +219,10 @@ namespace ec
 
 		if (!neighbors.size())
 		{
-			std::map<Particle*, bool>::iterator next_iter;
-			int offset;
 			CloudParticle* next;
 			while (true)
 			{
-				next_iter = effect->particles.begin();
-				offset = randint((int)effect->particles.size());
-				for (int j = 0; j < offset; j++)
-					next_iter++;
-				next = (CloudParticle*)next_iter->first;
+				next = (CloudParticle*)effect->particles[randint((int)effect->particles.size())];
 				if ((next != this) && (next != p))
 					break;
 			}
@@ -313,17 +295,14 @@ namespace ec
 		}
 
 		// Load one neighbor for each one.  It'll get more on its own.
-		for (std::map<Particle*, bool>::iterator iter = particles.begin(); iter
-			!= particles.end(); iter++)
+		for (int i = 0; i < (int)particles.size(); i++)
 		{
-			CloudParticle* p = (CloudParticle*)iter->first;
+			CloudParticle* p = (CloudParticle*)particles[i];
 			CloudParticle* next;
-			std::map<Particle*, bool>::iterator iter2 = iter;
-			iter2++;
-			if (iter2 != particles.end())
-				next = (CloudParticle*)iter2->first;
+			if (i + 1 < (int)particles.size())
+				next = (CloudParticle*)particles[i + 1];
 			else
-				next = (CloudParticle*)particles.begin()->first;
+				next = (CloudParticle*)particles[0];
 			p->neighbors.push_back(next);
 			next->add_incoming_neighbor(p);
 		}
@@ -351,7 +330,7 @@ namespace ec
 
 		if (particles.size())
 		{
-			CloudParticle* last = (CloudParticle*)(particles.rbegin()->first);
+			CloudParticle* last = (CloudParticle*)(particles.back());
 			for (int i = count - (int)particles.size(); i >= 0; i--)
 			{
 				Vec3 coords = spawner->get_new_coords();
@@ -391,17 +370,14 @@ namespace ec
 			}
 
 			// Load one neighbor for each one.  It'll get more on its own.
-			for (std::map<Particle*, bool>::iterator iter = particles.begin(); iter
-				!= particles.end(); iter++)
+			for (int i = 0; i < (int)particles.size(); i++)
 			{
-				CloudParticle* p = (CloudParticle*)iter->first;
+				CloudParticle* p = (CloudParticle*)particles[i];
 				CloudParticle* next;
-				std::map<Particle*, bool>::iterator iter2 = iter;
-				iter2++;
-				if (iter2 != particles.end())
-					next = (CloudParticle*)iter2->first;
+				if (i + 1 < (int)particles.size())
+					next = (CloudParticle*)particles[i + 1];
 				else
-					next = (CloudParticle*)particles.begin()->first;
+					next = (CloudParticle*)particles[0];
 				p->neighbors.push_back(next);
 				next->add_incoming_neighbor(p);
 			}
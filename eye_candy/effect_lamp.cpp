@@ -83,7 +83,7 @@ namespace ec
 		flare_max = 1.0;
 		flare_exp = 0.0;
 		flare_frequency = 2.0;
-		state = ((rand() % 3) == 0);
+		state = (randint(3) == 0);
 	}
 
 	bool LampBigParticle::idle(const Uint64 delta_t)
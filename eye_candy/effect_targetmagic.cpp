@@ -139,7 +139,7 @@ namespace ec
 					pos = pos * percent + cur_target * inv_percent;
 				}
 				((TargetMagicEffect*)effect)->effect_count++;
-				base->push_back_effect(new TargetMagicEffect2(base, (TargetMagicEffect*)effect, ((TargetMagicEffect*)effect)->targets[0], type, spawner2, mover2, ((TargetMagicEffect*)effect)->target_alpha, effect_id, LOD));
+				base->spawn_effect(effect, new TargetMagicEffect2(base, (TargetMagicEffect*)effect, ((TargetMagicEffect*)effect)->targets[0], type, spawner2, mover2, ((TargetMagicEffect*)effect)->target_alpha, effect_id, LOD));
 				return false;
 			}
 
@@ -288,7 +288,7 @@ namespace ec
 			(state == 2)) ||
 			(((type == TargetMagicEffect::HARM) ||
 			(type == TargetMagicEffect::SMITE_SUMMONED)) &&
-			(state) && (rand() & 1)))
+			(state) && randint(2)))
 		{
 			return 0.0f;
 		}
@@ -320,7 +320,7 @@ namespace ec
 			glDisable(GL_LIGHTING);
 		}
 		else if (((type == TargetMagicEffect::HARM) || (type
-			== TargetMagicEffect::SMITE_SUMMONED)) && (state) && (rand() & 1))
+			== TargetMagicEffect::SMITE_SUMMONED)) && (state) && randint(2))
 		{
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -861,6 +861,7 @@ namespace ec
 	{
 		base = _base;
 		effect = _effect;
+		mover_owner = _effect;
 		pos = _pos;
 		center = *pos;
 		type = _type;
@@ -1044,7 +1045,7 @@ namespace ec
 					coords += center;
 					coords.y += randcoord(10.0) + 8.0;
 					Particle* p;
-					if (rand() & 1)
+					if (randint(2))
 						p
 #ifdef	NEW_TEXTURES
 							= new TargetMagicParticle(this, mover, coords, velocity, 3.5 + randcoord(7.0), 0.5 + randalpha(0.3), 1.0, 1.0, 1.0, EC_SHIMMER, LOD, type, NULL, NULL, &center, effect_id, 1);
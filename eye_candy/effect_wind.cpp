@@ -37,7 +37,7 @@ namespace ec
 				value = 0.35 + randcolor(0.20);
 				size = 0.08 * scalar;
 				alpha = 1.0;
-				subtype = rand() % 3; // Store it in case we need it later -- say, for a texture.
+				subtype = randint(3); // Store it in case we need it later -- say, for a texture.
 				switch (subtype)
 				{
 					case 0: // Maple
@@ -209,7 +209,7 @@ namespace ec
 		{
 			velocity /= ((min_height - pos.y + 1.0) * 8);
 			pos.y = min_height;
-			if (!(rand() % 3))
+			if (!randint(3))
 				velocity.y = -velocity.y * 1.5;
 		}
 		else
@@ -270,9 +270,7 @@ namespace ec
 					state = 1;
 					return true;
 				}
-				effect->particles.erase(this);
-				effect = iter->neighbor;
-				effect->particles[this] = true;
+				base->transfer_particle(this, iter->neighbor);
 			}
 		}
 		else
@@ -494,8 +492,10 @@ namespace ec
 			* PI / 2000.0; // Translation: Convert to milliseconds, truncate the higher-order digits, convert to a float, make it wraparound in radians, and scale it down some.
 		const unsigned short individual_offset =
 			(unsigned short)(long)(void*)(this); // Based on the memory address in order to give each particle a unique bias.
-		srand(individual_offset);
+		const Uint32 saved_random_state = MathCache::get_random_state();
+		MathCache::set_random_state(individual_offset);
 		const float offset= randfloat() * 0.5;
+		MathCache::set_random_state(saved_random_state);
 
 		const coord_t x = 1.0 * sin(offset + pos.x * 0.5283 + pos.z * 0.7111
 			+ time_offset * 0.6817) * sin(offset + pos.x * 1.2019 + pos.z
@@ -3,6 +3,7 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include <errno.h>
+#include <algorithm>
 
 #include "eye_candy.h"
 #include "../platform.h"
@@ -91,6 +92,171 @@ namespace ec
 
 	const float MIN_SAFE_ALPHA = 0.02942f;
 
+	namespace
+	{
+
+		// Particle memory is handed out in size classes of 16 bytes.  Freed
+		// particles go onto the free list of their size class and are reused
+		// by the next particle of that size, so spell-heavy fights don't keep
+		// the heap busy.  The memory is never given back to the heap, so each
+		// size class keeps as much as its most particles alive at once.  The
+		// particle limit bounds that, but the size classes don't share it.
+		const size_t particle_pool_granularity = 16;
+		const size_t particle_pool_size_classes = 64;
+		const size_t particle_pool_block_count = 64;
+
+		struct ParticlePoolNode
+		{
+			ParticlePoolNode* next;
+		};
+
+		// Particles get spawned from the particle jobs, so every thread has
+		// its own free lists and only takes the lock of the shared ones to
+		// move particle_pool_block_count nodes at once.  A thread list holds
+		// at most twice that many nodes.
+		ParticlePoolNode* particle_pool_free_lists[particle_pool_size_classes];
+		SDL_mutex* particle_pool_mutex = NULL;
+		Uint64 particle_pool_lock_count = 0;
+		EC_THREAD_LOCAL ParticlePoolNode* particle_pool_thread_lists[particle_pool_size_classes];
+		EC_THREAD_LOCAL Uint32 particle_pool_thread_counts[particle_pool_size_classes];
+
+		size_t get_particle_pool_size_class(const size_t size)
+		{
+			return (size + particle_pool_granularity - 1)
+				/ particle_pool_granularity;
+		}
+
+		// Refills the empty list of this thread from the shared list, or
+		// from a new block if that is empty too.
+		void fill_particle_pool_thread_list(const size_t size_class)
+		{
+			ParticlePoolNode* first;
+			ParticlePoolNode* last;
+			Uint32 count;
+
+			SDL_LockMutex(particle_pool_mutex);
+			particle_pool_lock_count++;
+
+			first = particle_pool_free_lists[size_class];
+
+			if (first == NULL)
+			{
+				SDL_UnlockMutex(particle_pool_mutex);
+
+				const size_t node_size = size_class * particle_pool_granularity;
+				char* block = static_cast<char*>(::operator new(node_size
+					* particle_pool_block_count));
+
+				for (size_t i = 0; i < particle_pool_block_count; i++)
+				{
+					ParticlePoolNode* node =
+						reinterpret_cast<ParticlePoolNode*>(block + i * node_size);
+					node->next = particle_pool_thread_lists[size_class];
+					particle_pool_thread_lists[size_class] = node;
+				}
+				particle_pool_thread_counts[size_class] = particle_pool_block_count;
+				return;
+			}
+
+			last = first;
+			for (count = 1; (count < particle_pool_block_count) && (last->next != NULL); count++)
+				last = last->next;
+
+			particle_pool_free_lists[size_class] = last->next;
+
+			SDL_UnlockMutex(particle_pool_mutex);
+
+			last->next = NULL;
+			particle_pool_thread_lists[size_class] = first;
+			particle_pool_thread_counts[size_class] = count;
+		}
+
+		// Hands particle_pool_block_count nodes of the full list of this
+		// thread back to the shared list.
+		void drain_particle_pool_thread_list(const size_t size_class)
+		{
+			ParticlePoolNode* first = particle_pool_thread_lists[size_class];
+			ParticlePoolNode* last = first;
+
+			for (size_t i = 1; i < particle_pool_block_count; i++)
+				last = last->next;
+
+			particle_pool_thread_lists[size_class] = last->next;
+			particle_pool_thread_counts[size_class] -= particle_pool_block_count;
+
+			SDL_LockMutex(particle_pool_mutex);
+			particle_pool_lock_count++;
+
+			last->next = particle_pool_free_lists[size_class];
+			particle_pool_free_lists[size_class] = first;
+
+			SDL_UnlockMutex(particle_pool_mutex);
+		}
+
+		// Movers get the force gradients of the particles of an effect in
+		// batches of this size, without a virtual call per particle.
+		const Uint32 particle_batch_size = 64;
+
+		// What the jobs of EyeCandy::idle() work on.  The particle jobs handle
+		// the effects from group_starts[i] to group_starts[i + 1], the buffer
+		// jobs only effects[i].
+		struct EffectJobData
+		{
+			Effect* const * effects;
+			const Uint32* group_starts;
+			Uint64 usec;
+			Uint32 frame;
+		};
+
+		// Each job draws its random numbers from a state that only depends
+		// on the frame and the job, and leaves the thread's own state alone.
+		Uint32 get_job_random_state(const EffectJobData* job_data,
+			const Uint32 index)
+		{
+			return (job_data->frame * 2654435761u)
+				^ ((index + 1) * 2246822519u);
+		}
+
+		void idle_effect_particles(void* data, const Uint32 index)
+		{
+			const EffectJobData* job_data =
+				static_cast<const EffectJobData*>(data);
+			const Uint32 random_state = MathCache::get_random_state();
+			Uint32 i;
+
+			MathCache::set_random_state(get_job_random_state(job_data,
+				index));
+
+			for (i = job_data->group_starts[index];
+				i < job_data->group_starts[index + 1]; i++)
+			{
+				Effect* e = job_data->effects[i];
+
+				e->move_particles(job_data->usec);
+				e->idle_particles(job_data->usec);
+			}
+
+			MathCache::set_random_state(random_state);
+		}
+
+#ifdef	NEW_TEXTURES
+		void fill_effect_particle_buffer(void* data, const Uint32 index)
+		{
+			const EffectJobData* job_data =
+				static_cast<const EffectJobData*>(data);
+			const Uint32 random_state = MathCache::get_random_state();
+
+			MathCache::set_random_state(~get_job_random_state(job_data,
+				index));
+
+			job_data->effects[index]->fill_particle_buffer(job_data->usec);
+
+			MathCache::set_random_state(random_state);
+		}
+#endif	/* NEW_TEXTURES */
+
+	}
+
 	// G L O B A L S //////////////////////////////////////////////////////////////
 
 	MathCache math_cache;
@@ -235,10 +401,8 @@ namespace ec
 		particle_count++;
 	}
 
-	void Effect::build_particle_buffer(const Uint64 time_diff)
+	bool Effect::map_particle_buffer()
 	{
-		std::map<Particle*, bool>::const_iterator iter;
-		const Vec3 center(base->center);
 		Uint32 size;
 
 		particle_count = 0;
@@ -247,7 +411,9 @@ namespace ec
 
 		if (particle_max_count == 0)
 		{
-			return;
+			buffer = 0;
+
+			return false;
 		}
 
 		particle_max_count = (particle_max_count + 0xF) & 0xFFFFFFF0;
@@ -266,11 +432,26 @@ namespace ec
 		buffer = static_cast<float*>(particle_vertex_buffer.map(
 			el::btt_vertex, el::hbat_write_only));
 
+		return buffer != 0;
+	}
+
+	// Only touches the mapped memory, so the effects can fill their buffers
+	// in parallel.
+	void Effect::fill_particle_buffer(const Uint64 time_diff)
+	{
+		std::vector<Particle*>::const_iterator iter;
+		const Vec3 center(base->center);
+
+		if (buffer == 0)
+		{
+			return;
+		}
+
 		if (bounds)
 		{
 			for (iter = particles.begin(); iter != particles.end(); iter++)
 			{
-				Particle* p = iter->first;
+				Particle* p = *iter;
 				const coord_t dist_squared = (p->pos - center).magnitude_squared();
 				if (dist_squared < MAX_DRAW_DISTANCE_SQUARED)
 					p->draw(time_diff);
@@ -280,12 +461,18 @@ namespace ec
 		{
 			for (iter = particles.begin(); iter != particles.end(); iter++)
 			{
-				Particle* p = iter->first;
+				Particle* p = *iter;
 				p->draw(time_diff);
 			}
 		}
+	}
 
+	void Effect::unmap_particle_buffer()
+	{
+		particle_vertex_buffer.bind(el::btt_vertex);
 		particle_vertex_buffer.unmap(el::btt_vertex);
+
+		buffer = 0;
 	}
 
 	void Effect::draw_particle_buffer()
@@ -326,6 +513,49 @@ namespace ec
 	}
 #endif	/* NEW_TEXTURES */
 
+	void Effect::move_particles(const Uint64 usec)
+	{
+		const Uint32 count = particles.size();
+		Uint32 start, end;
+
+		// Particles of an effect mostly share one mover, so each run of
+		// particles with the same mover is moved as one batch.
+		for (start = 0; start < count; start = end)
+		{
+			ParticleMover* mover = particles[start]->mover;
+
+			for (end = start + 1; end < count; end++)
+			{
+				if (particles[end]->mover != mover)
+					break;
+			}
+
+			mover->move_particles(&particles[start], end - start, usec);
+		}
+	}
+
+	// Runs as one of the particle jobs, so adding, deleting and transferring
+	// particles only gets queued here.  Dead particles still leave the list
+	// of the effect at once, since the particles idled after them may pick
+	// other particles from it (clouds pick their neighbors there).  The list
+	// only belongs to the job of this effect.
+	void Effect::idle_particles(const Uint64 usec)
+	{
+		for (Uint32 i = 0; i < particles.size(); )
+		{
+			Particle* p = particles[i];
+
+			if (p->idle(usec))
+			{
+				i++;
+				continue;
+			}
+
+			unregister_particle(p); // The last particle is now at i.
+			deleted_particles.push_back(p);
+		}
+	}
+
 	Shape::~Shape()
 	{
 #ifndef	NEW_TEXTURES
@@ -370,9 +600,9 @@ namespace ec
 
 		if (base->poor_transparency_resolution)
 #ifdef X86_64
-			srand((Uint32)(Uint64)(void*)this);
+			MathCache::set_random_state((Uint32)(Uint64)(void*)this);
 #else
-			srand((Uint32)(void*)this);
+			MathCache::set_random_state((Uint32)(void*)this);
 #endif
 		glBegin(GL_TRIANGLES);
 		{
@@ -1320,6 +1550,58 @@ namespace ec
 		born = get_time();
 		mover->attachParticle(this);
 		size = _size;
+		index = 0;
+		effect_index = 0;
+	}
+
+	void* Particle::operator new(size_t size)
+	{
+		const size_t size_class = get_particle_pool_size_class(size);
+
+		if (size_class >= particle_pool_size_classes)
+			return ::operator new(size);
+
+		if (particle_pool_thread_lists[size_class] == NULL)
+			fill_particle_pool_thread_list(size_class);
+
+		ParticlePoolNode* node = particle_pool_thread_lists[size_class];
+		particle_pool_thread_lists[size_class] = node->next;
+		particle_pool_thread_counts[size_class]--;
+
+		return node;
+	}
+
+	void Particle::operator delete(void* ptr, size_t size)
+	{
+		const size_t size_class = get_particle_pool_size_class(size);
+
+		if (ptr == NULL)
+			return;
+
+		if (size_class >= particle_pool_size_classes)
+		{
+			::operator delete(ptr);
+			return;
+		}
+
+		ParticlePoolNode* node = static_cast<ParticlePoolNode*>(ptr);
+		node->next = particle_pool_thread_lists[size_class];
+		particle_pool_thread_lists[size_class] = node;
+		particle_pool_thread_counts[size_class]++;
+
+		if (particle_pool_thread_counts[size_class] > 2 * particle_pool_block_count)
+			drain_particle_pool_thread_list(size_class);
+	}
+
+	Uint64 Particle::get_pool_lock_count()
+	{
+		Uint64 result;
+
+		SDL_LockMutex(particle_pool_mutex);
+		result = particle_pool_lock_count;
+		SDL_UnlockMutex(particle_pool_mutex);
+
+		return result;
 	}
 
 	Particle::~Particle()
@@ -1608,8 +1890,13 @@ namespace ec
 
 	void GradientMover::move(Particle& p, Uint64 usec)
 	{
-		const coord_t scalar = usec / 1000000.0;
-		Vec3 gradient_velocity = p.velocity + get_force_gradient(p) * scalar;
+		move_with_gradient(p, get_force_gradient(p), usec / 1000000.0);
+	}
+
+	void GradientMover::move_with_gradient(Particle& p,
+		const Vec3& force_gradient, const coord_t scalar)
+	{
+		Vec3 gradient_velocity = p.velocity + force_gradient * scalar;
 		if (gradient_velocity.magnitude_squared() > 10000.0)
 			gradient_velocity.normalize(100.0);
 		p.velocity = gradient_velocity + get_obstruction_gradient(p) * scalar;
@@ -1621,16 +1908,55 @@ namespace ec
 		p.pos += p.velocity * scalar;
 	}
 
+	void ParticleMover::move_particles(Particle* const * particles,
+		const Uint32 count, const Uint64 usec)
+	{
+		for (Uint32 i = 0; i < count; i++)
+			move(*particles[i], usec);
+	}
+
+	void GradientMover::move_particles(Particle* const * particles,
+		const Uint32 count, const Uint64 usec)
+	{
+		Vec3 gradients[particle_batch_size];
+		const coord_t scalar = usec / 1000000.0;
+
+		for (Uint32 start = 0; start < count; start += particle_batch_size)
+		{
+			const Uint32 size = std::min(count - start, particle_batch_size);
+			Particle* const * batch_particles = particles + start;
+
+			get_force_gradients(batch_particles, size, gradients);
+
+			for (Uint32 i = 0; i < size; i++)
+				move_with_gradient(*batch_particles[i], gradients[i], scalar);
+		}
+	}
+
 	Vec3 GradientMover::get_force_gradient(Particle& p) const
 	{
 		return Vec3(0.0, 0.0, 0.0);
 	}
 
+	void GradientMover::get_force_gradients(Particle* const * particles,
+		const Uint32 count, Vec3* gradients) const
+	{
+		for (Uint32 i = 0; i < count; i++)
+			gradients[i] = get_force_gradient(*particles[i]);
+	}
+
 	Vec3 SmokeMover::get_force_gradient(Particle& p) const
 	{
 		return Vec3(0.0, 0.2 * strength, 0.0);
 	}
 
+	void SmokeMover::get_force_gradients(Particle* const * particles,
+		const Uint32 count, Vec3* gradients) const
+	{
+		std::fill(gradients, gradients + count, Vec3(0.0, 0.2 * strength,
+			0.0));
+	}
+
 	Vec3 SpiralMover::get_force_gradient(Particle& p) const
 	{
 		Vec3 shifted_pos = p.pos - *center;
@@ -1638,6 +1964,20 @@ namespace ec
 			0.0, shifted_pos.x * spiral_speed - shifted_pos.z * pinch_rate);
 	}
 
+	void SpiralMover::get_force_gradients(Particle* const * particles,
+		const Uint32 count, Vec3* gradients) const
+	{
+		const Vec3 spiral_center = *center;
+
+		for (Uint32 i = 0; i < count; i++)
+		{
+			const Vec3 shifted_pos = particles[i]->pos - spiral_center;
+			gradients[i] = Vec3(shifted_pos.z * spiral_speed - shifted_pos.x
+				* pinch_rate, 0.0, shifted_pos.x * spiral_speed
+				- shifted_pos.z * pinch_rate);
+		}
+	}
+
 	coord_t PolarCoordsBoundingRange::get_radius(const angle_t angle) const
 	{
 		float radius = 0.0;
@@ -1703,6 +2043,12 @@ namespace ec
 		return Vec3(0.0, -1.6, 0.0);
 	}
 
+	void SimpleGravityMover::get_force_gradients(Particle* const * particles,
+		const Uint32 count, Vec3* gradients) const
+	{
+		std::fill(gradients, gradients + count, Vec3(0.0, -1.6, 0.0));
+	}
+
 	Vec3 GradientMover::get_obstruction_gradient(Particle& p) const
 	{ //Unlike normal force gradients, obstruction gradients are used in a magnitude-preserving fashion.
 		Vec3 ret(0.0, 0.0, 0.0);
@@ -1808,6 +2154,13 @@ namespace ec
 		p.velocity = obstruction_velocity;
 	}
 
+	void GravityMover::move_particles(Particle* const * particles,
+		const Uint32 count, const Uint64 usec)
+	{
+		for (Uint32 i = 0; i < count; i++)
+			GravityMover::move(*particles[i], usec);
+	}
+
 	energy_t GravityMover::calculate_velocity_energy(const Particle& p) const
 	{
 		return 0.5 * p.velocity.magnitude_squared();
@@ -2085,6 +2438,12 @@ namespace ec
 		poor_transparency_resolution = false;
 #endif	/* NEW_TEXTURES */
 		draw_shapes = true;
+		frame_count = 0;
+		particle_job_room = 0;
+		job_runner = NULL;
+		particle_jobs_running = false;
+		if (particle_pool_mutex == NULL)
+			particle_pool_mutex = SDL_CreateMutex();
 	}
 
 	EyeCandy::EyeCandy(int _max_particles)
@@ -2110,6 +2469,12 @@ namespace ec
 		poor_transparency_resolution = false;
 #endif	/* NEW_TEXTURES */
 		draw_shapes = true;
+		frame_count = 0;
+		particle_job_room = 0;
+		job_runner = NULL;
+		particle_jobs_running = false;
+		if (particle_pool_mutex == NULL)
+			particle_pool_mutex = SDL_CreateMutex();
 	}
 
 	EyeCandy::~EyeCandy()
@@ -2396,15 +2761,45 @@ namespace ec
 		effects.push_back(e);
 	}
 
+	void EyeCandy::spawn_effect(Effect* parent, Effect* e)
+	{
+		if (particle_jobs_running)
+		{
+			// Other jobs may read the effect list, so the new effect (and the
+			// particles its constructor spawned) joins it when merging.
+			parent->spawned_effects.push_back(e);
+			return;
+		}
+
+		push_back_effect(e);
+	}
+
 	bool EyeCandy::push_back_particle(Particle* p)
 	{
-		if /*(*/((int)particles.size() >= max_particles)/* || (!allowable_particles_to_add))*/
+		if (particle_jobs_running)
+		{
+			// Particles spawned in a job belong to one of the effects of the
+			// job or to an effect the job just created with spawn_effect(),
+			// so no other job touches the list.  No effect may queue more
+			// than the room left before the jobs started; the merge checks
+			// the limit for all of them together.
+			if ((int)p->effect->spawned_particles.size() >= particle_job_room)
+			{
+				delete p;
+				return false;
+			}
+
+			p->effect->spawned_particles.push_back(p);
+			return true;
+		}
+		else if /*(*/((int)particles.size() >= max_particles)/* || (!allowable_particles_to_add))*/
 		{
 			delete p;
 			return false;
 		}
 		else
 		{
+			p->index = particles.size();
 			particles.push_back(p);
 			p->effect->register_particle(p);
 			light_estimate += p->estimate_light_level();
@@ -2413,6 +2808,68 @@ namespace ec
 		}
 	}
 
+	void EyeCandy::delete_particle(Particle* p)
+	{
+		p->effect->unregister_particle(p);
+		delete_unregistered_particle(p);
+	}
+
+	void EyeCandy::delete_unregistered_particle(Particle* p)
+	{
+		// Swap the last particle into the hole instead of shifting the rest.
+		Particle* last = particles.back();
+
+		particles[p->index] = last;
+		last->index = p->index;
+		particles.pop_back();
+
+		for (int j = 0; j < (int)light_particles.size(); )
+		{
+			std::vector< std::pair<Particle*, light_t> >::iterator iter2 = light_particles.begin() + j;
+			if (iter2->first == p)
+			{
+				light_particles.erase(iter2);
+				continue;
+			}
+			j++;
+		}
+		light_estimate -= p->estimate_light_level();
+		delete p;
+	}
+
+	void EyeCandy::transfer_particle(Particle* p, Effect* e)
+	{
+		if (particle_jobs_running)
+		{
+			p->effect->transferred_particles.push_back(std::pair<Particle*, Effect*>(p, e));
+			return;
+		}
+
+		p->effect->unregister_particle(p);
+		p->effect = e;
+		e->register_particle(p);
+	}
+
+	void EyeCandy::merge_spawned_particles(Effect* e)
+	{
+		for (std::vector<Particle*>::iterator iter = e->spawned_particles.begin(); iter != e->spawned_particles.end(); iter++)
+			push_back_particle(*iter);
+
+		e->spawned_particles.clear();
+	}
+
+	void EyeCandy::run_jobs(void (*job)(void* data, const Uint32 index), void* data, const Uint32 count)
+	{
+		if ((job_runner != NULL) && (count > 1))
+		{
+			job_runner->run(job, data, count);
+			return;
+		}
+
+		for (Uint32 i = 0; i < count; i++)
+			job(data, i);
+	}
+
 	void EyeCandy::start_draw()
 	{
 		glDisable(GL_LIGHTING);
@@ -2536,9 +2993,9 @@ namespace ec
 			// Draw particles
 			if (e->bounds)
 			{
-				for (std::map<Particle*, bool>::const_iterator iter2 = (*iter)->particles.begin(); iter2 != (*iter)->particles.end(); iter2++)
+				for (std::vector<Particle*>::const_iterator iter2 = (*iter)->particles.begin(); iter2 != (*iter)->particles.end(); iter2++)
 				{
-					Particle* p = iter2->first;
+					Particle* p = *iter2;
 					const coord_t dist_squared = (p->pos - center).magnitude_squared();
 					if (dist_squared < MAX_DRAW_DISTANCE_SQUARED)
 						p->draw(time_diff);
@@ -2546,9 +3003,9 @@ namespace ec
 			}
 			else
 			{
-				for (std::map<Particle*, bool>::const_iterator iter2 = (*iter)->particles.begin(); iter2 != (*iter)->particles.end(); iter2++)
+				for (std::vector<Particle*>::const_iterator iter2 = (*iter)->particles.begin(); iter2 != (*iter)->particles.end(); iter2++)
 				{
-					Particle* p = iter2->first;
+					Particle* p = *iter2;
 					p->draw(time_diff);
 				}
 			}
@@ -2782,11 +3239,10 @@ namespace ec
 			const float particle_cleanout_rate = (1.0 - std::pow(0.5f, 5.0f / (framerate * square(change_LOD))));
 			//  std::cout << (1.0 / particle_cleanout_rate) << std::endl;
 			float counter = randfloat();
-			for (int i = 0; i < (int)particles.size(); ) //Iterate using an int, not an iterator, because we may be adding/deleting entries, and that messes up iterators.
+			for (int i = 0; i < (int)particles.size(); ) //Iterate using an int, not an iterator, because we may be deleting entries.
 
 			{
-				std::vector<Particle*>::iterator iter = particles.begin() + i;
-				Particle* p = *iter;
+				Particle* p = particles[i];
 
 				counter -= particle_cleanout_rate;
 				if (counter < 0) // Kill off a random particle.
@@ -2795,74 +3251,105 @@ namespace ec
 					counter++;
 					if ((p->deletable()) && (!p->effect->active))
 					{
-						particles.erase(iter);
-						for (int j = 0; j < (int)light_particles.size(); )
-						{
-							std::vector< std::pair<Particle*, light_t> >::iterator iter2 = light_particles.begin() + j;
-							if (iter2->first == p)
-							{
-								light_particles.erase(iter2);
-								continue;
-							}
-							j++;
-						}
-						p->effect->unregister_particle(p);
-						light_estimate -= p->estimate_light_level();
-						delete p;
+						delete_particle(p); // The last particle is now at i.
+						continue;
 					}
-
-					i++;
-					continue;
 				}
 
-				if ((!p->effect->active) && (!p->effect->recall))
+				i++;
+			}
+
+			// Move and idle the particles of each effect as one job.  The jobs
+			// only queue up particles to add, delete or hand to other effects;
+			// that gets merged afterwards in effect order, so the result
+			// doesn't depend on how the jobs got scheduled.  Effects that use
+			// the movers of another effect share its job, since moving
+			// updates mover state.
+			const Uint32 no_job_group = 0xFFFFFFFF;
+			Uint32 job_group_count = 0;
+
+			for (std::vector<Effect*>::iterator iter = effects.begin(); iter != effects.end(); iter++)
+			(*iter)->job_group = no_job_group;
+			for (std::vector<Effect*>::iterator iter = effects.begin(); iter != effects.end(); iter++)
+			{
+				Effect* e = *iter;
+
+				if ((!e->active) && (!e->recall))
+				continue;
+
+				Effect* owner = (e->mover_owner != NULL) ? e->mover_owner : e;
+				if (owner->job_group == no_job_group)
 				{
-					i++;
-					continue;
+					owner->job_group = job_group_count++;
+					if (job_groups.size() < job_group_count)
+					job_groups.resize(job_group_count);
+					job_groups[owner->job_group].clear();
 				}
+				job_groups[owner->job_group].push_back(e);
+			}
 
-				p->mover->move(*p, time_diff);
-				const bool ret = p->idle(time_diff);
-				if (!ret)
+			job_effects.clear();
+			job_group_starts.clear();
+			for (Uint32 i = 0; i < job_group_count; i++)
+			{
+				job_group_starts.push_back(job_effects.size());
+				job_effects.insert(job_effects.end(), job_groups[i].begin(), job_groups[i].end());
+			}
+			job_group_starts.push_back(job_effects.size());
+
+			EffectJobData job_data;
+			job_data.effects = job_effects.empty() ? NULL : &job_effects[0];
+			job_data.group_starts = &job_group_starts[0];
+			job_data.usec = time_diff;
+			job_data.frame = ++frame_count;
+
+			particle_job_room = max_particles - (int)particles.size();
+			particle_jobs_running = true;
+			run_jobs(idle_effect_particles, &job_data, job_group_count);
+			particle_jobs_running = false;
+
+			for (std::vector<Effect*>::iterator iter = job_effects.begin(); iter != job_effects.end(); iter++)
+			{
+				Effect* e = *iter;
+
+				for (std::vector< std::pair<Particle*, Effect*> >::iterator iter2 = e->transferred_particles.begin(); iter2 != e->transferred_particles.end(); iter2++)
+				transfer_particle(iter2->first, iter2->second);
+				for (std::vector<Particle*>::iterator iter2 = e->deleted_particles.begin(); iter2 != e->deleted_particles.end(); iter2++)
+				delete_unregistered_particle(*iter2);
+				merge_spawned_particles(e);
+				for (std::vector<Effect*>::iterator iter2 = e->spawned_effects.begin(); iter2 != e->spawned_effects.end(); iter2++)
 				{
-					iter = particles.begin() + i; //Why the heck do I need to redo this just because I've push_back'ed entries to the vector in idle()?  :P  Makes no sense.  My best guess: array resizing.
-					particles.erase(iter);
-					for (int j = 0; j < (int)light_particles.size(); )
-					{
-						std::vector< std::pair<Particle*, light_t> >::iterator iter2 = light_particles.begin() + j;
-						if (iter2->first == p)
-						{
-							light_particles.erase(iter2);
-							continue;
-						}
-						j++;
-					}
-					p->effect->unregister_particle(p);
-					light_estimate -= p->estimate_light_level();
-					delete p;
+					push_back_effect(*iter2);
+					merge_spawned_particles(*iter2);
 				}
-				else
-				i++;
+
+				e->transferred_particles.clear();
+				e->deleted_particles.clear();
+				e->spawned_effects.clear();
 			}
 			last_forced_LOD = (Uint16)round(change_LOD);
 
 			//  allowable_particles_to_add = 1 + (int)(particles.size() * 0.00005 * time_diff / 1000000.0 * (max_particles - particles.size()) * change_LOD);
 			//  std::cout << "Current: " << particles.size() << "; Allowable new: " << allowable_particles_to_add << std::endl;
 #ifdef	NEW_TEXTURES
-			Uint32 i, count;
-
-			count = effects.size();
-
-			for (i = 0; i < count; i++)
+			// Mapping the buffers needs the GL context, so only the filling
+			// runs as jobs.
+			job_effects.clear();
+			for (std::vector<Effect*>::iterator iter = effects.begin(); iter != effects.end(); iter++)
 			{
-				Effect* e = effects[i];
+				Effect* e = *iter;
 
-				if (e->active)
-				{
-					e->build_particle_buffer(time_diff);
-				}
+				if (e->active && e->map_particle_buffer())
+				job_effects.push_back(e);
 			}
 
+			job_data.effects = job_effects.empty() ? NULL : &job_effects[0];
+
+			run_jobs(fill_effect_particle_buffer, &job_data, job_effects.size());
+
+			for (std::vector<Effect*>::iterator iter = job_effects.begin(); iter != job_effects.end(); iter++)
+			(*iter)->unmap_particle_buffer();
+
 			el::HardwareBuffer::unbind(el::btt_index);
 			el::HardwareBuffer::unbind(el::btt_vertex);
 #endif	/* NEW_TEXTURES */
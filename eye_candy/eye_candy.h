@@ -1053,6 +1053,13 @@ namespace ec
 				const Vec3 _velocity, const coord_t _size = 1.0f);
 			virtual ~Particle();
 
+			// Particles are small, short-lived and created by the thousands,
+			// so they come from per size free lists instead of the heap.
+			static void* operator new(size_t size);
+			static void operator delete(void* ptr, size_t size);
+			// How often a thread had to lock the shared free lists.
+			static Uint64 get_pool_lock_count();
+
 			virtual bool idle(const Uint64 delta_t) = 0;
 #ifdef	NEW_TEXTURES
 			virtual Uint32 get_texture() = 0;
@@ -1100,6 +1107,8 @@ namespace ec
 
 			ParticleHistory* motion_blur;
 			int cur_motion_blur_point;
+			Uint32 index; // Position in EyeCandy::particles
+			Uint32 effect_index; // Position in Effect::particles
 
 	};
 
@@ -1129,6 +1138,9 @@ namespace ec
 				return 0;
 			}
 			;
+			// Moves a batch of particles that all use this mover.
+			virtual void move_particles(Particle* const * particles,
+				const Uint32 count, const Uint64 usec);
 
 			Vec3 vec_shift(const Vec3 src, const Vec3 dest,
 				const percent_t percent) const;
@@ -1169,8 +1181,15 @@ namespace ec
 			;
 
 			virtual void move(Particle& p, Uint64 usec);
+			virtual void move_particles(Particle* const * particles,
+				const Uint32 count, const Uint64 usec);
+			// What move() does once the force gradient is known.
+			void move_with_gradient(Particle& p, const Vec3& force_gradient,
+				const coord_t scalar);
 
 			virtual Vec3 get_force_gradient(Particle& p) const;
+			virtual void get_force_gradients(Particle* const * particles,
+				const Uint32 count, Vec3* gradients) const;
 			virtual Vec3 get_obstruction_gradient(Particle& p) const;
 	};
 
@@ -1199,6 +1218,8 @@ namespace ec
 
 			//  virtual void move(Particle& p, Uint64 usec);
 			virtual Vec3 get_force_gradient(Particle& p) const;
+			virtual void get_force_gradients(Particle* const * particles,
+				const Uint32 count, Vec3* gradients) const;
 
 			coord_t strength;
 	};
@@ -1228,6 +1249,8 @@ namespace ec
 			;
 
 			virtual Vec3 get_force_gradient(Particle& p) const;
+			virtual void get_force_gradients(Particle* const * particles,
+				const Uint32 count, Vec3* gradients) const;
 
 			Vec3* center;
 			coord_t spiral_speed;
@@ -1336,6 +1359,8 @@ namespace ec
 			;
 
 			virtual Vec3 get_force_gradient(Particle& p) const;
+			virtual void get_force_gradients(Particle* const * particles,
+				const Uint32 count, Vec3* gradients) const;
 	};
 
 	/*!
@@ -1364,6 +1389,8 @@ namespace ec
 
 			void set_gravity_center(Vec3* _gravity_center);
 			virtual void move(Particle& p, Uint64 usec);
+			virtual void move_particles(Particle* const * particles,
+				const Uint32 count, const Uint64 usec);
 			energy_t calculate_velocity_energy(const Particle& p) const;
 			energy_t calculate_position_energy(const Particle& p) const;
 			coord_t gravity_dist(const Particle& p, const Vec3& center) const;
@@ -2042,6 +2069,8 @@ namespace ec
 				active = true;
 				obstructions = &null_obstructions;
 				bounds = NULL;
+				mover_owner = NULL;
+				job_group = 0;
 #ifdef	NEW_TEXTURES
 				particle_max_count = 0;
 				particle_count = 0;
@@ -2061,32 +2090,41 @@ namespace ec
 				const color_t g, const color_t b,
 				const alpha_t alpha, const Vec3 pos,
 				const alpha_t burn);
-			void build_particle_buffer(const Uint64 time_diff);
+			bool map_particle_buffer();
+			void fill_particle_buffer(const Uint64 time_diff);
+			void unmap_particle_buffer();
 			void draw_particle_buffer();
 #endif	/* NEW_TEXTURES */
 
 			void register_particle(Particle* p)
 			{
-				particles[p] = true;
+				p->effect_index = particles.size();
+				particles.push_back(p);
 			}
 			;
 			void unregister_particle(Particle* p)
 			{
-				particles.erase(particles.find(p));
+				Particle* last = particles.back();
+
+				particles[p->effect_index] = last;
+				last->effect_index = p->effect_index;
+				particles.pop_back();
 			}
 			;
+			void move_particles(const Uint64 usec);
+			void idle_particles(const Uint64 usec);
 
 			virtual EffectEnum get_type() = 0;
 			virtual bool idle(const Uint64 usec) = 0;
 			virtual void draw(const Uint64 usec)
 			{
-				for (std::map<Particle*, bool>::iterator iter2 =
+				for (std::vector<Particle*>::iterator iter2 =
 					particles.begin(); iter2 != particles.end(); iter2++)
 				{
 					for (std::vector<Obstruction*>::iterator iter =
 						obstructions->begin(); iter != obstructions->end(); iter++)
 					{
-						(*iter)->get_force_gradient(*(iter2->first));
+						(*iter)->get_force_gradient(**iter2);
 					}
 				}
 			}
@@ -2131,7 +2169,14 @@ namespace ec
 			bool* dead; //Provided by the effect caller; set when this effect is going away.
 			Vec3* pos;
 			std::vector<Obstruction*>* obstructions;
-			std::map<Particle*, bool> particles;
+			std::vector<Particle*> particles; // Unordered, removal swaps in the last one
+			// Filled while the particle jobs run, merged by EyeCandy::idle() afterwards.
+			std::vector<Particle*> spawned_particles;
+			std::vector<Particle*> deleted_particles;
+			std::vector< std::pair<Particle*, Effect*> > transferred_particles;
+			std::vector<Effect*> spawned_effects;
+			Effect* mover_owner; // Set if the particles use the movers of that effect.
+			Uint32 job_group;
 			BoundingRange* bounds;
 			bool active;
 			bool recall;
@@ -2146,6 +2191,24 @@ namespace ec
 #endif	/* NEW_TEXTURES */
 		};
 
+		/*!
+		 \brief Runs the per effect jobs of EyeCandy::idle()
+
+		 Eye candy doesn't know about any thread pool, so the caller hands in a
+		 runner.  Without one, the jobs run one after another.
+		 */
+		class JobRunner
+		{
+			public:
+			virtual ~JobRunner()
+			{
+			}
+			;
+
+			// Calls job(data, i) for every i < count, returns when all are done.
+			virtual void run(void (*job)(void* data, const Uint32 index), void* data, const Uint32 count) = 0;
+		};
+
 		/*!
 		 \brief The core object of all eye candy
 
@@ -2186,7 +2249,13 @@ namespace ec
 #endif	/* NEW_TEXTURES */
 			void load_textures();
 			void push_back_effect(Effect* e);
+			void spawn_effect(Effect* parent, Effect* e); // Use this from particle idles.
 			bool push_back_particle(Particle* p);
+			void delete_particle(Particle* p);
+			void delete_unregistered_particle(Particle* p); // For particles already taken out of their effect.
+			void transfer_particle(Particle* p, Effect* e);
+			void set_job_runner(JobRunner* _job_runner)
+			{	job_runner = _job_runner;};
 			void set_camera(const Vec3& _camera)
 			{	camera = _camera;};
 			void set_center(const Vec3& _center)
@@ -2280,6 +2349,17 @@ namespace ec
 			std::vector<Effect*> effects;
 			std::vector<Particle*> particles;
 			std::vector<GLenum> lights;
+			JobRunner* job_runner;
+			Uint32 frame_count; // Seeds the random numbers of the particle jobs.
+			bool particle_jobs_running; // Defers adding, deleting and transferring particles.
+			int particle_job_room; // Particles that could still be added when the jobs started.
+			std::vector<Effect*> job_effects;
+			std::vector< std::vector<Effect*> > job_groups;
+			std::vector<Uint32> job_group_starts;
+
+			protected:
+			void merge_spawned_particles(Effect* e);
+			void run_jobs(void (*job)(void* data, const Uint32 index), void* data, const Uint32 count);
 		};
 
 		extern bool ec_error_status;
@@ -11,6 +11,8 @@ const float PI = 3.141592654;
 namespace ec
 {
 
+	EC_THREAD_LOCAL Uint32 random_state = 2463534242u;
+
 	// C L A S S   F U N C T I O N S //////////////////////////////////////////////
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -33,9 +33,22 @@
 
 #include "types.h"
 
+#ifdef _MSC_VER
+#define EC_THREAD_LOCAL __declspec(thread)
+#else
+#define EC_THREAD_LOCAL __thread
+#endif
+
 namespace ec
 {
 
+	// The random numbers come from a xorshift generator with one state per
+	// thread instead of rand().  rand() takes a lock in glibc and starts
+	// unseeded in every thread with the Windows CRT.  The particle jobs of
+	// EyeCandy::idle() seed the state from the frame and the effect, so what a
+	// job draws doesn't depend on the thread that runs it.
+	extern EC_THREAD_LOCAL Uint32 random_state;
+
 	// C L A S S E S //////////////////////////////////////////////////////////////
 
 	/*
@@ -115,21 +128,47 @@ namespace ec
 	{
 		public:
 
+			static Uint32 get_random_state()
+			{
+				return random_state;
+			}
+			;
+
+			static void set_random_state(const Uint32 state)
+			{
+				// Zero is the one state xorshift never leaves.
+				random_state = state != 0 ? state : 2463534242u;
+			}
+			;
+
+			static Uint32 randuint()
+			{
+				Uint32 x = random_state;
+
+				x ^= x << 13;
+				x ^= x >> 17;
+				x ^= x << 5;
+				random_state = x;
+
+				return x;
+			}
+			;
+
 			static int randint(const int upto)
 			{
-				return rand() % upto;
+				return (randuint() >> 1) % upto;
 			}
 			;
 
 			static double randdouble()
 			{
-				return (double)rand() / (double)RAND_MAX;
+				return (double)randuint() / 4294967295.0;
 			}
 			;
 
 			static float randfloat()
 			{
-				return (float)rand() / (float)RAND_MAX;
+				return (float)(randuint() >> 8) / 16777215.0f;
 			}
 			;
 
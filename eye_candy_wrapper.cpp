@@ -16,6 +16,12 @@
 #include "skeletons.h"
 #include "tiles.h"
 #include "weather.h"
+#ifndef MAP_EDITOR
+#include "asc.h"
+#include "colors.h"
+#include "engine.h"
+#include "text.h"
+#endif //!MAP_EDITOR
 // G L O B A L S //////////////////////////////////////////////////////////////
 
 #ifdef MAP_EDITOR
@@ -63,6 +69,21 @@ volatile bool idle_semaphore = false;
 
 float average_framerate = 20000.0; // Windows has such horrible timer resolution, I have to average these out.  Anyways, it doesn't hurt to do this in Linux, either.
 
+#ifndef MAP_EDITOR
+// Runs the per effect jobs of the eye candy idle on the engine job system.
+class EngineJobRunner : public ec::JobRunner
+{
+	public:
+	virtual void run(void (*job)(void* data, const Uint32 index), void* data, const Uint32 count)
+	{
+		engine_run_jobs(job, data, count);
+	}
+	;
+};
+
+EngineJobRunner engine_job_runner;
+#endif //!MAP_EDITOR
+
 // F U N C T I O N S //////////////////////////////////////////////////////////
 
 void set_vec3_actor_bone2(ec::Vec3& position, actor* _actor, int bone);
@@ -96,6 +117,9 @@ extern "C" void ec_init()
 	//happen, but it'd be proper to do so.
 	self_actor.obstruction = new ec::CappedSimpleCylinderObstruction(&(self_actor.center), 0.45, 3.0, self_actor.center.y, self_actor.center.y + 0.9);
 
+#ifndef MAP_EDITOR
+	eye_candy.set_job_runner(&engine_job_runner);
+#endif //!MAP_EDITOR
 #ifdef MAP_EDITOR
 	ec::SmoothPolygonElement e(0.0, 25.0);
 	initial_bounds.elements.push_back(e);
@@ -539,6 +563,132 @@ extern "C" void ec_heartbeat()
 	general_obstructions_list.push_back(self_actor.obstruction);
 }
 
+#if defined DEBUG && !defined MAP_EDITOR
+// Creates count effects of each type that doesn't need an actor near the
+// camera.
+static void ec_benchmark_create_effects(std::vector<ec_reference> &refs, const int count)
+{
+	const float x = -camera_x;
+	const float y = -camera_y;
+	const float z = 0.0;
+	ec_bounds bounds = ec_create_bounds_list();
+	int i;
+
+	for (i = 0; i < 8; i++)
+		ec_add_smooth_polygon_bound(bounds, i * (2 * ec::PI) / 8, 10.0);
+
+	for (i = 0; i < count; i++)
+	{
+		const float sx = x + ec::randfloat(8.0) - 4.0;
+		const float sy = y + ec::randfloat(8.0) - 4.0;
+
+		refs.push_back(ec_create_bag_drop(sx, sy, z, 10));
+		refs.push_back(ec_create_breath_fire(sx, sy, z + 1.0, sx + 2.0, sy, z, 10, 1.0));
+		refs.push_back(ec_create_campfire(sx, sy, z, 0.0, 1.0, 10, 1.0));
+		refs.push_back(ec_create_candle(sx, sy, z, 0.0, 1.0, 1.0, 10));
+		refs.push_back(ec_create_cloud(sx, sy, z, 0.0, 1.0, 1.0, bounds, 10));
+		refs.push_back(ec_create_fireflies(sx, sy, z, 0.0, 1.0, 1.0, 1.0, bounds));
+		refs.push_back(ec_create_fountain(sx, sy, z, 0.0, 1.0, z, 0, 1.0, 10));
+		refs.push_back(ec_create_harvesting_bees(sx, sy, z, 10));
+		refs.push_back(ec_create_impact_blood(sx, sy, z, 0.0, 0.0, 1.0, 10, 1.0));
+		refs.push_back(ec_create_lamp(sx, sy, z, 0.0, 1.0, 1.0, 10));
+		refs.push_back(ec_create_ongoing_poison(sx, sy, z, 0.0, 1.0, 10, 1.0));
+		refs.push_back(ec_create_selfmagic_heal(sx, sy, z, 10));
+		refs.push_back(ec_create_smoke(sx, sy, z, 0.0, 1.0, 1.0, 10));
+		refs.push_back(ec_create_summon_rabbit(sx, sy, z, 10));
+		refs.push_back(ec_create_targetmagic_remote_heal(sx, sy, z + 1.0, sx, sy + 2.0, z + 1.0, 10));
+		refs.push_back(ec_create_teleporter(sx, sy, z, 0.0, 1.0, 1.0, 10));
+		refs.push_back(ec_create_wind_leaves(sx, sy, z, 0.0, 1.0, 1.0, 1.0, bounds, 1.0, 0.0, 0.0));
+	}
+	ec_free_bounds_list(bounds);
+}
+
+// Recalls the benchmark effects and idles until they and their particles are
+// gone again.
+static void ec_benchmark_remove_effects(std::vector<ec_reference> &refs, const size_t effect_count)
+{
+	for (std::vector<ec_reference>::iterator iter = refs.begin(); iter != refs.end(); iter++)
+		ec_recall_effect(*iter);
+	refs.clear();
+
+	for (int i = 0; (eye_candy.effects.size() > effect_count) && (i < 1000); i++)
+		eye_candy.idle();
+}
+
+// Idles the same set of effects for a fixed number of frames twice, first
+// with the per effect jobs run one after another, then on the engine job
+// system, and logs the time per frame, the particles and how often the threads
+// had to lock the shared particle free lists for both passes.
+// Every pass recreates the effects from the same random seed and starts the
+// job seeds over, so both passes move the same particles.  The text gives the
+// number of effects of each type, at most max_count.
+extern "C" int ec_benchmark(char *text, int len)
+{
+	const Uint32 seed = 0x2545F491;
+	const int warm_up_frames = 50;
+	const int frames = 200;
+	const int max_count = 20;
+	std::vector<ec_reference> refs;
+	Uint64 start, saved_time_diff, times[2], particles[2], locks[2];
+	size_t effect_count, effects[2];
+	char str[256];
+	int count, i, j;
+
+	count = atoi(text);
+	if (count <= 0)
+		count = 10;
+	else if (count > max_count)
+		count = max_count;
+
+	saved_time_diff = eye_candy.time_diff;
+	eye_candy.time_diff = 20000;
+	effect_count = eye_candy.effects.size();
+
+	for (i = 0; i < 2; i++)
+	{
+		ec::MathCache::set_random_state(seed);
+		eye_candy.frame_count = 0;
+		eye_candy.set_job_runner(NULL);
+
+		ec_benchmark_create_effects(refs, count);
+
+		for (j = 0; j < warm_up_frames; j++)
+			eye_candy.idle();
+
+		eye_candy.set_job_runner(i == 0 ? NULL : &engine_job_runner);
+
+		particles[i] = 0;
+		locks[i] = ec::Particle::get_pool_lock_count();
+		start = ec::get_time();
+		for (j = 0; j < frames; j++)
+		{
+			eye_candy.idle();
+			particles[i] += eye_candy.particles.size();
+		}
+		times[i] = ec::get_time() - start;
+		locks[i] = ec::Particle::get_pool_lock_count() - locks[i];
+		effects[i] = eye_candy.effects.size() - effect_count;
+
+		eye_candy.set_job_runner(NULL);
+		ec_benchmark_remove_effects(refs, effect_count);
+	}
+
+	eye_candy.set_job_runner(&engine_job_runner);
+	eye_candy.time_diff = saved_time_diff;
+
+	safe_snprintf(str, sizeof(str), "eye candy serial: %u effects, %u particles, %u us/frame, %u pool locks",
+		(unsigned int)effects[0], (unsigned int)(particles[0] / frames),
+		(unsigned int)(times[0] / frames), (unsigned int)locks[0]);
+	LOG_TO_CONSOLE(c_grey1, str);
+	safe_snprintf(str, sizeof(str), "eye candy in jobs: %u effects, %u particles, %u us/frame, %u pool locks",
+		(unsigned int)effects[1], (unsigned int)(particles[1] / frames),
+		(unsigned int)(times[1] / frames), (unsigned int)locks[1]);
+	LOG_TO_CONSOLE(c_grey1, str);
+
+	return 1;
+}
+#endif //DEBUG && !MAP_EDITOR
+
 extern "C" void ec_draw()
 {
 	if (ec::get_error_status())
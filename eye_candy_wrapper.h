@@ -193,6 +193,9 @@ extern "C"
 	void ec_idle(); //!< \callergraph
 	void ec_heartbeat(); // Once per second.
 	void ec_draw(); //!< \callergraph
+#if defined DEBUG && !defined MAP_EDITOR
+	int ec_benchmark(char *text, int len);
+#endif
 	void ec_actor_delete(actor* _actor);
 	void ec_recall_effect(ec_reference ref);
 	void ec_destroy_all_effects();
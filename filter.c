@@ -2,6 +2,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <SDL.h>
 #include "filter.h"
 #include "asc.h"
 #include "init.h"
@@ -30,6 +31,30 @@ char storage_filter[128];
 
 unsigned char cached_storage_list[8192] = {0};
 
+/*
+ * All filters compiled into one case folded Aho-Corasick automaton, so a
+ * line is searched for all filters in a single pass. Wildcards are not
+ * part of the automaton, they only change where a match must start and
+ * end. The automaton is rebuilt on the first use after the list changed.
+ */
+typedef struct
+{
+	int *transitions;	/* next node for each node and character class, failure links already followed */
+	int *patterns;		/* first filter slot whose core ends in the node, -1 if none */
+	int *outputs;		/* next node with patterns on the failure path, 0 if none */
+	int num_nodes;
+	int num_classes;
+	int next_pattern[MAX_FILTERS];	/* next filter slot whose core ends in the same node */
+	int core_len[MAX_FILTERS];	/* length of the filter name without the wildcards */
+	int empty_patterns;	/* first filter slot that is only wildcards, matches every word */
+	Uint8 classes[256];	/* class of each case folded character, 0 if not used by any filter */
+	int dirty;
+} filter_automaton;
+
+static filter_automaton automaton = { NULL, NULL, NULL, 0, 0, {0}, {0}, -1, {0}, 1 };
+static int *word_filters = NULL;	/* filter slot to use for each word start of the line, -1 if none */
+static int word_filters_size = 0;
+
 //returns -1 if the name is already filtered, 1 on sucess, -2 if no more filter slots
 int add_to_filter_list (const char *name, char local, char save_name)
 {
@@ -100,6 +125,7 @@ int add_to_filter_list (const char *name, char local, char save_name)
 			filter_list[i].local = local;
 
 			filtered_so_far++;
+			automaton.dirty = 1;
 			return 1;
 		}
 	}
@@ -124,6 +150,7 @@ int remove_from_filter_list (const char *name)
 				local = filter_list[i].local;
 				filter_list[i].len = 0;
 				filtered_so_far--;
+				automaton.dirty = 1;
 				break;
 			}
 		}
@@ -164,61 +191,314 @@ void print_filter_list ()
 }
 #endif
 
-//returns length to be filtered, 0 if not filtered
-int check_if_filtered (const char *name)
+static Uint8 fold_char(Uint8 ch)
+{
+	/* same case folding as my_strncompare */
+	if (ch >= 'A' && ch <= 'Z')
+		return ch + 32;
+	return ch;
+}
+
+// the name of the filter without the wildcards, returns its length, -1 if it can never match
+static int get_filter_core (int slot, const char **core)
+{
+	switch (filter_list[slot].wildcard_type)
+	{
+		case 1:
+			*core = filter_list[slot].name + 1;
+			return filter_list[slot].len - 1;
+		case 2:
+			*core = filter_list[slot].name;
+			return filter_list[slot].len - 1;
+		case 3:
+			*core = filter_list[slot].name + 1;
+			return filter_list[slot].len - 2;
+		default:
+			*core = filter_list[slot].name;
+			return filter_list[slot].len;
+	}
+}
+
+// grows the array to count ints, keeps the old array and returns 0 if there is not enough memory
+static int resize_int_array (int **array, int count)
+{
+	int *tmp;
+
+	tmp = realloc (*array, count * sizeof (int));
+	if (tmp == NULL)
+	{
+		LOG_ERROR_OLD("%s: can't allocate %d filter entries\n", __FUNCTION__, count);
+		return 0;
+	}
+	*array = tmp;
+	return 1;
+}
+
+// returns 0 if there is not enough memory, the automaton stays dirty then
+static int build_filter_automaton ()
 {
-	int t, i, l;
+	int i, j, c, node, next, max_nodes, head, tail;
+	int *fail, *queue;
+	const char *core;
+
+	automaton.num_nodes = 1;
+	automaton.num_classes = 1;
+	automaton.empty_patterns = -1;
+	memset (automaton.classes, 0, sizeof (automaton.classes));
+	max_nodes = 1;
 
 	for (i = 0; i < MAX_FILTERS; i++)
 	{
-		if (filter_list[i].len > 0 && (use_global_filters || filter_list[i].local))
+		automaton.next_pattern[i] = -1;
+		automaton.core_len[i] = -1;
+		if (filter_list[i].len <= 0)
+			continue;
+		automaton.core_len[i] = get_filter_core (i, &core);
+		for (j = 0; j < automaton.core_len[i]; j++)
 		{
-			if (filter_list[i].wildcard_type==0)
+			c = fold_char (core[j]);
+			if (automaton.classes[c] == 0)
+				automaton.classes[c] = automaton.num_classes++;
+		}
+		if (automaton.core_len[i] > 0)
+			max_nodes += automaton.core_len[i];
+	}
+
+	if (!resize_int_array (&automaton.transitions, max_nodes * automaton.num_classes) ||
+		!resize_int_array (&automaton.patterns, max_nodes) ||
+		!resize_int_array (&automaton.outputs, max_nodes))
+		return 0;
+	fail = malloc (max_nodes * sizeof (int));
+	queue = malloc (max_nodes * sizeof (int));
+	if (fail == NULL || queue == NULL)
+	{
+		LOG_ERROR_OLD("%s: can't allocate %d filter entries\n", __FUNCTION__, max_nodes);
+		free (fail);
+		free (queue);
+		return 0;
+	}
+
+	for (c = 0; c < automaton.num_classes; c++)
+		automaton.transitions[c] = -1;
+	automaton.patterns[0] = -1;
+	automaton.outputs[0] = 0;
+
+	// build the trie of all filter cores
+	for (i = 0; i < MAX_FILTERS; i++)
+	{
+		if (automaton.core_len[i] < 0)
+			continue;
+		if (automaton.core_len[i] == 0)
+		{
+			automaton.next_pattern[i] = automaton.empty_patterns;
+			automaton.empty_patterns = i;
+			continue;
+		}
+		get_filter_core (i, &core);
+		node = 0;
+		for (j = 0; j < automaton.core_len[i]; j++)
+		{
+			c = automaton.classes[fold_char (core[j])];
+			next = automaton.transitions[node * automaton.num_classes + c];
+			if (next < 0)
 			{
-				/* no wildcard, normal compare */
-				if (my_strncompare (filter_list[i].name, name, filter_list[i].len))
-				{
-					if (!isalpha (name[filter_list[i].len]))
-					{
-						/* fits with end of word? */
-						return i; // yep, filtered
-					}
-				}
+				next = automaton.num_nodes++;
+				for (c = 0; c < automaton.num_classes; c++)
+					automaton.transitions[next * automaton.num_classes + c] = -1;
+				automaton.patterns[next] = -1;
+				c = automaton.classes[fold_char (core[j])];
+				automaton.transitions[node * automaton.num_classes + c] = next;
 			}
-			else if (filter_list[i].wildcard_type == 1)
+			node = next;
+		}
+		automaton.next_pattern[i] = automaton.patterns[node];
+		automaton.patterns[node] = i;
+	}
+
+	// breadth first, set the failure links and replace the missing transitions with the ones of the failure node
+	head = tail = 0;
+	for (c = 0; c < automaton.num_classes; c++)
+	{
+		next = automaton.transitions[c];
+		if (next < 0)
+		{
+			automaton.transitions[c] = 0;
+		}
+		else
+		{
+			fail[next] = 0;
+			automaton.outputs[next] = 0;
+			queue[tail++] = next;
+		}
+	}
+	while (head < tail)
+	{
+		node = queue[head++];
+		for (c = 0; c < automaton.num_classes; c++)
+		{
+			next = automaton.transitions[node * automaton.num_classes + c];
+			if (next < 0)
 			{
-				/* *word                       */
-				for (t = 0; ; t++)
-				{
-					if (!isalpha (name[t])) break; /* t points now at the end of the word */
-				}
-				l = filter_list[i].len;
-				if (t >= l-1)
-				{
-					if (my_strncompare (&(filter_list[i].name[1]), &name[t-l], l-1))
-						return i;
-				}
+				automaton.transitions[node * automaton.num_classes + c] = automaton.transitions[fail[node] * automaton.num_classes + c];
 			}
-			else if (filter_list[i].wildcard_type == 2)
+			else
 			{
-				/* word*                      */
-				if (my_strncompare (filter_list[i].name, name, filter_list[i].len-1))
-					return i;
+				fail[next] = automaton.transitions[fail[node] * automaton.num_classes + c];
+				if (automaton.patterns[fail[next]] >= 0)
+					automaton.outputs[next] = fail[next];
+				else
+					automaton.outputs[next] = automaton.outputs[fail[next]];
+				queue[tail++] = next;
 			}
-			else if (filter_list[i].wildcard_type==3)
+		}
+	}
+
+	free (fail);
+	free (queue);
+
+	automaton.dirty = 0;
+	return 1;
+}
+
+static int is_word_start (const Uint8 *text, int pos)
+{
+	return isalpha (text[pos]) && (pos == 0 || !isalpha (text[pos-1]));
+}
+
+static int is_word_end (const Uint8 *text, int pos, int len)
+{
+	return isalpha (text[pos]) && (pos + 1 >= len || !isalpha (text[pos+1]));
+}
+
+static void set_word_filter (int word, int slot)
+{
+	if (word_filters[word] < 0 || slot < word_filters[word])
+		word_filters[word] = slot;
+}
+
+// makes room for the filter slots of len word starts, returns 0 if there is not enough memory
+static int reserve_word_filters (int len)
+{
+	if (len <= word_filters_size)
+		return 1;
+	if (!resize_int_array (&word_filters, len))
+		return 0;
+	word_filters_size = len;
+	return 1;
+}
+
+// one pass over the text, stores for each word start the lowest filter slot that matches the word, returns 0 if there is not enough memory
+static int find_word_filters (const char *buff, int len)
+{
+	const Uint8 *text = (const Uint8 *)buff;
+	int i, state, node, slot, start, run_start, word;
+
+	if (automaton.dirty && !build_filter_automaton ())
+		return 0;
+
+	if (!reserve_word_filters (len))
+		return 0;
+
+	run_start = 0;
+	state = 0;
+	for (i = 0; i < len; i++)
+	{
+		word_filters[i] = -1;
+		if (!isalpha (text[i]))
+		{
+			run_start = i + 1;
+		}
+		else if (i == run_start)
+		{
+			for (slot = automaton.empty_patterns; slot >= 0; slot = automaton.next_pattern[slot])
+			{
+				if (use_global_filters || filter_list[slot].local)
+					set_word_filter (i, slot);
+			}
+		}
+
+		state = automaton.transitions[state * automaton.num_classes + automaton.classes[fold_char (text[i])]];
+
+		node = automaton.patterns[state] >= 0 ? state : automaton.outputs[state];
+		for (; node > 0; node = automaton.outputs[node])
+		{
+			for (slot = automaton.patterns[node]; slot >= 0; slot = automaton.next_pattern[slot])
 			{
-				/* *word*                     */
-				for (t = 0; ; t++)
+				if (!use_global_filters && !filter_list[slot].local)
+					continue;
+				start = i - automaton.core_len[slot] + 1;
+				word = -1;
+				switch (filter_list[slot].wildcard_type)
 				{
-					if (!isalpha (name[t])) break;
-					if (my_strncompare(&(filter_list[i].name[1]), &name[t], filter_list[i].len-2))
-						return i;//yep, filtered
+					case 0:
+						/* no wildcard, whole word(s) */
+						if (is_word_start (text, start) && (i + 1 >= len || !isalpha (text[i+1])))
+							word = start;
+						break;
+					case 1:
+						/* *word, the end of the word */
+						if (is_word_end (text, i, len) && start >= run_start)
+							word = run_start;
+						break;
+					case 2:
+						/* word*, the start of the word */
+						if (is_word_start (text, start))
+							word = start;
+						break;
+					case 3:
+						/* *word*, starts anywhere in the word */
+						if (isalpha (text[start]))
+						{
+							for (word = start; word > 0 && isalpha (text[word-1]); word--) ;
+						}
+						break;
 				}
+				if (word >= 0)
+					set_word_filter (word, slot);
 			}
 		}
 	}
-	
-	return -1;//nope
+
+	return 1;
+}
+
+// replaces the word at i with the replacement of the filter, returns the position after the replacement, -1 if there is not enough space
+static int replace_word (char *buff, int i, int idx, int *new_len, int size)
+{
+	int t, bad_len, rep_len;
+
+	if (filter_list[idx].wildcard_type > 0)
+	{
+		bad_len = 0;
+		for (t = 0; ; t++)
+		{
+			if (!isalpha ((unsigned char)buff[i+t])) break;
+			bad_len++;
+		}
+	}
+	else
+	{
+		bad_len = filter_list[idx].len;
+	}
+	rep_len = filter_list[idx].rlen;
+
+	if (bad_len == rep_len)
+	{
+		memcpy(buff+i, filter_list[idx].replacement, rep_len);
+	}
+	else if (*new_len + rep_len - bad_len >= size - 1)
+	{
+		// not enough space for substitution
+		return -1;
+	}
+	else
+	{
+		memmove(buff+i+rep_len, buff+i+bad_len, *new_len-i-bad_len+1);
+		memcpy(buff+i, filter_list[idx].replacement, rep_len);
+		*new_len += rep_len - bad_len;
+	}
+	/* don't filter the replacement text */
+	return i + rep_len;
 }
 
 // Filter the lines that contain the desired string from the inventory listing
@@ -268,11 +548,41 @@ int filter_storage_text (char * input_text, int len, int size) {
 	return len;
 }  
 
+// replaces the words found by find_word_filters, returns the new length of the text
+static int replace_words (char *buff, int len, int size)
+{
+	int i, new_len, idx;
+
+	// scan the text for any strings
+	new_len = len;
+	i = 0;
+	while (i < new_len)
+	{
+		/* skip non-alpha characters */
+		while (i < new_len && !isalpha ((unsigned char)buff[i])) i++;
+		if (i >= new_len) break;
+
+		/* check if we need to filter this word, the text before i changed its length by new_len - len */
+		idx = word_filters[i - (new_len - len)];
+		if (idx >= 0)
+		{
+			/* oops, remove this word */
+			i = replace_word (buff, i, idx, &new_len, size);
+			if (i < 0) break;
+		}
+		else
+		{
+			/* skip this word */
+			while (i < new_len && isalpha ((unsigned char)buff[i])) i++;
+		}
+	}
+	
+	return new_len;
+}
+
 //returns the new length of the text
 int filter_text (char *buff, int len, int size)
 {
-	int i, t, bad_len, rep_len, new_len, idx;
-
 	if (len > 31 && my_strncompare (buff+1, "Items you have in your storage:", 31)){
 		//First up, attempt to save the storage list for re-reading later
 		if(size <= sizeof(cached_storage_list)){
@@ -338,64 +648,15 @@ int filter_text (char *buff, int len, int size)
 	//do we need to do any content filtering?
 	if (filtered_so_far == 0) return len;
 
-	// scan the text for any strings
-	new_len = len;
-	i = 0;
-	while (i < new_len)
-	{
-		/* skip non-alpha characters */
-		while (i < new_len && !isalpha ((unsigned char)buff[i])) i++;
-		if (i >= new_len) break;
-		
-		/* check if we need to filter this word */
-		idx = check_if_filtered (&buff[i]);
-		if (idx >= 0)
-		{
-			/* oops, remove this word */
-			if (filter_list[idx].wildcard_type > 0)
-			{
-				bad_len = 0;
-				for (t = 0; ; t++)
-				{
-					if (!isalpha (buff[i+t])) break;
-					bad_len++;
-				}
-			}
-			else
-			{
-				bad_len = filter_list[idx].len;
-			}
-			rep_len = filter_list[idx].rlen;
+	// find the filters of all words at once, leave the text as it is if that fails
+	if (!find_word_filters (buff, len))
+		return len;
 
-			if (bad_len == rep_len)
-			{
-				memcpy(buff+i, filter_list[idx].replacement, rep_len);
-			}
-			else if (new_len + rep_len - bad_len >= size - 1)
-			{
-				// not enough space for substitution
-				break;
-			}
-			else
-			{
-				memmove(buff+i+rep_len, buff+i+bad_len, new_len-i-bad_len+1);
-				memcpy(buff+i, filter_list[idx].replacement, rep_len);
-				new_len+= rep_len - bad_len;
-			}
-			/* don't filter the replacement text */
-			i += rep_len;
-		}
-		else
-		{
-			/* skip this word */
-			while (i < new_len && isalpha (buff[i])) i++;
-		}
-	}
-	
-	return new_len;
+	return replace_words (buff, len, size);
 }
 
 
+
 void load_filters_list (const char *file_name, char local)
 {
 	int f_size;
@@ -463,6 +724,7 @@ void clear_filter_list ()
 	for (i = 0; i < MAX_FILTERS; i++)
 		filter_list[i].len = 0;
 	filtered_so_far = 0;
+	automaton.dirty = 1;
 }
 
 
@@ -517,3 +779,145 @@ int list_filters()
 	free (str);
 	return 1;
 }
+
+#ifdef DEBUG
+// the lowest filter slot of each word start, found by comparing every filter with every word, returns 0 if there is not enough memory
+static int find_word_filters_linear (const char *buff, int len)
+{
+	const Uint8 *text = (const Uint8 *)buff;
+	int i, j, start, end, core_len;
+	const char *core;
+
+	if (!reserve_word_filters (len))
+		return 0;
+
+	for (i = 0; i < len; i++)
+	{
+		word_filters[i] = -1;
+		if (!is_word_start (text, i))
+			continue;
+		for (end = i; end < len && isalpha (text[end]); end++) ;
+		for (j = 0; j < MAX_FILTERS && word_filters[i] < 0; j++)
+		{
+			if (filter_list[j].len <= 0 || !(use_global_filters || filter_list[j].local))
+				continue;
+			core_len = get_filter_core (j, &core);
+			if (core_len < 0)
+				continue;
+			switch (filter_list[j].wildcard_type)
+			{
+				case 0:
+					if (i + core_len <= len && my_strncompare (core, buff + i, core_len) && (i + core_len == len || !isalpha (text[i + core_len])))
+						word_filters[i] = j;
+					break;
+				case 1:
+					if (end - i >= core_len && my_strncompare (core, buff + end - core_len, core_len))
+						word_filters[i] = j;
+					break;
+				case 2:
+					if (i + core_len <= len && my_strncompare (core, buff + i, core_len))
+						word_filters[i] = j;
+					break;
+				case 3:
+					for (start = i; start < end && start + core_len <= len; start++)
+					{
+						if (my_strncompare (core, buff + start, core_len))
+						{
+							word_filters[i] = j;
+							break;
+						}
+					}
+					break;
+			}
+		}
+	}
+
+	return 1;
+}
+
+// compares the automaton with the linear search on random filters and lines
+int benchmark_filters (char *text, int len)
+{
+	static const char* words[] = { "the", "hello", "trade", "sword", "need", "steel", "bars", "sell", "buy", "you", "fighter", "mage" };
+	char str[256], line[256], reference[256], name[32];
+	filter_slot *saved_list;
+	int i, j, k, l, count, saved_filtered, line_len, new_len, mismatches;
+	Uint32 start, automaton_time, linear_time;
+	const int line_count = 2000;
+
+	saved_list = malloc (sizeof (filter_list));
+	if (saved_list == NULL)
+		return 1;
+	memcpy (saved_list, filter_list, sizeof (filter_list));
+	saved_filtered = filtered_so_far;
+	srand (1);
+
+	for (count = 10; count <= MAX_FILTERS; count *= 10)
+	{
+		clear_filter_list ();
+		for (i = 0; i < count; i++)
+		{
+			l = 3 + rand () % 6;
+			k = 0;
+			if (i % 4 == 1 || i % 4 == 3)
+				name[k++] = '*';
+			for (j = 0; j < l; j++)
+				name[k++] = 'a' + rand () % 26;
+			if (i % 4 >= 2)
+				name[k++] = '*';
+			safe_snprintf (name + k, sizeof (name) - k, "=%.*s", l, "*********");
+			add_to_filter_list (name, 1, 0);
+		}
+
+		automaton_time = linear_time = 0;
+		mismatches = 0;
+		for (i = 0; i < line_count; i++)
+		{
+			line_len = 0;
+			while (line_len < 120)
+			{
+				if (rand () % 4 == 0)
+				{
+					/* some random letters, so that a few filters match */
+					l = 2 + rand () % 8;
+					for (j = 0; j < l; j++)
+						line[line_len++] = 'a' + rand () % 26;
+				}
+				else
+				{
+					k = rand () % (sizeof (words) / sizeof (words[0]));
+					l = strlen (words[k]);
+					memcpy (line + line_len, words[k], l);
+					line_len += l;
+				}
+				line[line_len++] = (rand () % 8 == 0) ? ',' : ' ';
+			}
+			line[line_len] = '\0';
+
+			memcpy (str, line, line_len + 1);
+			start = SDL_GetTicks ();
+			new_len = find_word_filters (str, line_len) ? replace_words (str, line_len, sizeof (str)) : line_len;
+			automaton_time += SDL_GetTicks () - start;
+
+			memcpy (reference, line, line_len + 1);
+			start = SDL_GetTicks ();
+			l = find_word_filters_linear (reference, line_len) ? replace_words (reference, line_len, sizeof (reference)) : line_len;
+			linear_time += SDL_GetTicks () - start;
+
+			if (new_len != l || memcmp (str, reference, l) != 0)
+				mismatches++;
+		}
+
+		safe_snprintf (str, sizeof (str), "%d filters, %d lines: automaton %u ms, linear %u ms, %d mismatches",
+			filtered_so_far, line_count, automaton_time, linear_time, mismatches);
+		LOG_TO_CONSOLE (c_grey1, str);
+	}
+
+	memcpy (filter_list, saved_list, sizeof (filter_list));
+	filtered_so_far = saved_filtered;
+	automaton.dirty = 1;
+	free (saved_list);
+
+	return 1;
+}
+#endif
@@ -103,6 +103,18 @@ int list_filters();
 
 #ifdef DEBUG
 void print_filter_list ();
+
+/*!
+ * \ingroup actors_utils
+ * \brief   times the filtering of random lines with random filters.
+ *
+ *      Filters random lines with 10, 100 and 1000 random filters, once with the filter automaton and once by comparing every filter with every word, and prints the times and the number of different results to the console. The current filters are restored afterwards.
+ *
+ * \param text    unused
+ * \param len     unused
+ * \retval int    always 1
+ */
+int benchmark_filters (char *text, int len);
 #endif
 
 #ifdef __cplusplus
@@ -680,8 +680,8 @@ int click_game_handler(window_info *win, int mx, int my, Uint32 flags)
 		//TODO: Withdraw from storage, drop on ground...
 	}
 
-	// if we're following a path, stop now if the click was in the main window
-	if (pf_follow_path && !((mx >= window_width-hud_x) || (my >= window_height-hud_y)))
+	// if we're following or searching a path, stop now if the click was in the main window
+	if (!((mx >= window_width-hud_x) || (my >= window_height-hud_y)))
 	{
 		pf_destroy_path();
 	}
@@ -1242,6 +1242,10 @@ int display_game_handler (window_info *win)
 		}
 		safe_snprintf ((char*)str, sizeof(str),"Lights: %i", show_lights);
 		draw_string (win->len_x-hud_x-105, 32, str, 1);
+		safe_snprintf ((char*)str, sizeof(str), "Net: %u msgs %u bytes", frame_server_messages, frame_server_bytes);
+		draw_string (400, 36, str, 1);
+		safe_snprintf((char*)str, sizeof(str), "Textures: %u pending", engine_get_pending_texture_count());
+		draw_string (400, 52, str, 1);
 
 		safe_snprintf((char*)str, sizeof(str), "lights: ambient=(%.2f,%.2f,%.2f,%.2f) diffuse=(%.2f,%.2f,%.2f,%.2f)",
 					  ambient_light[0], ambient_light[1], ambient_light[2], ambient_light[3],
@@ -38,6 +38,7 @@
 #include "item_lists.h"
 #include "interface.h"
 #include "lights.h"
+#include "message_ring.h"
 #include "multiplayer.h"
 #include "particles.h"
 #include "pm_log.h"
@@ -133,15 +134,24 @@ int start_rendering()
 	static Uint32 last_frame_and_command_update = 0;
 
 	SDL_Thread *network_thread;
-	queue_t *message_queue;
+	message_ring_t *message_ring;
 
 #ifndef WINDOWS
 	SDL_EventState(SDL_SYSWMEVENT,SDL_ENABLE);
 #endif
-	queue_initialise(&message_queue);
-	network_thread_data[0] = message_queue;
-	network_thread_data[1] = &done;
-	network_thread = SDL_CreateThread(get_message_from_server, network_thread_data);
+	if (message_ring_initialise(&message_ring, 512 * 1024))
+	{
+		network_thread_data[0] = message_ring;
+		network_thread_data[1] = &done;
+		network_thread = SDL_CreateThread(get_message_from_server, network_thread_data);
+	}
+	else
+	{
+		/* no ring to read the server messages into, shut down again */
+		LOG_ERROR_OLD("Can't create the message ring, closing the client");
+		network_thread = NULL;
+		done = 1;
+	}
 
 	/* Loop until done. */
 	while( !done )
@@ -160,16 +170,7 @@ int start_rendering()
 			cur_time = SDL_GetTicks();
 
 			//check for network data
-			if(!queue_isempty(message_queue)) {
-				message_t *message;
-
-				while((message = queue_pop(message_queue)) != NULL)
-				{
-					process_message_from_server(message->data, message->length);
-					free(message->data);
-					free(message);
-				}
-			}
+			process_messages_from_server(message_ring);
 #ifdef	OLC
 			olc_process();
 #endif	//OLC
@@ -226,8 +227,9 @@ int start_rendering()
 		done = 1;
 	}
 	LOG_INFO_OLD("Client closed");
-	SDL_WaitThread(network_thread,&done);
-	queue_destroy(message_queue);
+	if (network_thread)
+		SDL_WaitThread(network_thread,&done);
+	message_ring_destroy(message_ring);
 	if(pm_log.ppl)free_pm_log();
 
 	//save all local data
@@ -69,6 +69,7 @@ void destroy_map()
 	///kill the pathfinding tile map
 	if(pf_tile_map)
 	{
+		pf_destroy_hierarchy();
 		free(pf_tile_map);
 		pf_tile_map = NULL;
 
@@ -150,6 +151,8 @@ static __inline__ void build_path_map()
 			pf_tile_map[i].z = height_map[i];
 		}
 	}
+
+	pf_build_hierarchy();
 }
 
 void updat_func(char *str, float percent)
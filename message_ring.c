@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+#include "message_ring.h"
+#include "errors.h"
+#if !defined(__GNUC__) && defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+#if defined(__GNUC__)
+#define MEMORY_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#define MEMORY_BARRIER() MemoryBarrier()
+#else
+#error "No memory barrier for this compiler"
+#endif
+
+/* Length field value of a message that marks the rest of the ring as unused */
+#define MESSAGE_RING_SKIP	0xFFFFFFFF
+
+static Uint32 get_slabs(Uint32 length)
+{
+	return (length + sizeof(Uint32) + MESSAGE_RING_SLAB_SIZE - 1) / MESSAGE_RING_SLAB_SIZE;
+}
+
+static Uint8 *get_slab(const message_ring_t *ring, Uint32 index)
+{
+	return ring->slabs + (index & (ring->slab_count - 1)) * MESSAGE_RING_SLAB_SIZE;
+}
+
+int message_ring_initialise(message_ring_t **ring, Uint32 size)
+{
+	Uint32 slab_count;
+
+	slab_count = 1;
+
+	while (slab_count * MESSAGE_RING_SLAB_SIZE < size)
+	{
+		slab_count *= 2;
+	}
+
+	(*ring) = calloc(1, sizeof(message_ring_t));
+
+	if ((*ring) == 0)
+	{
+		LOG_ERROR_OLD("Failed to allocate memory for message ring");
+
+		return 0;
+	}
+
+	(*ring)->slabs = malloc(slab_count * MESSAGE_RING_SLAB_SIZE);
+
+	if ((*ring)->slabs == 0)
+	{
+		LOG_ERROR_OLD("Failed to allocate memory for message ring slabs");
+
+		free(*ring);
+		(*ring) = 0;
+
+		return 0;
+	}
+
+	(*ring)->slab_count = slab_count;
+
+	return 1;
+}
+
+void message_ring_destroy(message_ring_t *ring)
+{
+	if (ring == 0)
+	{
+		return;
+	}
+
+	free(ring->slabs);
+	free(ring);
+}
+
+Uint8 *message_ring_reserve(message_ring_t *ring, Uint32 length)
+{
+	Uint32 slabs, tail, free_slabs, position;
+	Uint8 *slab;
+
+	slabs = get_slabs(length);
+	position = ring->write & (ring->slab_count - 1);
+	tail = ring->slab_count - position;
+
+	/* The reader must be done with the slabs before we write to them */
+	free_slabs = ring->slab_count - (ring->write - ring->read);
+	MEMORY_BARRIER();
+
+	if (slabs > tail)
+	{
+		/* The message must not wrap around, so skip the rest of the ring */
+		if ((tail + slabs) > free_slabs)
+		{
+			ring->full_count++;
+
+			return NULL;
+		}
+
+		*((Uint32 *)get_slab(ring, ring->write)) = MESSAGE_RING_SKIP;
+
+		MEMORY_BARRIER();
+
+		ring->write += tail;
+	}
+	else if (slabs > free_slabs)
+	{
+		ring->full_count++;
+
+		return NULL;
+	}
+
+	slab = get_slab(ring, ring->write);
+
+	*((Uint32 *)slab) = length;
+
+	ring->reserved = slabs;
+
+	return slab + sizeof(Uint32);
+}
+
+void message_ring_commit(message_ring_t *ring)
+{
+	/* The message must be complete before the reader can see it */
+	MEMORY_BARRIER();
+
+	ring->write += ring->reserved;
+	ring->reserved = 0;
+}
+
+const Uint8 *message_ring_view(message_ring_t *ring, Uint32 *length)
+{
+	Uint32 write, position;
+	Uint8 *slab;
+
+	write = ring->write;
+	MEMORY_BARRIER();
+
+	while (ring->view != write)
+	{
+		slab = get_slab(ring, ring->view);
+
+		if (*((Uint32 *)slab) == MESSAGE_RING_SKIP)
+		{
+			position = ring->view & (ring->slab_count - 1);
+			ring->view += ring->slab_count - position;
+
+			continue;
+		}
+
+		*length = *((Uint32 *)slab);
+		ring->view += get_slabs(*length);
+
+		return slab + sizeof(Uint32);
+	}
+
+	return NULL;
+}
+
+void message_ring_release(message_ring_t *ring)
+{
+	/* We must be done with the messages before the writer reuses them */
+	MEMORY_BARRIER();
+
+	ring->read = ring->view;
+}
+
+Uint32 message_ring_get_used(const message_ring_t *ring)
+{
+	return (ring->write - ring->read) * MESSAGE_RING_SLAB_SIZE;
+}
@@ -0,0 +1,102 @@
+/*!
+ * \file
+ * \ingroup network_actors
+ * \brief Lock free ring buffer for the messages from the server.
+ *
+ *      The network thread copies every complete server message into
+ *      the ring and the main thread processes the messages in place,
+ *      without any allocation or mutex. Only one thread may write and
+ *      only one thread may read the ring.
+ */
+#ifndef __MESSAGE_RING_H__
+#define __MESSAGE_RING_H__
+
+#include <SDL_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MESSAGE_RING_SLAB_SIZE	64	/*!< size of one slab in bytes */
+
+/*!
+ * Ring of fixed size slabs. A message uses as many consecutive slabs as
+ * needed for its length and the length field in front of it. The
+ * indices count slabs and are never wrapped, only the lower bits are
+ * used as position.
+ */
+typedef struct
+{
+	Uint8 *slabs;		/*!< memory of all slabs */
+	Uint32 slab_count;	/*!< number of slabs, a power of two */
+	volatile Uint32 write;	/*!< first slab not yet committed, only changed by the writer */
+	volatile Uint32 read;	/*!< first slab not yet released, only changed by the reader */
+	Uint32 reserved;	/*!< slabs of the reserved message, used by the writer */
+	Uint32 view;		/*!< first slab not yet viewed, used by the reader */
+	volatile Uint32 full_count;	/*!< number of times the writer found the ring full */
+} message_ring_t;
+
+/*!
+ * \brief Creates a ring.
+ *
+ * \param ring	the new ring
+ * \param size	minimum size of the ring in bytes
+ * \retval int	1 on success, 0 on failure
+ */
+int message_ring_initialise(message_ring_t **ring, Uint32 size);
+
+/*!
+ * \brief Frees the ring and all messages in it.
+ *
+ * \param ring	the ring to free
+ */
+void message_ring_destroy(message_ring_t *ring);
+
+/*!
+ * \brief Reserves space for a message, only called by the writer.
+ *
+ * \param ring		the ring
+ * \param length	the length of the message in bytes
+ * \retval Uint8*	where to write the message, NULL if the ring is full
+ * \sa message_ring_commit
+ */
+Uint8 *message_ring_reserve(message_ring_t *ring, Uint32 length);
+
+/*!
+ * \brief Makes the last reserved message visible to the reader.
+ *
+ * \param ring	the ring
+ */
+void message_ring_commit(message_ring_t *ring);
+
+/*!
+ * \brief Returns the next message, only called by the reader.
+ *
+ *      The message stays valid until message_ring_release is called.
+ *
+ * \param ring		the ring
+ * \param length	returns the length of the message in bytes
+ * \retval const Uint8*	the message, NULL if there is no new message
+ */
+const Uint8 *message_ring_view(message_ring_t *ring, Uint32 *length);
+
+/*!
+ * \brief Gives all viewed messages back to the writer.
+ *
+ * \param ring	the ring
+ */
+void message_ring_release(message_ring_t *ring);
+
+/*!
+ * \brief Returns the number of bytes used by not released messages.
+ *
+ * \param ring		the ring
+ * \retval Uint32	the used bytes
+ */
+Uint32 message_ring_get_used(const message_ring_t *ring);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __MESSAGE_RING_H__
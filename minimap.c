@@ -591,8 +591,8 @@ static int minimap_walkto(int mx, int my)
 	fmy = me->y_tile_pos - minimap_tiles_distance 
 		+ minimap_tiles_distance * 2 * fmy/float_minimap_size;
 
-	/* Do path finding */
-	if (pf_find_path(fmx, fmy))
+	/* Request a path, the actor starts walking once it is found */
+	if (pf_request_path(fmx, fmy, 0) > 0)
 	{
 		return 1;
 	}
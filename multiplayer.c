@@ -31,7 +31,7 @@
 #include "particles.h"
 #include "pathfinder.h"
 #include "questlog.h"
-#include "queue.h"
+#include "message_ring.h"
 #include "rules.h"
 #include "serverpopup.h"
 #include "sound.h"
@@ -69,6 +69,8 @@ SDLNet_SocketSet set= 0;
 Uint8 tcp_in_data[MAX_TCP_BUFFER];
 Uint8 tcp_out_data[MAX_TCP_BUFFER];
 int in_data_used=0;
+Uint32 frame_server_messages = 0;
+Uint32 frame_server_bytes = 0;
 int tcp_out_loc= 0;
 int previously_logged_in= 0;
 time_t last_heart_beat;
@@ -200,13 +202,16 @@ void move_to (short int x, short int y, int try_pathfinder)
 {
 	Uint8 str[5];
 
+	/* a new walk replaces the path we follow and any path still searched for */
+	pf_destroy_path();
+
 	if (try_pathfinder && always_pathfinding)
 	{
 		actor *me = get_our_actor();
 		/* check distance */
 		if (me && (abs(me->x_tile_pos-x)+abs(me->y_tile_pos-y)) > 2)
-			/* if path finder fails, try standard move */
-			if (pf_find_path(x,y))
+			/* if path finder fails, it sends the standard move */
+			if (pf_request_path(x, y, PF_MOVE_IF_NOT_FOUND) > 0)
 				return;
 	}
 
@@ -2198,8 +2203,11 @@ void process_message_from_server (const Uint8 *in_data, int data_length)
 		}
 }
 
-static void process_data_from_server(queue_t *queue)
+/* returns 1 if a complete message is left, because the message ring is full */
+static int process_data_from_server(message_ring_t *ring)
 {
+	int stalled = 0;
+
 	/* enough data present for the length field ? */
 	if (3 <= in_data_used) {
 		Uint8   *pData  = tcp_in_data;
@@ -2212,11 +2220,15 @@ static void process_data_from_server(queue_t *queue)
 			if (sizeof (tcp_in_data) - 3 >= size) { /* buffer big enough ? */
 
 				if (size <= in_data_used) { /* do we have a complete message ? */
-					message_t *message = malloc(sizeof *message);
-					message->data = malloc(size*sizeof(unsigned char));
-					message->length = size;
-					memcpy(message->data, pData, size);
-					queue_push(queue, message);
+					Uint8 *message = message_ring_reserve(ring, size);
+
+					if (message == NULL) { /* try again when the main thread released some messages */
+						stalled = 1;
+						break;
+					}
+
+					memcpy(message, pData, size);
+					message_ring_commit(ring);
 
 					if (log_conn_data){
 						log_conn(pData, size);
@@ -2250,13 +2262,43 @@ static void process_data_from_server(queue_t *queue)
 			memmove(tcp_in_data, pData, in_data_used);
 		}
 	}
+
+	return stalled;
+}
+
+void process_messages_from_server(message_ring_t *ring)
+{
+	const Uint8 *data;
+	Uint32 length;
+	Uint32 messages = 0;
+	Uint32 bytes = 0;
+
+	while ((data = message_ring_view(ring, &length)) != NULL)
+	{
+		process_message_from_server(data, length);
+
+		messages++;
+		bytes += length;
+
+		/* give the slabs back in batches, so the network thread never waits long */
+		if ((messages % 64) == 0)
+		{
+			message_ring_release(ring);
+		}
+	}
+
+	message_ring_release(ring);
+
+	frame_server_messages = messages;
+	frame_server_bytes = bytes;
 }
 
 int get_message_from_server(void *thread_args)
 {
 	int received;
-	void *queue = ((void **) thread_args)[0];
+	message_ring_t *ring = ((void **) thread_args)[0];
 	int *done = ((void **) thread_args)[1];
+	int stalled = 0;
 
 	LOG_DEBUG_OLD("init thread server_message");
 
@@ -2266,6 +2308,11 @@ int get_message_from_server(void *thread_args)
 		if(disconnected){
 			SDL_Delay(100);	// 10 times per second should be often enough
 			continue; //Continue to make the main loop check int done.
+		} else if(stalled){
+			// The message ring was full, wait for the main thread
+			SDL_Delay(1);
+			stalled = process_data_from_server(ring);
+			continue;
 		} else if(SDLNet_CheckSockets(set, 100) <= 0 || !SDLNet_SocketReady(my_socket)) {
 			//if no data, loop back and check again, the delay is in SDLNet_CheckSockets()
 			continue; //Continue to make the main loop check int done.
@@ -2273,7 +2320,7 @@ int get_message_from_server(void *thread_args)
 
 		if ((received = SDLNet_TCP_Recv(my_socket, &tcp_in_data[in_data_used], sizeof (tcp_in_data) - in_data_used)) > 0) {
 			in_data_used += received;
-			process_data_from_server(queue);
+			stalled = process_data_from_server(ring);
 		}
 		else { /* 0 >= received (EOF or some error) */
 			char str[256];
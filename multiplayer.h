@@ -7,6 +7,7 @@
 #define __MULTIPLAYER_H__
 
 #include <SDL_net.h>
+#include "message_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +32,9 @@ extern int always_pathfinding; /*!< use pathfinding for walk click on far visibl
 /*! @} */
 
 
+extern Uint32 frame_server_messages; /*!< number of server messages processed in the last frame */
+extern Uint32 frame_server_bytes; /*!< bytes of server messages processed in the last frame */
+
 extern Uint32 next_second_time; /*!< the time of the next second */
 extern short real_game_minute; /*!< the real game minute */
 extern short real_game_second; /*!< the real game second */
@@ -157,6 +161,17 @@ int get_message_from_server(void *thread_args);
 
 void process_message_from_server(const Uint8 *in_data, int data_length);
 
+/*!
+ * \ingroup network_actors
+ * \brief   Processes all server messages received by the network thread.
+ *
+ *      Processes the messages in place and gives them back to the network thread in batches.
+ *      Updates \ref frame_server_messages and \ref frame_server_bytes.
+ *
+ * \param ring   the message ring the network thread writes to
+ */
+void process_messages_from_server(message_ring_t *ring);
+
 void send_heart_beat();
 
 /*!
@@ -111,6 +111,8 @@ namespace eternal_lands
 		m_scene->set_main_light_color(glm::vec3(0.8f));
 		m_scene->set_main_light_direction(glm::vec3(0.0f, 0.0f, 1.0f));
 		m_scene->set_lights(false);
+		m_terrain_editor.set_job_system(
+			m_scene->get_scene_resources().get_job_system());
 		clear_tile_layers();
 	}
 
@@ -890,31 +892,38 @@ namespace eternal_lands
 	void EditorMapData::set_terrain_displacement_values(
 		const DisplacementValueVector &displacement_values)
 	{
-		m_terrain_editor.set_displacement_values(displacement_values);
+		glm::uvec4 rect;
+
+		rect = m_terrain_editor.set_displacement_values(
+			displacement_values);
 
 		m_scene->update_terrain_geometry_maps(
 			m_terrain_editor.get_displacement_map(),
 			m_terrain_editor.get_normal_tangent_map(),
 			m_terrain_editor.get_dudv_map(),
-			m_terrain_editor.get_translation());
+			m_terrain_editor.get_translation(), rect);
 	}
 
 	void EditorMapData::set_terrain_blend_values(
 		const ImageValueVector &blend_values, const Uint16 layer)
 	{
-		m_terrain_editor.set_blend_values(blend_values, layer);
+		glm::uvec4 rect;
+
+		rect = m_terrain_editor.set_blend_values(blend_values, layer);
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(), rect);
 	}
 
 	void EditorMapData::set_terrain_blend_values(
 		const ImageValuesVector &blend_values)
 	{
-		m_terrain_editor.set_blend_values(blend_values);
+		glm::uvec4 rect;
+
+		rect = m_terrain_editor.set_blend_values(blend_values);
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(), rect);
 	}
 
 	void EditorMapData::swap_terrain_blend_layers(const Uint16 idx0,
@@ -923,7 +932,8 @@ namespace eternal_lands
 		m_terrain_editor.swap_blend_layers(idx0, idx1);
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(),
+			m_terrain_editor.get_full_rect());
 
 		m_scene->set_terrain_material(
 			m_terrain_editor.get_albedo_maps(),
@@ -939,7 +949,8 @@ namespace eternal_lands
 		m_terrain_editor.move_blend_layer(idx0, idx1);
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(),
+			m_terrain_editor.get_full_rect());
 
 		m_scene->set_terrain_material(
 			m_terrain_editor.get_albedo_maps(),
@@ -1205,7 +1216,8 @@ namespace eternal_lands
 			m_terrain_editor.get_displacement_map(),
 			m_terrain_editor.get_normal_tangent_map(),
 			m_terrain_editor.get_dudv_map(),
-			m_terrain_editor.get_translation());
+			m_terrain_editor.get_translation(),
+			m_terrain_editor.get_full_rect());
 	}
 
 	void EditorMapData::set_focus(const glm::vec3 &focus) noexcept
@@ -1291,7 +1303,8 @@ namespace eternal_lands
 			m_terrain_editor.get_displacement_map(),
 			m_terrain_editor.get_normal_tangent_map(),
 			m_terrain_editor.get_dudv_map(),
-			m_terrain_editor.get_translation());
+			m_terrain_editor.get_translation(),
+			m_terrain_editor.get_full_rect());
 	}
 
 	void EditorMapData::import_terrain_blend_map(const String &name)
@@ -1305,7 +1318,8 @@ namespace eternal_lands
 		m_terrain_editor.import_blend_map(blend_map);
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(),
+			m_terrain_editor.get_full_rect());
 	}
 
 	void EditorMapData::set_terrain(
@@ -1345,7 +1359,8 @@ namespace eternal_lands
 			m_terrain_editor.get_displacement_map(),
 			m_terrain_editor.get_normal_tangent_map(),
 			m_terrain_editor.get_dudv_map(),
-			m_terrain_editor.get_translation());
+			m_terrain_editor.get_translation(),
+			m_terrain_editor.get_full_rect());
 
 		m_scene->set_terrain_dudv_scale_offset(
 			m_terrain_editor.get_dudv_scale_offset());
@@ -1356,7 +1371,8 @@ namespace eternal_lands
 		m_terrain_editor.clear_invisible_layers();
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(),
+			m_terrain_editor.get_full_rect());
 
 		m_scene->set_terrain_material(
 			m_terrain_editor.get_albedo_maps(),
@@ -1371,7 +1387,8 @@ namespace eternal_lands
 		m_terrain_editor.pack_layers();
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(),
+			m_terrain_editor.get_full_rect());
 
 		m_scene->set_terrain_material(
 			m_terrain_editor.get_albedo_maps(),
@@ -1407,7 +1424,8 @@ namespace eternal_lands
 		m_terrain_editor.fill_blend_layer(strength, effect, layer);
 
 		m_scene->update_terrain_blend_map(
-			m_terrain_editor.get_blend_map());
+			m_terrain_editor.get_blend_map(),
+			m_terrain_editor.get_full_rect());
 	}
 
 	void EditorMapData::save(const AbstractProgressSharedPtr &progress,
@@ -364,17 +364,18 @@ namespace eternal_lands
 	void EditorScene::update_terrain_geometry_maps(
 		const ImageSharedPtr &displacement_map,
 		const ImageSharedPtr &normal_tangent_map,
-		const ImageSharedPtr &dudv_map, const glm::vec3 &translation)
+		const ImageSharedPtr &dudv_map, const glm::vec3 &translation,
+		const glm::uvec4 &rect)
 	{
 		get_map()->update_terrain_geometry_maps(displacement_map,
-			normal_tangent_map, dudv_map, translation);
+			normal_tangent_map, dudv_map, translation, rect);
 		rebuild_terrain_map();
 	}
 
 	void EditorScene::update_terrain_blend_map(
-		const ImageSharedPtr &blend_map)
+		const ImageSharedPtr &blend_map, const glm::uvec4 &rect)
 	{
-		get_map()->update_terrain_blend_map(blend_map, 0xFFFF);
+		get_map()->update_terrain_blend_map(blend_map, 0xFFFF, rect);
 		rebuild_terrain_map();
 	}
 
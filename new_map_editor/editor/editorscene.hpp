@@ -102,9 +102,11 @@ namespace eternal_lands
 				const ImageSharedPtr &displacement_map,
 				const ImageSharedPtr &normal_tangent_map,
 				const ImageSharedPtr &dudv_map,
-				const glm::vec3 &translation);
+				const glm::vec3 &translation,
+				const glm::uvec4 &rect);
 			void update_terrain_blend_map(
-				const ImageSharedPtr &blend_map);
+				const ImageSharedPtr &blend_map,
+				const glm::uvec4 &rect);
 			void draw_selection(const glm::uvec4 &selection_rect);
 /*
 			void set_height(const Uint16 x, const Uint16 y,
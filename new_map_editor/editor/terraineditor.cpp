@@ -11,10 +11,51 @@
 #include "terrain/uvtool.hpp"
 #include "imageupdate.hpp"
 #include "meshdatatool.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
 
 namespace eternal_lands
 {
 
+	namespace
+	{
+
+		const Uint32 normal_tangent_tile_size = 64;
+
+		class UpdateNormalTangentMapTask: public AbstractThreadTask
+		{
+			private:
+				TerrainEditor &m_terrain_editor;
+				const glm::uvec4 m_rect;
+
+			public:
+				UpdateNormalTangentMapTask(
+					TerrainEditor &terrain_editor,
+					const glm::uvec4 &rect);
+				virtual ~UpdateNormalTangentMapTask() noexcept;
+				virtual void operator()();
+
+		};
+
+		UpdateNormalTangentMapTask::UpdateNormalTangentMapTask(
+			TerrainEditor &terrain_editor, const glm::uvec4 &rect):
+			m_terrain_editor(terrain_editor), m_rect(rect)
+		{
+		}
+
+		UpdateNormalTangentMapTask::~UpdateNormalTangentMapTask()
+			noexcept
+		{
+		}
+
+		void UpdateNormalTangentMapTask::operator()()
+		{
+			m_terrain_editor.update_normal_tangent_map_tile(m_rect);
+		}
+
+	}
+
 	TerrainEditor::TerrainEditor(): m_enabled(false)
 	{
 		glm::uvec2 value;
@@ -41,16 +82,18 @@ namespace eternal_lands
 	{
 	}
 
-	void TerrainEditor::set_displacement_values(
+	glm::uvec4 TerrainEditor::set_displacement_values(
 		const DisplacementValueVector &displacement_values)
 	{
-		Ivec2Set indices;
-		glm::ivec2 index, min, max;
-		Sint32 x, y;
+		glm::uvec4 rect;
+		glm::uvec2 index;
+
+		if (displacement_values.size() == 0)
+		{
+			return glm::uvec4(0);
+		}
 
-		min = glm::ivec2(0);
-		max = glm::ivec2(m_displacement_map->get_width() - 1,
-			m_displacement_map->get_height()) - 1;
+		rect = glm::uvec4(m_size.x, m_size.y, 0, 0);
 
 		BOOST_FOREACH(const DisplacementValue &displacement_value,
 			displacement_values)
@@ -60,35 +103,43 @@ namespace eternal_lands
 				displacement_value.get_y(), 0, 0, 0,
 				displacement_value.get_packed_value());
 
-			for (y = -1; y < 2; ++y)
-			{
-				for (x = -1; x < 2; ++x)
-				{
-					index.x = displacement_value.get_x();
-					index.y = displacement_value.get_y();
-					index.x += x;
-					index.y += y;
-
-					index = glm::min(index, max);
-					index = glm::max(index, min);
+			index.x = displacement_value.get_x();
+			index.y = displacement_value.get_y();
 
-					indices.insert(index);
-				}
-			}
+			rect.x = std::min(rect.x, index.x);
+			rect.y = std::min(rect.y, index.y);
+			rect.z = std::max(rect.z, index.x);
+			rect.w = std::max(rect.w, index.y);
 		}
 
-		update_normal_tangent_map(indices);
+		/* The normals of the neighbours use the changed values */
+		rect.x = std::max(rect.x, 1u) - 1;
+		rect.y = std::max(rect.y, 1u) - 1;
+		rect.z = std::min(rect.z + 2, m_size.x);
+		rect.w = std::min(rect.w + 2, m_size.y);
+
+		update_normal_tangent_map(rect);
+
+		return rect;
 	}
 
-	void TerrainEditor::set_blend_values(
+	glm::uvec4 TerrainEditor::set_blend_values(
 		const ImageValueVector &blend_values, const Uint16 layer)
 	{
-		glm::uvec4 value;
+		glm::uvec4 value, rect;
+		glm::uvec2 index;
 
 		assert(get_blend_map()->get_depth() <= 4);
 
 		assert(layer < (get_blend_map()->get_depth() * 4));
 
+		if (blend_values.size() == 0)
+		{
+			return glm::uvec4(0);
+		}
+
+		rect = glm::uvec4(m_size.x, m_size.y, 0, 0);
+
 		BOOST_FOREACH(const ImageValue &blend_value, blend_values)
 		{
 			value = m_blend_map->get_pixel_uint(blend_value.get_x(),
@@ -97,17 +148,35 @@ namespace eternal_lands
 
 			m_blend_map->set_pixel_uint(blend_value.get_x(),
 				blend_value.get_y(), layer / 4, 0, 0, value);
+
+			index.x = blend_value.get_x();
+			index.y = blend_value.get_y();
+
+			rect.x = std::min(rect.x, index.x);
+			rect.y = std::min(rect.y, index.y);
+			rect.z = std::max(rect.z, index.x + 1);
+			rect.w = std::max(rect.w, index.y + 1);
 		}
+
+		return rect;
 	}
 
-	void TerrainEditor::set_blend_values(
+	glm::uvec4 TerrainEditor::set_blend_values(
 		const ImageValuesVector &blend_values)
 	{
+		glm::uvec4 rect;
+		glm::uvec2 index;
 		Uint16 i, count;
 
 		assert(get_blend_map()->get_depth() <= 4);
 
+		if (blend_values.size() == 0)
+		{
+			return glm::uvec4(0);
+		}
+
 		count = get_blend_map()->get_depth();
+		rect = glm::uvec4(m_size.x, m_size.y, 0, 0);
 
 		BOOST_FOREACH(const ImageValues &blend_value, blend_values)
 		{
@@ -118,7 +187,17 @@ namespace eternal_lands
 					blend_value.get_y(), i, 0, 0,
 					blend_value.get_packed_value(i));
 			}
+
+			index.x = blend_value.get_x();
+			index.y = blend_value.get_y();
+
+			rect.x = std::min(rect.x, index.x);
+			rect.y = std::min(rect.y, index.y);
+			rect.z = std::max(rect.z, index.x + 1);
+			rect.w = std::max(rect.w, index.y + 1);
 		}
+
+		return rect;
 	}
 
 	void TerrainEditor::get_displacement_values(const Uint32 x,
@@ -568,13 +647,7 @@ namespace eternal_lands
 			}
 		}
 
-		for (y = 0; y < m_size.y; ++y)
-		{
-			for (x = 0; x < m_size.x; ++x)
-			{
-				update_normal_tangent_map(glm::ivec2(x, y));
-			}
-		}
+		update_normal_tangent_map(get_full_rect());
 
 		for (z = 0; z < m_size.z; ++z)
 		{
@@ -927,11 +1000,59 @@ namespace eternal_lands
 			value);
 	}
 
-	void TerrainEditor::update_normal_tangent_map(const Ivec2Set &indices)
+	void TerrainEditor::update_normal_tangent_map_tile(
+		const glm::uvec4 &rect)
+	{
+		Uint32 x, y;
+
+		for (y = rect.y; y < rect.w; ++y)
+		{
+			for (x = rect.x; x < rect.z; ++x)
+			{
+				update_normal_tangent_map(glm::ivec2(x, y));
+			}
+		}
+	}
+
+	void TerrainEditor::update_normal_tangent_map(const glm::uvec4 &rect)
 	{
-		BOOST_FOREACH(const glm::ivec2 &index, indices)
+		std::auto_ptr<AbstractThreadTask> task;
+		TaskGroup task_group;
+		JobSystemSharedPtr job_system;
+		glm::uvec4 tile;
+		Uint32 x, y;
+
+		job_system = m_job_system.lock();
+
+		for (y = rect.y; y < rect.w; y += normal_tangent_tile_size)
+		{
+			for (x = rect.x; x < rect.z;
+				x += normal_tangent_tile_size)
+			{
+				tile.x = x;
+				tile.y = y;
+				tile.z = std::min(x + normal_tangent_tile_size,
+					rect.z);
+				tile.w = std::min(y + normal_tangent_tile_size,
+					rect.w);
+
+				if (job_system.get() == nullptr)
+				{
+					update_normal_tangent_map_tile(tile);
+
+					continue;
+				}
+
+				task.reset(new UpdateNormalTangentMapTask(*this,
+					tile));
+
+				job_system->add(task, task_group);
+			}
+		}
+
+		if (job_system.get() != nullptr)
 		{
-			update_normal_tangent_map(index);
+			job_system->wait(task_group);
 		}
 	}
 
@@ -1138,13 +1259,7 @@ namespace eternal_lands
 			}
 		}
 
-		for (y = 0; y < m_size.y; ++y)
-		{
-			for (x = 0; x < m_size.x; ++x)
-			{
-				update_normal_tangent_map(glm::ivec2(x, y));
-			}
-		}
+		update_normal_tangent_map(get_full_rect());
 	}
 
 	void TerrainEditor::get_all_displacement_values(
@@ -1305,19 +1420,11 @@ namespace eternal_lands
 
 	void TerrainEditor::rebuild_normal_tangent_map()
 	{
-		Uint32 x, y;
-
 		m_normal_tangent_map = boost::make_shared<Image>(
 			String(UTF8("normal tangent map")), false, tft_rgba8,
 			glm::uvec3(m_size.x, m_size.y, 0), 0, false);
 
-		for (y = 0; y < m_size.y; ++y)
-		{
-			for (x = 0; x < m_size.x; ++x)
-			{
-				update_normal_tangent_map(glm::ivec2(x, y));
-			}
-		}
+		update_normal_tangent_map(get_full_rect());
 	}
 
 	void TerrainEditor::import_dudv_map(const ImageConstSharedPtr &dudv_map,
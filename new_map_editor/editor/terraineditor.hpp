@@ -60,32 +60,6 @@ namespace eternal_lands
 		bet_inverse_slope = 2
 	};
 
-	class LessIvec2
-	{
-		public:
-			inline LessIvec2()
-			{
-			}
-
-			inline ~LessIvec2() noexcept
-			{
-			}
-
-			inline bool operator()(const glm::ivec2 &p0,
-				const glm::ivec2 &p1)
-			{
-				if (p0.x == p1.x)
-				{
-					return p0.y < p1.y;
-				}
-
-				return p0.x < p1.x;
-			}
-
-	};
-
-	typedef std::set<glm::ivec2, LessIvec2> Ivec2Set;
-
 	/**
 	 * @brief @c class for editing terrain.
 	 *
@@ -100,6 +74,7 @@ namespace eternal_lands
 			ImageSharedPtr m_dudv_map;
 			ImageSharedPtr m_blend_map;
 			boost::scoped_ptr<UvTool> m_uv_tool;
+			JobSystemWeakPtr m_job_system;
 			TerrainMaterialData m_material_data;
 			StringVector m_albedo_maps;
 			StringVector m_specular_maps;
@@ -124,7 +99,7 @@ namespace eternal_lands
 			void update_normal_tangent_map(
 				const glm::ivec2 &index);
 			void update_normal_tangent_map(
-				const Ivec2Set &positions);
+				const glm::uvec4 &rect);
 			void get_blend_values(const glm::uvec2 &vertex,
 				const float radius,
 				ImageValueVector &blend_values) const;
@@ -154,14 +129,32 @@ namespace eternal_lands
 		public:
 			TerrainEditor();
 			~TerrainEditor() noexcept;
-			void set_displacement_values(
+			/**
+			 * Sets the displacement values and updates the normal
+			 * tangent map around them.
+			 * @return The changed rect of the normal tangent map
+			 * as (min x, min y, max x, max y), max is exclusive.
+			 */
+			glm::uvec4 set_displacement_values(
 				const DisplacementValueVector
 					&displacement_values);
-			void set_blend_values(
+			/**
+			 * @return The changed rect of the blend map.
+			 */
+			glm::uvec4 set_blend_values(
 				const ImageValueVector &blend_values,
 				const Uint16 layer);
-			void set_blend_values(
+			/**
+			 * @return The changed rect of the blend map.
+			 */
+			glm::uvec4 set_blend_values(
 				const ImageValuesVector &blend_values);
+			/**
+			 * Updates the normal tangent map for the rect, used
+			 * by the tasks the editor splits its updates into.
+			 */
+			void update_normal_tangent_map_tile(
+				const glm::uvec4 &rect);
 			void init(const glm::vec3 &translation,
 				const glm::uvec2 &size,
 				const String &albedo_map,
@@ -343,6 +336,17 @@ namespace eternal_lands
 				m_enabled = enabled;
 			}
 
+			inline void set_job_system(
+				const JobSystemWeakPtr &job_system)
+			{
+				m_job_system = job_system;
+			}
+
+			inline glm::uvec4 get_full_rect() const
+			{
+				return glm::uvec4(0, 0, m_size.x, m_size.y);
+			}
+
 			inline void set_translation(
 				const glm::vec3 &translation)
 			{
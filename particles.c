@@ -389,7 +389,7 @@ void add_teleporters_from_list (const Uint8 *teleport_list)
 		//mark the teleporter as an unwalkable so that the pathfinder
 		//won't try to plot a path through it
 
-		pf_tile_map[teleport_y*tile_map_size_x*6+teleport_x].z = 0;
+		pf_block_tile(teleport_x, teleport_y);
 	}
 }
 
@@ -1,28 +1,135 @@
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include "pathfinder.h"
 #include "actors.h"
 #include "events.h"
 #include "gl_init.h"
 #include "hud.h"
 #include "interface.h"
+#include "misc.h"
 #include "multiplayer.h"
 #include "tiles.h"
+#include "threads.h"
+#include <SDL_thread.h>
+#ifdef DEBUG
+#include "asc.h"
+#include "text.h"
+#include "io/elfilewrapper.h"
+#include "io/map_io.h"
+#endif
 
 PF_TILE *pf_tile_map = NULL;
 PF_TILE *pf_dst_tile;
 int pf_follow_path = 0;
 
-static PF_OPEN_LIST pf_open;
-static PF_TILE *pf_src_tile, *pf_cur_tile;
+/*
+ * The walk grid is split into square clusters. The entrances between
+ * neighbouring clusters and the costs to walk between the entrances of
+ * a cluster form a small graph, so long paths are first searched on
+ * this graph and then only refined between consecutive entrances.
+ */
+#define PF_CLUSTER_SIZE 16
+#define PF_LONG_ENTRANCE 8
+#define PF_NO_COST 0xFFFFFFFF
+
+typedef struct
+{
+	Sint32 min_x;
+	Sint32 min_y;
+	Sint32 max_x;
+	Sint32 max_y;
+} PF_RECT;
+
+typedef struct
+{
+	Uint32 tile; /*!< index of the tile of the entrance */
+	Uint32 first_edge;
+	Uint32 edge_count;
+} PF_NODE;
+
+typedef struct
+{
+	Uint32 from;
+	Uint32 to;
+	Uint32 cost;
+} PF_EDGE;
+
+typedef struct
+{
+	PF_TILE *tiles;
+	Sint32 width;
+	Sint32 height;
+	PF_OPEN_LIST open;
+	Uint32 search; /*!< id of the current search, tiles with another id are not visited yet */
+	Sint32 clusters_x;
+	Sint32 clusters_y;
+	Uint32 *cluster_nodes; /*!< index of the first node of each cluster, one more than clusters */
+	Uint8 *uniform_clusters; /*!< clusters without obstacles, the costs inside are the distances */
+	PF_NODE *nodes;
+	Uint32 node_count;
+	PF_EDGE *edges;
+	Uint32 edge_count;
+	int dirty;
+	const volatile Uint32 *newest_query; /*!< the search is cancelled when this is not query any more */
+	Uint32 query;
+} PF_GRID;
+
+typedef struct
+{
+	Uint32 *tiles; /*!< tile indices from the destination to the start */
+	int count;
+	int size;
+} PF_PATH;
+
+typedef struct
+{
+	Uint32 id;
+	Sint32 src_x;
+	Sint32 src_y;
+	Sint32 dst_x;
+	Sint32 dst_y;
+	int flags;
+} PF_QUERY;
+
+/*
+ * The paths are searched by a worker thread on its own copy of the walk
+ * grid, so clicks never wait for a search. Only the queries, the tiles
+ * blocked since the copy was made and the results are shared.
+ */
+typedef struct
+{
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *condition;
+	PF_GRID grid; /*!< only used by the worker */
+	PF_TILE *tiles; /*!< the copy of the walk grid, only used by the worker */
+	Sint32 width;
+	Sint32 height;
+	Uint32 *blocked; /*!< tiles blocked since the last query */
+	int blocked_count;
+	int blocked_size;
+	PF_QUERY query; /*!< the last query, not yet taken by the worker */
+	int has_query;
+	PF_PATH result;
+	PF_QUERY result_query;
+	int result_found;
+	int has_result;
+	volatile Uint32 newest_query; /*!< id of the newest query, older ones are cancelled */
+	int running;
+} PF_WORKER;
+
+static PF_WORKER pf_worker;
+static PF_PATH pf_path;
 static int pf_visited_squares[20];
 static SDL_TimerID pf_movement_timer = NULL;
 
 #define PF_DIFF(a, b) ((a > b) ? a - b : b - a)
-#define PF_HEUR(a, b) pf_heuristic(a->x-b->x, a->y-b->y);
+#define PF_HEUR(a, b) pf_heuristic(a->x-b->x, a->y-b->y)
 #define PF_SWAP(i, j) {\
-	PF_TILE *a = pf_open.tiles[i], *b = pf_open.tiles[j];\
+	PF_TILE *a = grid->open.tiles[i], *b = grid->open.tiles[j];\
 	a->open_pos = j; b->open_pos = i;\
-	pf_open.tiles[i] = b; pf_open.tiles[j] = a;\
+	grid->open.tiles[i] = b; grid->open.tiles[j] = a;\
 }
 
 static __inline__ int pf_heuristic(int dx, int dy)
@@ -37,7 +144,7 @@ static __inline__ int pf_heuristic(int dx, int dy)
 #if 0
 	// Grum: Is the cost of a diagonal move really sqrt(2) times that of
 	// an aligned move? If not, the below should simply be max(dx, dy), and
-	// the cost function in pf_add_tile_to_open_list() should also be
+	// the cost function in pf_add_neighbours_to_open_list() and pf_get_distance() should also be
 	// updated.
 	return dx < dy ? 14*dx + 10*(dy-dx) : 14*dy + 10*(dx-dy);
 #endif
@@ -56,28 +163,108 @@ static __inline__ PF_TILE *pf_get_tile(int x, int y)
 	(((x) >= tile_map_size_x*6 || (y) >= tile_map_size_y*6 || ((Sint32)(x)) < 0 || ((Sint32)(y)) < 0) ? NULL : &pf_tile_map[(y)*tile_map_size_x*6+(x)])
 #endif
 
-static PF_TILE *pf_get_next_open_tile()
+static __inline__ PF_TILE *pf_get_grid_tile(const PF_GRID *grid, Sint32 x, Sint32 y)
+{
+	if (x >= grid->width || y >= grid->height || x < 0 || y < 0) {
+		return NULL;
+	}
+	return &grid->tiles[y*grid->width+x];
+}
+
+static __inline__ Uint32 pf_get_cluster(const PF_GRID *grid, const PF_TILE *tile)
+{
+	return (tile->y / PF_CLUSTER_SIZE) * grid->clusters_x + tile->x / PF_CLUSTER_SIZE;
+}
+
+static __inline__ int pf_is_connected(const PF_TILE *a, const PF_TILE *b)
+{
+	return a && b && a->z != 0 && b->z != 0 && PF_DIFF(a->z, b->z) <= 2;
+}
+
+static __inline__ Uint32 pf_get_distance(const PF_TILE *a, const PF_TILE *b)
+{
+	Uint32 dx = PF_DIFF(a->x, b->x), dy = PF_DIFF(a->y, b->y);
+
+	// the exact costs of a path without obstacles
+	return dx < dy ? 14*dx + 10*(dy-dx) : 14*dy + 10*(dx-dy);
+}
+
+static void pf_get_cluster_rect(const PF_GRID *grid, const PF_TILE *tile, PF_RECT *rect)
+{
+	rect->min_x = (tile->x / PF_CLUSTER_SIZE) * PF_CLUSTER_SIZE;
+	rect->min_y = (tile->y / PF_CLUSTER_SIZE) * PF_CLUSTER_SIZE;
+	rect->max_x = min2i(rect->min_x + PF_CLUSTER_SIZE, grid->width) - 1;
+	rect->max_y = min2i(rect->min_y + PF_CLUSTER_SIZE, grid->height) - 1;
+}
+
+// all tiles walkable and all neighbours connected
+static int pf_is_uniform_rect(const PF_GRID *grid, const PF_RECT *rect)
+{
+	const PF_TILE *tile;
+	Sint32 x, y;
+
+	for (y = rect->min_y; y <= rect->max_y; y++)
+	{
+		for (x = rect->min_x; x <= rect->max_x; x++)
+		{
+			tile = &grid->tiles[y*grid->width+x];
+			if (tile->z == 0)
+				return 0;
+			if (x < rect->max_x && !pf_is_connected(tile, tile + 1))
+				return 0;
+			if (y < rect->max_y && !pf_is_connected(tile, tile + grid->width))
+				return 0;
+			if (x < rect->max_x && y < rect->max_y && !pf_is_connected(tile, tile + grid->width + 1))
+				return 0;
+			if (x > rect->min_x && y < rect->max_y && !pf_is_connected(tile, tile + grid->width - 1))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+static __inline__ int pf_is_cancelled(const PF_GRID *grid)
+{
+	return grid->newest_query && *grid->newest_query != grid->query;
+}
+
+static void pf_begin_search(PF_GRID *grid)
+{
+	int i;
+
+	if (++grid->search == 0)
+	{
+		// the ids wrapped around, make sure no tile looks visited
+		for (i = 0; i < grid->width*grid->height; i++)
+			grid->tiles[i].search = 0;
+		grid->search = 1;
+	}
+	grid->open.count = 0;
+}
+
+static PF_TILE *pf_get_next_open_tile(PF_GRID *grid)
 {
 	PF_TILE *ret;
 
-	if (pf_open.count == 0)
+	if (grid->open.count == 0)
 		return NULL;
 
-	ret = pf_open.tiles[0];
+	ret = grid->open.tiles[0];
 	ret->state = PF_STATE_CLOSED;
 
-	if (--pf_open.count)
+	if (--grid->open.count)
 	{
 		int i, j;
-		PF_TILE *tmp = pf_open.tiles[0] = pf_open.tiles[pf_open.count];
+		PF_TILE *tmp = grid->open.tiles[0] = grid->open.tiles[grid->open.count];
 
 		tmp->open_pos = 0;
 		i = 0;
-		while ( (j = 2*i + 1) < pf_open.count )
+		while ( (j = 2*i + 1) < grid->open.count )
 		{
-			if (j+1 < pf_open.count && pf_open.tiles[j+1]->f < pf_open.tiles[j]->f)
+			if (j+1 < grid->open.count && grid->open.tiles[j+1]->f < grid->open.tiles[j]->f)
 				j++;
-			if (pf_open.tiles[j]->f >= tmp->f)
+			if (grid->open.tiles[j]->f >= tmp->f)
 				break;
 			PF_SWAP(i, j);
 			i = j;
@@ -87,60 +274,616 @@ static PF_TILE *pf_get_next_open_tile()
 	return ret;
 }
 
-static void pf_add_tile_to_open_list(PF_TILE *current, PF_TILE *neighbour)
+static void pf_add_tile_to_open_list(PF_GRID *grid, PF_TILE *parent, PF_TILE *tile, Uint32 g, Uint32 h)
 {
-	if (!neighbour
-		|| neighbour->state == PF_STATE_CLOSED
-		|| neighbour->z == 0
-		|| (current && PF_DIFF(current->z, neighbour->z) > 2))
+	Uint32 f = g + h;
+
+	if (tile->search != grid->search)
+	{
+		tile->search = grid->search;
+		tile->state = PF_STATE_NONE;
+	}
+	else if (tile->state == PF_STATE_CLOSED
+		|| (tile->state == PF_STATE_OPEN && f >= tile->f))
+	{
 		return;
+	}
+
+	tile->f = f;
+	tile->g = g;
+	tile->parent = parent;
+
+	if (tile->state != PF_STATE_OPEN)
+	{
+		tile->open_pos = grid->open.count++;
+		grid->open.tiles[tile->open_pos] = tile;
+	}
+
+	while (tile->open_pos > 0)
+	{
+		int idx = tile->open_pos;
+		int parent_idx = (idx-1) / 2;
+
+		if (tile->f >= grid->open.tiles[parent_idx]->f)
+			break;
+
+		PF_SWAP(idx, parent_idx);
+	}
+
+	tile->state = PF_STATE_OPEN;
+}
 
-	if (current)
+static void pf_add_neighbours_to_open_list(PF_GRID *grid, PF_TILE *current, const PF_TILE *dst, const PF_RECT *rect)
+{
+	static const int offsets[8][2] = {
+		{ 0, 1 }, { 1, 1 }, { 1, 0 }, { 1, -1 },
+		{ 0, -1 }, { -1, -1 }, { -1, 0 }, { -1, 1 }
+	};
+	PF_TILE *neighbour;
+	int i, x, y, g;
+
+	for (i = 0; i < 8; i++)
 	{
-		int f, g, h;
-		int diagonal = (neighbour->x != current->x && neighbour->y != current->y);
+		x = current->x + offsets[i][0];
+		y = current->y + offsets[i][1];
+
+		if (x < rect->min_x || x > rect->max_x || y < rect->min_y || y > rect->max_y)
+			continue;
+
+		neighbour = &grid->tiles[y*grid->width+x];
+
+		if (neighbour->z == 0 || PF_DIFF(current->z, neighbour->z) > 2)
+			continue;
 
 #ifdef	FUZZY_PATHS
-		g = current->g + (diagonal ? 14 : 10) + rand()%3;
+		g = current->g + ((offsets[i][0] && offsets[i][1]) ? 14 : 10) + rand()%3;
 #else	//FUZZY_PATHS
-		g = current->g + (diagonal ? 14 : 10);
+		g = current->g + ((offsets[i][0] && offsets[i][1]) ? 14 : 10);
 #endif	//FUZZY_PATHS
-		h = PF_HEUR(neighbour, pf_dst_tile);
-		f = g + h;
+		pf_add_tile_to_open_list(grid, current, neighbour, g, dst ? PF_HEUR(neighbour, dst) : 0);
+	}
+}
 
-		if (neighbour->state == PF_STATE_OPEN && f >= neighbour->f)
-			return;
+// A* search over the tiles inside the rect, the parents of the tiles lead from dst back to src
+static int pf_search_tiles(PF_GRID *grid, PF_TILE *src, PF_TILE *dst, const PF_RECT *rect, int max_attempts)
+{
+	PF_TILE *current;
+	int attempts = 0;
+
+	pf_begin_search(grid);
+	pf_add_tile_to_open_list(grid, NULL, src, 0, PF_HEUR(src, dst));
+
+	while ((current = pf_get_next_open_tile(grid)) && attempts++ < max_attempts)
+	{
+		if (current == dst)
+			return 1;
 
-		neighbour->f = f;
-		neighbour->g = g;
-		neighbour->parent = current;
+		if ((attempts & 1023) == 0 && pf_is_cancelled(grid))
+			return 0;
+
+		pf_add_neighbours_to_open_list(grid, current, dst, rect);
+	}
+
+	return 0;
+}
+
+// the costs from src to the nodes inside the rect, PF_NO_COST for unreachable nodes
+static void pf_search_costs(PF_GRID *grid, PF_TILE *src, const PF_RECT *rect, const PF_NODE *nodes, Uint32 count, Uint32 *costs)
+{
+	PF_TILE *current;
+	Uint32 i, remaining, index;
+
+	if (grid->uniform_clusters[pf_get_cluster(grid, src)])
+	{
+		for (i = 0; i < count; i++)
+			costs[i] = pf_get_distance(src, &grid->tiles[nodes[i].tile]);
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		costs[i] = PF_NO_COST;
+
+	remaining = count;
+
+	pf_begin_search(grid);
+	pf_add_tile_to_open_list(grid, NULL, src, 0, 0);
+
+	while (remaining > 0 && (current = pf_get_next_open_tile(grid)))
+	{
+		index = current - grid->tiles;
+
+		for (i = 0; i < count; i++)
+		{
+			if (nodes[i].tile == index)
+			{
+				costs[i] = current->g;
+				remaining--;
+			}
+		}
+
+		pf_add_neighbours_to_open_list(grid, current, NULL, rect);
+	}
+}
+
+static int pf_compare_nodes(const void *a, const void *b)
+{
+	const PF_NODE *node_a = a, *node_b = b;
+
+	// first_edge holds the cluster while building
+	if (node_a->first_edge != node_b->first_edge)
+		return node_a->first_edge < node_b->first_edge ? -1 : 1;
+	if (node_a->tile != node_b->tile)
+		return node_a->tile < node_b->tile ? -1 : 1;
+	return 0;
+}
+
+static int pf_compare_edges(const void *a, const void *b)
+{
+	const PF_EDGE *edge_a = a, *edge_b = b;
+
+	if (edge_a->from != edge_b->from)
+		return edge_a->from < edge_b->from ? -1 : 1;
+	if (edge_a->to != edge_b->to)
+		return edge_a->to < edge_b->to ? -1 : 1;
+	return 0;
+}
+
+static int pf_find_node(const PF_GRID *grid, const PF_TILE *tile)
+{
+	Uint32 cluster, index;
+	int low, high, mid;
+
+	if (!grid->cluster_nodes)
+		return -1;
+
+	cluster = pf_get_cluster(grid, tile);
+	index = tile - grid->tiles;
+	low = grid->cluster_nodes[cluster];
+	high = grid->cluster_nodes[cluster+1] - 1;
+
+	while (low <= high)
+	{
+		mid = (low + high) / 2;
+		if (grid->nodes[mid].tile == index)
+			return mid;
+		if (grid->nodes[mid].tile < index)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+
+	return -1;
+}
+
+static void pf_add_node(PF_NODE **nodes, Uint32 *count, Uint32 *size, const PF_GRID *grid, const PF_TILE *tile)
+{
+	if (*count >= *size)
+	{
+		*size = max2u(*size * 2, 256);
+		*nodes = realloc(*nodes, *size * sizeof(PF_NODE));
+	}
+	(*nodes)[*count].tile = tile - grid->tiles;
+	(*nodes)[*count].first_edge = pf_get_cluster(grid, tile);
+	(*nodes)[*count].edge_count = 0;
+	(*count)++;
+}
+
+static void pf_add_edge(PF_EDGE **edges, Uint32 *count, Uint32 *size, Uint32 from, Uint32 to, Uint32 cost)
+{
+	if (*count >= *size)
+	{
+		*size = max2u(*size * 2, 256);
+		*edges = realloc(*edges, *size * sizeof(PF_EDGE));
+	}
+	(*edges)[*count].from = from;
+	(*edges)[*count].to = to;
+	(*edges)[*count].cost = cost;
+	(*count)++;
+}
+
+// adds the entrances of a run of connected tiles along a cluster border
+static void pf_add_entrance(PF_NODE **nodes, Uint32 *count, Uint32 *size, const PF_GRID *grid,
+	Sint32 x, Sint32 y, Sint32 dx, Sint32 dy, Sint32 length)
+{
+	Sint32 along_x = dy, along_y = dx;
+
+	// runs run along the border, so they move perpendicular to (dx, dy)
+	if (length < PF_LONG_ENTRANCE)
+	{
+		x += along_x * (length / 2);
+		y += along_y * (length / 2);
+		pf_add_node(nodes, count, size, grid, pf_get_grid_tile(grid, x, y));
+		pf_add_node(nodes, count, size, grid, pf_get_grid_tile(grid, x + dx, y + dy));
 	}
 	else
 	{
-		neighbour->f = PF_HEUR(pf_src_tile, pf_dst_tile);
-		neighbour->g = 0;
-		neighbour->parent = NULL;
+		pf_add_node(nodes, count, size, grid, pf_get_grid_tile(grid, x, y));
+		pf_add_node(nodes, count, size, grid, pf_get_grid_tile(grid, x + dx, y + dy));
+		x += along_x * (length - 1);
+		y += along_y * (length - 1);
+		pf_add_node(nodes, count, size, grid, pf_get_grid_tile(grid, x, y));
+		pf_add_node(nodes, count, size, grid, pf_get_grid_tile(grid, x + dx, y + dy));
 	}
+}
+
+// finds the runs of connected tiles along the border between the tile (x, y) and (x + dx, y + dy)
+static void pf_add_border_entrances(PF_NODE **nodes, Uint32 *count, Uint32 *size, const PF_GRID *grid,
+	Sint32 x, Sint32 y, Sint32 dx, Sint32 dy, Sint32 length)
+{
+	Sint32 i, run;
 
-	if (neighbour->state != PF_STATE_OPEN)
+	run = 0;
+	for (i = 0; i <= length; i++)
 	{
-		neighbour->open_pos = pf_open.count++;
-		pf_open.tiles[neighbour->open_pos] = neighbour;
+		if (i < length && pf_is_connected(pf_get_grid_tile(grid, x + dy * i, y + dx * i),
+			pf_get_grid_tile(grid, x + dy * i + dx, y + dx * i + dy)))
+		{
+			run++;
+		}
+		else if (run > 0)
+		{
+			pf_add_entrance(nodes, count, size, grid, x + dy * (i - run), y + dx * (i - run), dx, dy, run);
+			run = 0;
+		}
 	}
+}
 
-	while (neighbour->open_pos > 0)
+static void pf_destroy_graph(PF_GRID *grid)
+{
+	free(grid->cluster_nodes);
+	free(grid->uniform_clusters);
+	free(grid->nodes);
+	free(grid->edges);
+	grid->cluster_nodes = NULL;
+	grid->uniform_clusters = NULL;
+	grid->nodes = NULL;
+	grid->edges = NULL;
+	grid->node_count = 0;
+	grid->edge_count = 0;
+}
+
+static void pf_build_graph(PF_GRID *grid)
+{
+	PF_NODE *nodes = NULL;
+	PF_EDGE *edges = NULL;
+	Uint32 node_count = 0, node_size = 0, edge_count = 0, edge_size = 0;
+	Uint32 i, j, k, node, cluster, cluster_count, first, last;
+	Sint32 x, y;
+	Uint32 *costs;
+	PF_TILE *tile;
+	PF_RECT rect;
+
+	pf_destroy_graph(grid);
+	grid->dirty = 0;
+
+	grid->clusters_x = (grid->width + PF_CLUSTER_SIZE - 1) / PF_CLUSTER_SIZE;
+	grid->clusters_y = (grid->height + PF_CLUSTER_SIZE - 1) / PF_CLUSTER_SIZE;
+	cluster_count = grid->clusters_x * grid->clusters_y;
+
+	// the entrances are pairs of nodes on both sides of a cluster border
+	for (y = 0; y < grid->height; y += PF_CLUSTER_SIZE)
 	{
-		int idx = neighbour->open_pos;
-		int parent_idx = (idx-1) / 2;
-		PF_TILE *parent = pf_open.tiles[parent_idx];
+		for (x = PF_CLUSTER_SIZE; x < grid->width; x += PF_CLUSTER_SIZE)
+			pf_add_border_entrances(&nodes, &node_count, &node_size, grid, x - 1, y, 1, 0, min2i(PF_CLUSTER_SIZE, grid->height - y));
+	}
+	for (y = PF_CLUSTER_SIZE; y < grid->height; y += PF_CLUSTER_SIZE)
+	{
+		for (x = 0; x < grid->width; x += PF_CLUSTER_SIZE)
+			pf_add_border_entrances(&nodes, &node_count, &node_size, grid, x, y - 1, 0, 1, min2i(PF_CLUSTER_SIZE, grid->width - x));
+	}
 
-		if (neighbour->f >= parent->f)
-			break;
+	// the pairs are next to each other, so the edges between clusters can be found before sorting
+	for (i = 0; i < node_count; i += 2)
+	{
+		pf_add_edge(&edges, &edge_count, &edge_size, nodes[i].tile, nodes[i+1].tile, 10);
+		pf_add_edge(&edges, &edge_count, &edge_size, nodes[i+1].tile, nodes[i].tile, 10);
+	}
 
-		PF_SWAP(idx, parent_idx);
+	if (node_count > 0)
+	{
+		qsort(nodes, node_count, sizeof(PF_NODE), pf_compare_nodes);
+		for (i = 1, j = 1; i < node_count; i++)
+		{
+			if (pf_compare_nodes(&nodes[i], &nodes[j-1]) != 0)
+				nodes[j++] = nodes[i];
+		}
+		node_count = j;
+	}
+
+	grid->nodes = nodes;
+	grid->node_count = node_count;
+	grid->cluster_nodes = calloc(cluster_count + 1, sizeof(Uint32));
+	grid->uniform_clusters = calloc(cluster_count, sizeof(Uint8));
+	for (y = 0; y < grid->height; y += PF_CLUSTER_SIZE)
+	{
+		for (x = 0; x < grid->width; x += PF_CLUSTER_SIZE)
+		{
+			tile = pf_get_grid_tile(grid, x, y);
+			pf_get_cluster_rect(grid, tile, &rect);
+			grid->uniform_clusters[pf_get_cluster(grid, tile)] = pf_is_uniform_rect(grid, &rect);
+		}
+	}
+	for (i = 0, cluster = 0; cluster <= cluster_count; cluster++)
+	{
+		while (i < node_count && nodes[i].first_edge < cluster)
+			i++;
+		grid->cluster_nodes[cluster] = i;
+	}
+
+	// the edges between clusters still use tile indices
+	for (i = 0; i < edge_count; i++)
+	{
+		edges[i].from = pf_find_node(grid, &grid->tiles[edges[i].from]);
+		edges[i].to = pf_find_node(grid, &grid->tiles[edges[i].to]);
+	}
+
+	// the edges inside of the clusters, the costs are the same in both directions
+	costs = malloc(max2u(node_count, 1) * sizeof(Uint32));
+	for (cluster = 0; cluster < cluster_count; cluster++)
+	{
+		first = grid->cluster_nodes[cluster];
+		last = grid->cluster_nodes[cluster+1];
+
+		if (last - first < 2)
+			continue;
+
+		pf_get_cluster_rect(grid, &grid->tiles[nodes[first].tile], &rect);
+
+		for (j = first; j < last - 1; j++)
+		{
+			pf_search_costs(grid, &grid->tiles[nodes[j].tile], &rect, &nodes[j+1], last - j - 1, costs);
+
+			for (k = j + 1; k < last; k++)
+			{
+				if (costs[k-j-1] == PF_NO_COST)
+					continue;
+				pf_add_edge(&edges, &edge_count, &edge_size, j, k, costs[k-j-1]);
+				pf_add_edge(&edges, &edge_count, &edge_size, k, j, costs[k-j-1]);
+			}
+		}
+	}
+	free(costs);
+
+	if (edge_count > 0)
+		qsort(edges, edge_count, sizeof(PF_EDGE), pf_compare_edges);
+
+	for (i = 0, node = 0; node < node_count; node++)
+	{
+		nodes[node].first_edge = i;
+		while (i < edge_count && edges[i].from == node)
+			i++;
+		nodes[node].edge_count = i - nodes[node].first_edge;
+	}
+
+	grid->edges = edges;
+	grid->edge_count = edge_count;
+}
+
+static void pf_init_grid(PF_GRID *grid, PF_TILE *tiles, Sint32 width, Sint32 height)
+{
+	memset(grid, 0, sizeof(PF_GRID));
+	grid->tiles = tiles;
+	grid->width = width;
+	grid->height = height;
+	grid->open.tiles = calloc(width*height, sizeof(PF_TILE*));
+	pf_build_graph(grid);
+}
+
+static void pf_destroy_grid(PF_GRID *grid)
+{
+	pf_destroy_graph(grid);
+	free(grid->open.tiles);
+	memset(grid, 0, sizeof(PF_GRID));
+}
+
+// A* search over the cluster graph, with the start and the destination as extra nodes
+static int pf_search_graph(PF_GRID *grid, PF_TILE *src, PF_TILE *dst, const Uint32 *src_costs, const Uint32 *dst_costs)
+{
+	PF_TILE *current, *tile;
+	Uint32 i, src_first, src_last, dst_first, dst_last, dst_cluster;
+	const PF_EDGE *edge;
+	int node, attempts = 0;
+
+	src_first = grid->cluster_nodes[pf_get_cluster(grid, src)];
+	src_last = grid->cluster_nodes[pf_get_cluster(grid, src)+1];
+	dst_cluster = pf_get_cluster(grid, dst);
+	dst_first = grid->cluster_nodes[dst_cluster];
+	dst_last = grid->cluster_nodes[dst_cluster+1];
+
+	pf_begin_search(grid);
+	pf_add_tile_to_open_list(grid, NULL, src, 0, PF_HEUR(src, dst));
+
+	while ((current = pf_get_next_open_tile(grid)))
+	{
+		if (current == dst)
+			return 1;
+
+		if ((++attempts & 255) == 0 && pf_is_cancelled(grid))
+			return 0;
+
+		if (current == src)
+		{
+			for (i = src_first; i < src_last; i++)
+			{
+				if (src_costs[i-src_first] == PF_NO_COST)
+					continue;
+				tile = &grid->tiles[grid->nodes[i].tile];
+				pf_add_tile_to_open_list(grid, current, tile, src_costs[i-src_first], PF_HEUR(tile, dst));
+			}
+		}
+
+		node = pf_find_node(grid, current);
+		if (node < 0)
+			continue;
+
+		edge = &grid->edges[grid->nodes[node].first_edge];
+		for (i = 0; i < grid->nodes[node].edge_count; i++, edge++)
+		{
+			tile = &grid->tiles[grid->nodes[edge->to].tile];
+			pf_add_tile_to_open_list(grid, current, tile, current->g + edge->cost, PF_HEUR(tile, dst));
+		}
+
+		if (node >= dst_first && node < dst_last && dst_costs[node-dst_first] != PF_NO_COST)
+			pf_add_tile_to_open_list(grid, current, dst, current->g + dst_costs[node-dst_first], 0);
+	}
+
+	return 0;
+}
+
+static void pf_add_to_path(PF_PATH *path, Uint32 tile)
+{
+	if (path->count >= path->size)
+	{
+		path->size = max2i(path->size * 2, 256);
+		path->tiles = realloc(path->tiles, path->size * sizeof(Uint32));
 	}
+	path->tiles[path->count++] = tile;
+}
+
+// adds the tiles from dst back to src, but not src itself
+static void pf_add_parents_to_path(const PF_GRID *grid, PF_PATH *path, const PF_TILE *src, const PF_TILE *dst)
+{
+	const PF_TILE *tile;
+
+	for (tile = dst; tile && tile != src; tile = tile->parent)
+		pf_add_to_path(path, tile - grid->tiles);
+}
+
+// adds the straight line from dst back to src, but not src itself, all tiles between must be connected
+static void pf_add_line_to_path(const PF_GRID *grid, PF_PATH *path, const PF_TILE *src, const PF_TILE *dst)
+{
+	Sint32 x, y;
+
+	x = dst->x;
+	y = dst->y;
 
-	neighbour->state = PF_STATE_OPEN;
+	while (x != src->x || y != src->y)
+	{
+		pf_add_to_path(path, y*grid->width+x);
+		x += (x < src->x) - (x > src->x);
+		y += (y < src->y) - (y > src->y);
+	}
+}
+
+// searches the cluster graph and refines each step with a search limited to its clusters,
+// returns 1 if a path was found, 0 if there is none and -1 if the graph is out of date
+static int pf_find_graph_path(PF_GRID *grid, PF_TILE *src, PF_TILE *dst, PF_PATH *path)
+{
+	Uint32 *src_costs, *dst_costs, *waypoints;
+	Uint32 src_cluster, dst_cluster, count, i;
+	PF_TILE *tile, *from, *to;
+	PF_RECT rect, to_rect;
+	int found;
+
+	src_cluster = pf_get_cluster(grid, src);
+	dst_cluster = pf_get_cluster(grid, dst);
+
+	count = grid->cluster_nodes[src_cluster+1] - grid->cluster_nodes[src_cluster];
+	src_costs = malloc(max2u(count, 1) * sizeof(Uint32));
+	pf_get_cluster_rect(grid, src, &rect);
+	pf_search_costs(grid, src, &rect, &grid->nodes[grid->cluster_nodes[src_cluster]], count, src_costs);
+
+	count = grid->cluster_nodes[dst_cluster+1] - grid->cluster_nodes[dst_cluster];
+	dst_costs = malloc(max2u(count, 1) * sizeof(Uint32));
+	pf_get_cluster_rect(grid, dst, &rect);
+	pf_search_costs(grid, dst, &rect, &grid->nodes[grid->cluster_nodes[dst_cluster]], count, dst_costs);
+
+	found = pf_search_graph(grid, src, dst, src_costs, dst_costs);
+
+	free(src_costs);
+	free(dst_costs);
+
+	if (!found)
+		return 0;
+
+	// the waypoints from dst back to src, before the tiles get reused for the refinement
+	count = 0;
+	for (tile = dst; tile; tile = tile->parent)
+		count++;
+	waypoints = malloc(count * sizeof(Uint32));
+	for (i = 0, tile = dst; tile; tile = tile->parent, i++)
+		waypoints[i] = tile - grid->tiles;
+
+	for (i = 0; i + 1 < count && found; i++)
+	{
+		from = &grid->tiles[waypoints[i+1]];
+		to = &grid->tiles[waypoints[i]];
+
+		if (pf_get_cluster(grid, from) == pf_get_cluster(grid, to)
+			&& grid->uniform_clusters[pf_get_cluster(grid, from)])
+		{
+			pf_add_line_to_path(grid, path, from, to);
+			continue;
+		}
+
+		pf_get_cluster_rect(grid, from, &rect);
+		pf_get_cluster_rect(grid, to, &to_rect);
+		rect.min_x = min2i(rect.min_x, to_rect.min_x);
+		rect.min_y = min2i(rect.min_y, to_rect.min_y);
+		rect.max_x = max2i(rect.max_x, to_rect.max_x);
+		rect.max_y = max2i(rect.max_y, to_rect.max_y);
+
+		found = pf_search_tiles(grid, from, to, &rect, grid->width*grid->height);
+		if (found)
+			pf_add_parents_to_path(grid, path, from, to);
+	}
+
+	if (found)
+		pf_add_to_path(path, src - grid->tiles);
+
+	free(waypoints);
+
+	if (found)
+		return 1;
+
+	// a tile blocked since the graph was built, -1 tells to rebuild it
+	return pf_is_cancelled(grid) ? 0 : -1;
+}
+
+// finds a path from src to dst, the path goes from dst to src
+static int pf_find_grid_path(PF_GRID *grid, PF_TILE *src, PF_TILE *dst, PF_PATH *path)
+{
+	PF_RECT rect;
+	Sint32 dx, dy;
+	int found;
+
+	path->count = 0;
+
+	if (grid->dirty)
+		pf_build_graph(grid);
+
+	rect.min_x = 0;
+	rect.min_y = 0;
+	rect.max_x = grid->width - 1;
+	rect.max_y = grid->height - 1;
+
+	// short paths are faster without the detour over the cluster graph
+	dx = src->x / PF_CLUSTER_SIZE - dst->x / PF_CLUSTER_SIZE;
+	dy = src->y / PF_CLUSTER_SIZE - dst->y / PF_CLUSTER_SIZE;
+	if (abs(dx) <= 1 && abs(dy) <= 1)
+	{
+		if (pf_search_tiles(grid, src, dst, &rect, MAX_PATHFINDER_ATTEMPTS))
+		{
+			pf_add_parents_to_path(grid, path, src, dst);
+			pf_add_to_path(path, src - grid->tiles);
+			return 1;
+		}
+	}
+
+	found = pf_find_graph_path(grid, src, dst, path);
+	if (found < 0)
+	{
+		path->count = 0;
+		pf_build_graph(grid);
+		found = pf_find_graph_path(grid, src, dst, path);
+	}
+
+	if (found > 0)
+		return 1;
+
+	path->count = 0;
+
+	return 0;
 }
 
 static Uint32 pf_movement_timer_callback(Uint32 interval, void* UNUSED(param))
@@ -157,11 +900,215 @@ static Uint32 pf_movement_timer_callback(Uint32 interval, void* UNUSED(param))
 		return interval;
 }
 
-int pf_find_path(int x, int y)
+// applies the tiles blocked by the main thread to the copy of the walk grid
+static void pf_block_grid_tiles(PF_GRID *grid, const Uint32 *blocked, int count)
 {
-	actor *me;
+	PF_TILE *tile;
 	int i;
-	int attempts= 0;
+
+	for (i = 0; i < count; i++)
+	{
+		tile = &grid->tiles[blocked[i]];
+		tile->z = 0;
+
+		// the costs inside the cluster are still good enough, a blocked entrance needs a new graph
+		grid->uniform_clusters[pf_get_cluster(grid, tile)] = 0;
+		if (pf_find_node(grid, tile) >= 0)
+			grid->dirty = 1;
+	}
+}
+
+static int pf_find_query_path(PF_GRID *grid, const PF_QUERY *query, PF_PATH *path, PF_QUERY *result)
+{
+	PF_TILE *src, *dst;
+	Sint32 x, y;
+	int tries;
+
+	*result = *query;
+
+	src = pf_get_grid_tile(grid, query->src_x, query->src_y);
+	if (!src)
+		return 0;
+
+	dst = pf_get_grid_tile(grid, query->dst_x, query->dst_y);
+	if (dst && dst->z > 0 && pf_find_grid_path(grid, src, dst, path))
+		return 1;
+
+	if (!(query->flags & PF_TRY_NEARBY))
+		return 0;
+
+	for (x = query->dst_x-3, tries = 0; x <= query->dst_x+3 && tries < 4; x++)
+	{
+		for (y = query->dst_y-3; y <= query->dst_y+3 && tries < 4; y++)
+		{
+			if (pf_is_cancelled(grid))
+				return 0;
+
+			if (x == query->dst_x && y == query->dst_y)
+				continue;
+
+			dst = pf_get_grid_tile(grid, x, y);
+			if (dst && dst->z > 0)
+			{
+				if (pf_find_grid_path(grid, src, dst, path))
+				{
+					result->dst_x = x;
+					result->dst_y = y;
+					return 1;
+				}
+				tries++;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int pf_worker_thread(void *data)
+{
+	PF_WORKER *worker = data;
+	PF_QUERY query, result;
+	PF_PATH path, tmp;
+	Uint32 *blocked = NULL, *swap;
+	int blocked_count, blocked_size = 0, size, found;
+	SDL_Event e;
+
+	memset(&path, 0, sizeof(path));
+
+	// built here, so loading the map doesn't wait for it
+	pf_init_grid(&worker->grid, worker->tiles, worker->width, worker->height);
+	worker->grid.newest_query = &worker->newest_query;
+
+	while (1)
+	{
+		CHECK_AND_LOCK_MUTEX(worker->mutex);
+
+		while (worker->running && !worker->has_query)
+		{
+			SDL_CondWait(worker->condition, worker->mutex);
+		}
+
+		if (!worker->running)
+		{
+			CHECK_AND_UNLOCK_MUTEX(worker->mutex);
+			break;
+		}
+
+		query = worker->query;
+		worker->has_query = 0;
+
+		// swap the lists, so the main thread can go on blocking tiles
+		blocked_count = worker->blocked_count;
+		swap = worker->blocked;
+		worker->blocked = blocked;
+		blocked = swap;
+		size = worker->blocked_size;
+		worker->blocked_size = blocked_size;
+		blocked_size = size;
+		worker->blocked_count = 0;
+
+		CHECK_AND_UNLOCK_MUTEX(worker->mutex);
+
+		pf_block_grid_tiles(&worker->grid, blocked, blocked_count);
+
+		worker->grid.query = query.id;
+		found = pf_find_query_path(&worker->grid, &query, &path, &result);
+
+		CHECK_AND_LOCK_MUTEX(worker->mutex);
+
+		if (worker->newest_query != query.id)
+		{
+			// a newer click or pf_destroy_path() cancelled the query
+			CHECK_AND_UNLOCK_MUTEX(worker->mutex);
+			continue;
+		}
+
+		tmp = worker->result;
+		worker->result = path;
+		path = tmp;
+		worker->result_query = result;
+		worker->result_found = found;
+		worker->has_result = 1;
+
+		CHECK_AND_UNLOCK_MUTEX(worker->mutex);
+
+		e.type = SDL_USEREVENT;
+		e.user.code = EVENT_PATH_FOUND;
+		SDL_PushEvent(&e);
+	}
+
+	free(blocked);
+	free(path.tiles);
+	pf_destroy_grid(&worker->grid);
+
+	return 0;
+}
+
+void pf_build_hierarchy()
+{
+	pf_destroy_hierarchy();
+
+	pf_worker.width = tile_map_size_x*6;
+	pf_worker.height = tile_map_size_y*6;
+	pf_worker.tiles = malloc(pf_worker.width*pf_worker.height * sizeof(PF_TILE));
+	memcpy(pf_worker.tiles, pf_tile_map, pf_worker.width*pf_worker.height * sizeof(PF_TILE));
+	pf_worker.mutex = SDL_CreateMutex();
+	pf_worker.condition = SDL_CreateCond();
+	pf_worker.running = 1;
+	pf_worker.thread = SDL_CreateThread(pf_worker_thread, &pf_worker);
+}
+
+void pf_destroy_hierarchy()
+{
+	if (!pf_worker.thread)
+		return;
+
+	CHECK_AND_LOCK_MUTEX(pf_worker.mutex);
+
+	pf_worker.running = 0;
+	pf_worker.newest_query++;
+
+	CHECK_AND_UNLOCK_MUTEX(pf_worker.mutex);
+
+	SDL_CondSignal(pf_worker.condition);
+	SDL_WaitThread(pf_worker.thread, NULL);
+
+	SDL_DestroyCond(pf_worker.condition);
+	SDL_DestroyMutex(pf_worker.mutex);
+
+	free(pf_worker.tiles);
+	free(pf_worker.blocked);
+	free(pf_worker.result.tiles);
+	memset(&pf_worker, 0, sizeof(pf_worker));
+}
+
+void pf_block_tile(int x, int y)
+{
+	PF_TILE *tile = pf_get_tile(x, y);
+
+	if (!tile)
+		return;
+
+	tile->z = 0;
+
+	if (!pf_worker.thread)
+		return;
+
+	CHECK_AND_LOCK_MUTEX(pf_worker.mutex);
+
+	if (pf_worker.blocked_count >= pf_worker.blocked_size)
+	{
+		pf_worker.blocked_size = max2i(pf_worker.blocked_size * 2, 16);
+		pf_worker.blocked = realloc(pf_worker.blocked, pf_worker.blocked_size * sizeof(Uint32));
+	}
+	pf_worker.blocked[pf_worker.blocked_count++] = tile - pf_tile_map;
+
+	CHECK_AND_UNLOCK_MUTEX(pf_worker.mutex);
+}
+
+int pf_request_path(int x, int y, int flags)
+{
+	actor *me;
 
 	pf_destroy_path();
 
@@ -169,48 +1116,89 @@ int pf_find_path(int x, int y)
 	if (!me)
 		return -1;
 
-	pf_src_tile = pf_get_tile(me->x_tile_pos, me->y_tile_pos);
+	if (!pf_worker.thread)
+		return 0;
+
 	pf_dst_tile = pf_get_tile(x, y);
 
-	if (!pf_dst_tile || pf_dst_tile->z == 0)
+	if (!(flags & PF_TRY_NEARBY) && (!pf_dst_tile || pf_dst_tile->z == 0))
 		return 0;
 
-	for (i = 0; i < tile_map_size_x*tile_map_size_y*6*6; i++)
+	CHECK_AND_LOCK_MUTEX(pf_worker.mutex);
+
+	// pf_destroy_path() already cancelled any older query
+	pf_worker.query.id = pf_worker.newest_query;
+	pf_worker.query.src_x = me->x_tile_pos;
+	pf_worker.query.src_y = me->y_tile_pos;
+	pf_worker.query.dst_x = x;
+	pf_worker.query.dst_y = y;
+	pf_worker.query.flags = flags;
+	pf_worker.has_query = 1;
+
+	CHECK_AND_UNLOCK_MUTEX(pf_worker.mutex);
+
+	SDL_CondSignal(pf_worker.condition);
+
+	return 1;
+}
+
+void pf_path_found()
+{
+	PF_PATH tmp;
+	PF_QUERY query;
+	actor *me;
+	int found;
+
+	if (!pf_worker.thread)
+		return;
+
+	CHECK_AND_LOCK_MUTEX(pf_worker.mutex);
+
+	// the event of a cancelled query may still be in the queue
+	if (!pf_worker.has_result || pf_worker.result_query.id != pf_worker.newest_query)
 	{
-		pf_tile_map[i].state = PF_STATE_NONE;
-		pf_tile_map[i].parent = NULL;
+		CHECK_AND_UNLOCK_MUTEX(pf_worker.mutex);
+		return;
 	}
 
-	pf_open.tiles = calloc(tile_map_size_x*tile_map_size_y*6*6, sizeof(PF_TILE*));
-	pf_open.count = 0;
+	tmp = pf_path;
+	pf_path = pf_worker.result;
+	pf_worker.result = tmp;
+	query = pf_worker.result_query;
+	found = pf_worker.result_found;
+	pf_worker.has_result = 0;
 
-	pf_add_tile_to_open_list(NULL, pf_src_tile);
+	CHECK_AND_UNLOCK_MUTEX(pf_worker.mutex);
 
-	while ((pf_cur_tile = pf_get_next_open_tile()) && attempts++ < MAX_PATHFINDER_ATTEMPTS)
+	if (!found)
 	{
-		if (pf_cur_tile == pf_dst_tile)
+		pf_path.count = 0;
+
+		if (query.flags & PF_MOVE_IF_NOT_FOUND)
 		{
-			pf_follow_path = 1;
+			Uint8 str[5];
 
-			pf_movement_timer_callback(0, NULL);
-			pf_movement_timer = SDL_AddTimer(me->step_duration * 10,
-				pf_movement_timer_callback, NULL);
-			break;
+			str[0] = MOVE_TO;
+			*((short *)(str+1)) = SDL_SwapLE16((short)query.dst_x);
+			*((short *)(str+3)) = SDL_SwapLE16((short)query.dst_y);
+			my_tcp_send(my_socket, str, 5);
 		}
+		return;
+	}
 
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x,   pf_cur_tile->y+1));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x+1, pf_cur_tile->y+1));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x+1, pf_cur_tile->y));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x+1, pf_cur_tile->y-1));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x,   pf_cur_tile->y-1));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x-1, pf_cur_tile->y-1));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x-1, pf_cur_tile->y));
-		pf_add_tile_to_open_list(pf_cur_tile, pf_get_tile(pf_cur_tile->x-1, pf_cur_tile->y+1));
+	me = get_our_actor();
+	pf_dst_tile = pf_get_tile(query.dst_x, query.dst_y);
+	if (!me || !pf_dst_tile)
+	{
+		pf_path.count = 0;
+		return;
 	}
 
-	free(pf_open.tiles);
+	pf_follow_path = 1;
 
-	return pf_follow_path;
+	pf_movement_timer_callback(0, NULL);
+	pf_movement_timer = SDL_AddTimer(me->step_duration * 10,
+		pf_movement_timer_callback, NULL);
 }
 
 void pf_destroy_path()
@@ -223,8 +1211,18 @@ void pf_destroy_path()
 		pf_movement_timer = NULL;
 	}
 	pf_follow_path = 0;
+	pf_path.count = 0;
 	for (i = 0; i < 20; i++)
 		pf_visited_squares[i]=-1;
+
+	// cancels the query in flight, if any
+	if (pf_worker.thread)
+	{
+		CHECK_AND_LOCK_MUTEX(pf_worker.mutex);
+		pf_worker.newest_query++;
+		pf_worker.has_query = 0;
+		CHECK_AND_UNLOCK_MUTEX(pf_worker.mutex);
+	}
 }
 
 int checkvisitedlist(int x, int y)
@@ -291,6 +1289,16 @@ static int pf_is_tile_occupied(int x, int y)
 	return 0;
 }
 
+static void pf_send_move_to(const PF_TILE *tile)
+{
+	Uint8 str[5];
+
+	str[0] = MOVE_TO;
+	*((short *)(str+1)) = SDL_SwapLE16((short)tile->x);
+	*((short *)(str+3)) = SDL_SwapLE16((short)tile->y);
+	my_tcp_send(my_socket, str, 5);
+}
+
 void pf_move()
 {
 	int x, y;
@@ -306,48 +1314,33 @@ void pf_move()
 	if (PF_DIFF(x, pf_dst_tile->x) < 2 && PF_DIFF(y, pf_dst_tile->y) < 2) {
 		pf_destroy_path();
 	} else {
-		PF_TILE *t = pf_get_tile(x, y);
-		int i = 0, j = 0;
+		PF_TILE *t = pf_get_tile(x, y), *tile;
+		int i;
 
-		for (pf_cur_tile = pf_dst_tile; pf_cur_tile; pf_cur_tile = pf_cur_tile->parent) {
-			if (pf_cur_tile == t) {
+		for (i = 0; i < pf_path.count; i++) {
+			if (&pf_tile_map[pf_path.tiles[i]] == t) {
 				break;
 			}
-			i++;
 		}
 
-		if (pf_cur_tile == t) {
+		if (i < pf_path.count) {
 #ifdef	FUZZY_PATHS
 			int	limit= i-(10+rand()%3);
 #else	//FUZZY_PATHS
 			int	limit= i-12;
 #endif	//FUZZY_PATHS
-			for (pf_cur_tile = pf_dst_tile; pf_cur_tile; pf_cur_tile = pf_cur_tile->parent) {
-				if (j++ == limit) {
-					break;
-				}
-			}
-			if (pf_cur_tile) {
-				Uint8 str[5];
-
-				str[0] = MOVE_TO;
-				*((short *)(str+1)) = SDL_SwapLE16((short)pf_cur_tile->x);
-				*((short *)(str+3)) = SDL_SwapLE16((short)pf_cur_tile->y);
-				my_tcp_send(my_socket, str, 5);
+			if (limit >= 0) {
+				pf_send_move_to(&pf_tile_map[pf_path.tiles[limit]]);
 
 				return;
 			}
 		}
 
-		for (pf_cur_tile = pf_dst_tile; pf_cur_tile; pf_cur_tile = pf_cur_tile->parent) {
-			if (PF_DIFF(x, pf_cur_tile->x) <= 12 && PF_DIFF(y, pf_cur_tile->y) <= 12
-			&& !pf_is_tile_occupied(pf_cur_tile->x, pf_cur_tile->y)) {
-				Uint8 str[5];
-
-				str[0] = MOVE_TO;
-				*((short *)(str+1)) = SDL_SwapLE16((short)pf_cur_tile->x);
-				*((short *)(str+3)) = SDL_SwapLE16((short)pf_cur_tile->y);
-				my_tcp_send(my_socket, str, 5);
+		for (i = 0; i < pf_path.count; i++) {
+			tile = &pf_tile_map[pf_path.tiles[i]];
+			if (PF_DIFF(x, tile->x) <= 12 && PF_DIFF(y, tile->y) <= 12
+			&& !pf_is_tile_occupied(tile->x, tile->y)) {
+				pf_send_move_to(tile);
 				break;
 			}
 		}
@@ -384,29 +1377,131 @@ int pf_get_mouse_position_extended(int mouse_x, int mouse_y, int * px, int * py,
 
 void pf_move_to_mouse_position()
 {
-	int x, y, clicked_x, clicked_y;
-	int tries;
+	int clicked_x, clicked_y;
 
 	if (!pf_get_mouse_position(mouse_x, mouse_y, &clicked_x, &clicked_y)) return;
-	x = clicked_x; y = clicked_y;
 
-	if (pf_find_path(x, y))
+	// the worker tries a few tiles around the click if the clicked one can't be reached
+	pf_request_path(clicked_x, clicked_y, PF_TRY_NEARBY);
+}
+
+#ifdef DEBUG
+// picks a random walkable tile at least min_distance away from the other tile
+static PF_TILE *pf_get_random_tile(PF_GRID *grid, const PF_TILE *other, int min_distance)
+{
+	PF_TILE *tile;
+	int i;
+
+	for (i = 0; i < 10000; i++)
+	{
+		tile = &grid->tiles[(rand() % grid->height) * grid->width + rand() % grid->width];
+		if (tile->z == 0)
+			continue;
+		if (other && PF_DIFF(tile->x, other->x) + PF_DIFF(tile->y, other->y) < min_distance)
+			continue;
+		return tile;
+	}
+
+	return NULL;
+}
+
+static void pf_benchmark_map(const char *file_name, int queries)
+{
+	map_header header;
+	el_file_ptr file;
+	const Uint8 *height_map;
+	PF_GRID grid;
+	PF_PATH path;
+	PF_TILE *tiles, *src, *dst;
+	PF_RECT rect;
+	Sint32 width, height, i;
+	Uint32 start, build_time, search_time, graph_time;
+	int search_found, graph_found, count;
+	char str[256];
+
+	file = el_open(file_name);
+	if (!file)
+		return;
+
+	memcpy(&header, el_get_pointer(file), sizeof(header));
+	width = SDL_SwapLE32(header.tile_map_x_len) * 6;
+	height = SDL_SwapLE32(header.tile_map_y_len) * 6;
+	height_map = (const Uint8 *)el_get_pointer(file) + SDL_SwapLE32(header.height_map_offset);
+
+	if (width <= 0 || height <= 0 || SDL_SwapLE32(header.height_map_offset) + width * height > el_get_size(file))
+	{
+		el_close(file);
 		return;
+	}
 
-	for (x= clicked_x-3, tries= 0; x <= clicked_x+3 && tries < 4 ; x++)
+	tiles = calloc(width * height, sizeof(PF_TILE));
+	for (i = 0; i < width * height; i++)
 	{
-		for (y= clicked_y-3; y <= clicked_y+3 && tries < 4; y++)
-		{
-			if (x == clicked_x && y == clicked_y)
-				continue;
+		tiles[i].x = i % width;
+		tiles[i].y = i / width;
+		tiles[i].z = height_map[i];
+	}
+	el_close(file);
+
+	start = SDL_GetTicks();
+	pf_init_grid(&grid, tiles, width, height);
+	build_time = SDL_GetTicks() - start;
+
+	memset(&path, 0, sizeof(path));
+	rect.min_x = 0;
+	rect.min_y = 0;
+	rect.max_x = width - 1;
+	rect.max_y = height - 1;
+	search_time = graph_time = 0;
+	search_found = graph_found = count = 0;
+	srand(1);
+
+	for (i = 0; i < queries; i++)
+	{
+		src = pf_get_random_tile(&grid, NULL, 0);
+		dst = pf_get_random_tile(&grid, src, (width + height) / 4);
+		if (!src || !dst)
+			continue;
+		count++;
+
+		start = SDL_GetTicks();
+		search_found += pf_search_tiles(&grid, src, dst, &rect, MAX_PATHFINDER_ATTEMPTS);
+		search_time += SDL_GetTicks() - start;
+
+		start = SDL_GetTicks();
+		graph_found += pf_find_grid_path(&grid, src, dst, &path);
+		graph_time += SDL_GetTicks() - start;
+	}
 
-			pf_dst_tile = pf_get_tile(x, y);
-			if (pf_dst_tile && pf_dst_tile->z > 0)
-			{
-				if (pf_find_path(x, y))
-					return;
-				tries++;
-			}
-		}
+	safe_snprintf(str, sizeof(str), "%s: %dx%d, %u nodes, %u edges, build %u ms, %d paths: A* %u ms (%d found), clusters %u ms (%d found)",
+		file_name, width, height, grid.node_count, grid.edge_count, build_time, count,
+		search_time, search_found, graph_time, graph_found);
+	LOG_TO_CONSOLE(c_grey1, str);
+
+	free(path.tiles);
+	pf_destroy_grid(&grid);
+	free(tiles);
+}
+
+int pf_benchmark(char *text, int len)
+{
+	int i;
+
+	while (len > 0 && isspace(*text))
+	{
+		text++;
+		len--;
 	}
+
+	if (len > 0)
+	{
+		pf_benchmark_map(text, 50);
+		return 1;
+	}
+
+	for (i = 0; continent_maps[i].name != NULL; i++)
+		pf_benchmark_map(continent_maps[i].name, 50);
+
+	return 1;
 }
+#endif
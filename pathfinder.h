@@ -20,6 +20,15 @@ extern "C" {
 #define	MAX_PATHFINDER_ATTEMPTS 200000
 /*! @} */
 
+/*!
+ * \name Path request flags
+ * @{
+ *      Flags for \see pf_request_path.
+ */
+#define PF_TRY_NEARBY		1 /*!< try a few tiles around the target if it can't be reached */
+#define PF_MOVE_IF_NOT_FOUND	2 /*!< send a plain move to the target if no path is found */
+/*! @} */
+
 /*!
  * \name Pathfinder states
  * @{
@@ -38,10 +47,11 @@ enum {
 typedef struct
 {
 	Uint32 open_pos;
+	Uint32 search; /*!< the search that last visited the tile, the state is only valid for this search */
 	Sint32 x;
 	Sint32 y;
-	Uint16 f;
-	Uint16 g;
+	Uint32 f;
+	Uint32 g;
 
 	Uint8 state; /*!< the current state pathfinder states */
 	Uint8 z;
@@ -64,16 +74,57 @@ extern int pf_follow_path; /*!< flag, that indicates whether we should follow th
 
 /*!
  * \ingroup move_actors
- * \brief Finds a path to the given position
+ * \brief Requests a path to the given position
  *
- *      Finds a path from the current position to the given target position (x,y).
+ *      Cancels the current path and any request still in flight, and asks the pathfinder thread for a path from the current position to the given target position (x,y). The actor starts to follow the path in \see pf_path_found, once it is found.
  *
  * \param x     x coordinate of the target position
  * \param y     y coordinate of the target position
- * \retval int
+ * \param flags the path request flags
+ * \retval int  1 if the path was requested, 0 if the target is not walkable, -1 if there is no actor
+ * \callgraph
+ */
+int pf_request_path(int x, int y, int flags);
+
+/*!
+ * \ingroup move_actors
+ * \brief Starts to follow the path found by the pathfinder thread
+ *
+ *      Called for the EVENT_PATH_FOUND event. Results of cancelled requests are ignored.
+ *
+ * \callgraph
+ */
+void pf_path_found();
+
+/*!
+ * \ingroup move_actors
+ * \brief Builds the cluster graph of the current map
+ *
+ *      Copies \see pf_tile_map for the pathfinder thread and starts it. The thread splits the copy into clusters and builds the graph of the entrances between them, used to find long paths quickly. Must be called after \see pf_tile_map is created.
+ *
  * \callgraph
  */
-int pf_find_path(int x, int y);
+void pf_build_hierarchy();
+
+/*!
+ * \ingroup move_actors
+ * \brief Frees the cluster graph of the current map
+ *
+ *      Stops the pathfinder thread and frees the cluster graph of the current map, must be called before \see pf_tile_map is freed.
+ *
+ */
+void pf_destroy_hierarchy();
+
+/*!
+ * \ingroup move_actors
+ * \brief Marks a tile as not walkable
+ *
+ *      Marks the tile (x,y) as not walkable. The copy of the pathfinder thread is updated before the next path is searched.
+ *
+ * \param x     x coordinate of the tile
+ * \param y     y coordinate of the tile
+ */
+void pf_block_tile(int x, int y);
 
 /*!
  * \ingroup move_actors
@@ -140,6 +191,20 @@ int pf_get_mouse_position(int mouse_x, int mouse_y, int * px, int * py);
  */
 int pf_get_mouse_position_extended(int mouse_x, int mouse_y, int * px, int * py, int tile_x, int tile_y);
 
+#ifdef DEBUG
+/*!
+ * \ingroup move_actors
+ * \brief Times random long paths on the shipped maps
+ *
+ *      Searches random long paths on the map given in \a text, or on all continent maps, once with A* on the tiles and once over the cluster graph, and prints the times to the console.
+ *
+ * \param text    the map file name or an empty string for all continent maps
+ * \param len     the length of \a text
+ * \retval int    always 1
+ */
+int pf_benchmark(char *text, int len);
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
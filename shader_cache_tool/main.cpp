@@ -0,0 +1,89 @@
+#include "prerequisites.hpp"
+#include "globalvars.hpp"
+#include "filesystem.hpp"
+#include "logging.hpp"
+#include "effect/effectcache.hpp"
+#include "shader/glslprogramcache.hpp"
+#include "shader/shadersourcebuilder.hpp"
+#include "shader/uniformbufferdescriptioncache.hpp"
+#include "thread/jobsystem.hpp"
+
+using namespace eternal_lands;
+
+/**
+ * Fills the shader source disk cache with the sources of all effects for
+ * all OpenGL versions the client uses, so no shader source needs to be
+ * built at the first start.
+ * Usage: shader_cache_tool <data dir> <cache dir>
+ */
+int main(int argc, char *argv[])
+{
+	GlobalVarsSharedPtr global_vars;
+	FileSystemSharedPtr file_system;
+	JobSystemSharedPtr job_system;
+	UniformBufferDescriptionCacheSharedPtr
+		uniform_buffer_description_cache;
+	ShaderSourceBuilderSharedPtr shader_source_builder;
+	GlslProgramCacheSharedPtr glsl_program_cache;
+	EffectCacheSharedPtr effect_cache;
+	std::string cache_dir;
+	Uint32 i;
+
+	if (argc < 3)
+	{
+		std::cout << "Usage: " << argv[0] << " <data dir> "
+			"<cache dir>" << std::endl;
+
+		return -1;
+	}
+
+	init_logging("log", false);
+
+	cache_dir = argv[2];
+	cache_dir += "/";
+
+	global_vars = boost::make_shared<GlobalVars>();
+	global_vars->set_shader_source_cache_dir(String(cache_dir));
+
+	file_system = boost::make_shared<FileSystem>();
+	file_system->add_dir(String(argv[1]));
+
+	job_system = boost::make_shared<JobSystem>(
+		JobSystem::get_default_thread_count());
+	uniform_buffer_description_cache =
+		boost::make_shared<UniformBufferDescriptionCache>();
+	shader_source_builder = boost::make_shared<ShaderSourceBuilder>(
+		global_vars, file_system, uniform_buffer_description_cache);
+	glsl_program_cache = boost::make_shared<GlslProgramCache>(
+		global_vars, uniform_buffer_description_cache);
+	effect_cache = boost::make_shared<EffectCache>(glsl_program_cache,
+		shader_source_builder, job_system);
+
+	shader_source_builder->load_xml(String(UTF8("shaders/shaders.xml")));
+	shader_source_builder->load_shader_sources(
+		String(UTF8("shaders/sources")));
+	shader_source_builder->load_shader_sources(
+		String(UTF8("shaders/terrains")));
+
+	for (i = ovt_2_1; i <= ovt_3_3; ++i)
+	{
+		global_vars->set_opengl_version(
+			static_cast<OpenglVerionType>(i));
+
+		effect_cache->build_sources(file_system,
+			String(UTF8("shaders/effects")));
+	}
+
+	std::cout << "Shader sources of " <<
+		effect_cache->get_effect_names().size() << " effects saved "
+		"in '" << cache_dir << "'" << std::endl;
+
+	effect_cache.reset();
+	glsl_program_cache.reset();
+	shader_source_builder.reset();
+	job_system.reset();
+
+	exit_logging();
+
+	return 0;
+}
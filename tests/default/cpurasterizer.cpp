@@ -0,0 +1,198 @@
+/****************************************************************************
+ *            cpurasterizer.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "cpurasterizer.hpp"
+#include "boundingbox.hpp"
+#include "thread/jobsystem.hpp"
+#define BOOST_TEST_MODULE cpu_rasterizer
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	/**
+	 * A wall at z = -20, from -10 to 10 in x and y, split into
+	 * quads with alternating winding.
+	 */
+	void build_wall(el::AlignedVec4Array &vertices,
+		Uint32Vector &indices)
+	{
+		Uint32 x, y, i;
+
+		vertices.resize(0);
+		indices.clear();
+
+		for (y = 0; y < 5; ++y)
+		{
+			for (x = 0; x < 5; ++x)
+			{
+				vertices.push_back(glm::vec4(x * 5.0f - 10.0f,
+					y * 5.0f - 10.0f, -20.0f, 1.0f));
+			}
+		}
+
+		for (y = 0; y < 4; ++y)
+		{
+			for (x = 0; x < 4; ++x)
+			{
+				i = y * 5 + x;
+
+				if (((x + y) % 2) == 0)
+				{
+					indices.push_back(i);
+					indices.push_back(i + 1);
+					indices.push_back(i + 6);
+					indices.push_back(i);
+					indices.push_back(i + 6);
+					indices.push_back(i + 5);
+				}
+				else
+				{
+					indices.push_back(i);
+					indices.push_back(i + 6);
+					indices.push_back(i + 1);
+					indices.push_back(i);
+					indices.push_back(i + 5);
+					indices.push_back(i + 6);
+				}
+			}
+		}
+	}
+
+	void build_boxes(el::AlignedSint16Vec8Array &min_max_boxes)
+	{
+		min_max_boxes.resize(0);
+
+		/* Behind the wall */
+		el::CpuRasterizer::append_min_max_box(el::BoundingBox(
+			glm::vec3(-1.0f, -1.0f, -40.0f),
+			glm::vec3(1.0f, 1.0f, -38.0f)), min_max_boxes);
+		/* In front of the wall */
+		el::CpuRasterizer::append_min_max_box(el::BoundingBox(
+			glm::vec3(-1.0f, -1.0f, -15.0f),
+			glm::vec3(1.0f, 1.0f, -13.0f)), min_max_boxes);
+		/* Behind the wall, but sticking out at the side */
+		el::CpuRasterizer::append_min_max_box(el::BoundingBox(
+			glm::vec3(5.0f, -1.0f, -40.0f),
+			glm::vec3(20.0f, 1.0f, -38.0f)), min_max_boxes);
+		/* Going through the wall */
+		el::CpuRasterizer::append_min_max_box(el::BoundingBox(
+			glm::vec3(-1.0f, -1.0f, -22.0f),
+			glm::vec3(1.0f, 1.0f, -18.0f)), min_max_boxes);
+		/* Far behind the wall */
+		el::CpuRasterizer::append_min_max_box(el::BoundingBox(
+			glm::vec3(2.0f, 2.0f, -200.0f),
+			glm::vec3(4.0f, 4.0f, -190.0f)), min_max_boxes);
+		/* Crossing the near plane */
+		el::CpuRasterizer::append_min_max_box(el::BoundingBox(
+			glm::vec3(-1.0f, -1.0f, -3.0f),
+			glm::vec3(1.0f, 1.0f, 2.0f)), min_max_boxes);
+	}
+
+	el::BitSet64 check_occlusion(const bool use_simd,
+		el::JobSystem* job_system)
+	{
+		el::CpuRasterizer cpu_rasterizer(1024, 768, 0.0f, use_simd);
+		el::AlignedVec4Array vertices;
+		el::AlignedSint16Vec8Array min_max_boxes;
+		Uint32Vector indices;
+		glm::mat4x4 projection;
+
+		build_wall(vertices, indices);
+		build_boxes(min_max_boxes);
+
+		projection = glm::perspective(60.0f, 4.0f / 3.0f, 1.0f,
+			500.0f);
+
+		cpu_rasterizer.clear_occluders(projection);
+		cpu_rasterizer.add_occluder(glm::mat4x3(), vertices, indices);
+		cpu_rasterizer.rasterize_occluders(job_system);
+
+		BOOST_CHECK_EQUAL(cpu_rasterizer.get_occluder_triangle_count(),
+			32);
+
+		/* Occlusion only for the matrix the occluders used */
+		BOOST_CHECK_EQUAL(cpu_rasterizer.check_visibility(
+			glm::translate(projection, glm::vec3(0.0f, 0.0f,
+				1.0f)), glm::mat4x3(), min_max_boxes).count(),
+			min_max_boxes.size());
+
+		return cpu_rasterizer.check_visibility(projection,
+			glm::mat4x3(), min_max_boxes);
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(default_creation)
+{
+	el::CpuRasterizer cpu_rasterizer(1024, 768, 5.0f, false);
+
+	BOOST_CHECK_EQUAL(cpu_rasterizer.get_width(), 1024);
+	BOOST_CHECK_EQUAL(cpu_rasterizer.get_height(), 768);
+	BOOST_CHECK_EQUAL(cpu_rasterizer.get_tiles_x(), 8);
+	BOOST_CHECK_EQUAL(cpu_rasterizer.get_tiles_y(), 6);
+	BOOST_CHECK_EQUAL(cpu_rasterizer.get_occluder_triangle_count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(occlusion)
+{
+	el::BitSet64 result;
+
+	result = check_occlusion(false, nullptr);
+
+	BOOST_CHECK(!result[0]);
+	BOOST_CHECK(result[1]);
+	BOOST_CHECK(result[2]);
+	BOOST_CHECK(result[3]);
+	BOOST_CHECK(!result[4]);
+	BOOST_CHECK(result[5]);
+}
+
+BOOST_AUTO_TEST_CASE(occlusion_simd_job_system)
+{
+	el::JobSystem job_system(2);
+	el::BitSet64 result;
+	Uint32 i;
+
+	for (i = 0; i < 2; ++i)
+	{
+		if (i == 0)
+		{
+			result = check_occlusion(true, nullptr);
+		}
+		else
+		{
+			result = check_occlusion(true, &job_system);
+		}
+
+		BOOST_CHECK(!result[0]);
+		BOOST_CHECK(result[1]);
+		BOOST_CHECK(result[2]);
+		BOOST_CHECK(result[3]);
+		BOOST_CHECK(!result[4]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(no_occluders)
+{
+	el::CpuRasterizer cpu_rasterizer(1024, 768, 0.0f, false);
+	el::AlignedSint16Vec8Array min_max_boxes;
+	glm::mat4x4 projection;
+
+	build_boxes(min_max_boxes);
+
+	projection = glm::perspective(60.0f, 4.0f / 3.0f, 1.0f, 500.0f);
+
+	cpu_rasterizer.clear_occluders(projection);
+	cpu_rasterizer.rasterize_occluders(nullptr);
+
+	BOOST_CHECK_EQUAL(cpu_rasterizer.check_visibility(projection,
+		glm::mat4x3(), min_max_boxes).count(), min_max_boxes.size());
+}
@@ -0,0 +1,194 @@
+/****************************************************************************
+ *            glslprogramcache.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "shader/glslprogramcache.hpp"
+#include "readwritememory.hpp"
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <boost/random.hpp>
+#define BOOST_TEST_MODULE glsl_program_cache
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	const el::String file_name(UTF8("glslprogramcache.elpb"));
+	const el::String key(UTF8("da39a3ee5e6b4b0d3255bfef95601890afd80709"));
+	const GLenum binary_format = 0x8741;
+
+	void fill_random(el::ReadWriteMemory &binary, const Uint32 size)
+	{
+		boost::mt19937 rng;
+		boost::uniform_int<Uint32> range(0, 255);
+		boost::variate_generator<boost::mt19937&,
+			boost::uniform_int<Uint32> > random_byte(rng, range);
+		Uint32 i;
+
+		binary.resize(size);
+
+		for (i = 0; i < size; ++i)
+		{
+			static_cast<Uint8*>(binary.get_ptr())[i] =
+				random_byte();
+		}
+	}
+
+	std::string read_file()
+	{
+		std::ifstream stream(file_name.get().c_str(),
+			std::ios::binary | std::ios::in);
+
+		return std::string(std::istreambuf_iterator<char>(stream),
+			std::istreambuf_iterator<char>());
+	}
+
+	void write_file(const std::string &data)
+	{
+		std::ofstream stream(file_name.get().c_str(),
+			std::ios::binary | std::ios::out | std::ios::trunc);
+
+		stream.write(data.c_str(), data.size());
+	}
+
+	bool load(el::ReadWriteMemory &binary)
+	{
+		GLenum format;
+
+		format = 0;
+
+		return el::GlslProgramCache::load_cached_binary(file_name, key,
+			format, binary);
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(save_load)
+{
+	el::ReadWriteMemory binary, loaded;
+	GLenum format;
+
+	fill_random(binary, 4099);
+
+	BOOST_CHECK(el::GlslProgramCache::save_cached_binary(file_name,
+		key, binary_format, binary));
+
+	format = 0;
+
+	BOOST_CHECK(el::GlslProgramCache::load_cached_binary(file_name,
+		key, format, loaded));
+
+	BOOST_CHECK_EQUAL(format, binary_format);
+	BOOST_CHECK_EQUAL(loaded.get_size(), binary.get_size());
+	BOOST_CHECK_EQUAL(memcmp(loaded.get_ptr(), binary.get_ptr(),
+		binary.get_size()), 0);
+
+	std::remove(file_name.get().c_str());
+}
+
+BOOST_AUTO_TEST_CASE(load_missing)
+{
+	el::ReadWriteMemory loaded;
+
+	std::remove(file_name.get().c_str());
+
+	BOOST_CHECK(!load(loaded));
+	BOOST_CHECK_EQUAL(loaded.get_size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(key_mismatch)
+{
+	el::ReadWriteMemory binary, loaded;
+	GLenum format;
+
+	fill_random(binary, 256);
+
+	BOOST_CHECK(el::GlslProgramCache::save_cached_binary(file_name,
+		el::String(UTF8("other key")), binary_format, binary));
+
+	BOOST_CHECK(!load(loaded));
+	BOOST_CHECK_EQUAL(loaded.get_size(), 0);
+
+	BOOST_CHECK(el::GlslProgramCache::save_cached_binary(file_name,
+		el::String(UTF8("da39a3ee5e6b4b0d3255bfef95601890afd80708")),
+		binary_format, binary));
+
+	format = 0;
+
+	BOOST_CHECK(!el::GlslProgramCache::load_cached_binary(file_name,
+		key, format, loaded));
+	BOOST_CHECK_EQUAL(loaded.get_size(), 0);
+
+	std::remove(file_name.get().c_str());
+}
+
+BOOST_AUTO_TEST_CASE(format_mismatch)
+{
+	el::ReadWriteMemory binary, loaded;
+	std::string data, changed;
+	Uint32 i;
+
+	fill_random(binary, 256);
+
+	BOOST_CHECK(el::GlslProgramCache::save_cached_binary(file_name,
+		key, binary_format, binary));
+
+	data = read_file();
+
+	BOOST_CHECK(load(loaded));
+
+	// magic number and version
+	for (i = 0; i < 8; ++i)
+	{
+		changed = data;
+		changed[i] ^= 0x10;
+
+		write_file(changed);
+
+		BOOST_CHECK(!load(loaded));
+		BOOST_CHECK_EQUAL(loaded.get_size(), 0);
+	}
+
+	std::remove(file_name.get().c_str());
+}
+
+BOOST_AUTO_TEST_CASE(truncated)
+{
+	el::ReadWriteMemory binary, loaded;
+	std::string data;
+	Uint32 i;
+
+	fill_random(binary, 256);
+
+	BOOST_CHECK(el::GlslProgramCache::save_cached_binary(file_name,
+		key, binary_format, binary));
+
+	data = read_file();
+
+	BOOST_CHECK(load(loaded));
+
+	for (i = 0; i < data.size(); i += 7)
+	{
+		write_file(data.substr(0, i));
+
+		BOOST_CHECK(!load(loaded));
+		BOOST_CHECK_EQUAL(loaded.get_size(), 0);
+	}
+
+	write_file(data.substr(0, data.size() - 1));
+
+	BOOST_CHECK(!load(loaded));
+
+	write_file(data + std::string(1, '\0'));
+
+	BOOST_CHECK(!load(loaded));
+
+	std::remove(file_name.get().c_str());
+}
@@ -8,6 +8,9 @@
 #include "prerequisites.hpp"
 #include "image.hpp"
 #include "packtool.hpp"
+#include "imageview.hpp"
+#include "exceptions.hpp"
+#include "tools/timeutil.hpp"
 #include <boost/random.hpp>
 #define BOOST_TEST_MODULE image
 #include <boost/test/unit_test.hpp>
@@ -132,6 +135,125 @@ namespace
 		}
 	}
 
+	template <typename T>
+	void check_view(const el::TextureFormatType texture_format)
+	{
+		boost::mt19937 rng;
+		boost::uniform_01<boost::mt19937&> random_float(rng);
+		el::ImageSharedPtr image;
+		glm::vec4 color;
+		Uint32 x, y, z, i;
+
+		image = boost::make_shared<el::Image>(el::String("image"),
+			false, texture_format, glm::uvec3(17, 13, 3), 0, false);
+
+		el::ImageView<T> view(*image, 0, 0);
+
+		BOOST_CHECK_EQUAL(view.get_width(), 17);
+		BOOST_CHECK_EQUAL(view.get_height(), 13);
+		BOOST_CHECK_EQUAL(view.get_depth(), 3);
+		BOOST_CHECK_EQUAL(view.get_row_end(0, 0) - view.get_row(0, 0),
+			17 * T::value_count);
+
+		for (z = 0; z < 3; ++z)
+		{
+			for (y = 0; y < 13; ++y)
+			{
+				for (x = 0; x < 17; ++x)
+				{
+					for (i = 0; i < 4; ++i)
+					{
+						color[i] = random_float();
+					}
+
+					image->set_pixel(x, y, z, 0, 0, color);
+
+					for (i = 0; i < 4; ++i)
+					{
+						BOOST_CHECK_EQUAL(
+							view.get_pixel(x, y,
+								z)[i],
+							image->get_pixel(x, y,
+								z, 0, 0)[i]);
+					}
+
+					view.set_pixel(x, y, z, color);
+
+					for (i = 0; i < 4; ++i)
+					{
+						BOOST_CHECK_EQUAL(
+							view.get_pixel(x, y,
+								z)[i],
+							image->get_pixel(x, y,
+								z, 0, 0)[i]);
+					}
+				}
+			}
+		}
+	}
+
+	template <typename T>
+	void benchmark_view(const el::TextureFormatType texture_format)
+	{
+		el::ImageSharedPtr image;
+		typename T::value_type* row;
+		glm::vec4 value;
+		double start, generic_time, view_time;
+		Uint32 x, y, i, count, size;
+
+		size = 512;
+		count = 8;
+
+		image = boost::make_shared<el::Image>(el::String("image"),
+			false, texture_format, glm::uvec3(size, size, 1), 0,
+			false);
+
+		el::ImageView<T> view(*image, 0, 0);
+
+		start = el::get_time();
+
+		for (i = 0; i < count; ++i)
+		{
+			for (y = 0; y < size; ++y)
+			{
+				for (x = 0; x < size; ++x)
+				{
+					value = image->get_pixel(x, y, 0, 0,
+						0);
+					image->set_pixel(x, y, 0, 0, 0,
+						value * 0.5f + 0.25f);
+				}
+			}
+		}
+
+		generic_time = std::max(el::get_time() - start, 0.001);
+
+		start = el::get_time();
+
+		for (i = 0; i < count; ++i)
+		{
+			for (y = 0; y < size; ++y)
+			{
+				row = view.get_row(y, 0);
+
+				for (x = 0; x < size; ++x)
+				{
+					value = T::get(row);
+					T::set(value * 0.5f + 0.25f, row);
+					row += T::value_count;
+				}
+			}
+		}
+
+		view_time = std::max(el::get_time() - start, 0.001);
+
+		BOOST_TEST_MESSAGE(el::TextureFormatUtil::get_str(
+			texture_format) << ": get_pixel/set_pixel " <<
+			(count * size * size / (generic_time * 1000.0)) <<
+			" MPixels/s, view " << (count * size * size /
+			(view_time * 1000.0)) << " MPixels/s");
+	}
+
 }
 
 BOOST_FIXTURE_TEST_SUITE(texture_formats, TextureFormats)
@@ -963,3 +1085,41 @@ BOOST_AUTO_TEST_CASE(set_get_rgb5_a1_value)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_CASE(image_view)
+{
+	check_view<el::ImagePixelR8>(el::tft_r8);
+	check_view<el::ImagePixelRG8>(el::tft_rg8);
+	check_view<el::ImagePixelRGB8>(el::tft_rgb8);
+	check_view<el::ImagePixelRGBA8>(el::tft_rgba8);
+	check_view<el::ImagePixelRGBA16>(el::tft_rgba16);
+	check_view<el::ImagePixelRGB10A2>(el::tft_rgb10_a2);
+	check_view<el::ImagePixelR16F>(el::tft_r16f);
+	check_view<el::ImagePixelRGBA16F>(el::tft_rgba16f);
+	check_view<el::ImagePixelR32F>(el::tft_r32f);
+	check_view<el::ImagePixelRGBA32F>(el::tft_rgba32f);
+}
+
+BOOST_AUTO_TEST_CASE(image_view_invalid)
+{
+	el::ImageSharedPtr image;
+
+	image = boost::make_shared<el::Image>(el::String("image"), false,
+		el::tft_rgba8, glm::uvec3(4, 4, 1), 0, false);
+
+	BOOST_CHECK(el::ConstImageView<el::ImagePixelRGBA8>::get_supported(
+		*image));
+	BOOST_CHECK(!el::ConstImageView<el::ImagePixelRGB8>::get_supported(
+		*image));
+	BOOST_CHECK_THROW(el::ImageView<el::ImagePixelR16F>(*image, 0, 0),
+		el::InvalidParameterException);
+	BOOST_CHECK_THROW(el::ImageView<el::ImagePixelRGB10A2>(*image, 0,
+		0), el::InvalidParameterException);
+}
+
+BOOST_AUTO_TEST_CASE(image_view_benchmark)
+{
+	benchmark_view<el::ImagePixelRGBA8>(el::tft_rgba8);
+	benchmark_view<el::ImagePixelRGB10A2>(el::tft_rgb10_a2);
+	benchmark_view<el::ImagePixelR16F>(el::tft_r16f);
+}
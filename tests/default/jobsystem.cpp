@@ -0,0 +1,282 @@
+/****************************************************************************
+ *            jobsystem.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "thread/abstractthreadtask.hpp"
+#include "thread/atomicutil.hpp"
+#include "thread/jobsystem.hpp"
+#include "thread/taskgroup.hpp"
+#include "thread/threadpool.hpp"
+#include "tools/timeutil.hpp"
+#define BOOST_TEST_MODULE job_system
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	class CountTask: public el::AbstractThreadTask
+	{
+		private:
+			volatile Sint32* m_counter;
+			Uint32 m_work;
+
+		public:
+			CountTask(volatile Sint32* counter, const Uint32 work);
+			virtual ~CountTask() throw();
+			virtual void operator()();
+
+	};
+
+	CountTask::CountTask(volatile Sint32* counter, const Uint32 work):
+		m_counter(counter), m_work(work)
+	{
+	}
+
+	CountTask::~CountTask() throw()
+	{
+	}
+
+	void CountTask::operator()()
+	{
+		volatile float value;
+		Uint32 i;
+
+		value = 1.0f;
+
+		for (i = 0; i < m_work; ++i)
+		{
+			value = std::sqrt(value + i);
+		}
+
+		el::AtomicUtil::increment(m_counter);
+	}
+
+	class SplitTask: public el::AbstractThreadTask
+	{
+		private:
+			el::JobSystem* m_job_system;
+			volatile Sint32* m_counter;
+			Uint32 m_depth;
+
+		public:
+			SplitTask(el::JobSystem* job_system,
+				volatile Sint32* counter, const Uint32 depth);
+			virtual ~SplitTask() throw();
+			virtual void operator()();
+
+	};
+
+	SplitTask::SplitTask(el::JobSystem* job_system,
+		volatile Sint32* counter, const Uint32 depth):
+		m_job_system(job_system), m_counter(counter), m_depth(depth)
+	{
+	}
+
+	SplitTask::~SplitTask() throw()
+	{
+	}
+
+	void SplitTask::operator()()
+	{
+		std::auto_ptr<el::AbstractThreadTask> task;
+
+		el::AtomicUtil::increment(m_counter);
+
+		if (m_depth == 0)
+		{
+			return;
+		}
+
+		task.reset(new SplitTask(m_job_system, m_counter,
+			m_depth - 1));
+		m_job_system->add_child(task, this);
+
+		task.reset(new SplitTask(m_job_system, m_counter,
+			m_depth - 1));
+		m_job_system->add_child(task, this);
+	}
+
+	class CheckTask: public el::AbstractThreadTask
+	{
+		private:
+			volatile Sint32* m_counter;
+			volatile Sint32* m_result;
+			Sint32 m_expected;
+
+		public:
+			CheckTask(volatile Sint32* counter,
+				volatile Sint32* result, const Sint32 expected);
+			virtual ~CheckTask() throw();
+			virtual void operator()();
+
+	};
+
+	CheckTask::CheckTask(volatile Sint32* counter, volatile Sint32* result,
+		const Sint32 expected): m_counter(counter), m_result(result),
+		m_expected(expected)
+	{
+	}
+
+	CheckTask::~CheckTask() throw()
+	{
+	}
+
+	void CheckTask::operator()()
+	{
+		*m_result = el::AtomicUtil::load(m_counter) == m_expected;
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(task_group)
+{
+	el::JobSystem job_system(3);
+	el::TaskGroup task_group;
+	std::auto_ptr<el::AbstractThreadTask> task;
+	volatile Sint32 counter;
+	Uint32 i;
+
+	counter = 0;
+
+	for (i = 0; i < 10000; ++i)
+	{
+		task.reset(new CountTask(&counter, 10));
+
+		job_system.add(task, task_group);
+	}
+
+	job_system.wait(task_group);
+
+	BOOST_CHECK_EQUAL(counter, 10000);
+	BOOST_CHECK(task_group.get_done());
+}
+
+BOOST_AUTO_TEST_CASE(no_workers)
+{
+	el::JobSystem job_system(0);
+	el::TaskGroup task_group;
+	std::auto_ptr<el::AbstractThreadTask> task;
+	volatile Sint32 counter;
+	Uint32 i;
+
+	counter = 0;
+
+	for (i = 0; i < 100; ++i)
+	{
+		task.reset(new CountTask(&counter, 10));
+
+		job_system.add(task, task_group);
+	}
+
+	job_system.wait(task_group);
+
+	BOOST_CHECK_EQUAL(job_system.get_thread_count(), 1);
+	BOOST_CHECK_EQUAL(counter, 100);
+}
+
+BOOST_AUTO_TEST_CASE(children)
+{
+	el::JobSystem job_system(3);
+	el::TaskGroup task_group;
+	std::auto_ptr<el::AbstractThreadTask> task;
+	volatile Sint32 counter;
+
+	counter = 0;
+
+	task.reset(new SplitTask(&job_system, &counter, 12));
+
+	job_system.add(task, task_group);
+
+	job_system.wait(task_group);
+
+	BOOST_CHECK_EQUAL(counter, (1 << 13) - 1);
+}
+
+BOOST_AUTO_TEST_CASE(continuation)
+{
+	el::JobSystem job_system(3);
+	el::TaskGroup task_group;
+	std::auto_ptr<el::AbstractThreadTask> task, continuation;
+	volatile Sint32 counter, result;
+
+	counter = 0;
+	result = 0;
+
+	task.reset(new SplitTask(&job_system, &counter, 10));
+	continuation.reset(new CheckTask(&counter, &result, (1 << 11) - 1));
+
+	task->set_continuation(continuation);
+
+	job_system.add(task, task_group);
+
+	job_system.wait(task_group);
+
+	BOOST_CHECK_EQUAL(result, 1);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	std::auto_ptr<el::AbstractThreadTask> task;
+	double start, thread_pool_time, job_system_time;
+	volatile Sint32 counter;
+	Uint32 i, threads, max_threads, count, work;
+
+	max_threads = std::max(el::JobSystem::get_cpu_count(),
+		static_cast<Uint16>(2));
+	count = 100000;
+	work = 50;
+
+	for (threads = 1; threads <= max_threads; ++threads)
+	{
+		{
+			el::ThreadPool thread_pool(threads);
+
+			counter = 0;
+			start = el::get_time();
+
+			for (i = 0; i < count; ++i)
+			{
+				task.reset(new CountTask(&counter, work));
+
+				thread_pool.add(task);
+			}
+
+			thread_pool.wait();
+
+			thread_pool_time = el::get_time() - start;
+
+			BOOST_CHECK_EQUAL(counter, count);
+		}
+
+		{
+			el::JobSystem job_system(threads - 1);
+			el::TaskGroup task_group;
+
+			counter = 0;
+			start = el::get_time();
+
+			for (i = 0; i < count; ++i)
+			{
+				task.reset(new CountTask(&counter, work));
+
+				job_system.add(task, task_group);
+			}
+
+			job_system.wait(task_group);
+
+			job_system_time = el::get_time() - start;
+
+			BOOST_CHECK_EQUAL(counter, count);
+		}
+
+		BOOST_TEST_MESSAGE(threads << " threads, " << count
+			<< " tasks: thread pool " << thread_pool_time
+			<< "ms, job system " << job_system_time << "ms");
+	}
+}
@@ -0,0 +1,151 @@
+/****************************************************************************
+ *            lrucache.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "lrucache.hpp"
+#define BOOST_TEST_MODULE lru_cache
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	typedef boost::shared_ptr<Uint32> Uint32SharedPtr;
+
+	/**
+	 * The value is the memory usage of the value.
+	 */
+	class Uint32CacheTraits
+	{
+		public:
+			static inline bool get_unused(const Uint32SharedPtr &value)
+				noexcept
+			{
+				return value.unique();
+			}
+
+			static inline Uint64 get_memory_usage(
+				const Uint32SharedPtr &value) noexcept
+			{
+				return *value;
+			}
+
+	};
+
+	typedef el::LruCache<Uint32SharedPtr, Uint32CacheTraits>
+		Uint32LruCache;
+
+	el::String get_name(const Uint32 index)
+	{
+		return el::String(boost::lexical_cast<std::string>(index));
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(default_creation)
+{
+	Uint32LruCache cache;
+
+	BOOST_CHECK_EQUAL(cache.get_count(), 0);
+	BOOST_CHECK_EQUAL(cache.get_memory_usage(), 0);
+	BOOST_CHECK_EQUAL(cache.get_budget(), 0);
+	BOOST_CHECK_EQUAL(cache.get_hits(), 0);
+	BOOST_CHECK_EQUAL(cache.get_misses(), 0);
+	BOOST_CHECK_EQUAL(cache.get_evictions(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(find)
+{
+	Uint32LruCache cache;
+	Uint32SharedPtr value;
+	Uint32 i;
+
+	for (i = 0; i < 16; ++i)
+	{
+		cache.add(get_name(i), boost::make_shared<Uint32>(i));
+	}
+
+	BOOST_CHECK_EQUAL(cache.get_count(), 16);
+	BOOST_CHECK_EQUAL(cache.get_memory_usage(), 120);
+
+	for (i = 0; i < 16; ++i)
+	{
+		BOOST_CHECK(cache.find(get_name(i), value));
+		BOOST_CHECK_EQUAL(*value, i);
+	}
+
+	BOOST_CHECK(!cache.find(get_name(16), value));
+	BOOST_CHECK_EQUAL(cache.get_hits(), 16);
+	BOOST_CHECK_EQUAL(cache.get_misses(), 1);
+
+	cache.add(get_name(3), boost::make_shared<Uint32>(13));
+
+	BOOST_CHECK_EQUAL(cache.get_count(), 16);
+	BOOST_CHECK_EQUAL(cache.get_memory_usage(), 130);
+	BOOST_CHECK(cache.find(get_name(3), value));
+	BOOST_CHECK_EQUAL(*value, 13);
+}
+
+BOOST_AUTO_TEST_CASE(trim)
+{
+	Uint32LruCache cache;
+	Uint32SharedPtr value, used;
+	Uint32 i;
+
+	for (i = 0; i < 16; ++i)
+	{
+		cache.add(get_name(i), boost::make_shared<Uint32>(10));
+	}
+
+	BOOST_CHECK(cache.find(get_name(0), used));
+	BOOST_CHECK(cache.find(get_name(1), value));
+	BOOST_CHECK(cache.find(get_name(2), used));
+	value.reset();
+
+	cache.set_budget(100);
+
+	/* 3 to 8 are the least recently used values */
+	BOOST_CHECK_EQUAL(cache.trim(), 6);
+	BOOST_CHECK_EQUAL(cache.get_count(), 10);
+	BOOST_CHECK_EQUAL(cache.get_memory_usage(), 100);
+	BOOST_CHECK_EQUAL(cache.get_evictions(), 6);
+
+	for (i = 3; i < 9; ++i)
+	{
+		BOOST_CHECK(!cache.find(get_name(i), value));
+	}
+
+	cache.set_budget(0);
+
+	/* only the value still in use is kept */
+	BOOST_CHECK_EQUAL(cache.trim(), 9);
+	BOOST_CHECK_EQUAL(cache.get_count(), 1);
+	BOOST_CHECK(cache.find(get_name(2), value));
+	BOOST_CHECK(value == used);
+}
+
+BOOST_AUTO_TEST_CASE(trim_memory_usage_change)
+{
+	Uint32LruCache cache;
+	Uint32SharedPtr value;
+
+	value = boost::make_shared<Uint32>(0);
+
+	cache.add(get_name(0), value);
+	cache.add(get_name(1), boost::make_shared<Uint32>(10));
+
+	*value = 100;
+	value.reset();
+
+	cache.set_budget(50);
+
+	BOOST_CHECK_EQUAL(cache.trim(), 1);
+	BOOST_CHECK(!cache.find(get_name(0), value));
+	BOOST_CHECK(cache.find(get_name(1), value));
+	BOOST_CHECK_EQUAL(cache.get_memory_usage(), 10);
+}
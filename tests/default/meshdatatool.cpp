@@ -9,12 +9,130 @@
 #include "meshdatatool.hpp"
 #include "indexbuilder.hpp"
 #include "submesh.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
+#include "readwritememory.hpp"
+#include "exceptions.hpp"
+#include "thread/jobsystem.hpp"
+#include "tools/timeutil.hpp"
 #include <boost/random.hpp>
 #define BOOST_TEST_MODULE mesh_data_tool
 #include <boost/test/unit_test.hpp>
 
 namespace el = eternal_lands;
 
+namespace
+{
+
+	/**
+	 * Builds a plane with random heights and texture coordinates
+	 * as position and morph target, with 2 * tile_size * tile_size
+	 * triangles.
+	 */
+	el::MeshDataToolSharedPtr build_random_plane(const Uint32 tile_size,
+		const bool use_simd)
+	{
+		boost::mt19937 rng;
+		boost::uniform_real<float> range(-0.25f, 0.25f);
+		boost::variate_generator<boost::mt19937&,
+			boost::uniform_real<float> > random_float(rng, range);
+		el::MeshDataToolSharedPtr mesh_data_tool;
+		el::VertexSemanticTypeSet semantics;
+		el::Uint32Vector indices;
+		glm::vec4 position, uv;
+		Uint32 vertex_count, index_count, i, index, x, y;
+
+		vertex_count = (tile_size + 1) * (tile_size + 1);
+
+		el::IndexBuilder::build_plane_indices(tile_size, false, 0,
+			true, indices);
+
+		index_count = indices.size();
+
+		semantics.insert(el::vst_position);
+		semantics.insert(el::vst_texture_coordinate);
+		semantics.insert(el::vst_normal);
+		semantics.insert(el::vst_tangent);
+		semantics.insert(el::vst_morph_position);
+		semantics.insert(el::vst_morph_texture_coordinate);
+		semantics.insert(el::vst_morph_normal);
+		semantics.insert(el::vst_morph_tangent);
+
+		mesh_data_tool = boost::make_shared<el::MeshDataTool>(
+			el::String("random plane"), vertex_count, index_count,
+			1, semantics, el::pt_triangles, false, use_simd);
+
+		for (i = 0; i < index_count; ++i)
+		{
+			mesh_data_tool->set_index_data(i, indices[i]);
+		}
+
+		index = 0;
+
+		for (y = 0; y <= tile_size; ++y)
+		{
+			for (x = 0; x <= tile_size; ++x)
+			{
+				position = glm::vec4(x, y, random_float(),
+					1.0f);
+				uv = glm::vec4(x + random_float() * 0.4f,
+					y + random_float() * 0.4f, 0.0f, 1.0f);
+				uv /= static_cast<float>(tile_size);
+
+				mesh_data_tool->set_vertex_data(
+					el::vst_position, index, position);
+				mesh_data_tool->set_vertex_data(
+					el::vst_texture_coordinate, index, uv);
+
+				position.z = random_float() * 4.0f;
+
+				mesh_data_tool->set_vertex_data(
+					el::vst_morph_position, index,
+					position);
+				mesh_data_tool->set_vertex_data(
+					el::vst_morph_texture_coordinate,
+					index, uv);
+
+				++index;
+			}
+		}
+
+		mesh_data_tool->set_sub_mesh_data(0, el::SubMesh(
+			el::BoundingBox(glm::vec3(0.0f, 0.0f, -1.0f),
+				glm::vec3(tile_size, tile_size, 1.0f)), 0,
+			index_count, 0, vertex_count - 1));
+
+		return mesh_data_tool;
+	}
+
+	float get_max_difference(const el::MeshDataTool &mesh_data_tool,
+		const el::MeshDataTool &reference,
+		const el::VertexSemanticType semantic)
+	{
+		glm::vec4 difference;
+		float result;
+		Uint32 i, j, count;
+
+		result = 0.0f;
+		count = mesh_data_tool.get_vertex_count();
+
+		for (i = 0; i < count; ++i)
+		{
+			difference = glm::abs(mesh_data_tool.get_vertex_data(
+				semantic, i) - reference.get_vertex_data(
+					semantic, i));
+
+			for (j = 0; j < 4; ++j)
+			{
+				result = std::max(result, difference[j]);
+			}
+		}
+
+		return result;
+	}
+
+}
+
 BOOST_AUTO_TEST_CASE(create)
 {
 	el::MeshDataToolSharedPtr mesh_data_tool;
@@ -2642,3 +2760,268 @@ BOOST_AUTO_TEST_CASE(add_plane_build_bounding_box_use_restart)
 		}
 	}
 }
+
+BOOST_AUTO_TEST_CASE(save_load)
+{
+	el::MeshDataToolSharedPtr mesh_data_tool, loaded;
+	el::ReadWriteMemorySharedPtr buffer;
+	boost::shared_ptr<el::StringStream> stream;
+	el::ReaderSharedPtr reader;
+	el::Uint32Vector indices;
+	el::VertexSemanticTypeSet semantics;
+	std::string str;
+	glm::vec4 data;
+	glm::vec3 min, max;
+	Uint32 vertex_count, index_count, i, j, x, y, tile_size;
+
+	tile_size = 16;
+
+	vertex_count = tile_size + 1;
+	vertex_count *= tile_size + 1;
+
+	el::IndexBuilder::build_plane_indices(tile_size, false, 0, true,
+		indices);
+
+	index_count = indices.size();
+
+	semantics.insert(el::vst_position);
+	semantics.insert(el::vst_texture_coordinate);
+	semantics.insert(el::vst_normal);
+
+	mesh_data_tool = boost::make_shared<el::MeshDataTool>(
+		el::String("plane"), vertex_count, index_count, 1, semantics,
+		el::pt_triangles, false, false);
+
+	for (i = 0; i < index_count; ++i)
+	{
+		mesh_data_tool->set_index_data(i, indices[i]);
+	}
+
+	i = 0;
+
+	for (y = 0; y <= tile_size; ++y)
+	{
+		for (x = 0; x <= tile_size; ++x)
+		{
+			data = glm::vec4(glm::vec2(x, y) /
+				static_cast<float>(tile_size), 0.0f, 1.0f);
+
+			mesh_data_tool->set_vertex_data(el::vst_position, i,
+				data);
+			mesh_data_tool->set_vertex_data(el::vst_normal, i,
+				glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+			mesh_data_tool->set_vertex_data(
+				el::vst_texture_coordinate, i, data);
+
+			++i;
+		}
+	}
+
+	min = glm::vec3(0.0f);
+	max = glm::vec3(1.0f, 1.0f, 0.0f);
+
+	mesh_data_tool->set_sub_mesh_data(0, el::SubMesh(el::BoundingBox(min,
+		max), 0, index_count, 0, vertex_count - 1, 5));
+	mesh_data_tool->build_min_max_boxes();
+
+	stream = boost::make_shared<el::StringStream>();
+
+	el::Writer writer(stream, el::String("plane"));
+
+	mesh_data_tool->save(writer);
+
+	str = stream->str();
+
+	buffer = boost::make_shared<el::ReadWriteMemory>(str.size());
+
+	memcpy(buffer->get_ptr(), str.c_str(), str.size());
+
+	reader = boost::make_shared<el::Reader>(buffer, el::String("plane"));
+
+	BOOST_CHECK_NO_THROW(loaded.reset(new el::MeshDataTool(
+		el::String("loaded"), *reader, false)));
+
+	BOOST_CHECK_EQUAL(reader->get_bytes_left(), 0);
+
+	BOOST_CHECK_EQUAL(loaded->get_name(), "loaded");
+	BOOST_CHECK_EQUAL(loaded->get_vertex_count(), vertex_count);
+	BOOST_CHECK_EQUAL(loaded->get_index_count(), index_count);
+	BOOST_CHECK_EQUAL(loaded->get_sub_mesh_count(), 1);
+	BOOST_CHECK_EQUAL(loaded->get_primitive(), el::pt_triangles);
+	BOOST_CHECK_EQUAL(loaded->get_use_restart_index(), false);
+	BOOST_CHECK_EQUAL(loaded->get_sub_mesh_data(0).get_base_vertex(), 5);
+	BOOST_CHECK_EQUAL(loaded->get_sub_mesh_data(0).get_max_vertex(),
+		vertex_count - 1);
+	BOOST_CHECK_EQUAL(loaded->get_sub_mesh_data(0).get_count(),
+		index_count);
+	BOOST_CHECK_EQUAL(loaded->get_sub_mesh_data(0
+		).get_min_max_boxes_count(), mesh_data_tool->get_sub_mesh_data(
+		0).get_min_max_boxes_count());
+	BOOST_CHECK_EQUAL(loaded->get_min_max_boxes().size(),
+		mesh_data_tool->get_min_max_boxes().size());
+
+	for (i = 0; i < 3; ++i)
+	{
+		BOOST_CHECK_EQUAL(loaded->get_sub_mesh_data(0
+			).get_bounding_box().get_min()[i], min[i]);
+		BOOST_CHECK_EQUAL(loaded->get_sub_mesh_data(0
+			).get_bounding_box().get_max()[i], max[i]);
+	}
+
+	for (i = 0; i < index_count; ++i)
+	{
+		BOOST_CHECK_EQUAL(loaded->get_index_data(i), indices[i]);
+	}
+
+	for (i = 0; i < vertex_count; ++i)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			BOOST_CHECK_EQUAL(loaded->get_vertex_data(
+				el::vst_position, i)[j],
+				mesh_data_tool->get_vertex_data(
+					el::vst_position, i)[j]);
+			BOOST_CHECK_EQUAL(loaded->get_vertex_data(
+				el::vst_normal, i)[j],
+				mesh_data_tool->get_vertex_data(
+					el::vst_normal, i)[j]);
+			BOOST_CHECK_EQUAL(loaded->get_vertex_data(
+				el::vst_texture_coordinate, i)[j],
+				mesh_data_tool->get_vertex_data(
+					el::vst_texture_coordinate, i)[j]);
+		}
+	}
+
+	/* vertices not saved get the default value */
+	BOOST_CHECK_EQUAL(loaded->get_vertex_data(el::vst_tangent, 0).w,
+		1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(load_too_small)
+{
+	el::ReadWriteMemorySharedPtr buffer;
+	el::ReaderSharedPtr reader;
+
+	buffer = boost::make_shared<el::ReadWriteMemory>(16);
+
+	memset(buffer->get_ptr(), 0xFF, buffer->get_size());
+
+	reader = boost::make_shared<el::Reader>(buffer, el::String("test"));
+
+	BOOST_CHECK_THROW(el::MeshDataTool(el::String("test"), *reader,
+		false), el::ReadErrorException);
+}
+
+BOOST_AUTO_TEST_CASE(build_normal_tangent_job_system)
+{
+	el::JobSystem job_system(2);
+	el::MeshDataToolSharedPtr reference, mesh_data_tool;
+	Uint32 i, tile_size;
+
+	/* 32258 triangles, more than one block and not a multiple of four */
+	tile_size = 127;
+
+	reference = build_random_plane(tile_size, false);
+
+	reference->build_normal_simple(false);
+	reference->build_tangent_simple(false, true);
+	reference->build_normal_simple(true);
+	reference->build_tangent_simple(true, false);
+
+	for (i = 0; i < 4; ++i)
+	{
+		mesh_data_tool = build_random_plane(tile_size, (i % 2) == 1);
+
+		if (i < 2)
+		{
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_normal(
+				false));
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_tangent(
+				false, true));
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_normal(
+				true));
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_tangent(
+				true, false));
+		}
+		else
+		{
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_normal(
+				false, &job_system));
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_tangent(
+				false, true, &job_system));
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_normal(
+				true, &job_system));
+			BOOST_CHECK_NO_THROW(mesh_data_tool->build_tangent(
+				true, false, &job_system));
+		}
+
+		BOOST_CHECK_SMALL(get_max_difference(*mesh_data_tool,
+			*reference, el::vst_normal), 0.0001f);
+		BOOST_CHECK_SMALL(get_max_difference(*mesh_data_tool,
+			*reference, el::vst_tangent), 0.001f);
+		BOOST_CHECK_SMALL(get_max_difference(*mesh_data_tool,
+			*reference, el::vst_morph_normal), 0.0001f);
+		BOOST_CHECK_SMALL(get_max_difference(*mesh_data_tool,
+			*reference, el::vst_morph_tangent), 0.001f);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(build_normal_tangent_benchmark)
+{
+	el::JobSystem job_system(el::JobSystem::get_default_thread_count());
+	el::MeshDataToolSharedPtr mesh_data_tool;
+	boost::array<Uint32, 3> tile_sizes;
+	boost::array<double, 3> times;
+	double start, triangles;
+	Uint32 i, j;
+
+	/* About 10k, 100k and 1M triangles */
+	tile_sizes[0] = 71;
+	tile_sizes[1] = 224;
+	tile_sizes[2] = 708;
+
+	for (i = 0; i < tile_sizes.size(); ++i)
+	{
+		for (j = 0; j < times.size(); ++j)
+		{
+			mesh_data_tool = build_random_plane(tile_sizes[i],
+				j > 0);
+
+			start = el::get_time();
+
+			switch (j)
+			{
+				case 0:
+					mesh_data_tool->build_normal_simple(
+						false);
+					mesh_data_tool->build_tangent_simple(
+						false, true);
+					break;
+				case 1:
+					mesh_data_tool->build_normal(false);
+					mesh_data_tool->build_tangent(false,
+						true);
+					break;
+				case 2:
+					mesh_data_tool->build_normal(false,
+						&job_system);
+					mesh_data_tool->build_tangent(false,
+						true, &job_system);
+					break;
+			}
+
+			times[j] = std::max(el::get_time() - start, 0.001);
+		}
+
+		triangles = 2.0 * tile_sizes[i] * tile_sizes[i];
+
+		BOOST_TEST_MESSAGE(triangles << " triangles: simple "
+			<< (triangles / (times[0] * 1000.0))
+			<< " MTriangles/s, simd "
+			<< (triangles / (times[1] * 1000.0))
+			<< " MTriangles/s, simd and "
+			<< job_system.get_thread_count() << " threads "
+			<< (triangles / (times[2] * 1000.0))
+			<< " MTriangles/s");
+	}
+}
@@ -8,6 +8,9 @@
 #include "prerequisites.hpp"
 #include "rstartree.hpp"
 #include "abstractnodevisitor.hpp"
+#include "abstractboundedobjectvisitor.hpp"
+#include "rstartreesubtree.hpp"
+#include "frustum.hpp"
 #include <boost/random.hpp>
 #define BOOST_TEST_MODULE rstartree
 #include <boost/test/unit_test.hpp>
@@ -131,6 +134,42 @@ namespace
 		return m_bounding_box;
 	}
 
+	class CollectBoundedObjectVisitor:
+		public el::AbstractBoundedObjectVisitor
+	{
+		private:
+			std::set<el::BoundedObject*> m_objects;
+
+		public:
+			CollectBoundedObjectVisitor();
+			virtual ~CollectBoundedObjectVisitor() throw();
+			virtual void operator()(
+				const el::BoundedObjectSharedPtr &object);
+
+			inline const std::set<el::BoundedObject*> &get_objects()
+				const
+			{
+				return m_objects;
+			}
+
+	};
+
+	CollectBoundedObjectVisitor::CollectBoundedObjectVisitor()
+	{
+	}
+
+	CollectBoundedObjectVisitor::~CollectBoundedObjectVisitor() throw()
+	{
+	}
+
+	void CollectBoundedObjectVisitor::operator()(
+		const el::BoundedObjectSharedPtr &object)
+	{
+		BOOST_CHECK_EQUAL(m_objects.count(object.get()), 0);
+
+		m_objects.insert(object.get());
+	}
+
 	typedef	std::vector<SimpleBoundedObjectSharedPtr>
 		SimpleBoundedObjectSharedPtrVector;
 
@@ -760,4 +799,62 @@ BOOST_AUTO_TEST_CASE(add_random_select_and_remove_count_objects)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(intersect_sub_trees)
+{
+	boost::mt19937 rng;
+	boost::uniform_real<float> float_range(0.0f, 1.0f);
+	boost::variate_generator<boost::mt19937&, boost::uniform_real<float> >
+		random_float(rng, float_range);
+	boost::scoped_ptr<el::RStarTree> tree;
+	el::RStarTreeSubTreeVector sub_trees;
+	glm::vec3 min, max, size, offset;
+	Uint32 i, j;
+	Uint16 depth;
+
+	BOOST_CHECK_NO_THROW(tree.reset(new el::RStarTree()));
+
+	for (i = 0; i < get_count(); ++i)
+	{
+		BOOST_CHECK_NO_THROW(tree->add(get_box(i)));
+	}
+
+	for (i = 0; i < 64; ++i)
+	{
+		min = tree->get_bounding_box().get_min();
+		max = tree->get_bounding_box().get_max();
+		size = max - min;
+
+		offset.x = random_float();
+		offset.y = random_float();
+		offset.z = random_float();
+
+		min += size * offset * 0.5f;
+		max -= size * (1.0f - offset) * 0.5f;
+
+		el::Frustum frustum(el::BoundingBox(min, max));
+		CollectBoundedObjectVisitor visitor;
+
+		tree->intersect(frustum, visitor);
+
+		for (depth = 0; depth < 4; ++depth)
+		{
+			CollectBoundedObjectVisitor split_visitor;
+
+			sub_trees.clear();
+
+			BOOST_CHECK_NO_THROW(tree->intersect(frustum, depth,
+				split_visitor, sub_trees));
+
+			for (j = 0; j < sub_trees.size(); ++j)
+			{
+				BOOST_CHECK_NO_THROW(sub_trees[j].intersect(
+					frustum, split_visitor));
+			}
+
+			BOOST_CHECK(visitor.get_objects() ==
+				split_visitor.get_objects());
+		}
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,428 @@
+/****************************************************************************
+ *            simd.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "simd/simd.hpp"
+#include "packtool.hpp"
+#include "alignedarrays.hpp"
+#include "readwritememory.hpp"
+#include "tools/timeutil.hpp"
+#include <boost/random.hpp>
+#define BOOST_TEST_MODULE simd
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	typedef std::vector<el::BitSet16> BitSet16Vector;
+
+	/**
+	 * The SSE2 versions first, then each supported instruction set
+	 * alone and all supported together.
+	 */
+	BitSet16Vector get_instruction_sets()
+	{
+		BitSet16Vector result;
+		el::BitSet16 supported, tmp;
+		Uint32 i;
+
+		supported = el::SIMD::get_supported_instruction_sets();
+
+		result.push_back(el::BitSet16());
+
+		for (i = 0; i < supported.size(); ++i)
+		{
+			if (supported[i])
+			{
+				tmp.reset();
+				tmp[i] = true;
+				result.push_back(tmp);
+			}
+		}
+
+		if (supported.count() > 1)
+		{
+			result.push_back(supported);
+		}
+
+		return result;
+	}
+
+	std::string get_str(const el::BitSet16 instruction_sets)
+	{
+		std::string result;
+		Uint32 i;
+
+		result = "sse2";
+
+		for (i = 0; i < instruction_sets.size(); ++i)
+		{
+			if (instruction_sets[i])
+			{
+				result += "+";
+				result += el::SIMD::get_str(
+					static_cast<el::SimdInstructionSetType>(
+						i));
+			}
+		}
+
+		return result;
+	}
+
+	void fill_random(const float min, const float max, const Uint32 count,
+		el::AlignedVec4Array &values)
+	{
+		boost::mt19937 rng;
+		boost::uniform_real<float> range(min, max);
+		boost::variate_generator<boost::mt19937&,
+			boost::uniform_real<float> > random_float(rng, range);
+		Uint32 i;
+
+		values.resize(count);
+
+		for (i = 0; i < count; ++i)
+		{
+			values[i] = glm::vec4(random_float(), random_float(),
+				random_float(), random_float());
+		}
+	}
+
+	void fill_boxes(const Uint32 count, el::AlignedSint16Vec8Array &boxes)
+	{
+		boost::mt19937 rng;
+		boost::uniform_int<Sint16> range(-1000, 1000);
+		boost::variate_generator<boost::mt19937&,
+			boost::uniform_int<Sint16> > random_int(rng, range);
+		Uint32 i, j;
+
+		boxes.resize(count);
+
+		for (i = 0; i < count; ++i)
+		{
+			for (j = 0; j < 3; ++j)
+			{
+				boxes[i][j] = random_int();
+				boxes[i][j + 4] = boxes[i][j] +
+					std::abs(random_int()) / 4;
+			}
+
+			boxes[i][3] = 1;
+			boxes[i][7] = 1;
+		}
+	}
+
+	glm::mat4x4 get_projection()
+	{
+		return glm::perspective(60.0f, 4.0f / 3.0f, 1.0f, 5000.0f) *
+			glm::translate(glm::mat4x4(), glm::vec3(0.0f, 0.0f,
+				-2500.0f));
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(half_pack_tool)
+{
+	el::AlignedVec4Array values;
+	el::ReadWriteMemory scalar(4096 * 8), simd(4096 * 8);
+	Uint32 i;
+
+	fill_random(-1000.0f, 1000.0f, 4096, values);
+
+	BOOST_FOREACH(const el::BitSet16 instruction_sets,
+		get_instruction_sets())
+	{
+		el::SIMD::set_instruction_sets(instruction_sets);
+
+		BOOST_TEST_CHECKPOINT(get_str(instruction_sets));
+
+		el::PackTool::pack(values, 0, 8, values.size(),
+			el::pft_half_4, false, scalar);
+		el::PackTool::pack(values, 0, 8, values.size(),
+			el::pft_half_4, true, simd);
+
+		for (i = 0; i < values.size() * 4; ++i)
+		{
+			BOOST_CHECK_EQUAL(static_cast<const Uint16*>(
+				scalar.get_ptr())[i], static_cast<const Uint16*>(
+				simd.get_ptr())[i]);
+		}
+
+		el::PackTool::pack(values, 0, 4, values.size(),
+			el::pft_half_2, false, scalar);
+		el::PackTool::pack(values, 0, 4, values.size(),
+			el::pft_half_2, true, simd);
+
+		for (i = 0; i < values.size() * 2; ++i)
+		{
+			BOOST_CHECK_EQUAL(static_cast<const Uint16*>(
+				scalar.get_ptr())[i], static_cast<const Uint16*>(
+				simd.get_ptr())[i]);
+		}
+	}
+
+	el::SIMD::set_instruction_sets(
+		el::SIMD::get_supported_instruction_sets());
+}
+
+BOOST_AUTO_TEST_CASE(transform)
+{
+	el::AlignedVec4Array values, result;
+	glm::mat4x3 matrix;
+	glm::mat3x3 normal_matrix;
+	glm::vec4 scale_offset, tmp;
+	glm::vec3 normal;
+	Uint32 i, j, count;
+
+	matrix = glm::mat4x3(glm::rotate(glm::mat4x4(), 30.0f,
+		glm::vec3(0.3f, 0.4f, 0.5f)));
+	matrix[3] = glm::vec3(1.0f, -2.0f, 3.0f);
+	normal_matrix = glm::mat3x3(matrix);
+	scale_offset = glm::vec4(0.5f, 2.0f, -1.0f, 4.0f);
+
+	fill_random(-100.0f, 100.0f, 1025, values);
+
+	BOOST_FOREACH(const el::BitSet16 instruction_sets,
+		get_instruction_sets())
+	{
+		el::SIMD::set_instruction_sets(instruction_sets);
+
+		BOOST_TEST_CHECKPOINT(get_str(instruction_sets));
+
+		/* Odd counts and not 32 byte aligned dest memory */
+		for (j = 0; j < 2; ++j)
+		{
+			count = values.size() - j;
+			result.resize(values.size());
+
+			el::SIMD::transform(values.get_ptr(), count, matrix,
+				result.get_ptr_at(j));
+
+			for (i = 0; i < count; ++i)
+			{
+				tmp = glm::vec4(matrix * glm::vec4(
+					glm::vec3(values[i]), 1.0f), 1.0f);
+
+				BOOST_CHECK_CLOSE(result[i + j].x, tmp.x, 0.01);
+				BOOST_CHECK_CLOSE(result[i + j].y, tmp.y, 0.01);
+				BOOST_CHECK_CLOSE(result[i + j].z, tmp.z, 0.01);
+				BOOST_CHECK_EQUAL(result[i + j].w, 1.0f);
+			}
+
+			el::SIMD::transform(values.get_ptr(), count,
+				normal_matrix, result.get_ptr_at(j));
+
+			for (i = 0; i < count; ++i)
+			{
+				normal = glm::normalize(normal_matrix *
+					glm::vec3(values[i]));
+
+				BOOST_CHECK_SMALL(result[i + j].x - normal.x,
+					0.001f);
+				BOOST_CHECK_SMALL(result[i + j].y - normal.y,
+					0.001f);
+				BOOST_CHECK_SMALL(result[i + j].z - normal.z,
+					0.001f);
+				BOOST_CHECK_EQUAL(result[i + j].w,
+					values[i].w);
+			}
+
+			el::SIMD::transform(values.get_ptr(), count,
+				scale_offset, result.get_ptr_at(j));
+
+			for (i = 0; i < count; ++i)
+			{
+				BOOST_CHECK_EQUAL(result[i + j].x,
+					values[i].x * scale_offset.x +
+					scale_offset.z);
+				BOOST_CHECK_EQUAL(result[i + j].y,
+					values[i].y * scale_offset.y +
+					scale_offset.w);
+				BOOST_CHECK_EQUAL(result[i + j].z,
+					values[i].z);
+				BOOST_CHECK_EQUAL(result[i + j].w,
+					values[i].w);
+			}
+
+			el::SIMD::fill(scale_offset, count,
+				result.get_ptr_at(j));
+
+			for (i = 0; i < count; ++i)
+			{
+				BOOST_CHECK_EQUAL(result[i + j].x,
+					scale_offset.x);
+				BOOST_CHECK_EQUAL(result[i + j].y,
+					scale_offset.y);
+				BOOST_CHECK_EQUAL(result[i + j].z,
+					scale_offset.z);
+				BOOST_CHECK_EQUAL(result[i + j].w,
+					scale_offset.w);
+			}
+		}
+	}
+
+	el::SIMD::set_instruction_sets(
+		el::SIMD::get_supported_instruction_sets());
+}
+
+BOOST_AUTO_TEST_CASE(float_to_signed_short_8_scale)
+{
+	el::AlignedVec4Array values;
+	el::AlignedSint16Vec8Array result;
+	Uint32 i, j, count;
+
+	fill_random(-1.0f, 1.0f, 1026, values);
+
+	BOOST_FOREACH(const el::BitSet16 instruction_sets,
+		get_instruction_sets())
+	{
+		el::SIMD::set_instruction_sets(instruction_sets);
+
+		BOOST_TEST_CHECKPOINT(get_str(instruction_sets));
+
+		for (j = 0; j < 2; ++j)
+		{
+			count = values.size() / 2 - j;
+			result.resize(values.size() / 2);
+
+			el::SIMD::float_to_signed_short_8_scale(
+				values.get_ptr(), count, 32767.0f,
+				result.get_ptr_at(j));
+
+			for (i = 0; i < count * 8; ++i)
+			{
+				BOOST_CHECK_EQUAL(result[i / 8 + j][i % 8],
+					static_cast<Sint16>(values[i / 4][
+						i % 4] * 32767.0f));
+			}
+		}
+	}
+
+	el::SIMD::set_instruction_sets(
+		el::SIMD::get_supported_instruction_sets());
+}
+
+BOOST_AUTO_TEST_CASE(check_coverage)
+{
+	el::AlignedSint16Vec8Array boxes;
+	el::BitSet64 sse2_result, result;
+	glm::mat4x4 matrix;
+	Uint32 i;
+
+	fill_boxes(64, boxes);
+	matrix = glm::transpose(get_projection());
+
+	el::SIMD::set_instruction_sets(el::BitSet16());
+
+	for (i = 0; i < 8; ++i)
+	{
+		sse2_result = el::SIMD::check_coverage_simple(
+			glm::value_ptr(matrix), boxes.get_ptr(), 64,
+			1024.0f, 768.0f, i * 10.0f);
+
+		BOOST_FOREACH(const el::BitSet16 instruction_sets,
+			get_instruction_sets())
+		{
+			el::SIMD::set_instruction_sets(instruction_sets);
+
+			BOOST_TEST_CHECKPOINT(get_str(instruction_sets));
+
+			result = el::SIMD::check_coverage_simple(
+				glm::value_ptr(matrix),
+				boxes.get_ptr(), 64, 1024.0f, 768.0f,
+				i * 10.0f);
+
+			BOOST_CHECK(result == sse2_result);
+			BOOST_CHECK_EQUAL(el::SIMD::check_coverage(
+				glm::value_ptr(matrix),
+				boxes.get_ptr(), 64, 1024.0f, 768.0f,
+				i * 10.0f), sse2_result.any());
+		}
+	}
+
+	el::SIMD::set_instruction_sets(
+		el::SIMD::get_supported_instruction_sets());
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	el::AlignedVec4Array values, result;
+	el::AlignedSint16Vec8Array boxes;
+	glm::mat4x4 matrix;
+	double start, transform, half, fill, coverage;
+	Uint32 i, count, size;
+
+	size = 64 * 1024;
+	count = 64;
+
+	fill_random(-100.0f, 100.0f, size, values);
+	fill_boxes(64, boxes);
+	result.resize(size);
+	matrix = glm::transpose(get_projection());
+
+	BOOST_FOREACH(const el::BitSet16 instruction_sets,
+		get_instruction_sets())
+	{
+		el::SIMD::set_instruction_sets(instruction_sets);
+
+		start = el::get_time();
+
+		for (i = 0; i < count; ++i)
+		{
+			el::SIMD::transform(values.get_ptr(), size,
+				glm::mat4x3(matrix), result.get_ptr());
+		}
+
+		transform = std::max(el::get_time() - start, 0.001);
+
+		start = el::get_time();
+
+		for (i = 0; i < count; ++i)
+		{
+			el::SIMD::float_to_half_4(values.get_ptr(), size, 8,
+				reinterpret_cast<Uint8*>(result.get_ptr()));
+		}
+
+		half = std::max(el::get_time() - start, 0.001);
+
+		start = el::get_time();
+
+		for (i = 0; i < count; ++i)
+		{
+			el::SIMD::fill(glm::vec4(1.0f), size,
+				result.get_ptr());
+		}
+
+		fill = std::max(el::get_time() - start, 0.001);
+
+		start = el::get_time();
+
+		for (i = 0; i < count * 64; ++i)
+		{
+			el::SIMD::check_coverage_simple(
+				glm::value_ptr(matrix),
+				boxes.get_ptr(), 64, 1024.0f, 768.0f,
+				i * 0.1f);
+		}
+
+		coverage = std::max(el::get_time() - start, 0.001);
+
+		BOOST_TEST_MESSAGE(get_str(instruction_sets) << ": transform "
+			<< (count * size / (transform * 1000.0))
+			<< " MVertices/s, float_to_half_4 "
+			<< (count * size / (half * 1000.0))
+			<< " MVertices/s, fill "
+			<< (count * size / (fill * 1000.0))
+			<< " MVertices/s, check_coverage_simple "
+			<< (count * 64 * 64 / (coverage * 1000.0))
+			<< " MBoxes/s");
+	}
+
+	el::SIMD::set_instruction_sets(
+		el::SIMD::get_supported_instruction_sets());
+}
@@ -0,0 +1,407 @@
+/****************************************************************************
+ *            staticrstartree.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "staticrstartree.hpp"
+#include "rstartree.hpp"
+#include "boundedobject.hpp"
+#include "rstartreesubtree.hpp"
+#include "abstractboundedobjectvisitor.hpp"
+#include "frustum.hpp"
+#include "tools/timeutil.hpp"
+#include <boost/random.hpp>
+#define BOOST_TEST_MODULE static_rstartree
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	class SimpleBoundedObject: public el::BoundedObject
+	{
+		public:
+			SimpleBoundedObject(const glm::vec3 &min,
+				const glm::vec3 &max);
+			virtual ~SimpleBoundedObject() throw();
+
+	};
+
+	SimpleBoundedObject::SimpleBoundedObject(const glm::vec3 &min,
+		const glm::vec3 &max)
+	{
+		set_bounding_box(el::BoundingBox(min, max));
+	}
+
+	SimpleBoundedObject::~SimpleBoundedObject() throw()
+	{
+	}
+
+	class CollectBoundedObjectVisitor:
+		public el::AbstractBoundedObjectVisitor
+	{
+		private:
+			std::set<el::BoundedObject*> m_objects;
+
+		public:
+			CollectBoundedObjectVisitor();
+			virtual ~CollectBoundedObjectVisitor() throw();
+			virtual void operator()(
+				const el::BoundedObjectSharedPtr &object);
+
+			inline const std::set<el::BoundedObject*> &get_objects()
+				const
+			{
+				return m_objects;
+			}
+
+	};
+
+	CollectBoundedObjectVisitor::CollectBoundedObjectVisitor()
+	{
+	}
+
+	CollectBoundedObjectVisitor::~CollectBoundedObjectVisitor() throw()
+	{
+	}
+
+	void CollectBoundedObjectVisitor::operator()(
+		const el::BoundedObjectSharedPtr &object)
+	{
+		BOOST_CHECK_EQUAL(m_objects.count(object.get()), 0);
+
+		m_objects.insert(object.get());
+	}
+
+	class CountBoundedObjectVisitor:
+		public el::AbstractBoundedObjectVisitor
+	{
+		private:
+			Uint32 m_count;
+
+		public:
+			CountBoundedObjectVisitor();
+			virtual ~CountBoundedObjectVisitor() throw();
+			virtual void operator()(
+				const el::BoundedObjectSharedPtr &object);
+
+			inline Uint32 get_count() const
+			{
+				return m_count;
+			}
+
+	};
+
+	CountBoundedObjectVisitor::CountBoundedObjectVisitor(): m_count(0)
+	{
+	}
+
+	CountBoundedObjectVisitor::~CountBoundedObjectVisitor() throw()
+	{
+	}
+
+	void CountBoundedObjectVisitor::operator()(
+		const el::BoundedObjectSharedPtr &object)
+	{
+		m_count++;
+	}
+
+	/**
+	 * Objects spread like on a big map, 1536 x 1536 units wide, but
+	 * only a few units high.
+	 */
+	class MapObjectsBuilder
+	{
+		private:
+			el::BoundedObjectSharedPtrVector m_objects;
+			std::vector<el::BoundingBox> m_views;
+
+		public:
+			MapObjectsBuilder();
+
+			inline const el::BoundedObjectSharedPtrVector
+				&get_objects() const
+			{
+				return m_objects;
+			}
+
+			inline const el::BoundingBox &get_view(
+				const Uint32 index) const
+			{
+				return m_views[index];
+			}
+
+			static inline Uint32 get_count()
+			{
+				return 32768;
+			}
+
+			static inline Uint32 get_view_count()
+			{
+				return 1024;
+			}
+
+	};
+
+	MapObjectsBuilder::MapObjectsBuilder()
+	{
+		boost::mt19937 rng;
+		boost::uniform_real<float> range(0.0f, 1.0f);
+		boost::variate_generator<boost::mt19937&,
+			boost::uniform_real<float> > random_float(rng, range);
+		glm::vec3 min, max;
+		Uint32 i;
+
+		for (i = 0; i < get_count(); ++i)
+		{
+			min.x = random_float() * 1536.0f;
+			min.y = random_float() * 1536.0f;
+			min.z = random_float() * 4.0f;
+
+			max.x = min.x + 0.25f + random_float() * 8.0f;
+			max.y = min.y + 0.25f + random_float() * 8.0f;
+			max.z = min.z + 0.25f + random_float() * 8.0f;
+
+			m_objects.push_back(boost::make_shared<
+				SimpleBoundedObject>(min, max));
+		}
+
+		for (i = 0; i < get_view_count(); ++i)
+		{
+			min.x = random_float() * 1536.0f - 32.0f;
+			min.y = random_float() * 1536.0f - 32.0f;
+			min.z = -4.0f;
+
+			max.x = min.x + 32.0f + random_float() * 64.0f;
+			max.y = min.y + 32.0f + random_float() * 64.0f;
+			max.z = 16.0f;
+
+			m_views.push_back(el::BoundingBox(min, max));
+		}
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	el::StaticRStarTree tree;
+	el::BoundedObjectSharedPtrVector objects;
+	el::RStarTreeSubTreeVector sub_trees;
+	CountBoundedObjectVisitor visitor;
+
+	tree.build(objects);
+
+	BOOST_CHECK(tree.get_empty());
+	BOOST_CHECK_EQUAL(tree.get_nodes_count(), 0);
+
+	tree.intersect(el::Frustum(el::BoundingBox(glm::vec3(-1.0f),
+		glm::vec3(1.0f))), visitor);
+	tree.intersect(el::Frustum(el::BoundingBox(glm::vec3(-1.0f),
+		glm::vec3(1.0f))), 2, visitor, sub_trees);
+
+	BOOST_CHECK_EQUAL(visitor.get_count(), 0);
+	BOOST_CHECK_EQUAL(sub_trees.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(single_object)
+{
+	el::StaticRStarTree tree;
+	el::BoundedObjectSharedPtrVector objects;
+	CountBoundedObjectVisitor inside, outside;
+
+	objects.push_back(boost::make_shared<SimpleBoundedObject>(
+		glm::vec3(0.0f), glm::vec3(1.0f)));
+
+	tree.build(objects);
+
+	BOOST_CHECK(!tree.get_empty());
+	BOOST_CHECK_EQUAL(tree.get_nodes_count(), 1);
+
+	tree.intersect(el::Frustum(el::BoundingBox(glm::vec3(-1.0f),
+		glm::vec3(0.5f))), inside);
+	tree.intersect(el::Frustum(el::BoundingBox(glm::vec3(2.0f),
+		glm::vec3(3.0f))), outside);
+
+	BOOST_CHECK_EQUAL(inside.get_count(), 1);
+	BOOST_CHECK_EQUAL(outside.get_count(), 0);
+}
+
+BOOST_FIXTURE_TEST_SUITE(map_objects, MapObjectsBuilder)
+
+BOOST_AUTO_TEST_CASE(intersect)
+{
+	el::StaticRStarTree static_tree;
+	el::RStarTree tree;
+	Uint32 i;
+
+	static_tree.build(get_objects());
+
+	BOOST_FOREACH(const el::BoundedObjectSharedPtr &object, get_objects())
+	{
+		tree.add(object);
+	}
+
+	BOOST_CHECK(static_tree.get_bounding_box().get_min() ==
+		tree.get_bounding_box().get_min());
+	BOOST_CHECK(static_tree.get_bounding_box().get_max() ==
+		tree.get_bounding_box().get_max());
+
+	for (i = 0; i < get_view_count(); ++i)
+	{
+		el::Frustum frustum(get_view(i));
+		CollectBoundedObjectVisitor visitor, static_visitor;
+
+		tree.intersect(frustum, visitor);
+		static_tree.intersect(frustum, static_visitor);
+
+		BOOST_CHECK(visitor.get_objects() ==
+			static_visitor.get_objects());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(intersect_sub_trees)
+{
+	el::StaticRStarTree tree;
+	el::RStarTreeSubTreeVector sub_trees;
+	Uint32 i, j;
+	Uint16 depth;
+
+	tree.build(get_objects());
+
+	for (i = 0; i < get_view_count(); i += 16)
+	{
+		el::Frustum frustum(get_view(i));
+		CollectBoundedObjectVisitor visitor;
+
+		tree.intersect(frustum, visitor);
+
+		for (depth = 0; depth < 4; ++depth)
+		{
+			CollectBoundedObjectVisitor split_visitor;
+
+			sub_trees.clear();
+
+			tree.intersect(frustum, depth, split_visitor,
+				sub_trees);
+
+			for (j = 0; j < sub_trees.size(); ++j)
+			{
+				sub_trees[j].intersect(frustum, split_visitor);
+			}
+
+			BOOST_CHECK(visitor.get_objects() ==
+				split_visitor.get_objects());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(remove)
+{
+	el::StaticRStarTree tree;
+	std::set<el::BoundedObject*> removed;
+	Uint32 i;
+
+	tree.build(get_objects());
+
+	for (i = 0; i < get_count(); i += 2)
+	{
+		BOOST_CHECK(tree.remove(get_objects()[i]));
+		BOOST_CHECK(!tree.remove(get_objects()[i]));
+
+		removed.insert(get_objects()[i].get());
+	}
+
+	for (i = 0; i < get_view_count(); ++i)
+	{
+		CollectBoundedObjectVisitor visitor;
+
+		tree.intersect(el::Frustum(get_view(i)), visitor);
+
+		BOOST_FOREACH(el::BoundedObject* object,
+			visitor.get_objects())
+		{
+			BOOST_CHECK_EQUAL(removed.count(object), 0);
+		}
+	}
+
+	for (i = 1; i < get_count(); i += 2)
+	{
+		CollectBoundedObjectVisitor visitor;
+
+		tree.intersect(el::Frustum(get_objects()[i]->get_bounding_box(
+			)), visitor);
+
+		BOOST_CHECK_EQUAL(visitor.get_objects().count(
+			get_objects()[i].get()), 1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	el::StaticRStarTree static_tree;
+	el::RStarTree tree;
+	double start, build_time, static_build_time;
+	double intersect_time, static_intersect_time;
+	Uint32 i, count, static_count;
+
+	start = el::get_time();
+
+	BOOST_FOREACH(const el::BoundedObjectSharedPtr &object, get_objects())
+	{
+		tree.add(object);
+	}
+
+	build_time = el::get_time() - start;
+
+	start = el::get_time();
+
+	static_tree.build(get_objects());
+
+	static_build_time = el::get_time() - start;
+
+	count = 0;
+	start = el::get_time();
+
+	for (i = 0; i < get_view_count(); ++i)
+	{
+		CountBoundedObjectVisitor visitor;
+
+		tree.intersect(el::Frustum(get_view(i)), visitor);
+
+		count += visitor.get_count();
+	}
+
+	intersect_time = el::get_time() - start;
+
+	static_count = 0;
+	start = el::get_time();
+
+	for (i = 0; i < get_view_count(); ++i)
+	{
+		CountBoundedObjectVisitor visitor;
+
+		static_tree.intersect(el::Frustum(get_view(i)), visitor);
+
+		static_count += visitor.get_count();
+	}
+
+	static_intersect_time = el::get_time() - start;
+
+	BOOST_CHECK_EQUAL(count, static_count);
+
+	BOOST_TEST_MESSAGE(get_count() << " objects, build: r*-tree "
+		<< build_time << "ms, static tree " << static_build_time
+		<< "ms");
+	BOOST_TEST_MESSAGE(get_view_count() << " views, intersect: "
+		<< "r*-tree " << intersect_time << "ms, static tree "
+		<< static_intersect_time << "ms");
+	BOOST_TEST_MESSAGE("memory usage: r*-tree "
+		<< tree.get_memory_usage() << " bytes, static tree "
+		<< static_tree.get_memory_usage() << " bytes");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,242 @@
+/****************************************************************************
+ *            zipfile.cpp
+ *
+ * Author: 2010-2012  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#include "prerequisites.hpp"
+#include "zipfile.hpp"
+#include "reader.hpp"
+#include "abstractreadmemory.hpp"
+#include "exceptions.hpp"
+#include <zlib.h>
+#include <fstream>
+#define BOOST_TEST_MODULE zip_file
+#include <boost/test/unit_test.hpp>
+
+namespace el = eternal_lands;
+
+namespace
+{
+
+	class ZipFileBuilder
+	{
+		private:
+			std::vector<Uint8> m_data;
+			std::vector<Uint8> m_central_dir;
+			Uint16 m_count;
+
+			static void write_u16(std::vector<Uint8> &data,
+				const Uint16 value)
+			{
+				data.push_back(value & 0xFF);
+				data.push_back(value >> 8);
+			}
+
+			static void write_u32(std::vector<Uint8> &data,
+				const Uint32 value)
+			{
+				write_u16(data, value & 0xFFFF);
+				write_u16(data, value >> 16);
+			}
+
+			static std::vector<Uint8> deflate_raw(
+				const std::string &content)
+			{
+				std::vector<Uint8> result;
+				z_stream stream;
+
+				result.resize(compressBound(content.size()));
+
+				memset(&stream, 0, sizeof(stream));
+
+				deflateInit2(&stream, Z_BEST_COMPRESSION,
+					Z_DEFLATED, -MAX_WBITS, 8,
+					Z_DEFAULT_STRATEGY);
+
+				stream.next_in = reinterpret_cast<Bytef*>(
+					const_cast<char*>(content.c_str()));
+				stream.avail_in = content.size();
+				stream.next_out = &result[0];
+				stream.avail_out = result.size();
+
+				BOOST_CHECK_EQUAL(deflate(&stream, Z_FINISH),
+					Z_STREAM_END);
+
+				result.resize(stream.total_out);
+
+				deflateEnd(&stream);
+
+				return result;
+			}
+
+		public:
+			ZipFileBuilder(): m_count(0)
+			{
+			}
+
+			void add(const std::string &name,
+				const std::string &content, const bool deflated)
+			{
+				std::vector<Uint8> data;
+				Uint32 crc, offset;
+				Uint16 method;
+
+				crc = crc32(0, reinterpret_cast<const Bytef*>(
+					content.c_str()), content.size());
+				offset = m_data.size();
+
+				if (deflated)
+				{
+					data = deflate_raw(content);
+					method = 8;
+				}
+				else
+				{
+					data.assign(content.begin(),
+						content.end());
+					method = 0;
+				}
+
+				write_u32(m_data, 0x04034B50);
+				write_u16(m_data, 20);
+				write_u16(m_data, 0);
+				write_u16(m_data, method);
+				write_u32(m_data, 0);
+				write_u32(m_data, crc);
+				write_u32(m_data, data.size());
+				write_u32(m_data, content.size());
+				write_u16(m_data, name.size());
+				/* local extra field not in the central dir */
+				write_u16(m_data, 4);
+				m_data.insert(m_data.end(), name.begin(),
+					name.end());
+				write_u32(m_data, 0);
+				m_data.insert(m_data.end(), data.begin(),
+					data.end());
+
+				write_u32(m_central_dir, 0x02014B50);
+				write_u16(m_central_dir, 20);
+				write_u16(m_central_dir, 20);
+				write_u16(m_central_dir, 0);
+				write_u16(m_central_dir, method);
+				write_u32(m_central_dir, 0);
+				write_u32(m_central_dir, crc);
+				write_u32(m_central_dir, data.size());
+				write_u32(m_central_dir, content.size());
+				write_u16(m_central_dir, name.size());
+				write_u16(m_central_dir, 0);
+				write_u16(m_central_dir, 0);
+				write_u16(m_central_dir, 0);
+				write_u16(m_central_dir, 0);
+				write_u32(m_central_dir, 0);
+				write_u32(m_central_dir, offset);
+				m_central_dir.insert(m_central_dir.end(),
+					name.begin(), name.end());
+
+				m_count++;
+			}
+
+			void save(const std::string &file_name)
+			{
+				std::vector<Uint8> data;
+				std::ofstream file;
+
+				data = m_data;
+				data.insert(data.end(), m_central_dir.begin(),
+					m_central_dir.end());
+
+				write_u32(data, 0x06054B50);
+				write_u16(data, 0);
+				write_u16(data, 0);
+				write_u16(data, m_count);
+				write_u16(data, m_count);
+				write_u32(data, m_central_dir.size());
+				write_u32(data, m_data.size());
+				write_u16(data, 5);
+				data.insert(data.end(), 5, 'x');
+
+				file.open(file_name.c_str(), std::ios::binary);
+				file.write(reinterpret_cast<const char*>(
+					&data[0]), data.size());
+			}
+
+	};
+
+	std::string get_content(const el::ReaderSharedPtr &reader)
+	{
+		return std::string(static_cast<const char*>(
+			reader->get_buffer()->get_ptr()), reader->get_size());
+	}
+
+	std::string get_long_content()
+	{
+		std::string result;
+		Uint32 i;
+
+		for (i = 0; i < 1000; ++i)
+		{
+			result += boost::lexical_cast<std::string>(i * i);
+		}
+
+		return result;
+	}
+
+}
+
+BOOST_AUTO_TEST_CASE(read_files)
+{
+	ZipFileBuilder builder;
+
+	builder.add("stored.txt", "stored file content", false);
+	builder.add("dir/deflated.txt", get_long_content(), true);
+	builder.add("empty.txt", "", false);
+	builder.save("test.zip");
+
+	el::ZipFile zip_file(el::String(UTF8("test.zip")));
+
+	BOOST_CHECK(zip_file.get_has_file(el::String(UTF8("stored.txt"))));
+	BOOST_CHECK(zip_file.get_has_file(el::String(UTF8(
+		"dir/deflated.txt"))));
+	BOOST_CHECK(!zip_file.get_has_file(el::String(UTF8("missing.txt"))));
+
+	BOOST_CHECK_EQUAL(get_content(zip_file.get_file(el::String(UTF8(
+		"stored.txt")))), "stored file content");
+	BOOST_CHECK_EQUAL(get_content(zip_file.get_file(el::String(UTF8(
+		"dir/deflated.txt")))), get_long_content());
+	BOOST_CHECK_EQUAL(zip_file.get_file(el::String(UTF8("empty.txt"))
+		)->get_size(), 0);
+
+	BOOST_CHECK_THROW(zip_file.get_file(el::String(UTF8("missing.txt"))),
+		el::FileNotFoundException);
+}
+
+BOOST_AUTO_TEST_CASE(stored_files_not_copied)
+{
+	ZipFileBuilder builder;
+	el::ReaderSharedPtr first, second;
+
+	builder.add("stored.txt", "stored file content", false);
+	builder.save("test.zip");
+
+	el::ZipFile zip_file(el::String(UTF8("test.zip")));
+
+	first = zip_file.get_file(el::String(UTF8("stored.txt")));
+	second = zip_file.get_file(el::String(UTF8("stored.txt")));
+
+	BOOST_CHECK_EQUAL(first->get_buffer()->get_ptr(),
+		second->get_buffer()->get_ptr());
+}
+
+BOOST_AUTO_TEST_CASE(no_zip_file)
+{
+	std::ofstream file;
+
+	file.open("test.zip", std::ios::binary);
+	file << "no zip file, just some text that is long enough";
+	file.close();
+
+	BOOST_CHECK_THROW(el::ZipFile(el::String(UTF8("test.zip"))),
+		el::ReadErrorException);
+}
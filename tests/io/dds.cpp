@@ -13,6 +13,10 @@
 #include "reader.hpp"
 #include "writer.hpp"
 #include "filesystem.hpp"
+#include "readwritememory.hpp"
+#include "codec/dxt.hpp"
+#include "thread/jobsystem.hpp"
+#include "tools/timeutil.hpp"
 #include <boost/random.hpp>
 #define BOOST_TEST_MODULE dds
 #include <boost/test/unit_test.hpp>
@@ -107,6 +111,263 @@ namespace
 	const Uint32 image_depth = 0;
 	const Uint32 image_mipmap_count = 5;
 
+	const TextureFormatType block_formats[7] =
+	{
+		tft_rgba_dxt1,
+		tft_rgba_dxt3,
+		tft_rgba_dxt5,
+		tft_r_rgtc1,
+		tft_signed_r_rgtc1,
+		tft_rg_rgtc2,
+		tft_signed_rg_rgtc2
+	};
+
+	const Uint32 block_format_channels[7] =
+	{
+		4, 4, 4, 1, 1, 2, 2
+	};
+
+	/**
+	 * Scalar reference decoder, one texel at a time, for bit exact
+	 * comparison with the block decoder.
+	 */
+	Uint32 get_reference_u16(const Uint8* data)
+	{
+		return data[0] + data[1] * 256;
+	}
+
+	Uint32 get_reference_channel(const Uint32 value, const Uint32 shift,
+		const Uint32 bits)
+	{
+		Uint32 result;
+
+		result = (value >> shift) & ((1 << bits) - 1);
+
+		return (result << (8 - bits)) | (result >> (2 * bits - 8));
+	}
+
+	Uint8 get_reference_color(const Uint8* block, const bool dxt1,
+		const Uint32 texel, const Uint32 channel)
+	{
+		Uint32 c0, c1, v0, v1, index;
+
+		c0 = get_reference_u16(block);
+		c1 = get_reference_u16(block + 2);
+
+		index = (block[4 + texel / 4] >> ((texel % 4) * 2)) & 0x3;
+
+		if (channel == 3)
+		{
+			if (dxt1 && (c0 <= c1) && (index == 3))
+			{
+				return 0;
+			}
+
+			return 255;
+		}
+
+		switch (channel)
+		{
+			case 0:
+				v0 = get_reference_channel(c0, 11, 5);
+				v1 = get_reference_channel(c1, 11, 5);
+				break;
+			case 1:
+				v0 = get_reference_channel(c0, 5, 6);
+				v1 = get_reference_channel(c1, 5, 6);
+				break;
+			default:
+				v0 = get_reference_channel(c0, 0, 5);
+				v1 = get_reference_channel(c1, 0, 5);
+				break;
+		}
+
+		switch (index)
+		{
+			case 0:
+				return v0;
+			case 1:
+				return v1;
+			case 2:
+				if (dxt1 && (c0 <= c1))
+				{
+					return (v0 + v1 + 1) / 2;
+				}
+
+				return (2 * v0 + v1 + 1) / 3;
+			default:
+				if (dxt1 && (c0 <= c1))
+				{
+					return 0;
+				}
+
+				return (v0 + 2 * v1 + 1) / 3;
+		}
+	}
+
+	Uint8 get_reference_alpha(const Uint8* block, const bool sign,
+		const Uint32 texel)
+	{
+		Uint32 bit, index;
+		Sint32 a0, a1, weight;
+		float value;
+
+		bit = texel * 3;
+		index = (block[2 + bit / 8] >> (bit % 8));
+
+		if ((bit % 8) > 5)
+		{
+			index |= block[3 + bit / 8] << (8 - (bit % 8));
+		}
+
+		index &= 0x7;
+
+		if (sign)
+		{
+			a0 = std::max(static_cast<Sint8>(block[0]),
+				static_cast<Sint8>(-127));
+			a1 = std::max(static_cast<Sint8>(block[1]),
+				static_cast<Sint8>(-127));
+		}
+		else
+		{
+			a0 = block[0];
+			a1 = block[1];
+		}
+
+		if (index == 0)
+		{
+			return a0;
+		}
+
+		if (index == 1)
+		{
+			return a1;
+		}
+
+		if (a0 > a1)
+		{
+			weight = index - 1;
+			value = ((7 - weight) * a0 + weight * a1) / 7.0f;
+		}
+		else
+		{
+			if (index == 6)
+			{
+				return sign ? -127 : 0;
+			}
+
+			if (index == 7)
+			{
+				return sign ? 127 : 255;
+			}
+
+			weight = index - 1;
+			value = ((5 - weight) * a0 + weight * a1) / 5.0f;
+		}
+
+		return static_cast<Sint32>(value + (value < 0.0f ? -0.5f :
+			0.5f));
+	}
+
+	Uint8 get_reference_value(const Uint8* block,
+		const TextureFormatType format, const Uint32 texel,
+		const Uint32 channel)
+	{
+		switch (format)
+		{
+			case tft_rgba_dxt1:
+				return get_reference_color(block, true, texel,
+					channel);
+			case tft_rgba_dxt3:
+				if (channel == 3)
+				{
+					return ((block[texel / 2] >>
+						((texel % 2) * 4)) & 0xF) * 17;
+				}
+
+				return get_reference_color(block + 8, false,
+					texel, channel);
+			case tft_rgba_dxt5:
+				if (channel == 3)
+				{
+					return get_reference_alpha(block, false,
+						texel);
+				}
+
+				return get_reference_color(block + 8, false,
+					texel, channel);
+			case tft_r_rgtc1:
+			case tft_rg_rgtc2:
+				return get_reference_alpha(block + channel * 8,
+					false, texel);
+			default:
+				return get_reference_alpha(block + channel * 8,
+					true, texel);
+		}
+	}
+
+	const TextureFormatType compress_formats[3] =
+	{
+		tft_rgb_dxt1,
+		tft_rgba_dxt1,
+		tft_rgba_dxt5
+	};
+
+	/**
+	 * Smooth rgba8 image, like the parts of an actor texture.
+	 */
+	ImageSharedPtr get_gradient_image(const glm::uvec3 &size)
+	{
+		ImageSharedPtr image;
+		Uint8* pixel;
+		Uint32 x, y;
+
+		image = boost::make_shared<Image>(String(UTF8("gradient")),
+			false, tft_rgba8, size, 0, false);
+
+		for (y = 0; y < size.y; ++y)
+		{
+			for (x = 0; x < size.x; ++x)
+			{
+				pixel = static_cast<Uint8*>(
+					image->get_pixel_data(x, y, 0, 0, 0));
+
+				pixel[0] = x * 255 / (size.x - 1);
+				pixel[1] = y * 255 / (size.y - 1);
+				pixel[2] = ((x + y) * 4) & 0xFF;
+				pixel[3] = 255 - pixel[0];
+			}
+		}
+
+		return image;
+	}
+
+	ImageSharedPtr get_random_compressed_image(
+		const TextureFormatType format, const glm::uvec3 &size,
+		const Uint16 mipmaps)
+	{
+		boost::mt19937 rng;
+		boost::uniform_int<Uint32> range(0, 255);
+		boost::variate_generator<boost::mt19937&,
+			boost::uniform_int<Uint32> > random_byte(rng, range);
+		ImageSharedPtr image;
+		Uint8* data;
+		Uint32 i;
+
+		image = boost::make_shared<Image>(String(UTF8("random")),
+			false, format, size, mipmaps, false);
+
+		data = static_cast<Uint8*>(image->get_buffer()->get_ptr());
+
+		for (i = 0; i < image->get_buffer()->get_size(); ++i)
+		{
+			data[i] = random_byte();
+		}
+
+		return image;
+	}
+
 }
 
 BOOST_AUTO_TEST_CASE(fourcc)
@@ -557,3 +818,289 @@ BOOST_AUTO_TEST_CASE(write_read_dxt10)
 		}
 	}
 }
+
+BOOST_AUTO_TEST_CASE(uncompress_blocks)
+{
+	ImageSharedPtr compressed, image;
+	const Uint8* block;
+	const Uint8* pixel;
+	Uint32 i, j, m, x, y, width, height, channels;
+
+	for (i = 0; i < 7; ++i)
+	{
+		compressed = get_random_compressed_image(block_formats[i],
+			glm::uvec3(36, 20, 0), 5);
+
+		BOOST_CHECK_NO_THROW(image = compressed->decompress(false,
+			true, false));
+
+		BOOST_CHECK(!image->get_compressed());
+
+		channels = block_format_channels[i];
+
+		BOOST_CHECK_EQUAL(image->get_pixel_size(), channels * 8);
+
+		for (m = 0; m <= 5; ++m)
+		{
+			width = image->get_width(m);
+			height = image->get_height(m);
+
+			for (y = 0; y < height; ++y)
+			{
+				for (x = 0; x < width; ++x)
+				{
+					block = static_cast<const Uint8*>(
+						compressed->get_data(x / 4,
+							y / 4, 0, 0, m));
+					pixel = static_cast<const Uint8*>(
+						image->get_data(x, y, 0, 0,
+							m));
+
+					for (j = 0; j < channels; ++j)
+					{
+						BOOST_CHECK_EQUAL(pixel[j],
+							get_reference_value(
+								block,
+								block_formats[
+									i],
+								(y % 4) * 4 +
+								(x % 4), j));
+					}
+				}
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(uncompress_blocks_too_small)
+{
+	ImageSharedPtr compressed;
+	ReaderSharedPtr reader;
+	ReadWriteMemorySharedPtr buffer;
+
+	compressed = get_random_compressed_image(tft_rgba_dxt5,
+		glm::uvec3(32, 32, 0), 0);
+
+	buffer = boost::make_shared<ReadWriteMemory>(
+		compressed->get_buffer()->get_size() - 1);
+
+	reader = boost::make_shared<Reader>(buffer, String(UTF8("small")));
+
+	BOOST_CHECK_THROW(Dxt::uncompress(reader, String(UTF8("small")),
+		glm::uvec3(32, 32, 0), tft_rgba_dxt5, 0, false, false, true,
+		false, false), ReadErrorException);
+}
+
+BOOST_AUTO_TEST_CASE(uncompress_threaded)
+{
+	ImageSharedPtr compressed, image, threaded;
+	JobSystem job_system(4);
+	Uint32 i;
+
+	for (i = 0; i < 7; ++i)
+	{
+		compressed = get_random_compressed_image(block_formats[i],
+			glm::uvec3(516, 260, 0), 9);
+
+		image = compressed->decompress(false, true, false);
+		threaded = compressed->decompress(false, true, false,
+			job_system);
+
+		BOOST_CHECK_EQUAL(image->get_texture_format(),
+			threaded->get_texture_format());
+		BOOST_CHECK_EQUAL(threaded->get_mipmap_count(), 9);
+		BOOST_CHECK_EQUAL(image->get_buffer()->get_size(),
+			threaded->get_buffer()->get_size());
+		BOOST_CHECK_EQUAL(memcmp(image->get_buffer()->get_ptr(),
+			threaded->get_buffer()->get_ptr(),
+			image->get_buffer()->get_size()), 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(uncompress_benchmark)
+{
+	ImageSharedPtr compressed, image;
+	double start, time;
+	Uint32 i, j, count;
+
+	count = 8;
+
+	for (i = 0; i < 7; ++i)
+	{
+		compressed = get_random_compressed_image(block_formats[i],
+			glm::uvec3(1024, 1024, 0), 10);
+
+		start = get_time();
+
+		for (j = 0; j < count; ++j)
+		{
+			image = compressed->decompress(false, true, false);
+		}
+
+		time = std::max(get_time() - start, 0.001);
+
+		BOOST_TEST_MESSAGE(TextureFormatUtil::get_str(block_formats[i])
+			<< ": " << (count * 1024.0 * 1024.0 * 4.0 / 3.0 /
+			(time * 1000.0)) << " MPixels/s");
+	}
+}
+
+BOOST_AUTO_TEST_CASE(compress_blocks)
+{
+	ImageSharedPtr image, compressed, uncompressed;
+	const Uint8* source;
+	const Uint8* pixel;
+	double error;
+	Uint32 i, j, x, y, width, height;
+
+	image = get_gradient_image(glm::uvec3(38, 22, 0));
+	width = image->get_width();
+	height = image->get_height();
+
+	for (i = 0; i < 3; ++i)
+	{
+		BOOST_CHECK_NO_THROW(compressed = Dxt::compress(image,
+			compress_formats[i], false));
+
+		BOOST_CHECK_EQUAL(compressed->get_texture_format(),
+			compress_formats[i]);
+		BOOST_CHECK_EQUAL(compressed->get_mipmap_count(), 0);
+
+		uncompressed = compressed->decompress(false, true, false);
+
+		error = 0.0;
+
+		for (y = 0; y < height; ++y)
+		{
+			for (x = 0; x < width; ++x)
+			{
+				source = static_cast<const Uint8*>(
+					image->get_pixel_data(x, y, 0, 0, 0));
+				pixel = static_cast<const Uint8*>(
+					uncompressed->get_pixel_data(x, y, 0,
+						0, 0));
+
+				if (compress_formats[i] == tft_rgb_dxt1)
+				{
+					BOOST_CHECK_EQUAL(pixel[3], 255);
+				}
+
+				if (compress_formats[i] == tft_rgba_dxt1)
+				{
+					BOOST_CHECK_EQUAL(pixel[3],
+						source[3] < 128 ? 0 : 255);
+
+					if (source[3] < 128)
+					{
+						continue;
+					}
+				}
+
+				if (compress_formats[i] == tft_rgba_dxt5)
+				{
+					BOOST_CHECK_LE(std::abs(pixel[3] -
+						source[3]), 2);
+				}
+
+				for (j = 0; j < 3; ++j)
+				{
+					BOOST_CHECK_LE(std::abs(pixel[j] -
+						source[j]), 24);
+
+					error += (pixel[j] - source[j]) *
+						(pixel[j] - source[j]);
+				}
+			}
+		}
+
+		BOOST_CHECK_LE(std::sqrt(error / (width * height * 3)), 8.0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(compress_mipmaps_threaded)
+{
+	ImageSharedPtr image, compressed, threaded;
+	JobSystem job_system(4);
+	Uint32 i;
+
+	image = get_gradient_image(glm::uvec3(512, 256, 0));
+
+	for (i = 0; i < 3; ++i)
+	{
+		compressed = Dxt::compress(image, compress_formats[i], true);
+		threaded = Dxt::compress(image, compress_formats[i], true,
+			job_system);
+
+		BOOST_CHECK_EQUAL(compressed->get_mipmap_count(), 9);
+		BOOST_CHECK_EQUAL(threaded->get_mipmap_count(), 9);
+		BOOST_CHECK_EQUAL(compressed->get_buffer()->get_size(),
+			threaded->get_buffer()->get_size());
+		BOOST_CHECK_EQUAL(memcmp(compressed->get_buffer()->get_ptr(),
+			threaded->get_buffer()->get_ptr(),
+			compressed->get_buffer()->get_size()), 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(compress_invalid)
+{
+	ImageSharedPtr image;
+
+	image = boost::make_shared<Image>(String(UTF8("rgb8")), false,
+		tft_rgb8, glm::uvec3(32, 32, 0), 0, false);
+
+	BOOST_CHECK_THROW(Dxt::compress(image, tft_rgba_dxt5, false),
+		InvalidParameterException);
+
+	image = get_gradient_image(glm::uvec3(32, 32, 0));
+
+	BOOST_CHECK_THROW(Dxt::compress(image, tft_rgba_dxt3, false),
+		InvalidParameterException);
+}
+
+BOOST_AUTO_TEST_CASE(compress_benchmark)
+{
+	ImageSharedPtr image, compressed;
+	JobSystem job_system(JobSystem::get_default_thread_count());
+	double start, time, threaded_time;
+	Uint64 uncompressed_size;
+	Uint32 i, j, count;
+
+	count = 8;
+
+	// the size of an actor texture, with all mipmaps
+	image = get_gradient_image(glm::uvec3(512, 512, 0));
+	uncompressed_size = Image(String(UTF8("uncompressed")), false,
+		tft_rgba8, glm::uvec3(512, 512, 0), 9, false).get_buffer(
+			)->get_size();
+
+	for (i = 0; i < 3; ++i)
+	{
+		start = get_time();
+
+		for (j = 0; j < count; ++j)
+		{
+			compressed = Dxt::compress(image, compress_formats[i],
+				true);
+		}
+
+		time = std::max(get_time() - start, 0.001) / count;
+
+		start = get_time();
+
+		for (j = 0; j < count; ++j)
+		{
+			compressed = Dxt::compress(image, compress_formats[i],
+				true, job_system);
+		}
+
+		threaded_time = std::max(get_time() - start, 0.001) / count;
+
+		BOOST_TEST_MESSAGE(TextureFormatUtil::get_str(
+			compress_formats[i]) << ": " << time << " ms per actor, "
+			<< threaded_time << " ms per actor with "
+			<< job_system.get_thread_count() << " threads, "
+			<< ((uncompressed_size -
+				compressed->get_buffer()->get_size()) / 1024)
+			<< " KiB VRAM saved per actor");
+	}
+}
@@ -0,0 +1,34 @@
+/****************************************************************************
+ *            timeutil.hpp
+ *
+ * Author: 2011  Daniel Jungmann <el.3d.source@gmail.com>
+ * Copyright: See COPYING file that comes with this distribution
+ ****************************************************************************/
+
+#ifndef	UUID_1c7d239e_9524_4b2a_abbe_07fbb744a7d5
+#define	UUID_1c7d239e_9524_4b2a_abbe_07fbb744a7d5
+
+#ifndef	__cplusplus
+#error	"Including C++ header in C translation unit!"
+#endif	/* __cplusplus */
+
+#include "prerequisites.hpp"
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace eternal_lands
+{
+
+	/**
+	 * Returns the wall clock time for timing the tests.
+	 * @return The time in milliseconds.
+	 */
+	inline double get_time()
+	{
+		return (boost::posix_time::microsec_clock::universal_time() -
+			boost::posix_time::ptime(boost::gregorian::date(2000,
+				1, 1))).total_microseconds() * 1e-3;
+	}
+
+}
+
+#endif	/* UUID_1c7d239e_9524_4b2a_abbe_07fbb744a7d5 */